@@ -0,0 +1,79 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/globber.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/settings.h>
+#include <core/str.h>
+#include <core/str_iter.h>
+#include <history/history_db.h>
+#include <utils/app_context.h>
+
+//------------------------------------------------------------------------------
+struct bench_history_db
+    : public history_db
+{
+    bench_history_db() { initialise(); }
+};
+
+//------------------------------------------------------------------------------
+BENCH_CASE("history_db")
+{
+    const int c_line_count = 20000;
+
+    // Scratch state dir with a populated master history file.
+    str<280> root;
+    os::get_temp_dir(root);
+    path::append(root, "clink_bench_history");
+    os::make_dir(root.c_str());
+
+    app_context::desc context_desc;
+    str_base(context_desc.state_dir).copy(root.c_str());
+    app_context context(context_desc);
+
+    settings::find("history.shared")->set("true");
+    settings::find("history.dupe_mode")->set("add");
+
+    {
+        bench_history_db history;
+        str<64> line;
+        for (int i = 0; i < c_line_count; ++i)
+        {
+            line.format("command --flag%d some\\path\\arg_%d", i % 57, i);
+            history.add(line.c_str());
+        }
+    }
+
+    ctx.measure("load", 20, [&] () {
+        bench_history_db history;
+        bench::consume(size_t(&history));
+    });
+
+    {
+        bench_history_db history;
+        history_read_buffer buffer;
+        ctx.measure("read_lines", 50, [&] () {
+            str_iter line;
+            unsigned int count = 0;
+            history_db::iter iter = history.read_lines(buffer.data(), buffer.size());
+            while (iter.next(line))
+                ++count;
+            bench::consume(count);
+        });
+    }
+
+    // Clean out the scratch dir; the alive files are gone now that every
+    // history_db instance has closed.
+    {
+        str<280> pattern(root.c_str());
+        path::append(pattern, "*");
+        globber glob(pattern.c_str());
+        str<280> file;
+        while (glob.next(file))
+            os::unlink(file.c_str());
+    }
+    os::remove_dir(root.c_str());
+}
@@ -6,8 +6,71 @@ clink = clink or {}
 local prompt_filters = {}
 local prompt_filters_unsorted = false
 
+-- Cached results of filters that declared their inputs, keyed by the filter
+-- object.  Weak keys so discarding a filter discards its cache entry.
+local prompt_caches = setmetatable({}, { __mode = "k" })
 
 
+
+--------------------------------------------------------------------------------
+-- Condenses the inputs a filter declared into a token string; the filter only
+-- needs re-running when the token changes.
+local function snapshot_inputs(inputs)
+    local token = ""
+
+    if inputs.cwd then
+        token = token.."\1"..os.getcwd()
+    end
+
+    if inputs.envvars then
+        for _, name in ipairs(inputs.envvars) do
+            token = token.."\1"..name.."="..(os.getenv(name) or "")
+        end
+    end
+
+    if inputs.files then
+        for _, file in ipairs(inputs.files) do
+            token = token.."\1"..file.."@"..(os.getfiletime(file) or "")
+        end
+    end
+
+    return token
+end
+
+--------------------------------------------------------------------------------
+-- Runs one prompt filter, serving the result from its cache when the inputs
+-- it declared are unchanged.  Slow filters refresh asynchronously from the
+-- prompt's point of view: when an input changes the stale cached result is
+-- served once more so the prompt displays instantly, and the filter re-runs
+-- on the next prompt.
+local function run_filter(filter, prompt)
+    if not filter.inputs then
+        return filter:filter(prompt)
+    end
+
+    local token = snapshot_inputs(filter.inputs)
+    local cache = prompt_caches[filter]
+    if cache and cache.prompt == prompt then
+        if cache.token == token then
+            return cache.filtered, cache.onwards
+        end
+
+        if filter.slow and not cache.stale then
+            cache.stale = true
+            return cache.filtered, cache.onwards
+        end
+    end
+
+    local filtered, onwards = filter:filter(prompt)
+    prompt_caches[filter] = {
+        prompt = prompt,
+        token = token,
+        filtered = filtered,
+        onwards = onwards,
+    }
+    return filtered, onwards
+end
+
 --------------------------------------------------------------------------------
 function clink._filter_prompt(prompt)
     -- Sort by priority if required.
@@ -21,7 +84,7 @@ function clink._filter_prompt(prompt)
     -- Protected call to prompt filters.
     local impl = function(prompt)
         for _, filter in ipairs(prompt_filters) do
-            local filtered, onwards = filter:filter(prompt)
+            local filtered, onwards = run_filter(filter, prompt)
             if filtered ~= nil then
                 if onwards == false then return filtered end
                 prompt = filtered
@@ -59,6 +122,19 @@ end
 --- further prompt filtering by also returning false.  See
 --- <a href="#customisingtheprompt">Customising The Prompt</a> for more
 --- information.
+---
+--- A filter whose result only depends on observable state can declare that
+--- state in an <code>inputs</code> table on the object, and its result is
+--- then cached and reused until one of the declared inputs changes:
+--- -show:  foo_prompt.inputs = {
+--- -show:  &nbsp; cwd = true,                     -- the current directory
+--- -show:  &nbsp; envvars = { "USERNAME" },       -- environment variables
+--- -show:  &nbsp; files = { ".git\\HEAD" },       -- files, by last write time
+--- -show:  }
+--- A filter that declares inputs and is expensive to run (e.g. queries git
+--- status) can additionally set <code>slow = true</code> on the object; then
+--- when an input changes the previous result is still shown so the prompt
+--- displays without delay, and the filter refreshes on the next prompt.
 function clink.promptfilter(priority)
     if priority == nil then priority = 999 end
 
@@ -94,7 +94,10 @@ INT_PTR WINAPI initialise_clink(const app_context::desc& app_desc)
         str<256> log_path;
         app_ctx->get_log_path(log_path);
         unlink(log_path.c_str()); // Restart the log file on every inject.
-        new file_logger(log_path.c_str());
+        if (app_ctx->is_binary_log_enabled())
+            new binary_file_logger(log_path.c_str());
+        else
+            new async_file_logger(log_path.c_str());
     }
 
     // What process is the DLL loaded into?
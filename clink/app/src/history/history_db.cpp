@@ -11,6 +11,7 @@
 #include <core/settings.h>
 #include <core/str.h>
 #include <core/str_tokeniser.h>
+#include <core/str_hash.h>
 #include <core/path.h>
 #include <core/log.h>
 #include <assert.h>
@@ -40,6 +41,28 @@ static setting_int g_max_history(
     2500);
 };
 
+static setting_int g_load_window(
+    "history.load_window",
+    "Number of history lines loaded at startup",
+    "Number of most recent history lines initially loaded into the editor.\n"
+    "Older lines are paged in on demand when history scrolling reaches the\n"
+    "oldest loaded line.  0 loads all lines.  Searches and history expansion\n"
+    "only see the loaded lines, so expansion event numbers are relative to\n"
+    "the window.  The window only applies when the history index file is\n"
+    "usable; otherwise all lines are loaded (which also rebuilds the index).",
+    0);
+
+static setting_int g_load_days(
+    "history.load_days",
+    "Days of history loaded at startup",
+    "Only load history lines recorded within this many days, so startup cost\n"
+    "follows the retention policy instead of the history file's lifetime.\n"
+    "While this is non-zero, new lines are recorded with timestamp markers;\n"
+    "lines recorded without markers count as old.  Older lines are paged in\n"
+    "on demand, exactly as with history.load_window, and the smaller of the\n"
+    "two windows wins.  0 disables the time window.",
+    0);
+
 static setting_bool g_ignore_space(
     "history.ignore_space",
     "Skip adding lines prefixed with whitespace",
@@ -135,6 +158,72 @@ static void* open_file(const char* path, bool if_exists=false)
 
 
 
+//------------------------------------------------------------------------------
+// Read-only memory-mapped view over a bank's lines file.  Reading the master
+// bank through a mapping avoids streaming the whole file through ReadFile in
+// small chunks, which dominates load time once the master bank grows large.
+// The mapping is taken while the bank lock is held, so the view's size is
+// stable for the lifetime of the read.
+class bank_mapping
+    : public no_copy
+{
+public:
+                    bank_mapping() = default;
+                    ~bank_mapping() { close(); }
+    bool            open(void* file_handle);
+    void            close();
+    const char*     data() const        { return m_data; }
+    unsigned int    size() const        { return m_size; }
+    explicit        operator bool () const { return (m_data != nullptr); }
+
+private:
+    void*           m_map = nullptr;
+    const char*     m_data = nullptr;
+    unsigned int    m_size = 0;
+};
+
+//------------------------------------------------------------------------------
+bool bank_mapping::open(void* file_handle)
+{
+    close();
+
+    if (file_handle == nullptr)
+        return false;
+
+    unsigned int size = GetFileSize(file_handle, nullptr);
+    if (!size || size == INVALID_FILE_SIZE)
+        return false;
+
+    m_map = CreateFileMapping(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_map == nullptr)
+        return false;
+
+    m_data = (const char*)MapViewOfFile(m_map, FILE_MAP_READ, 0, 0, 0);
+    if (m_data == nullptr)
+    {
+        CloseHandle(m_map);
+        m_map = nullptr;
+        return false;
+    }
+
+    m_size = size;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void bank_mapping::close()
+{
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+    if (m_map != nullptr)
+        CloseHandle(m_map);
+    m_map = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+}
+
+
+
 //------------------------------------------------------------------------------
 const int max_ctag_size = 6 + 10 + 1 + 10 + 1 + 10 + 1 + 10 + 1 + 1;
 void concurrency_tag::generate_new_tag()
@@ -317,9 +406,11 @@ public:
                             file_iter() = default;
                             file_iter(const read_lock& lock, char* buffer, int buffer_size);
                             file_iter(void* handle, char* buffer, int buffer_size);
+                            file_iter(const bank_mapping& mapping, char* buffer, int buffer_size);
         template <int S>    file_iter(const read_lock& lock, char (&buffer)[S]);
         template <int S>    file_iter(void* handle, char (&buffer)[S]);
         unsigned int        next(unsigned int rollback=0);
+        void                use_mapping(const bank_mapping& mapping);
         unsigned int        get_buffer_offset() const   { return m_buffer_offset; }
         char*               get_buffer() const          { return m_buffer; }
         unsigned int        get_buffer_size() const     { return m_buffer_size; }
@@ -329,6 +420,9 @@ public:
     private:
         char*               m_buffer;
         void*               m_handle;
+        const char*         m_view = nullptr;
+        unsigned int        m_view_size = 0;
+        unsigned int        m_view_cursor = 0;
         unsigned int        m_buffer_size;
         unsigned int        m_buffer_offset;
         unsigned int        m_remaining;
@@ -339,19 +433,23 @@ public:
     public:
                             line_iter() = default;
                             line_iter(const read_lock& lock, char* buffer, int buffer_size);
+                            line_iter(const read_lock& lock, const bank_mapping& mapping, char* buffer, int buffer_size);
                             line_iter(void* handle, char* buffer, int buffer_size);
         template <int S>    line_iter(const read_lock& lock, char (&buffer)[S]);
         template <int S>    line_iter(void* handle, char (&buffer)[S]);
                             ~line_iter() = default;
         line_id_impl        next(str_iter& out);
+        void                use_mapping(const bank_mapping& mapping);
         void                set_file_offset(unsigned int offset);
         unsigned int        get_deleted_count() const { return m_deleted; }
+        unsigned int        get_timestamp() const { return m_timestamp; }
 
     private:
         bool                provision();
         file_iter           m_file_iter;
         unsigned int        m_remaining = 0;
         unsigned int        m_deleted = 0;
+        unsigned int        m_timestamp = 0;
         bool                m_first_line = true;
         bool                m_eating_ctag = false;
         std::unordered_set<unsigned int> m_removals;
@@ -375,8 +473,9 @@ public:
                     write_lock() = default;
     explicit        write_lock(const bank_handles& handles);
     void            clear();
-    void            add(const char* line);
+    unsigned int    add(const char* line);
     void            remove(line_id_impl id);
+    void            remove_batch(std::vector<unsigned int>& offsets);
     void            append(const read_lock& src);
 };
 
@@ -391,7 +490,7 @@ read_lock::read_lock(const bank_handles& handles, bool exclusive)
 //------------------------------------------------------------------------------
 template <class T> void read_lock::find(const char* line, T&& callback) const
 {
-    history_read_buffer buffer;
+    history_read_buffer buffer(history_read_buffer::sequential);
     line_iter iter(*this, buffer.data(), buffer.size());
 
     line_id_impl id;
@@ -427,11 +526,16 @@ line_id_impl read_lock::find(const char* line) const
 void read_lock::apply_removals(write_lock& lock) const
 {
     if (m_handle_removals)
+    {
+        // Collect the removal records and apply them in one sorted pass over
+        // the lines file, instead of one seek+write round trip per record.
+        std::vector<unsigned int> offsets;
         for_each_removal(m_handle_removals, [&] (unsigned int offset)
         {
-            line_id_impl id(offset);
-            lock.remove(id);
+            offsets.push_back(offset);
         });
+        lock.remove_batch(offsets);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -490,6 +594,17 @@ read_lock::file_iter::file_iter(void* handle, char* buffer, int buffer_size)
     set_file_offset(0);
 }
 
+//------------------------------------------------------------------------------
+read_lock::file_iter::file_iter(const bank_mapping& mapping, char* buffer, int buffer_size)
+: m_handle(nullptr)
+, m_buffer(buffer)
+, m_view(mapping.data())
+, m_view_size(mapping.size())
+, m_buffer_size(buffer_size)
+{
+    set_file_offset(0);
+}
+
 //------------------------------------------------------------------------------
 unsigned int read_lock::file_iter::next(unsigned int rollback)
 {
@@ -506,21 +621,39 @@ unsigned int read_lock::file_iter::next(unsigned int rollback)
     int needed = min(m_remaining, m_buffer_size - rollback);
 
     DWORD read = 0;
-    ReadFile(m_handle, target, needed, &read, nullptr);
+    if (m_view != nullptr)
+    {
+        read = needed;
+        memcpy(target, m_view + m_view_cursor, read);
+        m_view_cursor += read;
+    }
+    else
+        ReadFile(m_handle, target, needed, &read, nullptr);
 
     m_remaining -= read;
     m_buffer_size = read + rollback;
     return m_buffer_size;
 }
 
+//------------------------------------------------------------------------------
+void read_lock::file_iter::use_mapping(const bank_mapping& mapping)
+{
+    m_view = mapping.data();
+    m_view_size = mapping.size();
+    set_file_offset(0);
+}
+
 //------------------------------------------------------------------------------
 void read_lock::file_iter::set_file_offset(unsigned int offset)
 {
-    m_remaining = GetFileSize(m_handle, nullptr);
+    m_remaining = (m_view != nullptr) ? m_view_size : GetFileSize(m_handle, nullptr);
     offset = clamp(offset, (unsigned int)0, m_remaining);
     m_remaining -= offset;
-    m_buffer_offset = 0 - m_buffer_size;
-    SetFilePointer(m_handle, offset, nullptr, FILE_BEGIN);
+    m_buffer_offset = offset - m_buffer_size;
+    if (m_view != nullptr)
+        m_view_cursor = offset;
+    else
+        SetFilePointer(m_handle, offset, nullptr, FILE_BEGIN);
     m_buffer[0] = '\0';
 }
 
@@ -551,6 +684,19 @@ read_lock::line_iter::line_iter(const read_lock& lock, char* buffer, int buffer_
     }
 }
 
+//------------------------------------------------------------------------------
+read_lock::line_iter::line_iter(const read_lock& lock, const bank_mapping& mapping, char* buffer, int buffer_size)
+: m_file_iter(mapping, buffer, buffer_size)
+{
+    if (lock.m_handle_removals)
+    {
+        for_each_removal(lock.m_handle_removals, [&] (unsigned int offset)
+        {
+            m_removals.insert(offset);
+        });
+    }
+}
+
 //------------------------------------------------------------------------------
 read_lock::line_iter::line_iter(void* handle, char* buffer, int buffer_size)
 : m_file_iter(handle, buffer, buffer_size)
@@ -569,6 +715,46 @@ inline bool is_line_breaker(unsigned char c)
     return c == 0x00 || c == 0x0a || c == 0x0d;
 }
 
+//------------------------------------------------------------------------------
+// Returns a pointer to the first line breaker in [start, last), or 'last' if
+// there isn't one.  Records almost always end with 0x0a, so the first memchr
+// clamps the span the other two have to scan.
+static const char* find_line_breaker(const char* start, const char* last)
+{
+    const char* found = (const char*)memchr(start, 0x0a, last - start);
+    if (found)
+        last = found;
+    found = (const char*)memchr(start, 0x0d, last - start);
+    if (found)
+        last = found;
+    found = (const char*)memchr(start, 0x00, last - start);
+    if (found)
+        last = found;
+    return last;
+}
+
+//------------------------------------------------------------------------------
+// Parses a "|TS_<seconds>" timestamp marker.  These are metadata lines that
+// history_db::add writes in front of history lines (when history.load_days is
+// enabled) to record the unix time the lines following them were added.
+static bool parse_timestamp_line(const char* start, const char* end, unsigned int& time)
+{
+    if (end - start < 5 || strncmp(start, "|TS_", 4) != 0)
+        return false;
+
+    unsigned int value = 0;
+    for (start += 4; start != end; ++start)
+    {
+        if (*start < '0' || *start > '9')
+            return false;
+        value *= 10;
+        value += *start - '0';
+    }
+
+    time = value;
+    return true;
+}
+
 //------------------------------------------------------------------------------
 line_id_impl read_lock::line_iter::next(str_iter& out)
 {
@@ -600,13 +786,9 @@ line_id_impl read_lock::line_iter::next(str_iter& out)
                 break;
             }
 
-        const char* end = start;
-        for (; end != last; ++end)
-            if (is_line_breaker(*end))
-            {
-                m_eating_ctag = false;
-                break;
-            }
+        const char* end = find_line_breaker(start, last);
+        if (end != last)
+            m_eating_ctag = false;
 
         if (end == last && start != m_file_iter.get_buffer())
         {
@@ -627,7 +809,16 @@ line_id_impl read_lock::line_iter::next(str_iter& out)
         // also test for deferred removals here.
         if (*start == '|' || eating_ctag || m_removals.find(offset) != m_removals.end())
         {
-            if (!eating_ctag)
+            unsigned int time;
+            if (!eating_ctag && parse_timestamp_line(start, end, time))
+            {
+                // Timestamps are written in increasing order; the guard means
+                // a removed line that happens to look like a marker can only
+                // move time forwards, which at worst widens a load window.
+                if (time > m_timestamp)
+                    m_timestamp = time;
+            }
+            else if (!eating_ctag)
                 ++m_deleted;
             continue;
         }
@@ -640,6 +831,16 @@ line_id_impl read_lock::line_iter::next(str_iter& out)
     return line_id_impl();
 }
 
+//------------------------------------------------------------------------------
+void read_lock::line_iter::use_mapping(const bank_mapping& mapping)
+{
+    m_file_iter.use_mapping(mapping);
+    m_remaining = 0;
+    m_timestamp = 0;
+    m_first_line = true;
+    m_eating_ctag = false;
+}
+
 //------------------------------------------------------------------------------
 void read_lock::line_iter::set_file_offset(unsigned int offset)
 {
@@ -668,12 +869,19 @@ void write_lock::clear()
 }
 
 //------------------------------------------------------------------------------
-void write_lock::add(const char* line)
+unsigned int write_lock::add(const char* line)
 {
     DWORD written;
-    SetFilePointer(m_handle_lines, 0, nullptr, FILE_END);
-    WriteFile(m_handle_lines, line, int(strlen(line)), &written, nullptr);
-    WriteFile(m_handle_lines, "\n", 1, &written, nullptr);
+    unsigned int offset = SetFilePointer(m_handle_lines, 0, nullptr, FILE_END);
+
+    // Write the line and its terminator with a single WriteFile; on network
+    // mounted profiles every write is a round trip, and separate writes also
+    // leave a window where another process can observe the bank ending
+    // without a newline.
+    str<1024> buffer;
+    buffer << line << "\n";
+    WriteFile(m_handle_lines, buffer.c_str(), buffer.length(), &written, nullptr);
+    return offset;
 }
 
 //------------------------------------------------------------------------------
@@ -696,6 +904,63 @@ void write_lock::remove(line_id_impl id)
     }
 }
 
+//------------------------------------------------------------------------------
+void write_lock::remove_batch(std::vector<unsigned int>& offsets)
+{
+    if (offsets.empty())
+        return;
+
+    // Batching only applies to in-place marking; with a removals redirect in
+    // play each record just gets appended to the removals file as usual.
+    if (m_handle_removals)
+    {
+        for (unsigned int offset : offsets)
+            remove(line_id_impl(offset));
+        return;
+    }
+
+    std::sort(offsets.begin(), offsets.end());
+    offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+    unsigned int size = GetFileSize(m_handle_lines, nullptr);
+
+    // Walk the sorted offsets, coalescing all that fall inside one window
+    // into a single read-modify-write of the lines file.
+    char buffer[8192];
+    size_t i = 0;
+    while (i < offsets.size())
+    {
+        unsigned int window_start = offsets[i];
+        if (window_start >= size)
+            break;
+
+        unsigned int window_end = min<unsigned int>(window_start + sizeof_array(buffer), size);
+
+        size_t j = i;
+        while (j < offsets.size() && offsets[j] < window_end)
+            ++j;
+
+        unsigned int span = offsets[j - 1] + 1 - window_start;
+
+        DWORD read = 0;
+        SetFilePointer(m_handle_lines, window_start, nullptr, FILE_BEGIN);
+        ReadFile(m_handle_lines, buffer, span, &read, nullptr);
+
+        for (size_t k = i; k < j; ++k)
+        {
+            unsigned int rel = offsets[k] - window_start;
+            if (rel < read)
+                buffer[rel] = '|';
+        }
+
+        DWORD written;
+        SetFilePointer(m_handle_lines, window_start, nullptr, FILE_BEGIN);
+        WriteFile(m_handle_lines, buffer, read, &written, nullptr);
+
+        i = j;
+    }
+}
+
 //------------------------------------------------------------------------------
 void write_lock::append(const read_lock& src)
 {
@@ -703,7 +968,7 @@ void write_lock::append(const read_lock& src)
 
     SetFilePointer(m_handle_lines, 0, nullptr, FILE_END);
 
-    history_read_buffer buffer;
+    history_read_buffer buffer(history_read_buffer::sequential);
     read_lock::file_iter src_iter(src, buffer.data(), buffer.size());
     while (int bytes_read = src_iter.next())
         WriteFile(m_handle_lines, buffer.data(), bytes_read, &written, nullptr);
@@ -711,6 +976,9 @@ void write_lock::append(const read_lock& src)
 
 
 
+//------------------------------------------------------------------------------
+static bool extract_ctag(const read_lock& lock, concurrency_tag& tag);
+
 //------------------------------------------------------------------------------
 class read_line_iter
 {
@@ -723,6 +991,7 @@ private:
     const history_db&       m_db;
     read_lock               m_lock;
     read_lock::line_iter    m_line_iter;
+    bank_mapping            m_mapping;
     unsigned int            m_buffer_size;
     unsigned int            m_bank_index = 0;
 };
@@ -748,7 +1017,25 @@ bool read_line_iter::next_bank()
             m_lock.~read_lock();
             m_line_iter.~line_iter();
             new (&m_lock) read_lock(handles);
-            new (&m_line_iter) read_lock::line_iter(m_lock, buffer, m_buffer_size);
+
+            // The master bank can be large; read it through a mapped view and,
+            // when the side-index is still valid, seek directly to the first
+            // active line instead of scanning past the deleted prefix.
+            m_mapping.close();
+            if (bank_index == bank_master && m_mapping.open(handles.m_handle_lines))
+            {
+                new (&m_line_iter) read_lock::line_iter(m_lock, m_mapping, buffer, m_buffer_size);
+
+                if (!m_db.m_master_offsets.empty())
+                {
+                    concurrency_tag tag;
+                    if (extract_ctag(m_lock, tag) &&
+                        strcmp(tag.get(), m_db.m_master_ctag.get()) == 0)
+                        m_line_iter.set_file_offset(m_db.m_master_offsets.front());
+                }
+            }
+            else
+                new (&m_line_iter) read_lock::line_iter(m_lock, buffer, m_buffer_size);
             return true;
         }
     }
@@ -834,17 +1121,154 @@ static bool extract_ctag(const read_lock& lock, concurrency_tag& tag)
     return true;
 }
 
+//------------------------------------------------------------------------------
+static void get_index_file_path(str_base& out)
+{
+    get_file_path(out, false);
+    out << ".idx";
+}
+
+//------------------------------------------------------------------------------
+static void get_mirror_file_path(str_base& out)
+{
+    get_file_path(out, false);
+    out << ".recent";
+}
+
+//------------------------------------------------------------------------------
+// The side-index caches the file offset of each active master bank line so
+// that a new session can seek straight to live content instead of scanning
+// the whole file.  The first line of the index file is the ctag of the master
+// bank it was built from; a mismatch means another process rewrote the bank
+// and the index is stale.  Each subsequent line is "offset time"; indexes
+// written before timestamps existed carry just the offset, in which case
+// 'times' comes back empty and time-windowed loading is unavailable until
+// the next full load rewrites the index.
+static bool load_master_index(const concurrency_tag& master_ctag,
+    std::vector<unsigned int>& offsets, std::vector<unsigned int>& times)
+{
+    offsets.clear();
+    times.clear();
+
+    str<280> path;
+    get_index_file_path(path);
+
+    bank_handles handles;
+    handles.m_handle_lines = open_file(path.c_str(), true/*if_exists*/);
+    if (!handles)
+        return false;
+
+    bool ok = false;
+    {
+        read_lock lock(handles);
+
+        concurrency_tag tag;
+        if (extract_ctag(lock, tag) && strcmp(tag.get(), master_ctag.get()) == 0)
+        {
+            char buffer[4096];
+            read_lock::line_iter iter(lock, buffer);
+
+            bool has_times = true;
+
+            str_iter value;
+            while (iter.next(value))
+            {
+                unsigned int offset = 0;
+                unsigned int time = 0;
+                unsigned int* accumulator = &offset;
+                unsigned int len = value.length();
+                for (const char* s = value.get_pointer(); len--; s++)
+                {
+                    if (*s == ' ' && accumulator == &offset)
+                    {
+                        accumulator = &time;
+                        continue;
+                    }
+                    if (*s < '0' || *s > '9')
+                        break;
+                    *accumulator *= 10;
+                    *accumulator += *s - '0';
+                }
+
+                if (offset > 0)
+                {
+                    offsets.push_back(offset);
+                    times.push_back(time);
+                    if (accumulator == &offset)
+                        has_times = false;
+                }
+            }
+
+            if (!has_times)
+                times.clear();
+
+            ok = true;
+        }
+    }
+
+    handles.close();
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+static void save_master_index(const concurrency_tag& master_ctag,
+    const std::vector<unsigned int>& offsets, const std::vector<unsigned int>& times)
+{
+    if (master_ctag.empty())
+        return;
+
+    str<280> path;
+    get_index_file_path(path);
+
+    // Small banks gain nothing from seeking and don't warrant a side file.
+    static const size_t min_indexed_lines = 1000;
+    if (offsets.size() < min_indexed_lines)
+    {
+        os::unlink(path.c_str());
+        return;
+    }
+
+    bank_handles handles;
+    handles.m_handle_lines = open_file(path.c_str());
+    if (!handles)
+        return;
+
+    {
+        write_lock lock(handles);
+        lock.clear();
+        lock.add(master_ctag.get());
+
+        const bool timed = (times.size() == offsets.size());
+
+        str<24> value;
+        for (size_t i = 0; i < offsets.size(); ++i)
+        {
+            if (timed)
+                value.format("%u %u", offsets[i], times[i]);
+            else
+                value.format("%u", offsets[i]);
+            lock.add(value.c_str());
+        }
+    }
+
+    handles.close();
+}
+
 //------------------------------------------------------------------------------
 static void rewrite_master_bank(write_lock& lock)
 {
-    history_read_buffer buffer;
+    history_read_buffer buffer(history_read_buffer::sequential);
 
     // Read lines to keep into vector.
     str_iter out;
     read_lock::line_iter iter(lock, buffer.data(), buffer.size());
     std::vector<auto_free_str> lines_to_keep;
+    std::vector<unsigned int> times;
     while (iter.next(out))
+    {
         lines_to_keep.push_back(std::move(auto_free_str(out.get_pointer(), out.length())));
+        times.push_back(iter.get_timestamp());
+    }
 
     // Clear and write new tag.
     concurrency_tag tag;
@@ -852,9 +1276,148 @@ static void rewrite_master_bank(write_lock& lock)
     lock.clear();
     lock.add(tag.get());
 
-    // Write lines from vector.
-    for (auto const& line : lines_to_keep)
-        lock.add(line.get());
+    // Write lines from vector, re-emitting a timestamp marker wherever the
+    // recorded time advances so rewriting doesn't shed the timeline.
+    unsigned int last_time = 0;
+    for (size_t i = 0; i < lines_to_keep.size(); ++i)
+    {
+        if (times[i] > last_time)
+        {
+            str<24> marker;
+            marker.format("|TS_%u", times[i]);
+            lock.add(marker.c_str());
+            last_time = times[i];
+        }
+        lock.add(lines_to_keep[i].get());
+    }
+}
+
+//------------------------------------------------------------------------------
+// Verifies that 'id' still refers to 'line' before acting on a hash index
+// hit.  The content compare guards against hash collisions and lines that
+// were since removed in place; the caller guards the master ctag against
+// rewrites by other processes.
+static bool verify_index_hit(const read_lock& lock, line_id_impl id, const char* line,
+    history_read_buffer& buffer)
+{
+    read_lock::line_iter iter(lock, buffer.data(), buffer.size());
+    iter.set_file_offset(id.offset);
+
+    str_iter out;
+    line_id_impl read_id = iter.next(out);
+    if (!read_id || read_id.offset != id.offset)
+        return false;
+
+    if (strncmp(line, out.get_pointer(), out.length()) != 0)
+        return false;
+
+    return (line[out.length()] == '\0');
+}
+
+//------------------------------------------------------------------------------
+// Compacts the master bank on a worker thread.  Surviving lines are copied
+// into a shadow file while holding only a shared lock, then swapped into the
+// bank under the exclusive lock.  The exclusive phase is a raw byte copy, so
+// the interactive session never waits on parsing and rewriting a large file.
+struct compact_thread_params
+{
+    bank_handles    handles;
+    concurrency_tag ctag;
+};
+
+//------------------------------------------------------------------------------
+static DWORD WINAPI compact_thread_proc(void* vparams)
+{
+    compact_thread_params* params = (compact_thread_params*)vparams;
+
+    str<280> shadow_path;
+    get_file_path(shadow_path, false);
+    shadow_path << ".compacting";
+
+    bank_handles shadow_handles;
+    shadow_handles.m_handle_lines = open_file(shadow_path.c_str());
+    if (shadow_handles)
+    {
+        unsigned int copied_size = 0;
+        FILETIME copied_time = {};
+        concurrency_tag new_tag;
+        new_tag.generate_new_tag();
+
+        bool ok = false;
+        {
+            // Phase one:  parse and copy surviving lines into the shadow file
+            // under a shared lock.
+            read_lock src(params->handles);
+            write_lock dest(shadow_handles);
+            if (src && dest)
+            {
+                concurrency_tag tag;
+                if (extract_ctag(src, tag) && strcmp(tag.get(), params->ctag.get()) == 0)
+                {
+                    dest.clear();
+                    dest.add(new_tag.get());
+
+                    history_read_buffer buffer(history_read_buffer::sequential);
+                    read_lock::line_iter iter(src, buffer.data(), buffer.size() - 1);
+
+                    str_iter out;
+                    unsigned int last_time = 0;
+                    while (iter.next(out))
+                    {
+                        // Re-emit timestamp markers so compacting keeps the
+                        // timeline (rewrite_master_bank does the same).
+                        if (iter.get_timestamp() > last_time)
+                        {
+                            last_time = iter.get_timestamp();
+                            str<24> marker;
+                            marker.format("|TS_%u", last_time);
+                            dest.add(marker.c_str());
+                        }
+
+                        const char* line = out.get_pointer();
+                        int buffer_offset = int(line - buffer.data());
+                        buffer.data()[buffer_offset + out.length()] = '\0';
+                        dest.add(line);
+                    }
+
+                    copied_size = GetFileSize(params->handles.m_handle_lines, nullptr);
+                    GetFileTime(params->handles.m_handle_lines, nullptr, nullptr, &copied_time);
+                    ok = true;
+                }
+            }
+        }
+
+        if (ok)
+        {
+            // Phase two:  swap the shadow content into the bank under the
+            // exclusive lock.  If anything happened to the bank between the
+            // phases (an append, a removal, a rewrite by another process) the
+            // swap is abandoned; the bank simply stays uncompacted until the
+            // threshold triggers another attempt.
+            write_lock dest(params->handles);
+
+            concurrency_tag tag;
+            FILETIME time = {};
+            GetFileTime(params->handles.m_handle_lines, nullptr, nullptr, &time);
+            if (dest &&
+                extract_ctag(dest, tag) &&
+                strcmp(tag.get(), params->ctag.get()) == 0 &&
+                GetFileSize(params->handles.m_handle_lines, nullptr) == copied_size &&
+                CompareFileTime(&time, &copied_time) == 0)
+            {
+                read_lock src(shadow_handles);
+                dest.clear();
+                dest.append(src);
+                LOG("async compacted master bank");
+            }
+        }
+
+        shadow_handles.close();
+        os::unlink(shadow_path.c_str());
+    }
+
+    delete params;
+    return 0;
 }
 
 //------------------------------------------------------------------------------
@@ -921,6 +1484,7 @@ static void migrate_history(const char* path)
 history_db::history_db()
 {
     memset(m_bank_handles, 0, sizeof(m_bank_handles));
+    memset(m_bank_cursors, 0, sizeof(m_bank_cursors));
     m_master_len = 0;
     m_master_deleted_count = 0;
 
@@ -941,6 +1505,9 @@ history_db::history_db()
 //------------------------------------------------------------------------------
 history_db::~history_db()
 {
+    // Wait for any in-flight background compaction; it uses the bank handles.
+    finish_async_compact();
+
     // Close alive handle
     CloseHandle(m_alive_file);
 
@@ -1041,6 +1608,11 @@ void history_db::initialise()
     }
     LOG("master bank ctag: %s", m_master_ctag.get());
 
+    // Load the side-index of master bank line offsets.  A stale index is
+    // discarded here and rebuilt by the next load.
+    if (!load_master_index(m_master_ctag, m_master_offsets, m_master_times))
+        LOG("no usable master bank index");
+
     if (g_shared.get())
         return;
 
@@ -1105,25 +1677,72 @@ template <typename T> void history_db::for_each_bank(T&& callback) const
 //------------------------------------------------------------------------------
 void history_db::load_internal()
 {
-    clear_history();
+    // Size Readline's history array up front.  On a reload the previous line
+    // count is known exactly; on the first load the master side-index gives
+    // the master bank's count.  Either way a 200k line history grows once
+    // instead of a realloc every DEFAULT_HISTORY_GROW_SIZE lines.
+    size_t prealloc = m_index_map.size();
+    if (prealloc < m_master_offsets.size())
+        prealloc = m_master_offsets.size();
+    if (m_load_window && prealloc > m_load_window)
+        prealloc = m_load_window;
+
+    // Use Readline's clearer rather than clear_history:  it also releases any
+    // undo lists attached to history entries, which matters when this runs
+    // mid-edit (expand_load_window pages older lines in while the user is
+    // scrolling history).
+    rl_clear_history();
+    history_prealloc(int(prealloc));
+
+    // The side-index's offsets were built under this ctag (load_master_index
+    // and the refresh below both guarantee it); if the bank's ctag has changed
+    // since (another process rewrote the bank, or compact just ran), the
+    // offsets are meaningless and the window can't be applied.
+    concurrency_tag offsets_ctag;
+    offsets_ctag.set(m_master_ctag.get());
+    m_windowed = false;
+
     m_index_map.clear();
+    m_line_index.clear();
     m_master_len = 0;
     m_master_deleted_count = 0;
 
-    history_read_buffer buffer;
+    history_read_buffer buffer(history_read_buffer::sequential);
+
+    // Unix time of each master line read, for the side-index refresh below.
+    std::vector<unsigned int> times;
 
     const history_db& const_this = *this;
     const_this.for_each_bank([&] (unsigned int bank_index, const read_lock& lock)
     {
+        bank_mapping mapping;
         if (bank_index == bank_master)
         {
             m_master_ctag.clear();
             extract_ctag(lock, m_master_ctag);
+            mapping.open(m_bank_handles[bank_master].m_handle_lines);
         }
 
         // Subtract 1 from the size to accommodate the forced NUL termination
         // prior to calling add_history.
         read_lock::line_iter iter(lock, buffer.data(), buffer.size() - 1);
+        if (mapping)
+            iter.use_mapping(mapping);
+
+        // Windowed load:  skip straight to the offset of the Nth-from-last
+        // indexed line instead of parsing the whole bank.  The bank is append
+        // only under a given ctag, so indexed offsets stay valid even when
+        // lines have been appended (or marked deleted) since the index was
+        // built; any newer unindexed lines simply follow the seek point.
+        if (bank_index == bank_master &&
+            m_load_window &&
+            m_master_offsets.size() > m_load_window &&
+            !offsets_ctag.empty() &&
+            strcmp(offsets_ctag.get(), m_master_ctag.get()) == 0)
+        {
+            iter.set_file_offset(m_master_offsets[m_master_offsets.size() - m_load_window]);
+            m_windowed = true;
+        }
 
         str_iter out;
         line_id_impl id;
@@ -1136,23 +1755,360 @@ void history_db::load_internal()
 
             id.bank_index = bank_index;
             m_index_map.push_back(id.outer);
+            m_line_index.insert({str_hash64(line), id.outer});
             if (bank_index == bank_master)
             {
                 //LOG("load:  bank %u, offset %u, active %u:  '%s', len %u", id.bank_index, id.offset, id.active, line, out.length());
                 m_master_len = m_index_map.size();
+                times.push_back(iter.get_timestamp());
             }
         }
 
         if (bank_index == bank_master)
             m_master_deleted_count = iter.get_deleted_count();
 
+        // Remember how much of the bank has been consumed so a later reload
+        // can pick up where this one left off.
+        m_bank_cursors[bank_index] = GetFileSize(m_bank_handles[bank_index].m_handle_lines, nullptr);
+        snapshot_bank(bank_index);
+
+        return true;
+    });
+
+    m_line_index_built = true;
+
+    // A windowed load read only the tail of the master bank, so m_index_map
+    // can't refresh the side-index; keep the full index as-is -- the window
+    // seek and expand_load_window both depend on it covering the whole bank.
+    if (m_windowed)
+        return;
+
+    // Refresh the persistent side-index from what was just read.  Only write
+    // the file when the offsets actually changed, so a quiescent session
+    // doesn't touch the disk on every reload.
+    std::vector<unsigned int> offsets;
+    offsets.reserve(m_master_len);
+    for (size_t i = 0; i < m_master_len; ++i)
+    {
+        line_id_impl id;
+        id.outer = m_index_map[i];
+        offsets.push_back(id.offset);
+    }
+    if (offsets != m_master_offsets || times != m_master_times)
+    {
+        m_master_offsets.swap(offsets);
+        m_master_times.swap(times);
+        save_master_index(m_master_ctag, m_master_offsets, m_master_times);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Reads a bank's current file size and last-write time.  WriteFile updates
+// both through the file control block shared by all open handles, so an
+// unlocked probe compared against a snapshot taken under the bank lock tells
+// whether any process has changed the file in between; the async compactor's
+// phase-two guard already relies on the same coherence.
+static bool probe_bank_file(void* handle, unsigned int& size, unsigned long long& time)
+{
+    if (handle == nullptr)
+        return false;
+
+    size = GetFileSize(handle, nullptr);
+
+    FILETIME ft = {};
+    if (!GetFileTime(handle, nullptr, nullptr, &ft))
+        return false;
+
+    time = (unsigned long long(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void history_db::snapshot_bank(unsigned int bank_index)
+{
+    bank_snapshot& snapshot = m_bank_snapshots[bank_index];
+    snapshot.valid = probe_bank_file(m_bank_handles[bank_index].m_handle_lines,
+        snapshot.size, snapshot.time);
+}
+
+//------------------------------------------------------------------------------
+bool history_db::banks_unchanged() const
+{
+    for (int i = 0; i < sizeof_array(m_bank_handles); ++i)
+    {
+        void* handle = m_bank_handles[i].m_handle_lines;
+        if (handle == nullptr)
+            continue;
+
+        const bank_snapshot& snapshot = m_bank_snapshots[i];
+        unsigned int size;
+        unsigned long long time;
+        if (!snapshot.valid || !probe_bank_file(handle, size, time))
+            return false;
+        if (size != snapshot.size || time != snapshot.time)
+            return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool history_db::load_appended_lines()
+{
+    history_read_buffer buffer;
+
+    bool ok = true;
+    const history_db& const_this = *this;
+    const_this.for_each_bank([&] (unsigned int bank_index, const read_lock& lock)
+    {
+        void* handle = m_bank_handles[bank_index].m_handle_lines;
+
+        if (bank_index == bank_master)
+        {
+            // A changed ctag means another process rewrote the bank; the
+            // watermark no longer refers to the same content.
+            concurrency_tag tag;
+            if (!extract_ctag(lock, tag) || strcmp(tag.get(), m_master_ctag.get()) != 0)
+            {
+                ok = false;
+                return false;
+            }
+        }
+
+        unsigned int size = GetFileSize(handle, nullptr);
+        unsigned int cursor = m_bank_cursors[bank_index];
+        if (size < cursor)
+        {
+            // The bank shrank (e.g. `clink history clear`); only a full
+            // reload can resynchronise.
+            ok = false;
+            return false;
+        }
+
+        if (size == cursor)
+        {
+            snapshot_bank(bank_index);
+            return true;
+        }
+
+        // New master lines can't be spliced into the middle of Readline's
+        // history list, so the master bank may only grow while no session
+        // lines are loaded after it.
+        if (bank_index == bank_master && m_index_map.size() > m_master_len)
+        {
+            ok = false;
+            return false;
+        }
+
+        // Subtract 1 from the size to accommodate the forced NUL termination
+        // prior to calling add_history.
+        read_lock::line_iter iter(lock, buffer.data(), buffer.size() - 1);
+        iter.set_file_offset(cursor);
+
+        str_iter out;
+        line_id_impl id;
+        while (id = iter.next(out))
+        {
+            const char* line = out.get_pointer();
+            int buffer_offset = int(line - buffer.data());
+            buffer.data()[buffer_offset + out.length()] = '\0';
+            add_history(line);
+
+            id.bank_index = bank_index;
+            m_index_map.push_back(id.outer);
+            m_line_index.insert({str_hash64(line), id.outer});
+            if (bank_index == bank_master)
+                m_master_len = m_index_map.size();
+        }
+
+        if (bank_index == bank_master)
+            m_master_deleted_count += iter.get_deleted_count();
+
+        m_bank_cursors[bank_index] = size;
+        snapshot_bank(bank_index);
         return true;
     });
+
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+// Pages older master lines into Readline's history list when scrolling has
+// reached the oldest loaded line.  Doubles the window each time so paging
+// through a huge history stays O(log n) reloads.  Returns how many lines were
+// prepended, so the caller can re-anchor Readline's history offset.
+unsigned int history_db::expand_load_window()
+{
+    // A mirror-primed session has only the recent-lines cache in Readline's
+    // list; paging past it is the cue to merge the real banks in place.
+    if (!m_loaded && m_mirrored)
+    {
+        const int cached = history_length;
+        load_rl_history(false/*can_clean*/);
+        const int loaded = int(m_index_map.size());
+        return (loaded > cached) ? (unsigned int)(loaded - cached) : 0;
+    }
+
+    if (!m_windowed || !m_load_window)
+        return 0;
+
+    const size_t old_size = m_index_map.size();
+    const line_id old_front = old_size ? m_index_map.front() : 0;
+
+    // Once the doubled window would cover every indexed line, drop it and
+    // load the whole bank (which also lets the side-index refresh again).
+    m_load_window *= 2;
+    if (m_load_window >= m_master_offsets.size())
+        m_load_window = 0;
+
+    load_internal();
+
+    // The number of lines paged in is the old front line's position in the
+    // rebuilt list.  Line ids are stable across reloads of the same bank
+    // content, so search for it rather than assuming the counts line up
+    // (compaction during the reload renumbers everything).
+    if (old_size)
+        for (size_t i = 0; i < m_index_map.size(); ++i)
+            if (m_index_map[i] == old_front)
+                return (unsigned int)i;
+
+    const size_t new_size = m_index_map.size();
+    return (new_size > old_size) ? (unsigned int)(new_size - old_size) : 0;
+}
+
+//------------------------------------------------------------------------------
+// Primes Readline's history list from the recent-lines mirror instead of the
+// banks, so a session's first prompt doesn't wait on master bank I/O.  The
+// mirror caches content only -- no line ids -- so the db still counts as
+// unloaded and the banks get merged in place later:  either when the caller
+// next calls load_rl_history(), or when scrolling pages past the mirrored
+// lines.  Returns false when there is nothing to prime from, or when the
+// list is already populated.
+bool history_db::load_mirror()
+{
+    if (m_loaded || m_mirrored || history_length > 0)
+        return false;
+
+    str<280> path;
+    get_mirror_file_path(path);
+
+    bank_handles handles;
+    handles.m_handle_lines = open_file(path.c_str(), true/*if_exists*/);
+    if (!handles)
+        return false;
+
+    unsigned int count = 0;
+    {
+        read_lock lock(handles);
+        if (lock)
+        {
+            history_read_buffer buffer;
+
+            // Subtract 1 from the size to accommodate the forced NUL
+            // termination prior to calling add_history.
+            read_lock::line_iter iter(lock, buffer.data(), buffer.size() - 1);
+
+            str_iter out;
+            while (iter.next(out))
+            {
+                const char* line = out.get_pointer();
+                int buffer_offset = int(line - buffer.data());
+                buffer.data()[buffer_offset + out.length()] = '\0';
+                add_history(line);
+                ++count;
+            }
+        }
+    }
+    handles.close();
+
+    if (!count)
+        return false;
+
+    m_mirrored = true;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Rewrites the recent-lines mirror from the tail of Readline's freshly loaded
+// history list.  Lines added mid-session also append to the mirror (see
+// add()), so between full loads it can exceed the target length; each full
+// load trims it back.  Histories below the target length load quickly from
+// the banks anyway and don't warrant the side file.
+void history_db::save_mirror()
+{
+    str<280> path;
+    get_mirror_file_path(path);
+
+    HIST_ENTRY** entries = history_list();
+    if (entries == nullptr || history_length < int(m_mirror_lines))
+    {
+        os::unlink(path.c_str());
+        return;
+    }
+
+    bank_handles handles;
+    handles.m_handle_lines = open_file(path.c_str());
+    if (!handles)
+        return;
+
+    {
+        write_lock lock(handles);
+        if (lock)
+        {
+            lock.clear();
+            for (int i = history_length - int(m_mirror_lines); i < history_length; ++i)
+                lock.add(entries[i]->line);
+        }
+    }
+    handles.close();
 }
 
 //------------------------------------------------------------------------------
 void history_db::load_rl_history(bool can_clean)
 {
+    // Fastest path:  when no process has changed any bank since the last
+    // load, Readline's history list is already current.  This is decided from
+    // unlocked size/time probes, so a quiescent prompt costs no file locks at
+    // all -- with many concurrent sessions the locks are the contended part.
+    if (m_loaded && banks_unchanged())
+        return;
+
+    // Fast path:  when the banks have only grown since the last load, parse
+    // and add just the appended lines instead of rebuilding Readline's whole
+    // history list.  Cleaning is deferred until the next full reload, since
+    // compacting invalidates line ids and requires a rebuild anyway.
+    if (m_loaded && load_appended_lines())
+        return;
+
+    if (!m_loaded)
+    {
+        const int window = g_load_window.get();
+        m_load_window = (window > 0) ? size_t(window) : 0;
+
+        // Convert the time window into a line count over the side-index's
+        // timestamps; the smaller of the two windows wins.  The windowed load
+        // machinery (the ctag guard, expand_load_window paging) then applies
+        // unchanged.
+        const int days = g_load_days.get();
+        if (days > 0 && !m_master_times.empty() &&
+            m_master_times.size() == m_master_offsets.size())
+        {
+            const unsigned long long now = (unsigned long long)time(nullptr);
+            const unsigned long long span = (unsigned long long)days * 24 * 60 * 60;
+            const unsigned int cutoff = (span < now) ? (unsigned int)(now - span) : 0;
+
+            // Timestamps are non-decreasing, so the window is everything from
+            // the first line at or after the cutoff.  Always keep at least one
+            // line so the editor never starts with an empty history.
+            size_t count = m_master_times.end() -
+                std::lower_bound(m_master_times.begin(), m_master_times.end(), cutoff);
+            if (count < 1)
+                count = 1;
+            if (count < m_master_offsets.size() && (!m_load_window || count < m_load_window))
+                m_load_window = count;
+        }
+    }
+
     load_internal();
 
     // The `clink history` command needs to be able to avoid cleaning the master
@@ -1162,6 +2118,12 @@ void history_db::load_rl_history(bool can_clean)
         compact();
         load_internal();
     }
+
+    m_loaded = true;
+
+    // Refresh the recent-lines mirror so the next session's first prompt can
+    // be primed without reading the banks.
+    save_mirror();
 }
 
 //------------------------------------------------------------------------------
@@ -1180,8 +2142,19 @@ void history_db::clear()
     });
 
     m_index_map.clear();
+    m_line_index.clear();
     m_master_len = 0;
     m_master_deleted_count = 0;
+
+    m_master_offsets.clear();
+    m_master_times.clear();
+    save_master_index(m_master_ctag, m_master_offsets, m_master_times);
+
+    // The mirror caches bank content; drop it too so the next session's
+    // first prompt can't resurrect cleared lines.
+    str<280> mirror_path;
+    get_mirror_file_path(mirror_path);
+    os::unlink(mirror_path.c_str());
 }
 
 //------------------------------------------------------------------------------
@@ -1225,9 +2198,52 @@ void history_db::compact(bool force)
                         2500);
     if (m_master_deleted_count > threshold)
     {
-        write_lock lock(get_bank(bank_master));
-        rewrite_master_bank(lock);
-        LOG("Compacted history:  %u active, %u deleted", m_master_len, m_master_deleted_count);
+        if (force)
+        {
+            write_lock lock(get_bank(bank_master));
+            rewrite_master_bank(lock);
+            LOG("Compacted history:  %u active, %u deleted", m_master_len, m_master_deleted_count);
+        }
+        else
+        {
+            // Rewrite the master bank on a worker thread so the interactive
+            // session doesn't stall on it.  The rewrite changes the ctag, so
+            // the next reload notices the swap and resynchronises.
+            start_async_compact();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void history_db::start_async_compact()
+{
+    if (m_compact_thread != nullptr)
+    {
+        // Still busy with the previous compaction?
+        if (WaitForSingleObject(m_compact_thread, 0) != WAIT_OBJECT_0)
+            return;
+
+        CloseHandle(m_compact_thread);
+        m_compact_thread = nullptr;
+    }
+
+    compact_thread_params* params = new compact_thread_params;
+    params->handles = get_bank(bank_master);
+    params->ctag.set(m_master_ctag.get());
+
+    m_compact_thread = CreateThread(nullptr, 0, compact_thread_proc, params, 0, nullptr);
+    if (m_compact_thread == nullptr)
+        delete params;
+}
+
+//------------------------------------------------------------------------------
+void history_db::finish_async_compact()
+{
+    if (m_compact_thread != nullptr)
+    {
+        WaitForSingleObject(m_compact_thread, INFINITE);
+        CloseHandle(m_compact_thread);
+        m_compact_thread = nullptr;
     }
 }
 
@@ -1255,16 +2271,91 @@ bool history_db::add(const char* line)
 
     case 2:
         // 'erase_prev'
-        remove(line);
+        // Erasing rearranges the banks underneath Readline's history list;
+        // only a full reload can resynchronise the index map.
+        if (remove(line))
+            m_loaded = false;
         break;
     }
 
     // Add the line.
-    write_lock lock(get_bank(get_active_bank()));
+    unsigned int bank = get_active_bank();
+    write_lock lock(get_bank(bank));
     if (!lock)
         return false;
 
-    lock.add(line);
+    // Precede the line with a timestamp marker when time-windowed loading is
+    // enabled and the clock has drifted past the last marker written.  The
+    // markers are metadata lines, so every reader (including older versions)
+    // skips them; granularity keeps them to at most one a minute.
+    unsigned int first_offset = 0;
+    bool wrote_timestamp = false;
+    if (g_load_days.get() > 0)
+    {
+        static const unsigned int c_timestamp_granularity = 60;
+        const unsigned int now = (unsigned int)time(nullptr);
+        if (now - m_last_timestamp_written >= c_timestamp_granularity)
+        {
+            str<24> marker;
+            marker.format("|TS_%u", now);
+            first_offset = lock.add(marker.c_str());
+            m_last_timestamp_written = now;
+            wrote_timestamp = true;
+        }
+    }
+
+    unsigned int offset = lock.add(line);
+    if (!wrote_timestamp)
+        first_offset = offset;
+
+    // Keep the duplicate hash index current with the append.
+    if (m_line_index_built)
+    {
+        line_id_impl id(offset);
+        id.bank_index = bank;
+        m_line_index.insert({str_hash64(line), id.outer});
+    }
+
+    // This is called from Readline's add_history hook, so the line is already
+    // present in the history list.  Keep the incremental reload watermark and
+    // the index map in step with the append.  If another session appended in
+    // between, fall back to a full reload next time rather than risk adding
+    // lines twice.
+    if (m_loaded)
+    {
+        if (m_bank_cursors[bank] == first_offset)
+        {
+            line_id_impl id(offset);
+            id.bank_index = bank;
+            m_index_map.push_back(id.outer);
+            if (bank == bank_master)
+                m_master_len = m_index_map.size();
+            m_bank_cursors[bank] = offset + (unsigned int)(strlen(line)) + 1;
+            snapshot_bank(bank);
+        }
+        else
+            m_loaded = false;
+    }
+
+    // Mirror the append so the next session's first prompt can be primed
+    // without reading the banks.  Best effort, and only while a mirror
+    // exists -- save_mirror creates and trims it on each full load.
+    {
+        str<280> mirror_path;
+        get_mirror_file_path(mirror_path);
+        bank_handles mirror;
+        mirror.m_handle_lines = open_file(mirror_path.c_str(), true/*if_exists*/);
+        if (mirror)
+        {
+            {
+                write_lock mirror_lock(mirror);
+                if (mirror_lock)
+                    mirror_lock.add(line);
+            }
+            mirror.close();
+        }
+    }
+
     return true;
 }
 
@@ -1272,6 +2363,45 @@ bool history_db::add(const char* line)
 int history_db::remove(const char* line)
 {
     int count = 0;
+
+    // As in find(), probe the hash index instead of scanning the banks.
+    if (m_line_index_built)
+    {
+        bool stale = false;
+        history_read_buffer buffer;
+        auto range = m_line_index.equal_range(str_hash64(line));
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            line_id_impl id;
+            id.outer = it->second;
+
+            write_lock lock(get_bank(id.bank_index));
+            if (!lock)
+                continue;
+
+            if (id.bank_index == bank_master)
+            {
+                concurrency_tag tag;
+                if (!extract_ctag(lock, tag) || strcmp(tag.get(), m_master_ctag.get()) != 0)
+                {
+                    stale = true;
+                    break;
+                }
+            }
+
+            if (verify_index_hit(lock, id, line, buffer))
+            {
+                lock.remove(id);
+                count++;
+            }
+        }
+
+        if (!stale)
+            return count;
+
+        count = 0;
+    }
+
     for_each_bank([line, &count] (unsigned int index, write_lock& lock)
     {
         lock.find(line, [&] (line_id_impl id) {
@@ -1386,6 +2516,42 @@ history_db::line_id history_db::find(const char* line) const
 {
     line_id_impl ret;
 
+    // The hash index turns duplicate lookup into probing a handful of
+    // candidate offsets instead of scanning every line of every bank.
+    if (m_line_index_built)
+    {
+        bool stale = false;
+        history_read_buffer buffer;
+        auto range = m_line_index.equal_range(str_hash64(line));
+        for (auto it = range.first; it != range.second && !ret; ++it)
+        {
+            line_id_impl id;
+            id.outer = it->second;
+
+            read_lock lock(get_bank(id.bank_index));
+            if (!lock)
+                continue;
+
+            if (id.bank_index == bank_master)
+            {
+                concurrency_tag tag;
+                if (!extract_ctag(lock, tag) || strcmp(tag.get(), m_master_ctag.get()) != 0)
+                {
+                    // Another process rewrote the bank; the indexed offsets
+                    // are meaningless until the next load rebuilds the index.
+                    stale = true;
+                    break;
+                }
+            }
+
+            if (verify_index_hit(lock, id, line, buffer))
+                ret = id;
+        }
+
+        if (!stale)
+            return ret.outer;
+    }
+
     for_each_bank([line, &ret] (unsigned int index, const read_lock& lock)
     {
         if (ret = lock.find(line))
@@ -1399,6 +2565,22 @@ history_db::line_id history_db::find(const char* line) const
 //------------------------------------------------------------------------------
 history_db::expand_result history_db::expand(const char* line, str_base& out)
 {
+    // Almost every submitted line contains no expansion trigger, yet
+    // history_expand copies the line and walks it through Readline's
+    // tokeniser (with its allocations) regardless.  The triggers are cheap
+    // to rule out up front: '!' anywhere, or quick substitution's '^' in the
+    // first column.
+    //
+    // No cache of past expansions sits behind this, deliberately: an
+    // expansion's result depends on the history list ("!!", "!-2", ...),
+    // which mutates when every accepted line is added, so cached entries
+    // would be invalidated at the same cadence they could be hit.
+    if (*line != '^' && strchr(line, '!') == nullptr)
+    {
+        out.copy(line);
+        return expand_none;
+    }
+
     using_history();
 
     char* expanded = nullptr;
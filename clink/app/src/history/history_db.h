@@ -5,6 +5,7 @@
 
 #include <core/str_iter.h>
 
+#include <unordered_map>
 #include <vector>
 
 //------------------------------------------------------------------------------
@@ -70,14 +71,29 @@ class history_read_buffer
     // memory block, or control structures stored separately in memory).
     static const unsigned int buffer_size = 64000;
 
+    // Full sequential scans (loads, compaction, copies) fetch in larger
+    // chunks to cut the number of ReadFile round trips on big banks.  The
+    // standard size stays the floor, so a valid-length line still always
+    // fits in one buffer; the page-fitting note above only matters for the
+    // standard size used by targeted reads.
+    static const unsigned int sequential_buffer_size = 4 * buffer_size;
+
 public:
-    history_read_buffer() : m_buffer((char*)malloc(buffer_size)) {}
+    // 'standard' suits targeted seeks (verifying an index hit, reading one
+    // line at an offset); 'sequential' suits reading a whole bank.
+    enum mode { standard, sequential };
+
+    history_read_buffer(mode m=standard)
+    : m_size((m == sequential) ? sequential_buffer_size : buffer_size)
+    , m_buffer((char*)malloc(m_size))
+    {}
     ~history_read_buffer() { free(m_buffer); }
 
     char*           data() { return m_buffer; }
-    unsigned int    size() const { return buffer_size; }
+    unsigned int    size() const { return m_size; }
 
 private:
+    unsigned int    m_size;
     char*           m_buffer;
 };
 
@@ -115,8 +131,13 @@ public:
                                 ~history_db();
     void                        initialise();
     void                        load_rl_history(bool can_clean=true);
+    bool                        load_mirror();
+    bool                        is_loaded() const { return m_loaded; }
+    bool                        load_appended_lines();
+    unsigned int                expand_load_window();
     void                        clear();
     void                        compact(bool force=false);
+    void                        finish_async_compact();
     bool                        add(const char* line);
     int                         remove(const char* line);
     bool                        remove(line_id id) { return remove_internal(id, true); }
@@ -136,14 +157,69 @@ private:
     unsigned int                get_active_bank() const;
     bank_handles                get_bank(unsigned int index) const;
     bool                        remove_internal(line_id id, bool guard_ctag);
+    void                        start_async_compact();
+    void                        snapshot_bank(unsigned int bank_index);
+    bool                        banks_unchanged() const;
+    void                        save_mirror();
+    void*                       m_compact_thread = nullptr;
     void*                       m_alive_file;
     bank_handles                m_bank_handles[bank_count];
+    unsigned int                m_bank_cursors[bank_count];
+
+    // Size and last-write time of a bank's lines file, captured while its
+    // lock was held.  Comparing against an unlocked probe tells whether any
+    // process has changed the bank since, so a quiescent prompt can skip
+    // taking the file locks altogether.
+    struct bank_snapshot
+    {
+        unsigned int            size = 0;
+        unsigned long long      time = 0;   // FILETIME as a 64-bit value.
+        bool                    valid = false;
+    };
+    bank_snapshot               m_bank_snapshots[bank_count];
+    bool                        m_loaded = false;
+    bool                        m_mirrored = false;
     concurrency_tag             m_master_ctag;
     std::vector<line_id>        m_index_map;
+    std::vector<unsigned int>   m_master_offsets;
+
+    // Unix time each master line was recorded, parallel to m_master_offsets.
+    // Empty when the side-index predates timestamps; lines recorded before
+    // markers existed carry time 0.
+    std::vector<unsigned int>   m_master_times;
+
+    // Hash of line content -> line id, for O(1) duplicate lookup.  Entries
+    // can go stale (removed lines); hits are verified against the bank before
+    // being acted on.
+    //
+    // This is deliberately the only search index, and it is in-memory only.
+    // The master bank is appended to by every concurrent session and pruned
+    // via the removals file, so a persistent prefix/substring index beside it
+    // would be invalidated by other sessions with no way to notice short of
+    // re-reading the bank it was meant to avoid.  Interactive recall does not
+    // need one either: searches run over Readline's in-memory history list
+    // and are incremental (i-search continues from the current position per
+    // keystroke), so they never re-scan the files.
+    std::unordered_multimap<unsigned long long, line_id> m_line_index;
+    bool                        m_line_index_built = false;
     size_t                      m_master_len;
     size_t                      m_master_deleted_count;
 
+    // Windowed loading:  number of most recent lines to materialize in
+    // Readline's history list (0 = all), and whether the last load actually
+    // clipped older lines off the front.
+    size_t                      m_load_window = 0;
+    bool                        m_windowed = false;
+
+    // Unix time of the last "|TS_" marker this session wrote to its active
+    // bank; used to throttle markers to one per minute.
+    unsigned int                m_last_timestamp_written = 0;
+
     size_t                      m_min_compact_threshold = 200;
+
+    // Number of lines the recent-lines mirror keeps; histories smaller than
+    // this load quickly from the banks and don't warrant the side file.
+    size_t                      m_mirror_lines = 1000;
 };
 
 //------------------------------------------------------------------------------
@@ -8,8 +8,11 @@
 #include <core/settings.h>
 #include <core/str.h>
 #include <core/str_iter.h>
+#include <core/str_stream.h>
 #include <core/str_tokeniser.h>
 
+#include <wchar.h>
+
 //------------------------------------------------------------------------------
 static setting_bool g_enhanced_doskey(
     "doskey.enhanced",
@@ -21,91 +24,6 @@ static setting_bool g_enhanced_doskey(
 
 
 
-//------------------------------------------------------------------------------
-class str_stream
-{
-public:
-    typedef char            TYPE;
-
-    struct range_desc
-    {
-        const TYPE* const   ptr;
-        unsigned int        count;
-    };
-
-                            str_stream();
-    void                    operator << (TYPE c);
-    void                    operator << (const range_desc desc);
-    void                    collect(str_impl<TYPE>& out);
-    static range_desc       range(TYPE const* ptr, unsigned int count);
-    static range_desc       range(const str_iter_impl<TYPE>& iter);
-
-private:
-    void                    grow(unsigned int hint=128);
-    char* __restrict        m_start;
-    char* __restrict        m_end;
-    char* __restrict        m_cursor;
-};
-
-//------------------------------------------------------------------------------
-str_stream::str_stream()
-: m_start(nullptr)
-, m_end(nullptr)
-, m_cursor(nullptr)
-{
-}
-
-//------------------------------------------------------------------------------
-void str_stream::operator << (TYPE c)
-{
-    if (m_cursor >= m_end)
-        grow();
-
-    *m_cursor++ = c;
-}
-
-//------------------------------------------------------------------------------
-void str_stream::operator << (const range_desc desc)
-{
-    if (m_cursor + desc.count >= m_end)
-        grow(desc.count);
-
-    for (unsigned int i = 0; i < desc.count; ++i, ++m_cursor)
-        *m_cursor = desc.ptr[i];
-}
-
-//------------------------------------------------------------------------------
-str_stream::range_desc str_stream::range(const TYPE* ptr, unsigned int count)
-{
-    return { ptr, count };
-}
-
-//------------------------------------------------------------------------------
-str_stream::range_desc str_stream::range(const str_iter_impl<TYPE>& iter)
-{
-    return { iter.get_pointer(), iter.length() };
-}
-
-//------------------------------------------------------------------------------
-void str_stream::collect(str_impl<TYPE>& out)
-{
-    out.attach(m_start, int(m_cursor - m_start));
-    m_start = m_end = m_cursor = nullptr;
-}
-
-//------------------------------------------------------------------------------
-void str_stream::grow(unsigned int hint)
-{
-    hint = (hint + 127) & ~127;
-    unsigned int size = int(m_end - m_start) + hint;
-    TYPE* next = (TYPE*)realloc(m_start, size * sizeof(TYPE));
-    m_cursor = next + (m_cursor - m_start);
-    m_end = next + size;
-    m_start = next;
-}
-
-
-
 //------------------------------------------------------------------------------
 doskey_alias::doskey_alias()
 {
@@ -125,14 +43,16 @@ bool doskey_alias::next(str_base& out)
     if (!*m_cursor)
         return false;
 
+    // Copy the whole line in one step rather than a character at a time.
+    const char* start = m_cursor;
+    while (*m_cursor && *m_cursor != '\n')
+        ++m_cursor;
+
     out.clear();
-    while (*m_cursor)
-    {
-        char c = *m_cursor++;
-        if (c == '\n')
-            break;
-        out.concat(&c, 1);
-    }
+    out.concat(start, int(m_cursor - start));
+
+    if (*m_cursor)
+        ++m_cursor;
 
     return true;
 }
@@ -168,6 +88,50 @@ bool doskey::remove_alias(const char* alias)
     return (AddConsoleAliasW(walias.data(), nullptr, wshell.data()) == TRUE);
 }
 
+//------------------------------------------------------------------------------
+bool doskey::load_alias_snapshot()
+{
+    m_aliases_chars = 0;
+
+    wstr<64> wshell(m_shell_name);
+    DWORD bytes = GetConsoleAliasesLengthW(wshell.data());
+    if (!bytes)
+        return false;
+
+    unsigned int chars = bytes / sizeof(wchar_t);
+    if (!m_aliases.reserve(chars + 1))
+        return false;
+
+    if (!GetConsoleAliasesW(m_aliases.data(), bytes, wshell.data()))
+        return false;
+
+    m_aliases.data()[chars] = '\0';
+    m_aliases_chars = chars;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+const wchar_t* doskey::lookup_alias(const wchar_t* name) const
+{
+    size_t name_length = wcslen(name);
+
+    // Alias names match case-insensitively, same as GetConsoleAliasW.
+    const wchar_t* read = m_aliases.c_str();
+    const wchar_t* end = read + m_aliases_chars;
+    while (read < end && *read)
+    {
+        size_t length = wcslen(read);
+        if (length > name_length &&
+            read[name_length] == '=' &&
+            _wcsnicmp(read, name, name_length) == 0)
+            return read + name_length + 1;
+
+        read += length + 1;
+    }
+
+    return nullptr;
+}
+
 //------------------------------------------------------------------------------
 bool doskey::resolve_impl(const str_iter& in, str_stream* out)
 {
@@ -187,25 +151,18 @@ bool doskey::resolve_impl(const str_iter& in, str_stream* out)
     alias.concat(alias_ptr, token.length());
     wstr<32> walias(alias.c_str());
 
-    // Find the alias' text. First check it exists.
-    wchar_t unused;
-    wstr<32> wshell(m_shell_name);
-    if (!GetConsoleAliasW(walias.data(), &unused, sizeof(unused), wshell.data()))
-        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
-            return false;
-
-    // It does. Allocate space and fetch it.
-    wstr<4> wtext;
-    wtext.reserve(8192, true/*exact*/);
-    GetConsoleAliasW(walias.data(), wtext.data(), wtext.size(), wshell.data());
-    str<4> text(wtext.c_str());
+    // Find the alias' text in the snapshot taken by resolve().
+    const wchar_t* alias_text = lookup_alias(walias.c_str());
+    if (alias_text == nullptr)
+        return false;
 
     // Early out if no output location was provided:  return true because the
-    // command is an alias that needs to be expanded (this is unreachable if the
-    // GetConsoleAliasW call doesn't find an alias).
+    // command is an alias that needs to be expanded.
     if (out == nullptr)
         return true;
 
+    str<4> text(alias_text);
+
     // Collect the remaining tokens.
     if (g_enhanced_doskey.get())
         tokens.add_quote_pair("\"");
@@ -222,17 +179,23 @@ bool doskey::resolve_impl(const str_iter& in, str_stream* out)
     // Expand the alias' text into 'out'.
     str_stream& stream = *out;
     const char* read = text.c_str();
-    for (int c = *read; c = *read; ++read)
+    while (int c = *read)
     {
+        // Copy runs between tags in one step rather than a character at a time.
         if (c != '$')
         {
-            stream << c;
+            const char* run = read;
+            do
+                ++read;
+            while (*read && *read != '$');
+            stream << str_stream::range(run, int(read - run));
             continue;
         }
 
         c = *++read;
         if (!c)
             break;
+        ++read;
 
         // Convert $x tags.
         switch (c)
@@ -280,6 +243,13 @@ void doskey::resolve(const char* chars, doskey_alias& out)
 {
     out.reset();
 
+    // Snapshot the console's alias table up front.  Each GetConsoleAliasW
+    // call is a console host round trip, and resolving can look up every
+    // command in the line twice; resolving from the snapshot pays one round
+    // trip per submission and also can't tear if aliases change mid-resolve.
+    if (!load_alias_snapshot())
+        return;
+
     str_stream stream;
     if (g_enhanced_doskey.get())
     {
@@ -6,6 +6,7 @@
 #include <core/array.h>
 #include <core/str.h>
 #include <core/str_iter.h>
+#include <core/str_stream.h>
 
 //------------------------------------------------------------------------------
 class doskey_alias
@@ -34,6 +35,13 @@ public:
     void            resolve(const char* chars, doskey_alias& out);
 
 private:
-    bool            resolve_impl(const str_iter& in, class str_stream* out);
+    bool            resolve_impl(const str_iter& in, str_stream* out);
+    bool            load_alias_snapshot();
+    const wchar_t*  lookup_alias(const wchar_t* name) const;
     const char*     m_shell_name;
+
+    // Snapshot of the console's "name=value" alias pairs, taken once per
+    // resolve() so lookups don't each pay a console host round trip.
+    wstr_moveable   m_aliases;
+    unsigned int    m_aliases_chars = 0;
 };
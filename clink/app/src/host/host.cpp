@@ -18,13 +18,16 @@
 #include <core/str.h>
 #include <core/str_compare.h>
 #include <core/str_tokeniser.h>
+#include <core/timings.h>
 #include <lib/match_generator.h>
 #include <lib/line_editor.h>
+#include <lib/usage_index.h>
 #include <lua/lua_script_loader.h>
 #include <lua/lua_state.h>
 #include <lua/lua_match_generator.h>
 #include <terminal/terminal.h>
 #include <readline/readline.h>
+#include <readline/history.h>
 
 #include <list>
 #include <memory>
@@ -67,6 +70,25 @@ static setting_str g_exclude_from_history_cmds(
     "\"exit history\", to exclude both of those commands.",
     "exit history");
 
+static setting_bool g_memory_stats(
+    "clink.memory_stats",
+    "Write per-session memory statistics",
+    "When enabled, a small report of the session's memory usage (Lua heap,\n"
+    "Readline history list, match store) is written to the profile directory\n"
+    "after each edited line, where 'clink info' run from any process can read\n"
+    "it.",
+    false);
+
+// Read by generator.lua, which owns the statistics; defined here so 'clink
+// set' can see it without a Lua runtime.
+static setting_bool g_generator_stats(
+    "clink.generator_stats",
+    "Write per-session generator statistics",
+    "When enabled, the per-generator match generation statistics (see\n"
+    "clink.generatorstats()) are written to the profile directory after each\n"
+    "edited line, where 'clink info' run from any process can read them.",
+    false);
+
 static setting_bool g_reload_scripts(
     "lua.reload_scripts",
     "Reload scripts on every prompt",
@@ -122,6 +144,102 @@ int clink_print(lua_State* state)
 
 
 
+//------------------------------------------------------------------------------
+extern void get_match_store_usage(size_t& used, size_t& peak);
+
+//------------------------------------------------------------------------------
+// Collected here because the host is the only place that can see the Lua
+// heap, the Readline history list, and the match store at the same time.
+struct memory_report
+{
+    size_t          lua_heap_bytes;
+    size_t          history_entries;
+    size_t          history_bytes;
+    size_t          match_store_bytes;
+    size_t          match_store_peak_bytes;
+};
+
+//------------------------------------------------------------------------------
+static void collect_memory_report(lua_State* state, memory_report& report)
+{
+    report.lua_heap_bytes = 0;
+    if (state != nullptr)
+        report.lua_heap_bytes = size_t(lua_gc(state, LUA_GCCOUNT, 0)) * 1024
+                              + size_t(lua_gc(state, LUA_GCCOUNTB, 0));
+
+    report.history_entries = 0;
+    report.history_bytes = 0;
+    if (HIST_ENTRY** list = history_list())
+    {
+        for (int i = 0; list[i] != nullptr; ++i)
+        {
+            const HIST_ENTRY* entry = list[i];
+            report.history_bytes += sizeof(*entry) + sizeof(entry);
+            if (entry->line != nullptr)
+                report.history_bytes += strlen(entry->line) + 1;
+            ++report.history_entries;
+        }
+    }
+
+    get_match_store_usage(report.match_store_bytes, report.match_store_peak_bytes);
+}
+
+//------------------------------------------------------------------------------
+// Documented in clink_api.cpp.
+int get_memory_usage(lua_State* state)
+{
+    memory_report report;
+    collect_memory_report(state, report);
+
+    const struct {
+        const char* name;
+        size_t      value;
+    } rows[] = {
+        { "lua_heap_bytes",         report.lua_heap_bytes },
+        { "history_entries",        report.history_entries },
+        { "history_bytes",          report.history_bytes },
+        { "match_store_bytes",      report.match_store_bytes },
+        { "match_store_peak_bytes", report.match_store_peak_bytes },
+    };
+
+    lua_createtable(state, 0, sizeof_array(rows));
+    for (const auto& row : rows)
+    {
+        lua_pushstring(state, row.name);
+        lua_pushinteger(state, lua_Integer(row.value));
+        lua_rawset(state, -3);
+    }
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// Writes the report where other processes ('clink info', fleet monitoring)
+// can read it without reaching into this one.
+static void write_memory_stats(lua_State* state)
+{
+    if (!g_memory_stats.get())
+        return;
+
+    memory_report report;
+    collect_memory_report(state, report);
+
+    str<280> stats_path;
+    app_context::get()->get_memory_stats_path(stats_path);
+
+    FILE* file = fopen(stats_path.c_str(), "wt");
+    if (file == nullptr)
+        return;
+
+    fprintf(file, "session %d\n", app_context::get()->get_id());
+    fprintf(file, "lua_heap_bytes %llu\n", (unsigned long long)report.lua_heap_bytes);
+    fprintf(file, "history_entries %llu\n", (unsigned long long)report.history_entries);
+    fprintf(file, "history_bytes %llu\n", (unsigned long long)report.history_bytes);
+    fprintf(file, "match_store_bytes %llu\n", (unsigned long long)report.match_store_bytes);
+    fprintf(file, "match_store_peak_bytes %llu\n", (unsigned long long)report.match_store_peak_bytes);
+    fclose(file);
+}
+
 //------------------------------------------------------------------------------
 bool call_lua_rl_global_function(const char* func_name)
 {
@@ -231,6 +349,30 @@ void host_remove_history(int rl_history_index, const char* line)
     if (s_history_db)
         s_history_db->remove(rl_history_index, line);
 }
+int host_page_older_history()
+{
+    if (!s_history_db)
+        return 0;
+
+    // Paging prepends lines, which shifts every Readline history position;
+    // re-anchor the offset so scrolling continues from the same line.
+    const int where = where_history();
+    const unsigned int added = s_history_db->expand_load_window();
+    int pos = where + int(added);
+    if (pos > history_length)
+        pos = history_length;
+    history_set_pos(pos);
+    return added != 0;
+}
+
+//------------------------------------------------------------------------------
+// Worker for the overlapped history initialisation in edit_line(); nothing
+// else may touch the history_db until the thread is joined.
+static DWORD WINAPI initialise_history_thread(void* param)
+{
+    static_cast<history_db*>(param)->initialise();
+    return 0;
+}
 
 //------------------------------------------------------------------------------
 static void write_line_feed()
@@ -435,8 +577,10 @@ host::host(const char* name)
 : m_name(name)
 , m_doskey("cmd.exe")
 {
-    m_terminal = terminal_create();
-    m_printer = new printer(*m_terminal.out);
+    // The terminal and printer are created lazily in edit_line().  The host
+    // is constructed at injection time, and cmd.exe may run a batch script
+    // for a long while before showing a prompt (or never show one at all);
+    // until then only the hooks need to exist.
 }
 
 //------------------------------------------------------------------------------
@@ -447,6 +591,16 @@ host::~host()
     delete m_history;
     delete m_printer;
     terminal_destroy(m_terminal);
+
+    usage_index::close();
+
+    // Remove this session's statistics files, if any were written; leftover
+    // files would report a session that no longer exists.
+    str<280> stats_path;
+    app_context::get()->get_memory_stats_path(stats_path);
+    os::unlink(stats_path.c_str());
+    app_context::get()->get_generator_stats_path(stats_path);
+    os::unlink(stats_path.c_str());
 }
 
 //------------------------------------------------------------------------------
@@ -463,6 +617,18 @@ bool host::edit_line(const char* prompt, str_base& out)
     app->update_env();
     path::refresh_pathext();
 
+    // Capture the environment once for this prompt; prompt filters and Lua
+    // scripts read variables from the snapshot instead of the OS.
+    os::refresh_env_snapshot();
+
+    // First interactive prompt; create the terminal and printer deferred
+    // from the constructor.
+    if (m_printer == nullptr)
+    {
+        m_terminal = terminal_create();
+        m_printer = new printer(*m_terminal.out);
+    }
+
     cwd_restorer cwd;
     printer_context prt(m_terminal, m_printer);
 
@@ -470,9 +636,20 @@ bool host::edit_line(const char* prompt, str_base& out)
     // settings declared in scripts.
     str<288> settings_file;
     app_context::get()->get_settings_path(settings_file);
-    settings::load(settings_file.c_str());
+    {
+        timing_scope timing("settings load");
+        settings::load(settings_file.c_str());
+    }
     reset_keyseq_to_name_map();
 
+    // Open the completion usage index (idempotent once it succeeds); both
+    // recording and ranking no-op while it's closed.
+    {
+        str<280> state_dir;
+        app->get_state_dir(state_dir);
+        usage_index::open(state_dir.c_str());
+    }
+
     // Set up the string comparison mode.
     static_assert(str_compare_scope::exact == 0, "g_ignore_case values must match str_compare_scope values");
     static_assert(str_compare_scope::caseless == 1, "g_ignore_case values must match str_compare_scope values");
@@ -491,26 +668,58 @@ bool host::edit_line(const char* prompt, str_base& out)
     bool init_editor = interactive;
     bool init_history = interactive && !rl_has_saved_history();
 
+    // Decide history now and start its initialisation on a worker thread.
+    // history_db::initialise() is file work (bank handles, ctag, side index,
+    // reaping) that touches no Lua or Readline state, so it can overlap the
+    // script loading and prompt filtering below; startup then costs the max
+    // of the phases instead of their sum.  The join point is just before
+    // history is used.  load_rl_history() stays on this thread because it
+    // populates Readline's global history list.
+    HANDLE history_thread = nullptr;
+    if (init_history)
+    {
+        if (g_save_history.get())
+        {
+            if (!m_history)
+                m_history = new history_db;
+        }
+        else if (m_history)
+        {
+            delete m_history;
+            m_history = nullptr;
+        }
+
+        if (m_history)
+            history_thread = CreateThread(nullptr, 0, initialise_history_thread, m_history, 0, nullptr);
+    }
+
     // Set up Lua.
     bool local_lua = g_reload_scripts.get();
     bool reload_lua = local_lua || (m_lua && m_lua->is_script_path_changed());
     std::unique_ptr<host_lua> tmp_lua;
     std::unique_ptr<prompt_filter> tmp_prompt_filter;
-    if (reload_lua || local_lua)
+    if (local_lua)
     {
         delete m_prompt_filter;
         delete m_lua;
         m_prompt_filter = nullptr;
         m_lua = nullptr;
-    }
-    if (local_lua)
-    {
         tmp_lua = std::make_unique<host_lua>();
         tmp_prompt_filter = std::make_unique<prompt_filter>(*tmp_lua);
     }
     else
     {
-        init_scripts = !m_lua;
+        if (reload_lua && m_lua)
+        {
+            // Reuse the interpreter rather than rebuilding it; initialise()
+            // resets script state in place, keeping the registered C API
+            // tables.  The prompt filter reloads its script, so it gets
+            // recreated below.
+            delete m_prompt_filter;
+            m_prompt_filter = nullptr;
+            static_cast<lua_state&>(*m_lua).initialise();
+        }
+        init_scripts = reload_lua || !m_lua;
         send_event |= init_scripts;
         if (!m_lua)
             m_lua = new host_lua;
@@ -525,6 +734,7 @@ bool host::edit_line(const char* prompt, str_base& out)
     // Load scripts.
     if (init_scripts)
     {
+        timing_scope timing("script load");
         initialise_lua(lua);
         lua.load_scripts();
     }
@@ -566,27 +776,30 @@ bool host::edit_line(const char* prompt, str_base& out)
             editor->set_classifier(lua);
     }
 
-    if (init_history)
+    if (init_history && m_history)
     {
-        if (g_save_history.get())
-        {
-            if (!m_history)
-                m_history = new history_db;
-        }
-        else
+        timing_scope timing("history load");
+
+        // Join the worker started above; only the wait for whatever hasn't
+        // finished yet shows up in the timing.
+        if (history_thread != nullptr)
         {
-            if (m_history)
-            {
-                delete m_history;
-                m_history = nullptr;
-            }
+            WaitForSingleObject(history_thread, INFINITE);
+            CloseHandle(history_thread);
         }
 
-        if (m_history)
-        {
-            m_history->initialise();
+        // No-op when the worker did the job; does it here when the thread
+        // couldn't be created.
+        m_history->initialise();
+
+        // First prompt of a session:  prime Readline's list from the recent-
+        // lines mirror instead of reading the banks, so the prompt appears
+        // immediately even when the master bank is large.  The banks merge in
+        // place later -- just before the accepted line is added below, or
+        // when scrolling pages past the mirrored lines.  Without a mirror
+        // (and on every later prompt) load the banks here as before.
+        if (!m_history->load_mirror())
             m_history->load_rl_history();
-        }
     }
 
     s_history_db = m_history;
@@ -687,6 +900,12 @@ bool host::edit_line(const char* prompt, str_base& out)
                     break;
             }
 
+            // A mirror-primed prompt deferred loading the banks; catch up
+            // now, in the transition into running the command, so the line
+            // is added on top of a fully loaded history list.
+            if (init_history && m_history && !m_history->is_loaded())
+                m_history->load_rl_history();
+
             // Add the line to the history.
             if (m_history)
                 m_history->add(out.c_str());
@@ -711,6 +930,8 @@ bool host::edit_line(const char* prompt, str_base& out)
         intercept_directory(out);
     }
 
+    write_memory_stats(static_cast<lua_state&>(lua).get_state());
+
     s_history_db = nullptr;
 
     line_editor_destroy(editor);
@@ -38,8 +38,8 @@ private:
     const char*     m_name;
     doskey          m_doskey;
     doskey_alias    m_doskey_alias;
-    terminal        m_terminal;
-    printer*        m_printer;
+    terminal        m_terminal = {};
+    printer*        m_printer = nullptr;
     history_db*     m_history = nullptr;
     host_lua*       m_lua = nullptr;
     prompt_filter*  m_prompt_filter = nullptr;
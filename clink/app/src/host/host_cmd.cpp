@@ -14,6 +14,7 @@
 #include <core/settings.h>
 #include <core/os.h>
 #include <core/path.h>
+#include <core/str_convert.h>
 #include <lib/line_editor.h>
 #include <lua/lua_script_loader.h>
 #include <process/hook.h>
@@ -25,8 +26,57 @@
 
 //------------------------------------------------------------------------------
 extern bool s_force_reload_scripts;
+extern const wchar_t* g_prompt_tag;
+extern const wchar_t* g_prompt_tag_hidden;
 extern "C" void reset_wcwidths();
 
+//------------------------------------------------------------------------------
+// Counts WriteConsoleW calls since the last ReadConsoleW.  Once a run of
+// consecutive writes makes it clear cmd.exe is streaming output (a batch
+// script, 'type largefile', a big directory listing) the write hook collapses
+// to a direct passthrough, because the only write that matters before the next
+// read is the tagged prompt and that is identifiable from its first character.
+static int s_writes_since_read = 0;
+static const int c_passthrough_threshold = 8;
+
+//------------------------------------------------------------------------------
+// Tail of what cmd.exe has written to the console since the last line read,
+// captured by the write hook so check_auto_answer() can match cmd.exe's
+// single-character prompts without reading them back from the screen buffer.
+// A stale generation (nothing captured since the last line read) or a write
+// skipped by the streaming passthrough means the capture is incomplete, and
+// the screen buffer is consulted instead.
+static wstr<160> s_last_write;
+static int s_read_generation = 0;
+static int s_capture_generation = -1;
+static bool s_capture_missed = false;
+
+//------------------------------------------------------------------------------
+static void capture_write_tail(const wchar_t* chars, DWORD count)
+{
+    if (chars == nullptr || count == 0)
+        return;
+
+    if (s_capture_generation != s_read_generation)
+    {
+        s_capture_generation = s_read_generation;
+        s_capture_missed = false;
+        s_last_write.clear();
+    }
+
+    // Only the newest characters can matter; a prompt always immediately
+    // precedes the read that asks about it.
+    const unsigned int capacity = s_last_write.size() - 1;
+    if (count >= capacity)
+    {
+        chars += count - capacity;
+        count = capacity;
+    }
+    if (s_last_write.length() + count > capacity)
+        s_last_write.clear();
+    s_last_write.concat(chars, int(count));
+}
+
 //------------------------------------------------------------------------------
 static setting_bool g_ctrld_exits(
     "cmd.ctrld_exits",
@@ -87,6 +137,14 @@ static int check_auto_answer()
         }
     }
 
+    // The write hook captures what cmd.exe writes to the console, so the
+    // prompt can usually be matched without a ReadConsoleOutputCharacterW
+    // round trip per read.  Fall back to the screen buffer when the capture
+    // is incomplete.
+    if (s_capture_generation == s_read_generation && !s_capture_missed)
+        return (wcsstr(s_last_write.c_str(), target_prompt.c_str()) != nullptr) ?
+               ((setting == 1) ? no_yes[1] : no_yes[0]) : 0;
+
     prompt prompt = prompt_utils::extract_from_console();
     if (prompt.get() != nullptr && wcsstr(prompt.get(), target_prompt.c_str()) != 0)
         return (setting == 1) ? no_yes[1] : no_yes[0];
@@ -115,6 +173,10 @@ static BOOL WINAPI single_char_read(
         {
             reply = '\n';
             visit_count = 0;
+
+            // The prompt has been answered; drop the captured text so it
+            // can't match a later, different single-character prompt.
+            s_last_write.clear();
         }
 
         *buffer = reply;
@@ -196,21 +258,19 @@ int expand_env_var(int count, int invoking_key)
     str<1024> in;
     in.concat(g_rl_buffer->get_buffer() + word_left, word_right - word_left);
 
-    wstr<> win;
-    to_utf16(win, in.c_str());
+    utf16_conversion_context win(in.c_str());
 
     // Do the environment variable expansion.
     DWORD size = ExpandEnvironmentStringsW(win.c_str(), 0, 0);
     if (!size)
         return 0;
-    wstr<1024> wout;
-    wout.reserve(size);
-    size = ExpandEnvironmentStringsW(win.c_str(), wout.data(), wout.size());
-    if (!size || size > wout.size())
+    utf16_conversion_context wout;
+    wout.get().reserve(size);
+    size = ExpandEnvironmentStringsW(win.c_str(), wout.get().data(), wout.get().size());
+    if (!size || size > wout.get().size())
         return 0;
 
-    str<> out;
-    to_utf8(out, wout.c_str());
+    utf8_conversion_context out(wout.c_str());
 
     // Update Readline with the resulting expansion.
     g_rl_buffer->begin_undo_group();
@@ -372,11 +432,8 @@ bool host_cmd::is_interactive() const
 }
 
 //------------------------------------------------------------------------------
-void host_cmd::edit_line(const wchar_t* prompt, wchar_t* chars, int max_chars)
+int host_cmd::edit_line(const wchar_t* prompt, wchar_t* chars, int max_chars)
 {
-    bool resolved = false;
-    wstr_base wout(chars, max_chars);
-
     // Convert the prompt to Utf8 and parse backspaces in the string.
     // BUGBUG: This mishandles multi-byte characters!
     // BUGBUG: This mishandles surrogate pairs and combining characters!
@@ -392,29 +449,26 @@ void host_cmd::edit_line(const wchar_t* prompt, wchar_t* chars, int max_chars)
             --write;
     *write = '\0';
 
-    // Call readline.
+    // Call readline.  Returns the length written to 'chars' so the caller
+    // doesn't have to re-measure the line.
+    str<1024> out;
+    while (1)
     {
-        str<1024> out;
-        while (1)
+        out.clear();
+        if (host::edit_line(utf8_prompt.c_str(), out))
+            return to_utf16(chars, max_chars, out.c_str());
+
+        if (s_force_reload_scripts)
         {
-            out.clear();
-            if (host::edit_line(utf8_prompt.c_str(), out))
-            {
-                to_utf16(chars, max_chars, out.c_str());
-                break;
-            }
-
-            if (s_force_reload_scripts)
-            {
-            }
-            else if (g_ctrld_exits.get())
-            {
-                wstr_base(chars, max_chars) = L"exit";
-                break;
-            }
-
-            write_line_feed();
         }
+        else if (g_ctrld_exits.get())
+        {
+            wstr_base exit(chars, max_chars);
+            exit = L"exit";
+            return exit.length();
+        }
+
+        write_line_feed();
     }
 }
 
@@ -438,27 +492,36 @@ BOOL WINAPI host_cmd::read_console(
     if (max_chars == 1)
         return single_char_read(input, chars, max_chars, read_in, control);
 
+    // Re-arm full write inspection; the next prompt comes after this read.
+    // Single-character reads deliberately don't re-arm, so check_auto_answer
+    // can still see what was written before them.
+    s_writes_since_read = 0;
+    ++s_read_generation;
+
     // Sometimes cmd.exe wants line input for reasons other than command entry.
     const wchar_t* prompt = host_cmd::get()->m_prompt.get();
     if (prompt == nullptr || *prompt == L'\0')
         return ReadConsoleW(input, chars, max_chars, read_in, control);
 
+    int written;
     {
         // Surround the entire edit_line() scope, otherwise any time Clink
         // doesn't read input fast enough the OS can handle processed input
         // while it's enabled between ReadConsoleInputW calls.
         console_config cc(input);
         reset_wcwidths();
-        host_cmd::get()->edit_line(prompt, chars, max_chars);
+        written = host_cmd::get()->edit_line(prompt, chars, max_chars);
     }
 
     // ReadConsole will also include the CRLF of the line that was input.
-    size_t len = max_chars - wcslen(chars);
-    wcsncat(chars, L"\x0d\x0a", len);
-    chars[max_chars - 1] = L'\0';
+    // edit_line() returned the length, so no re-measuring the line here.
+    const wchar_t crlf[] = L"\x0d\x0a";
+    for (int i = 0; i < 2 && written < int(max_chars) - 1; ++i)
+        chars[written++] = crlf[i];
+    chars[written] = L'\0';
 
     if (read_in != nullptr)
-        *read_in = (unsigned)wcslen(chars);
+        *read_in = (unsigned)written;
 
     return TRUE;
 }
@@ -471,8 +534,26 @@ BOOL WINAPI host_cmd::write_console(
     LPDWORD written,
     LPVOID unused)
 {
+    // Mid-stream writes can't be a prompt unless they begin with one of the
+    // tag characters, so once streaming is detected the hook degenerates to
+    // this tail call -- no exception frame, no GetFileType syscall, and no
+    // prompt capture.  It only fires while no prompt is captured, so the
+    // inspected path's behaviour (each non-tagged console write discards any
+    // captured prompt) is a no-op for every write it skips.  read_console()
+    // restores full inspection.
+    if (s_writes_since_read > c_passthrough_threshold &&
+        !host_cmd::get()->m_prompt.is_set() &&
+        chars != nullptr && to_write != 0 &&
+        chars[0] != g_prompt_tag_hidden[0] && chars[0] != g_prompt_tag[0])
+    {
+        s_capture_missed = true;
+        return WriteConsoleW(output, chars, to_write, written, unused);
+    }
+
     seh_scope seh;
 
+    ++s_writes_since_read;
+
     // if the output handle isn't a console handle then go the default route.
     if (GetFileType(output) != FILE_TYPE_CHAR)
         return WriteConsoleW(output, chars, to_write, written, unused);
@@ -486,6 +567,10 @@ BOOL WINAPI host_cmd::write_console(
         return TRUE;
     }
 
+    // Capture is only consumed by auto-answer; skip the copy otherwise.
+    if (g_autoanswer.get() > 0)
+        capture_write_tail(chars, to_write);
+
     return WriteConsoleW(output, chars, to_write, written, unused);
 }
 
@@ -29,7 +29,7 @@ private:
     bool                initialise_system();
     virtual void        initialise_lua(lua_state& lua) override;
     virtual void        initialise_editor_desc(line_editor::desc& desc) override;
-    void                edit_line(const wchar_t* prompt, wchar_t* chars, int max_chars);
+    int                 edit_line(const wchar_t* prompt, wchar_t* chars, int max_chars);
     bool                capture_prompt(const wchar_t* chars, int char_count);
     bool                is_interactive() const;
     tagged_prompt       m_prompt;
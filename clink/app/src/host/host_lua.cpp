@@ -8,9 +8,12 @@
 #include <core/globber.h>
 #include <core/os.h>
 #include <core/path.h>
+#include <core/settings.h>
 #include <core/str.h>
 #include <core/str_tokeniser.h>
 
+#include <lib/line_state.h>
+
 #include <vector>
 
 extern "C" {
@@ -77,14 +80,178 @@ extern "C" void use_clink_input_mode()
 
 
 
+//------------------------------------------------------------------------------
+static setting_bool g_lua_lazyscripts(
+    "lua.lazy_script_load",
+    "Defer loading completion scripts",
+    "When enabled, scripts that only register argmatchers aren't run during\n"
+    "injection.  Each such script is run the first time its command word is\n"
+    "actually seen in the input line.  Scripts that do anything else (prompt\n"
+    "filters, event handlers, generic generators, etc) always load immediately.",
+    false);
+
+//------------------------------------------------------------------------------
+static setting_bool g_lua_argmatcher_cache(
+    "lua.argmatcher_cache",
+    "Reuse compiled argmatchers across sessions",
+    "When enabled, scripts that only register argmatchers have their finished\n"
+    "parser tables saved to the profile directory and reinstalled directly on\n"
+    "later loads, skipping the script.  A cached script is rerun whenever its\n"
+    "file changes, or when its matchers use Lua functions (those can't be\n"
+    "saved).",
+    true);
+
 //------------------------------------------------------------------------------
 bool s_force_reload_scripts = false;
+static bool s_reload_even_if_unchanged = false;
+
+//------------------------------------------------------------------------------
+/// -name:  clink.reload
+/// -arg:   [force:boolean]
+/// Requests a reload of the Lua scripts, which happens at the start of the
+/// next edit prompt.  The reload is skipped when no script file has actually
+/// changed (each file's last write time is compared against when it was
+/// loaded, and the script directories are rescanned for added or removed
+/// files), so calling this periodically or from a file watcher is cheap.
+/// Pass <span class="arg">force</span> as true to reload even when no file
+/// has changed (e.g. when scripts depend on external state).
+int clink_reload(lua_State* state)
+{
+    s_force_reload_scripts = true;
+    if (lua_toboolean(state, 1))
+        s_reload_even_if_unchanged = true;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static bool get_script_time(const char* path, FILETIME& out)
+{
+    wstr<280> wpath(path);
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &fad))
+        return false;
+
+    out = fad.ftLastWriteTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Collects the command names a script registers argmatchers for, by scanning
+// the source text for clink.argmatcher() and clink.arg.register_parser()
+// calls with literal string arguments.  Returns false when the script's
+// registrations can't be determined from the text (e.g. a command name held
+// in a variable), in which case the script can't be deferred.
+static bool scan_argmatcher_commands(const char* text, std::vector<str_moveable>& commands)
+{
+    static const char* const c_registrars[] = {
+        "clink.argmatcher(",
+        "clink.arg.register_parser(",
+    };
+
+    for (const char* registrar : c_registrars)
+    {
+        size_t registrar_length = strlen(registrar);
+        for (const char* scan = strstr(text, registrar); scan != nullptr; scan = strstr(scan, registrar))
+        {
+            scan += registrar_length;
+
+            // Collect the call's leading literal string arguments; anything
+            // else (priorities, parsers) ends the argument scan.
+            while (true)
+            {
+                while (isspace((unsigned char)*scan))
+                    scan++;
+
+                // An anonymous argmatcher registers no command; fine.
+                if (*scan == ')')
+                    break;
+
+                char quote = *scan;
+                if (quote != '\"' && quote != '\'')
+                    return false;
+
+                const char* start = ++scan;
+                while (*scan && *scan != quote)
+                    scan++;
+                if (*scan == '\0')
+                    return false;
+
+                if (scan > start)
+                {
+                    str_moveable command;
+                    command.concat(start, int(scan - start));
+                    commands.push_back(std::move(command));
+                }
+
+                scan++;
+                while (isspace((unsigned char)*scan))
+                    scan++;
+                if (*scan != ',')
+                    break;
+                scan++;
+            }
+        }
+    }
+
+    return !commands.empty();
+}
+
+//------------------------------------------------------------------------------
+// Determines whether a script's only observable behaviour is registering
+// argmatchers for known command words, collecting those words.  Such scripts
+// can be deferred until their command word is actually seen
+// (lua.lazy_script_load), and can be satisfied from the compiled argmatcher
+// cache instead of being run (see arguments.lua).
+static bool scan_script(const char* path, std::vector<str_moveable>& commands)
+{
+    FILE* in = fopen(path, "rb");
+    if (in == nullptr)
+        return false;
+
+    fseek(in, 0, SEEK_END);
+    int size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+
+    if (size <= 0)
+    {
+        fclose(in);
+        return false;
+    }
+
+    str<4096> buffer;
+    buffer.reserve(size);
+    char* data = buffer.data();
+    bool ok = (fread(data, size, 1, in) == 1);
+    fclose(in);
+    if (!ok)
+        return false;
+    data[size] = '\0';
+
+    // Prompt filters, event handlers, generic generators, classifiers, and
+    // new settings all take effect at injection and disqualify the script.
+    static const char* const c_eager_apis[] = {
+        "clink.prompt",
+        "clink.on",
+        "clink.generator",
+        "clink.classifier",
+        "clink.register_match_generator",
+        "clink.match_display_filter",
+        "settings.add",
+    };
+    for (const char* api : c_eager_apis)
+        if (strstr(data, api) != nullptr)
+            return false;
+
+    return scan_argmatcher_commands(data, commands);
+}
 
 //------------------------------------------------------------------------------
 host_lua::host_lua()
 : m_generator(m_state)
 , m_classifier(m_state)
 {
+    m_generator.set_demand_loader(this);
+
     str<280> bin_path;
     app_context::get()->get_binaries_dir(bin_path);
 
@@ -122,6 +289,7 @@ void host_lua::load_scripts()
     load_scripts(script_path.c_str());
     m_prev_script_path = script_path.c_str();
     s_force_reload_scripts = false;
+    s_reload_even_if_unchanged = false;
 }
 
 //------------------------------------------------------------------------------
@@ -130,7 +298,11 @@ bool host_lua::load_scripts(const char* paths)
     if (paths == nullptr || paths[0] == '\0')
         return false;
 
+    m_deferred_scripts.clear();
+    m_loaded_scripts.clear();
+
     bool first = true;
+    bool lazy = g_lua_lazyscripts.get();
 
     str<280> token;
     str_tokeniser tokens(paths, ";");
@@ -151,13 +323,13 @@ bool host_lua::load_scripts(const char* paths)
                 m_state.do_file(clink.c_str());
         }
 
-        load_script(token.c_str());
+        load_script(token.c_str(), lazy);
     }
     return true;
 }
 
 //------------------------------------------------------------------------------
-void host_lua::load_script(const char* path)
+void host_lua::load_script(const char* path, bool lazy)
 {
     str_moveable buffer;
     path::join(path, "*.lua", buffer);
@@ -168,9 +340,16 @@ void host_lua::load_script(const char* path)
 #if 1
     while (lua_globs.next(buffer))
     {
+        // Every globbed file is recorded (run, deferred, or skipped), so
+        // are_scripts_changed() can compare the whole collection.
+        record_script(buffer.c_str());
+
         const char* s = path::get_name(buffer.c_str());
         if (stricmp(s, "clink.lua") != 0)
-            m_state.do_file(buffer.c_str());
+        {
+            if (!lazy || !defer_script(buffer.c_str()))
+                run_script(buffer.c_str());
+        }
     }
 #else
     // This feels dangerous...
@@ -207,11 +386,187 @@ void host_lua::load_script(const char* path)
 #endif
 }
 
+//------------------------------------------------------------------------------
+// Tries to queue a script for on demand loading instead of running it now.
+// Only scripts whose observable behaviour is registering argmatchers for
+// known command words are deferred; anything else must take effect during
+// injection.
+bool host_lua::defer_script(const char* path)
+{
+    deferred_script script;
+    if (!scan_script(path, script.commands))
+        return false;
+
+    script.path.copy(path);
+    m_deferred_scripts.push_back(std::move(script));
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Runs a script file, unless it only registers argmatchers and the compiled
+// argmatcher cache still matches it -- then the cached parser graphs are
+// installed and the script isn't run at all.  A cold run of such a script
+// refreshes its cache entry afterwards, capturing the matchers before any
+// later script gets a chance to merge into them.
+void host_lua::run_script(const char* path)
+{
+    std::vector<str_moveable> commands;
+    if (!g_lua_argmatcher_cache.get() || !scan_script(path, commands))
+    {
+        m_state.do_file(path);
+        return;
+    }
+
+    if (call_argmatcher_cache("clink._load_argmatcher_cache", path, commands))
+        return;
+
+    if (m_state.do_file(path))
+        call_argmatcher_cache("clink._save_argmatcher_cache", path, commands);
+}
+
+//------------------------------------------------------------------------------
+// Calls one of the clink._load/_save_argmatcher_cache functions with a script
+// path and the command words it registers; returns the function's result
+// (loading reports whether the cached matchers were installed).
+bool host_lua::call_argmatcher_cache(const char* func_name, const char* path, const std::vector<str_moveable>& commands)
+{
+    lua_State* state = m_state.get_state();
+    save_stack_top ss(state);
+
+    if (!lua_state::push_named_function(state, func_name))
+        return false;
+
+    lua_pushstring(state, path);
+    lua_createtable(state, int(commands.size()), 0);
+    for (unsigned int i = 0; i < commands.size(); i++)
+    {
+        lua_pushlstring(state, commands[i].c_str(), commands[i].length());
+        lua_rawseti(state, -2, i + 1);
+    }
+
+    if (m_state.pcall(2, 1) != 0)
+        return false;
+
+    return lua_toboolean(state, -1) != 0;
+}
+
+//------------------------------------------------------------------------------
+void host_lua::on_generate(const line_state& line)
+{
+    if (m_deferred_scripts.empty())
+        return;
+
+    // Match how argmatchers get looked up; neither the command word's path
+    // nor its extension take part.
+    str<64> command_word;
+    if (!line.get_word(0, command_word) || command_word.empty())
+        return;
+
+    str<64> name(path::get_name(command_word.c_str()));
+    str<64> stem;
+    path::get_base_name(name.c_str(), stem);
+
+    for (unsigned int i = 0; i < m_deferred_scripts.size();)
+    {
+        const deferred_script& script = m_deferred_scripts[i];
+
+        bool hit = false;
+        for (const str_moveable& command : script.commands)
+            if (command.iequals(name.c_str()) || command.iequals(stem.c_str()))
+            {
+                hit = true;
+                break;
+            }
+
+        if (hit)
+        {
+            str_moveable script_path(std::move(m_deferred_scripts[i].path));
+            m_deferred_scripts.erase(m_deferred_scripts.begin() + i);
+            run_script(script_path.c_str());
+        }
+        else
+            i++;
+    }
+}
+
+//------------------------------------------------------------------------------
+void host_lua::record_script(const char* path)
+{
+    loaded_script script;
+    script.path.copy(path);
+    if (!get_script_time(path, script.time))
+        memset(&script.time, 0, sizeof(script.time));
+    m_loaded_scripts.push_back(std::move(script));
+}
+
+//------------------------------------------------------------------------------
+// Rescans the script directories and compares the collection against what was
+// loaded:  any added, removed, or rewritten file means a reload is needed.
+// Only runs when a reload has been requested, so the per-prompt path never
+// pays for the directory scans.
+bool host_lua::are_scripts_changed() const
+{
+    if (s_reload_even_if_unchanged)
+        return true;
+
+    str<280> script_path;
+    app_context::get()->get_script_path(script_path);
+    if (!script_path.iequals(m_prev_script_path.c_str()))
+        return true;
+
+    unsigned int seen = 0;
+
+    str<280> token;
+    str_tokeniser tokens(script_path.c_str(), ";");
+    while (tokens.next(token))
+    {
+        token.trim();
+
+        str_moveable buffer;
+        path::join(token.c_str(), "*.lua", buffer);
+
+        globber lua_globs(buffer.c_str());
+        lua_globs.directories(false);
+
+        while (lua_globs.next(buffer))
+        {
+            seen++;
+
+            const loaded_script* recorded = nullptr;
+            for (const loaded_script& script : m_loaded_scripts)
+                if (script.path.iequals(buffer.c_str()))
+                {
+                    recorded = &script;
+                    break;
+                }
+
+            if (recorded == nullptr)
+                return true;    // Added file.
+
+            FILETIME time;
+            if (!get_script_time(buffer.c_str(), time) ||
+                CompareFileTime(&time, &recorded->time) != 0)
+                return true;    // Rewritten file.
+        }
+    }
+
+    return seen != m_loaded_scripts.size(); // Removed file(s).
+}
+
 //------------------------------------------------------------------------------
 bool host_lua::is_script_path_changed() const
 {
     if (s_force_reload_scripts)
-        return true;
+    {
+        if (are_scripts_changed())
+            return true;
+
+        // Nothing changed; the requested reload would re-run every script to
+        // rebuild the exact same state.  Skip it, and stand down the request
+        // so subsequent prompts don't rescan the directories.
+        s_force_reload_scripts = false;
+        return false;
+    }
 
     str<280> script_path;
     app_context::get()->get_script_path(script_path);
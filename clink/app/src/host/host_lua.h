@@ -8,9 +8,11 @@
 #include <lua/lua_word_classifier.h>
 #include <lua/lua_state.h>
 #include <functional>
+#include <vector>
 
 //------------------------------------------------------------------------------
 class host_lua
+    : public lua_script_demand_loader
 {
 public:
                         host_lua();
@@ -27,10 +29,30 @@ public:
     bool                call_lua_rl_global_function(const char* func_name);
 
 private:
+    struct deferred_script
+    {
+        str_moveable    path;
+        std::vector<str_moveable> commands;
+    };
+
+    struct loaded_script
+    {
+        str_moveable    path;
+        FILETIME        time;
+    };
+
+    virtual void        on_generate(const line_state& line) override;
     bool                load_scripts(const char* paths);
-    void                load_script(const char* path);
+    void                load_script(const char* path, bool lazy);
+    bool                defer_script(const char* path);
+    void                run_script(const char* path);
+    bool                call_argmatcher_cache(const char* func_name, const char* path, const std::vector<str_moveable>& commands);
+    void                record_script(const char* path);
+    bool                are_scripts_changed() const;
     lua_state           m_state;
     lua_match_generator m_generator;
     lua_word_classifier m_classifier;
     str<>               m_prev_script_path;
+    std::vector<deferred_script> m_deferred_scripts;
+    std::vector<loaded_script> m_loaded_scripts;
 };
@@ -6,6 +6,7 @@
 
 #include <core/base.h>
 #include <core/str.h>
+#include <core/str_stream.h>
 #include <lua/lua_script_loader.h>
 #include <lua/lua_state.h>
 
@@ -113,25 +114,39 @@ void tagged_prompt::tag(const wchar_t* value)
         return;
     }
 
-    int length = int(wcslen(value));
-    length += int(wcslen(g_prompt_tag_hidden));
-
-    m_data = (wchar_t*)malloc(sizeof(*m_data) * (length + 1));
-    wcscpy(m_data, g_prompt_tag_hidden);
-    wcscat(m_data, value);
+    // Collect the segments and serialise once.
+    wstr_stream stream;
+    stream << wstr_stream::range(g_prompt_tag_hidden, (unsigned int)wcslen(g_prompt_tag_hidden));
+    stream << wstr_stream::range(value, (unsigned int)wcslen(value));
+    m_data = stream.detach();
 }
 
 //------------------------------------------------------------------------------
 int tagged_prompt::is_tagged(const wchar_t* chars, int char_count)
 {
+    // This runs for every console write cmd.exe makes (the WriteConsoleW
+    // hook funnels them all through here), so bail out cheaply when the
+    // write can't possibly begin with a tag.  The tags are anchored at the
+    // start of the prompt, so testing the first character is enough; bulk
+    // command output (e.g. a large 'dir' listing) takes this path.
+    if (chars[0] != g_prompt_tag_hidden[0] && chars[0] != g_prompt_tag[0])
+        return 0;
+
     if (char_count <= 0)
         char_count = int(wcslen(chars));
 
+    // The tags are constant; measure them once instead of per write.
+    static const int tag_lengths[] = {
+        int(wcslen(g_prompt_tags[0])),
+        int(wcslen(g_prompt_tags[1])),
+    };
+    static_assert(sizeof_array(tag_lengths) == sizeof_array(g_prompt_tags), "tag_lengths out of sync");
+
     // For each accepted tag...
     for (int i = 0; i < sizeof_array(g_prompt_tags); ++i)
     {
         const wchar_t* tag = g_prompt_tags[i];
-        int tag_length = (int)wcslen(tag);
+        int tag_length = tag_lengths[i];
 
         if (tag_length > char_count)
             continue;
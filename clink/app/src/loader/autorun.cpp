@@ -84,6 +84,92 @@ static HKEY open_cmd_proc_key(int all_users, int wow64, int writable)
     return open_software_key(all_users, "Microsoft\\Command Processor", wow64, writable);
 }
 
+//------------------------------------------------------------------------------
+// Cached snapshot of the AutoRun values.  One invocation reads the same keys
+// several times -- install re-reads what uninstall just rewrote, and every
+// successful verb re-reads all four variants for the feedback display -- so
+// repeated queries are served from memory.  Each cached key keeps a read
+// handle open with a RegNotifyChangeKeyValue subscription, so a change made
+// by our own writes or by anything else drops the cached value instead of
+// serving it stale.
+class autorun_snapshot
+{
+public:
+                    ~autorun_snapshot();
+    bool            get(int all_users, int wow64, char** out);
+    void            invalidate(int all_users, int wow64);
+
+private:
+    struct entry
+    {
+        HKEY        key = nullptr;
+        HANDLE      event = nullptr;
+        char*       value = nullptr;
+        bool        valid = false;
+    };
+    entry           m_entries[2][2];
+};
+
+static autorun_snapshot g_autorun_snapshot;
+
+//------------------------------------------------------------------------------
+autorun_snapshot::~autorun_snapshot()
+{
+    for (auto& row : m_entries)
+        for (entry& e : row)
+        {
+            if (e.key != nullptr)
+                close_key(e.key);
+            if (e.event != nullptr)
+                CloseHandle(e.event);
+            free(e.value);
+        }
+}
+
+//------------------------------------------------------------------------------
+// On success '*out' receives a malloc'd copy of the AutoRun value, or nullptr
+// when the value is unset, matching get_value()'s contract.
+bool autorun_snapshot::get(int all_users, int wow64, char** out)
+{
+    entry& e = m_entries[!!all_users][!!wow64];
+
+    // A signalled notification means the key changed since the snapshot.
+    if (e.valid && e.event != nullptr &&
+        WaitForSingleObject(e.event, 0) == WAIT_OBJECT_0)
+        e.valid = false;
+
+    if (!e.valid)
+    {
+        if (e.key == nullptr)
+            e.key = open_cmd_proc_key(all_users, wow64, 0);
+        if (e.key == nullptr)
+            return false;
+
+        free(e.value);
+        e.value = nullptr;
+        get_value(e.key, "AutoRun", &e.value);
+        e.valid = true;
+
+        // (Re)arm the change notification; it needs rearming after each
+        // signal.  If this fails the entry just refreshes on every read.
+        if (e.event == nullptr)
+            e.event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        if (e.event != nullptr)
+            RegNotifyChangeKeyValue(e.key, FALSE, REG_NOTIFY_CHANGE_LAST_SET, e.event, TRUE);
+    }
+
+    *out = (e.value != nullptr) ? _strdup(e.value) : nullptr;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Writes go through separate key handles; invalidating explicitly keeps the
+// feedback display correct even if the notification lags the write.
+void autorun_snapshot::invalidate(int all_users, int wow64)
+{
+    m_entries[!!all_users][!!wow64].valid = false;
+}
+
 //------------------------------------------------------------------------------
 static bool check_registry_access()
 {
@@ -196,7 +282,8 @@ static int uninstall_autorun(const char* clink_path, int wow64)
     }
 
     key_value = nullptr;
-    get_value(cmd_proc_key, "AutoRun", &key_value);
+    if (!g_autorun_snapshot.get(g_all_users, wow64, &key_value))
+        get_value(cmd_proc_key, "AutoRun", &key_value);
 
     ret = 0;
     if (key_value && find_clink_entry(key_value, &left, &right))
@@ -233,6 +320,7 @@ static int uninstall_autorun(const char* clink_path, int wow64)
     }
 
     // Tidy up.
+    g_autorun_snapshot.invalidate(g_all_users, wow64);
     close_key(cmd_proc_key);
     free(key_value);
     return ret;
@@ -260,7 +348,8 @@ static int install_autorun(const char* clink_path, int wow64)
     }
 
     key_value = nullptr;
-    get_value(cmd_proc_key, "AutoRun", &key_value);
+    if (!g_autorun_snapshot.get(g_all_users, wow64, &key_value))
+        get_value(cmd_proc_key, "AutoRun", &key_value);
 
     i = key_value ? (int)strlen(key_value) : 0;
     i += 2048;
@@ -282,6 +371,7 @@ static int install_autorun(const char* clink_path, int wow64)
         i = 1;
 
     // Tidy up.
+    g_autorun_snapshot.invalidate(g_all_users, wow64);
     close_key(cmd_proc_key);
     free(new_value.data());
     free(key_value);
@@ -303,25 +393,18 @@ static int show_autorun()
 
         for (wow64 = 0; wow64 < 2; ++wow64)
         {
-            HKEY cmd_proc_key;
             char* key_value;
-
-            cmd_proc_key = open_cmd_proc_key(all_users, wow64, 0);
-            if (cmd_proc_key == nullptr)
+            if (!g_autorun_snapshot.get(all_users, wow64, &key_value))
             {
                 printf("ERROR: Failed to open registry key (%d)\n", GetLastError());
                 return 1;
             }
 
-            key_value = nullptr;
-            get_value(cmd_proc_key, "AutoRun", &key_value);
-
             printf("\n    %6s : %s",
                     wow64     ? " wow64"  : "native",
                     key_value ? key_value : "<unset>"
                   );
 
-            close_key(cmd_proc_key);
             free(key_value);
         }
 
@@ -348,6 +431,7 @@ static int set_autorun_value(const char* value, int wow64)
     else
         ret = !set_value(cmd_proc_key, "AutoRun", value);
 
+    g_autorun_snapshot.invalidate(g_all_users, wow64);
     close_key(cmd_proc_key);
     return ret;
 }
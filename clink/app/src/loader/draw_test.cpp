@@ -3,11 +3,13 @@
 
 #include "pch.h"
 
+#include <core/str.h>
 #include <core/str_iter.h>
 #include <lib/line_editor.h>
 #include <terminal/terminal.h>
 #include <terminal/terminal_in.h>
 #include <terminal/terminal_out.h>
+#include <terminal/printer.h>
 
 #include <Windows.h>
 #include <xmmintrin.h>
@@ -349,8 +351,143 @@ void runner::line_test()
 
 
 //------------------------------------------------------------------------------
-int draw_test(int, char**)
+// Terminal throughput benchmark.  Renders synthetic workloads through the
+// real output stack (printer -> ecma48 emulation -> console) and reports
+// bytes/sec and calls/sec, so the conhost, ConEmu, and Windows Terminal
+// hosts clink deploys on can be compared by running the same build in each.
+class draw_bench
 {
+public:
+    void            go();
+
+private:
+    void            report(const char* name, unsigned int calls, unsigned long long bytes, long long ticks);
+    void            run_workload(const char* name, const char* payload, int length, unsigned int calls);
+    void            wrapped_colored_lines();
+    void            partial_updates();
+    void            scroll_storm();
+    test_console    m_console;
+    terminal        m_terminal;
+    long long       m_frequency;
+};
+
+//------------------------------------------------------------------------------
+void draw_bench::go()
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    m_frequency = frequency.QuadPart;
+
+    m_console.resize(80, 25);
+
+    m_terminal = terminal_create();
+    m_terminal.out->begin();
+
+    wrapped_colored_lines();
+    partial_updates();
+    scroll_storm();
+
+    m_terminal.out->end();
+    terminal_destroy(m_terminal);
+}
+
+//------------------------------------------------------------------------------
+void draw_bench::report(const char* name, unsigned int calls, unsigned long long bytes, long long ticks)
+{
+    double seconds = double(ticks) / double(m_frequency);
+    if (seconds <= 0.0)
+        seconds = 1.0 / double(m_frequency);
+
+    // The active screen buffer is the benchmark console; report on stderr so
+    // the numbers land in the user's console (and can be redirected).
+    fprintf(stderr, "%-16s %10u calls  %12llu bytes  %9.0f calls/sec  %7.2f MB/sec\n",
+            name, calls, bytes,
+            double(calls) / seconds,
+            double(bytes) / seconds / (1024.0 * 1024.0));
+}
+
+//------------------------------------------------------------------------------
+void draw_bench::run_workload(const char* name, const char* payload, int length, unsigned int calls)
+{
+    terminal_out& output = *m_terminal.out;
+
+    // One untimed pass warms the emulation's code cache and the console.
+    output.write(payload, length);
+    output.flush();
+
+    LARGE_INTEGER start, stop;
+    QueryPerformanceCounter(&start);
+    for (unsigned int i = 0; i < calls; ++i)
+        output.write(payload, length);
+    output.flush();
+    QueryPerformanceCounter(&stop);
+
+    report(name, calls, (unsigned long long)length * calls, stop.QuadPart - start.QuadPart);
+}
+
+//------------------------------------------------------------------------------
+// Colored text that wraps across several screen lines, like a prompt filter
+// or clink.print dumping a long annotated line.
+void draw_bench::wrapped_colored_lines()
+{
+    static const char* const colors[] = { "\x1b[31m", "\x1b[33;1m", "\x1b[36m", "\x1b[0m" };
+
+    str<512> payload;
+    payload << "\x1b[1;1H";
+    for (int i = 0; payload.length() < 300; ++i)
+        payload << colors[i % sizeof_array(colors)] << "lorem_ipsum_" << "0123456789 ";
+    payload << "\x1b[0m";
+
+    run_workload("wrapped color", payload.c_str(), payload.length(), 2000);
+}
+
+//------------------------------------------------------------------------------
+// Small repaints at a fixed position, like cursor movement and single-cell
+// edits during line editing.
+void draw_bench::partial_updates()
+{
+    static const char payload[] = "\x1b[12;20H\x1b[7mX\x1b[27myz";
+    run_workload("partial update", payload, sizeof_array(payload) - 1, 20000);
+}
+
+//------------------------------------------------------------------------------
+// Full-width lines fed at the bottom of the screen so every write scrolls,
+// like bursts of command output.
+void draw_bench::scroll_storm()
+{
+    str<128> payload;
+    payload << "\x1b[25;1H";
+    while (payload.length() < 86)
+        payload << "scroll...";
+    payload << "\n";
+
+    run_workload("scroll storm", payload.c_str(), payload.length(), 5000);
+}
+
+//------------------------------------------------------------------------------
+int draw_test(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        if (_stricmp(arg, "--help") == 0 || _stricmp(arg, "-h") == 0)
+        {
+            extern const char* g_clink_header;
+            puts(g_clink_header);
+            printf("Usage: %s [--bench]\n\n", argv[0]);
+            puts("Exercises terminal drawing.  By default steps through manual drawing\n"
+                 "tests.  With --bench, renders synthetic workloads (wrapped colored\n"
+                 "lines, rapid partial updates, scroll storms) through the output stack\n"
+                 "and reports bytes/sec and calls/sec, for comparing console hosts.");
+            return 0;
+        }
+        if (_stricmp(arg, "--bench") == 0)
+        {
+            draw_bench().go();
+            return 0;
+        }
+    }
+
     runner().go();
     return 0;
 }
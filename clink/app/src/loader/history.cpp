@@ -50,63 +50,134 @@ static bool is_console(HANDLE h)
 }
 
 //------------------------------------------------------------------------------
-static void print_history(unsigned int tail_count)
+// Batches export output into large writes.  Printing a big history is
+// dominated by the per-line write calls (a WriteConsoleW round trip, or a CRT
+// write per line when redirected), so lines accumulate into a chunk which is
+// flushed wholesale.
+class history_export_stream
+{
+public:
+                    history_export_stream();
+                    ~history_export_stream() { flush(); }
+    void            add(const char* chars);
+    void            flush();
+
+private:
+    // Stay comfortably below the ~64KB per-call limit WriteConsoleW has on
+    // some systems.
+    static const unsigned int chunk_size = 32 * 1024;
+
+    HANDLE          m_handle;
+    bool            m_translate;
+    str<>           m_utf8;
+    wstr<>          m_utf16;
+};
+
+//------------------------------------------------------------------------------
+history_export_stream::history_export_stream()
+: m_handle(GetStdHandle(STD_OUTPUT_HANDLE))
+, m_translate(is_console(m_handle))
+{
+    if (m_translate)
+        m_utf16.reserve(chunk_size + 1024);
+    else
+        m_utf8.reserve(chunk_size + 1024);
+}
+
+//------------------------------------------------------------------------------
+void history_export_stream::add(const char* chars)
+{
+    if (m_translate)
+    {
+        // Translate to UTF16, and also translate control characters.
+        for (const char* walk = chars; *walk;)
+        {
+            const char* begin = walk;
+            while (*walk >= 0x20 || *walk == 0x09)
+                walk++;
+            if (walk > begin)
+                to_utf16(m_utf16, str_iter(begin, int(walk - begin)));
+            if (!*walk)
+                break;
+            wchar_t ctrl[3] = { '^', wchar_t(*walk + 'A' - 1) };
+            m_utf16.concat(ctrl, 2);
+            walk++;
+        }
+
+        m_utf16.concat(L"\r\n", 2);
+        if (m_utf16.length() >= chunk_size)
+            flush();
+    }
+    else
+    {
+        m_utf8 << chars << "\n";
+        if (m_utf8.length() >= chunk_size)
+            flush();
+    }
+}
+
+//------------------------------------------------------------------------------
+void history_export_stream::flush()
+{
+    if (m_translate)
+    {
+        DWORD written;
+        if (m_utf16.length())
+            WriteConsoleW(m_handle, m_utf16.c_str(), m_utf16.length(), &written, nullptr);
+        m_utf16.clear();
+    }
+    else
+    {
+        if (m_utf8.length())
+            fwrite(m_utf8.c_str(), m_utf8.length(), 1, stdout);
+        m_utf8.clear();
+    }
+}
+
+//------------------------------------------------------------------------------
+// Prints 'count' lines starting after the first 'skip' lines; when 'tail' is
+// set 'skip' is derived so the window covers the last 'count' lines instead.
+static void print_history(unsigned int skip, unsigned int count, bool tail)
 {
     history_scope history;
 
     str_iter line;
-    history_read_buffer buffer;
+    history_read_buffer buffer(history_read_buffer::sequential);
 
-    int count = 0;
+    if (tail)
     {
+        unsigned int total = 0;
         history_db::iter iter = history->read_lines(buffer.data(), buffer.size());
         while (iter.next(line))
-            ++count;
+            ++total;
+        skip = (total > count) ? total - count : 0;
     }
 
-    int index = 1;
+    unsigned int index = 1;
     history_db::iter iter = history->read_lines(buffer.data(), buffer.size());
+    for (; skip && iter.next(line); --skip, ++index);
 
-    int skip = count - tail_count;
-    for (int i = 0; i < skip; ++i, ++index, iter.next(line));
+    history_export_stream out;
 
     str<> utf8;
-    wstr<> utf16;
-    HANDLE hout = GetStdHandle(STD_OUTPUT_HANDLE);
-    bool translate = is_console(hout);
-
-    for (; iter.next(line); ++index)
+    for (; count && iter.next(line); --count, ++index)
     {
         utf8.clear();
         utf8.format("%5d  %.*s", index, line.length(), line.get_pointer());
-        if (translate)
-        {
-            DWORD written;
-            utf16.clear();
+        out.add(utf8.c_str());
+    }
+}
 
-            // Translate to UTF16, and also translate control characters.
-            for (const char* walk = utf8.c_str(); *walk;)
-            {
-                const char* begin = walk;
-                while (*walk >= 0x20 || *walk == 0x09)
-                    walk++;
-                if (walk > begin)
-                    to_utf16(utf16, str_iter(begin, int(walk - begin)));
-                if (!*walk)
-                    break;
-                wchar_t ctrl[3] = { '^', wchar_t(*walk + 'A' - 1) };
-                utf16.concat(ctrl, 2);
-                walk++;
-            }
+//------------------------------------------------------------------------------
+static bool is_uint(const char* arg, unsigned int& out)
+{
+    // Check the argument is just digits.
+    for (const char* c = arg; *c; ++c)
+        if (unsigned(*c - '0') > 10)
+            return false;
 
-            utf16.concat(L"\r\n", 2);
-            WriteConsoleW(hout, utf16.c_str(), utf16.length(), &written, nullptr);
-        }
-        else
-        {
-            puts(utf8.c_str());
-        }
-    }
+    out = unsigned(atoi(arg));
+    return true;
 }
 
 //------------------------------------------------------------------------------
@@ -114,16 +185,15 @@ static bool print_history(const char* arg)
 {
     if (arg == nullptr)
     {
-        print_history(INT_MIN);
+        print_history(0, unsigned(-1), false/*tail*/);
         return true;
     }
 
-    // Check the argument is just digits.
-    for (const char* c = arg; *c; ++c)
-        if (unsigned(*c - '0') > 10)
-            return false;
+    unsigned int count;
+    if (!is_uint(arg, count))
+        return false;
 
-    print_history(atoi(arg));
+    print_history(0, count, true/*tail*/);
     return true;
 }
 
@@ -200,6 +270,7 @@ static int print_help()
 
     static const char* const help[] = {
         "[n]",          "Print history items (only the last N items if specified).",
+        "[start n]",    "Print N history items starting at 1-based item START.",
         "clear",        "Completely clears the command history.",
         "compact",      "Compacts the history file.",
         "delete <n>",   "Delete Nth item (negative N indexes history backwards).",
@@ -323,6 +394,18 @@ int history(int argc, char** argv)
         }
     }
 
+    // Two numeric arguments select a window into the history; a 1-based
+    // start item and a count.
+    if (argc == 3)
+    {
+        unsigned int start, count;
+        if (!is_uint(argv[1], start) || !is_uint(argv[2], count) || !start)
+            return print_help();
+
+        print_history(start - 1, count, false/*tail*/);
+        return 0;
+    }
+
     // Failing all else try to display the history.
     if (argc > 2)
         return print_help();
@@ -9,6 +9,8 @@
 #include <core/settings.h>
 #include <core/os.h>
 #include <core/path.h>
+#include <core/perf_counters.h>
+#include <core/globber.h>
 
 //------------------------------------------------------------------------------
 int clink_info(int argc, char** argv)
@@ -91,5 +93,70 @@ int clink_info(int argc, char** argv)
         }
     }
 
+    // Per-session memory reports, written by interactive sessions when the
+    // clink.memory_stats setting is enabled.
+    {
+        str<280> pattern;
+        context->get_state_dir(pattern);
+        path::append(pattern, "clink_memory_*");
+
+        globber globber(pattern.c_str());
+        str<280> file;
+        bool first = true;
+        while (globber.next(file))
+        {
+            printf("%-*s : %s\n", spacing, first ? "memory" : "", file.c_str());
+            first = false;
+
+            FILE* f = fopen(file.c_str(), "rt");
+            if (f == nullptr)
+                continue;
+
+            char line[128];
+            while (fgets(line, sizeof_array(line), f))
+                printf("%-*s     %s", spacing, "", line);
+            fclose(f);
+        }
+    }
+
+    // Per-session match generator statistics, written by interactive sessions
+    // when the clink.generator_stats setting is enabled.
+    {
+        str<280> pattern;
+        context->get_state_dir(pattern);
+        path::append(pattern, "clink_generators_*");
+
+        globber globber(pattern.c_str());
+        str<280> file;
+        bool first = true;
+        while (globber.next(file))
+        {
+            printf("%-*s : %s\n", spacing, first ? "genstats" : "", file.c_str());
+            first = false;
+
+            FILE* f = fopen(file.c_str(), "rt");
+            if (f == nullptr)
+                continue;
+
+            // Lines carry script paths, so they run longer than the memory
+            // report's.
+            char line[512];
+            while (fgets(line, sizeof_array(line), f))
+                printf("%-*s     %s", spacing, "", line);
+            fclose(f);
+        }
+    }
+
+#if CLINK_PERF_COUNTERS
+    // Allocation counters for this loader process; interactive sessions see
+    // the same counters through clink.perfcounters().
+    for (int i = 0; i < perf_counters::count; ++i)
+    {
+        const auto c = perf_counters::counter(i);
+        printf("%-*s : %s = %llu\n", spacing, i ? "" : "counters",
+               perf_counters::get_name(c), perf_counters::get(c));
+    }
+#endif
+
     return 0;
 }
@@ -167,10 +167,9 @@ static int check_dll_version(const char* clink_dll)
 }
 
 //------------------------------------------------------------------------------
-static void* inject_dll(DWORD target_pid)
+static bool prepare_dll(str_base& dll_path)
 {
     // Get path to clink's DLL that we'll inject.
-    str<280> dll_path;
     process().get_file_name(dll_path);
     path::get_directory(dll_path);
     path::append(dll_path, CLINK_DLL);
@@ -204,18 +203,14 @@ static void* inject_dll(DWORD target_pid)
     LOG("Arch: x%s", AS_STR(ARCHITECTURE));
     LOG("DLL: %s", dll_path.c_str());
 
-    LOG("Parent pid: %d", target_pid);
-
     // Check Dll's version.
     if (!check_dll_version(dll_path.c_str()))
     {
         ERR("DLL failed version check.");
-        return 0;
+        return false;
     }
 
-    // Inject Clink DLL.
-    process cmd_process(target_pid);
-    return cmd_process.inject_module(dll_path.c_str());
+    return true;
 }
 
 //------------------------------------------------------------------------------
@@ -266,6 +261,69 @@ static DWORD find_inject_target()
     return 0;
 }
 
+//------------------------------------------------------------------------------
+static int inject_one(
+    DWORD target_pid,
+    const char* dll_path,
+    uintptr_t init_offset,
+    const app_context::desc& app_desc)
+{
+    LOG("Target pid: %d", target_pid);
+
+    // Check to see if clink is already installed.
+    if (is_clink_present(target_pid))
+    {
+        if (app_desc.script_path[0])
+        {
+            // Get the address to SetEnvironmentVariableW directly from
+            // kernel32.dll's export table.  If our import table has had
+            // SetEnvironmentVariableW hooked then we'd get a potentially
+            // invalid address if we were to just use &SetEnvironmentVariableW.
+            pe_info kernel32(LoadLibrary("kernel32.dll"));
+            pe_info::funcptr_t func = kernel32.get_export("SetEnvironmentVariableW");
+
+            struct string_struct
+            {
+                wchar_t s[sizeof_array(app_desc.script_path)];
+            };
+
+            string_struct value = {};
+            wstr_base script_path(value.s);
+            to_utf16(script_path, app_desc.script_path);
+
+            process(target_pid).remote_call(func, L"=clink.scripts.inject", value);
+        }
+        return 1;
+    }
+
+    // Inject Clink's DLL
+    void* remote_dll_base = process(target_pid).inject_module(dll_path);
+    if (remote_dll_base == nullptr)
+        return 1;
+
+    // Remotely call Clink's initialisation function.
+    uintptr_t init_func = uintptr_t(remote_dll_base) + init_offset;
+    return (process(target_pid).remote_call((process::funcptr_t)init_func, app_desc) == nullptr);
+}
+
+//------------------------------------------------------------------------------
+struct inject_job
+{
+    DWORD                       pid;
+    const char*                 dll_path;
+    uintptr_t                   init_offset;
+    const app_context::desc*    app_desc;
+    int                         result;
+};
+
+//------------------------------------------------------------------------------
+static DWORD WINAPI inject_thread_proc(void* param)
+{
+    inject_job* job = (inject_job*)param;
+    job->result = inject_one(job->pid, job->dll_path, job->init_offset, *job->app_desc);
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 void get_profile_path(const char* in, str_base& out)
 {
@@ -298,6 +356,7 @@ int inject(int argc, char** argv)
         { "quiet",       no_argument,        nullptr, 'q' },
         { "pid",         required_argument,  nullptr, 'd' },
         { "nolog",       no_argument,        nullptr, 'l' },
+        { "binarylog",   no_argument,        nullptr, 'b' },
         { "autorun",     no_argument,        nullptr, '_' },
         { "help",        no_argument,        nullptr, 'h' },
         { nullptr, 0, nullptr, 0 }
@@ -307,20 +366,22 @@ int inject(int argc, char** argv)
         "-s, --scripts <path>", "Alternative path to load .lua scripts from.",
         "-p, --profile <path>", "Specifies an alternative path for profile data.",
         "-q, --quiet",          "Suppress copyright output.",
-        "-d, --pid <pid>",      "Inject into the process specified by <pid>.",
+        "-d, --pid <pid>",      "Inject into the process specified by <pid> (repeatable).",
         "-l, --nolog",          "Disable file logging.",
+        "-b, --binarylog",      "Log binary records; view with 'clink log decode'.",
         "-h, --help",           "Shows this help text.",
     };
 
     extern const char* g_clink_header;
 
     // Parse arguments
-    DWORD target_pid = 0;
+    DWORD target_pids[16];
+    unsigned int target_count = 0;
     app_context::desc app_desc;
     int i;
     int ret = 1;
     bool is_autorun = false;
-    while ((i = getopt_long(argc, argv, "lqhp:s:d:", options, nullptr)) != -1)
+    while ((i = getopt_long(argc, argv, "blqhp:s:d:", options, nullptr)) != -1)
     {
         switch (i)
         {
@@ -345,13 +406,21 @@ int inject(int argc, char** argv)
             break;
 
         case 'q': app_desc.quiet = true;        break;
-        case 'd': target_pid = atoi(optarg);    break;
         case '_': ret = 0; is_autorun = true;   break;
 
+        case 'd':
+            if (target_count < sizeof_array(target_pids))
+                target_pids[target_count++] = atoi(optarg);
+            break;
+
         case 'l':
             app_desc.log = false;
             break;
 
+        case 'b':
+            app_desc.binary_log = true;
+            break;
+
         case '?':
             return ret;
 
@@ -367,51 +436,60 @@ int inject(int argc, char** argv)
 
     // Unless a target pid was specified on the command line search for a
     // compatible parent process.
-    if (target_pid == 0)
+    if (target_count == 0)
     {
-        if (!(target_pid = find_inject_target()))
+        if (!(target_pids[target_count++] = find_inject_target()))
         {
             LOG("Failed to find parent pid.");
             return ret;
         }
     }
 
-    // Check to see if clink is already installed.
-    if (is_clink_present(target_pid))
-    {
-        if (app_desc.script_path[0])
-        {
-            // Get the address to SetEnvironmentVariableW directly from
-            // kernel32.dll's export table.  If our import table has had
-            // SetEnvironmentVariableW hooked then we'd get a potentially
-            // invalid address if we were to just use &SetEnvironmentVariableW.
-            pe_info kernel32(LoadLibrary("kernel32.dll"));
-            pe_info::funcptr_t func = kernel32.get_export("SetEnvironmentVariableW");
+    // Prepare the DLL once; the cached copy and version check are shared by
+    // every target.
+    str<280> dll_path;
+    if (!prepare_dll(dll_path))
+        return ret;
 
-            struct string_struct
-            {
-                wchar_t s[sizeof_array(app_desc.script_path)];
-            };
+    // The initialisation function's offset from the DLL base is the same in
+    // every process; only the remote base address differs per target.
+    void* our_dll_base = vm().get_alloc_base("");
+    uintptr_t init_offset = uintptr_t(initialise_clink) - uintptr_t(our_dll_base);
 
-            string_struct value = {};
-            wstr_base script_path(value.s);
-            to_utf16(script_path, app_desc.script_path);
+    if (target_count == 1)
+        ret = inject_one(target_pids[0], dll_path.c_str(), init_offset, app_desc);
+    else
+    {
+        // Multiple targets get injected concurrently; each injection mostly
+        // waits on the target process, so they overlap well.
+        inject_job jobs[sizeof_array(target_pids)];
+        HANDLE threads[sizeof_array(target_pids)];
+        unsigned int thread_count = 0;
 
-            process(target_pid).remote_call(func, L"=clink.scripts.inject", value);
+        for (unsigned int i = 0; i < target_count; ++i)
+        {
+            inject_job& job = jobs[i];
+            job.pid = target_pids[i];
+            job.dll_path = dll_path.c_str();
+            job.init_offset = init_offset;
+            job.app_desc = &app_desc;
+            job.result = 1;
+
+            HANDLE thread = CreateThread(nullptr, 0, inject_thread_proc, &job, 0, nullptr);
+            if (thread != nullptr)
+                threads[thread_count++] = thread;
+            else
+                inject_thread_proc(&job);
         }
-        return ret;
-    }
 
-    // Inject Clink's DLL
-    void* remote_dll_base = inject_dll(target_pid);
-    if (remote_dll_base == nullptr)
-        return ret;
+        WaitForMultipleObjects(thread_count, threads, TRUE, INFINITE);
+        for (unsigned int i = 0; i < thread_count; ++i)
+            CloseHandle(threads[i]);
 
-    // Remotely call Clink's initialisation function.
-    void* our_dll_base = vm().get_alloc_base("");
-    uintptr_t init_func = uintptr_t(remote_dll_base);
-    init_func += uintptr_t(initialise_clink) - uintptr_t(our_dll_base);
-    ret = (process(target_pid).remote_call((process::funcptr_t)init_func, app_desc) == nullptr);
+        ret = 0;
+        for (unsigned int i = 0; i < target_count; ++i)
+            ret |= jobs[i].result;
+    }
 
     return is_autorun ? 0 : ret;
 }
@@ -3,6 +3,7 @@
 
 #include "pch.h"
 
+#include <core/base.h>
 #include <core/str.h>
 #include <core/settings.h>
 #include <terminal/terminal.h>
@@ -45,40 +46,62 @@ int input_echo(int argc, char** argv)
     input.begin();
 
     bool quit = false;
+    str<512> out;
     while (!quit)
     {
         input.select();
 
-        bool need_quote = true;
-        while (1)
+        // Drain every key that's already waiting before writing anything, so
+        // key repeat and paste bursts cost one console write instead of one
+        // per character; on laggy consoles the writes are what can't keep up.
+        out.clear();
+        do
         {
-            int c = input.read();
-            if (c < 0)
-                break;
-
-            if (need_quote)
+            bool need_quote = true;
+            while (1)
             {
-                need_quote = false;
-                printf("\"");
+                int c = input.read();
+                if (c < 0)
+                    break;
+
+                if (need_quote)
+                {
+                    need_quote = false;
+                    out << "\"";
+                }
+
+                if (c > 0x7f)
+                {
+                    static const char hex[] = "0123456789abcdef";
+                    out << "\\x";
+                    out.concat(&hex[(c >> 4) & 0x0f], 1);
+                    out.concat(&hex[c & 0x0f], 1);
+                }
+                else if (c == 0x1b)
+                    out << "\\e";
+                else if (c < 0x20)
+                {
+                    const char ctrl[] = { '\\', 'C', '-', char(c|0x40) };
+                    out.concat(ctrl, sizeof_array(ctrl));
+                }
+                else
+                {
+                    const char ch = char(c);
+                    out.concat(&ch, 1);
+                }
+
+                if (quit = (c == ('C' & 0x1f))) // Ctrl-c
+                    break;
             }
 
-            if (c > 0x7f)
-                printf("\\x%02x", unsigned(c));
-            else if (c == 0x1b)
-                printf("\\e");
-            else if (c < 0x20)
-                printf("\\C-%c", c|0x40);
-            else
-                printf("%c", c);
-
-            if (quit = (c == ('C' & 0x1f))) // Ctrl-c
-                break;
-        }
+            if (!need_quote)
+                out << "\"";
 
-        if (!need_quote)
-            printf("\"");
+            out << "\n";
+        }
+        while (!quit && input.more_input_available());
 
-        puts("");
+        fputs(out.c_str(), stdout);
     }
 
     input.end();
@@ -20,6 +20,7 @@ int draw_test(int, char**);
 int history(int, char**);
 int inject(int, char**);
 int input_echo(int, char**);
+int clink_log(int, char**);
 int set(int, char**);
 int installscripts(int, char**);
 int uninstallscripts(int, char**);
@@ -57,6 +58,7 @@ static void show_usage()
         "uninstallscripts","Remove a path to search for scripts",
         "history",         "List and operate on the command history",
         "info",            "Prints information about Clink",
+        "log",             "Decodes binary log files",
         "echo",            "Echo key sequences",
         "",                "('<verb> --help' for more details)",
         "Options:",        "",
@@ -84,6 +86,7 @@ static int dispatch_verb(const char* verb, int argc, char** argv)
         "history",              history,
         "info",                 clink_info,
         "inject",               inject,
+        "log",                  clink_log,
         "set",                  set,
         "installscripts",       installscripts,
         "uninstallscripts",     uninstallscripts,
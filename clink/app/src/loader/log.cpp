@@ -0,0 +1,421 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "utils/app_context.h"
+
+#include <core/base.h>
+#include <core/log.h>
+#include <core/str.h>
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+void puts_help(const char* const*, int);
+
+//------------------------------------------------------------------------------
+// Pulls fields out of a binary log record (see binary_file_logger in
+// core/log.h for the format).  A short read poisons the reader so malformed
+// or truncated files fail a whole record at a time instead of crashing.
+struct record_reader
+{
+                        record_reader(const unsigned char* data, size_t size)
+                        : m_data(data), m_size(size) {}
+
+    bool get_bytes(void* out, size_t count)
+    {
+        if (m_fail || count > m_size - m_cursor)
+        {
+            m_fail = true;
+            return false;
+        }
+
+        memcpy(out, m_data + m_cursor, count);
+        m_cursor += count;
+        return true;
+    }
+
+    template <typename T>
+    T get()             { T value = T(); get_bytes(&value, sizeof(value)); return value; }
+    bool more() const   { return !m_fail && m_cursor < m_size; }
+
+    const unsigned char* m_data;
+    size_t              m_size;
+    size_t              m_cursor = 0;
+    bool                m_fail = false;
+};
+
+//------------------------------------------------------------------------------
+struct decoded_site
+{
+    str_moveable        function;
+    str_moveable        fmt;
+    int                 line;
+};
+
+//------------------------------------------------------------------------------
+struct decoded_arg
+{
+    unsigned char       kind;
+    unsigned __int64    value = 0;      // int/uint/pointer bits, or double bits
+    str_moveable        text;
+    wstr_moveable       wtext;
+};
+
+//------------------------------------------------------------------------------
+// Renders one event by walking the site's format string and printing each
+// conversion with the matching decoded argument.  This mirrors the specifier
+// parsing in binary_file_logger::encode_event(); only the conversion character
+// and the 64 bit length modifiers matter, the rest of the specifier is handed
+// to printf verbatim.
+static void render_event(
+    const decoded_site& site,
+    unsigned int pid,
+    const decoded_arg* args,
+    int argc)
+{
+    printf("%04x %-24s %4d ", pid, site.function.c_str(), site.line);
+
+    int next = 0;
+    for (const char* p = site.fmt.c_str(); *p;)
+    {
+        if (*p != '%')
+        {
+            fputc(*p++, stdout);
+            continue;
+        }
+
+        const char* spec_start = p;
+        ++p;
+        if (*p == '%')
+        {
+            fputc('%', stdout);
+            ++p;
+            continue;
+        }
+
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+            ++p;
+        while (*p >= '0' && *p <= '9')
+            ++p;
+        if (*p == '.')
+        {
+            ++p;
+            while (*p >= '0' && *p <= '9')
+                ++p;
+        }
+
+        bool size64 = false;
+        switch (*p)
+        {
+        case 'h':
+            ++p;
+            if (*p == 'h')
+                ++p;
+            break;
+
+        case 'l':
+            ++p;
+            if (*p == 'l')
+            {
+                size64 = true;
+                ++p;
+            }
+            break;
+
+        case 'w':   ++p;                                    break;
+        case 'j':   size64 = true; ++p;                     break;
+        case 'z':
+        case 't':   size64 = (sizeof(size_t) == 8); ++p;    break;
+
+        case 'I':
+            ++p;
+            if (p[0] == '6' && p[1] == '4')         { size64 = true; p += 2; }
+            else if (p[0] == '3' && p[1] == '2')    p += 2;
+            else                                    size64 = (sizeof(size_t) == 8);
+            break;
+        }
+
+        const char conversion = *p;
+        if (conversion)
+            ++p;
+
+        char spec[32];
+        int spec_length = min<int>(int(p - spec_start), sizeof_array(spec) - 1);
+        memcpy(spec, spec_start, spec_length);
+        spec[spec_length] = '\0';
+
+        if (next >= argc)
+        {
+            fputs(spec, stdout);
+            continue;
+        }
+
+        const decoded_arg& arg = args[next++];
+        switch (conversion)
+        {
+        case 'd': case 'i': case 'c':
+            if (size64)
+                printf(spec, (__int64)arg.value);
+            else
+                printf(spec, (int)arg.value);
+            break;
+
+        case 'u': case 'o': case 'x': case 'X':
+            if (size64)
+                printf(spec, arg.value);
+            else
+                printf(spec, (unsigned int)arg.value);
+            break;
+
+        case 'p':
+            printf(spec, (void*)(uintptr_t)arg.value);
+            break;
+
+        case 'f': case 'F':
+        case 'e': case 'E':
+        case 'g': case 'G':
+        case 'a': case 'A':
+            {
+                double value;
+                memcpy(&value, &arg.value, sizeof(value));
+                printf(spec, value);
+            }
+            break;
+
+        case 's': case 'S':
+            if (arg.kind == binary_file_logger::arg_wstring)
+                printf("%ls", arg.wtext.c_str());
+            else
+                fputs(arg.text.c_str(), stdout);
+            break;
+
+        default:
+            fputs(spec, stdout);
+            break;
+        }
+    }
+
+    fputc('\n', stdout);
+}
+
+//------------------------------------------------------------------------------
+// Arguments are tagged with their kind and length, so an event can be pulled
+// apart (and skipped) even when its site's define record is missing.
+static bool read_args(record_reader& reader, std::vector<decoded_arg>& args)
+{
+    int argc = reader.get<unsigned char>();
+    args.resize(argc);
+    for (int i = 0; i < argc; ++i)
+    {
+        decoded_arg& arg = args[i];
+        arg.kind = reader.get<unsigned char>();
+        switch (arg.kind)
+        {
+        case binary_file_logger::arg_int:
+        case binary_file_logger::arg_uint:
+        case binary_file_logger::arg_double:
+        case binary_file_logger::arg_pointer:
+            arg.value = reader.get<unsigned __int64>();
+            break;
+
+        case binary_file_logger::arg_string:
+            {
+                unsigned short length = reader.get<unsigned short>();
+                arg.text.reserve(length);
+                char* data = arg.text.data();
+                if (!reader.get_bytes(data, length))
+                    return false;
+                data[length] = '\0';
+            }
+            break;
+
+        case binary_file_logger::arg_wstring:
+            {
+                unsigned short length = reader.get<unsigned short>();
+                arg.wtext.reserve(length);
+                wchar_t* data = arg.wtext.data();
+                if (!reader.get_bytes(data, length * sizeof(*data)))
+                    return false;
+                data[length] = '\0';
+            }
+            break;
+
+        default:
+            return false;
+        }
+
+        if (reader.m_fail)
+            return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static int decode_file(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        printf("*** ERROR: Unable to open '%s'.\n", path);
+        return 1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    std::vector<unsigned char> data(size > 0 ? size : 0);
+    bool read_ok = (size > 0 && fread(&data[0], size, 1, file) == 1);
+    fclose(file);
+
+    if (!read_ok || size < int(sizeof(binary_file_logger::c_magic)) ||
+        memcmp(&data[0], binary_file_logger::c_magic, sizeof(binary_file_logger::c_magic)) != 0)
+    {
+        printf("*** ERROR: '%s' is not a binary log file.\n", path);
+        return 1;
+    }
+
+    std::vector<decoded_site> sites;
+    decoded_site unknown;
+    unknown.function = "<unknown>";
+    unknown.line = 0;
+
+    record_reader reader(&data[0], size);
+    reader.m_cursor = sizeof(binary_file_logger::c_magic);
+
+    while (reader.more())
+    {
+        unsigned char type = reader.get<unsigned char>();
+        unsigned int id = reader.get<unsigned int>();
+        switch (type)
+        {
+        case binary_file_logger::record_define:
+            {
+                unsigned short line = reader.get<unsigned short>();
+                unsigned char func_len = reader.get<unsigned char>();
+                unsigned short fmt_len = reader.get<unsigned short>();
+
+                decoded_site site;
+                site.line = line;
+                site.function.reserve(func_len);
+                site.fmt.reserve(fmt_len);
+                if (!reader.get_bytes(site.function.data(), func_len) ||
+                    !reader.get_bytes(site.fmt.data(), fmt_len))
+                    break;
+                site.function.data()[func_len] = '\0';
+                site.fmt.data()[fmt_len] = '\0';
+
+                // Ids are handed out sequentially so they index the table.
+                if (id == sites.size() + 1)
+                    sites.push_back(std::move(site));
+            }
+            break;
+
+        case binary_file_logger::record_event:
+            {
+                unsigned int pid = reader.get<unsigned int>();
+
+                std::vector<decoded_arg> args;
+                if (!read_args(reader, args))
+                    break;
+
+                const decoded_site& site = (id && id <= sites.size())
+                    ? sites[id - 1] : unknown;
+                render_event(site, pid, args.data(), int(args.size()));
+            }
+            break;
+
+        case binary_file_logger::record_text:
+            {
+                unsigned int pid = reader.get<unsigned int>();
+                unsigned short length = reader.get<unsigned short>();
+
+                str<> text;
+                text.reserve(length);
+                if (!reader.get_bytes(text.data(), length))
+                    break;
+                text.data()[length] = '\0';
+
+                const decoded_site& site = (id && id <= sites.size())
+                    ? sites[id - 1] : unknown;
+                printf("%04x %-24s %4d %s\n", pid, site.function.c_str(),
+                    site.line, text.c_str());
+            }
+            break;
+
+        default:
+            // Unknown record; the format is prefix coded so nothing after
+            // this point can be trusted.
+            printf("*** ERROR: Unrecognised record type 0x%02x; stopping.\n", type);
+            return 1;
+        }
+
+        if (reader.m_fail)
+        {
+            printf("*** ERROR: Truncated record; stopping.\n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int clink_log(int argc, char** argv)
+{
+    static const struct option options[] = {
+        { "help", no_argument, nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    static const char* const help[] = {
+        "decode [<file>]", "Renders a binary log file as text.",
+        "-h, --help",      "Shows this help text.",
+    };
+
+    extern const char* g_clink_header;
+
+    int i;
+    while ((i = getopt_long(argc, argv, "h", options, nullptr)) != -1)
+    {
+        switch (i)
+        {
+        case 'h':
+        default:
+            puts(g_clink_header);
+            puts("Usage: log <verb> [<file>]\n");
+            puts("Verbs:");
+            puts_help(help, sizeof_array(help));
+            puts("Operates on the log file written when 'clink inject' is run with\n"
+                 "--binarylog.  Without a <file> argument the current profile's log\n"
+                 "file is decoded.");
+            return (i == 'h') ? 0 : 1;
+        }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if (argc >= 1 && strcmp(argv[0], "decode") == 0)
+    {
+        str<280> path;
+        if (argc >= 2)
+            path = argv[1];
+        else
+            app_context::get()->get_log_path(path);
+
+        return decode_file(path.c_str());
+    }
+
+    printf("*** ERROR: Unknown or missing verb.\n");
+    puts("Usage: log <verb> [<file>]\n");
+    puts("Verbs:");
+    puts_help(help, sizeof_array(help));
+    return 1;
+}
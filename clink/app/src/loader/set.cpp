@@ -77,18 +77,11 @@ static void list_options(const char* key)
 //------------------------------------------------------------------------------
 static bool print_keys()
 {
-    int longest = 0;
-    for (auto iter = settings::first(); auto* next = iter.next();)
-        longest = max(longest, int(strlen(next->get_name())));
-
-    for (auto iter = settings::first(); auto* next = iter.next();)
-    {
-        str<> value;
-        next->get_descriptive(value);
-        const char* name = next->get_name();
-        printf("%-*s  %s\n", longest, name, value.c_str());
-    }
-
+    // Format the whole listing into one buffer and emit it with a single
+    // write, rather than paying a console round trip per setting.
+    str<4096> list;
+    settings::format_list(list);
+    fwrite(list.c_str(), list.length(), 1, stdout);
     return true;
 }
 
@@ -172,13 +165,18 @@ static void print_help()
     };
 
     puts(g_clink_header);
-    puts("Usage: set [<setting_name> [clear|<value>]]\n");
+    puts("Usage: set [<setting_name> [clear|<value>]]\n"
+        "       set <setting_name>=<value> [<setting_name>=<value> ...]\n");
 
     puts_help(help, sizeof_array(help));
 
     puts("If 'settings_name' is omitted then all settings are listed. Omit 'value'\n"
         "for more detailed info about a setting and use a value of 'clear' to reset\n"
-        "the setting to its default value.");
+        "the setting to its default value.\n"
+        "\n"
+        "When every argument is a 'name=value' pair the settings are applied as a\n"
+        "batch and the settings file is written once, atomically.  Use 'name=clear'\n"
+        "to reset a setting within a batch.");
 }
 
 //------------------------------------------------------------------------------
@@ -223,6 +221,36 @@ int set(int argc, char** argv)
         return 0;
     }
 
+    // Batch mode; when every argument is a name=value pair, apply them all
+    // and serialize the settings file once.  Provisioning scripts that apply
+    // dozens of settings do it in one invocation instead of one rewrite each.
+    bool batch = (optind < argc);
+    for (int i = optind; batch && i < argc; ++i)
+        batch = (argv[i][0] != '=' && strchr(argv[i], '=') != nullptr);
+    if (batch)
+    {
+        settings::begin_transaction();
+
+        bool ok = true;
+        for (int i = optind; i < argc; ++i)
+        {
+            char* value = strchr(argv[i], '=');
+            *(value++) = '\0';
+            if (_stricmp(value, "clear") == 0)
+                ok = set_value(argv[i]) && ok;
+            else
+                ok = set_value(argv[i], &value, 1) && ok;
+        }
+
+        // Nothing is written unless every pair applied cleanly.
+        if (ok)
+            ok = settings::save(settings_file.c_str());
+        if (!settings::commit_transaction(settings_file.c_str()))
+            ok = false;
+
+        return ok ? 0 : 1;
+    }
+
     bool clear = false;
     switch (argc - optind)
     {
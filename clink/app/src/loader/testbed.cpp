@@ -3,15 +3,296 @@
 
 #include "pch.h"
 
+#include <core/base.h>
+#include <core/str.h>
 #include <core/str_compare.h>
 #include <lib/line_editor.h>
 #include <lib/match_generator.h>
 #include <terminal/terminal.h>
+#include <terminal/terminal_in.h>
+#include <terminal/terminal_out.h>
 #include <terminal/printer.h>
 
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+void rl_get_alloc_counters(unsigned long* count, unsigned long long* bytes, int reset);
+};
+
+//------------------------------------------------------------------------------
+// Terminal input fed from a recorded keystroke script instead of the console.
+// more_input_available() deliberately reports false so the editor runs its
+// full per-key path (word collection, match update, classify) for every
+// keystroke, the same as interactive typing; reporting buffered input would
+// trigger the paste-burst deferral and measure a different code path.
+class replay_terminal_in
+    : public terminal_in
+{
+public:
+    bool                    has_input() const { return (m_read != nullptr && *m_read != '\0'); }
+    void                    set_input(const char* input) { m_read = input; }
+    virtual void            begin() override {}
+    virtual void            end() override {}
+    virtual void            select() override {}
+    virtual int             read() override { return has_input() ? *(unsigned char*)m_read++ : int(input_none); }
+    virtual key_tester*     set_key_tester(key_tester*) override { return nullptr; }
+
+private:
+    const char*             m_read = nullptr;
+};
+
+//------------------------------------------------------------------------------
+// Terminal output that swallows everything, so replay measures the editor
+// and not the console it happens to run in.
+class null_terminal_out
+    : public terminal_out
+{
+public:
+    virtual void            open() override {}
+    virtual void            begin() override {}
+    virtual void            end() override {}
+    virtual void            close() override {}
+    virtual void            write(const char* chars, int length) override {}
+    virtual void            flush() override {}
+    virtual int             get_columns() const override { return 80; }
+    virtual int             get_rows() const override { return 25; }
+    virtual bool            get_line_text(int line, str_base& out) const override { return false; }
+    virtual int             is_line_default_color(int line) const override { return true; }
+    virtual int             line_has_color(int line, const BYTE* attrs, int num_attrs, BYTE mask=0xff) const override { return false; }
+    virtual int             find_line(int starting_line, int distance, const char* text, find_line_mode mode, const BYTE* attrs=nullptr, int num_attrs=0, BYTE mask=0xff) const override { return 0; }
+};
+
+//------------------------------------------------------------------------------
+// Expands the escapes allowed in a replay script line into raw keystrokes.
+// Supported: \e (escape), \t (tab), \r (enter), \n (newline), \\ and \xHH.
+static bool unescape_keystrokes(const char* in, str_base& out, str_base& error)
+{
+    out.clear();
+
+    while (*in)
+    {
+        char c = *in++;
+        if (c != '\\')
+        {
+            out.concat(&c, 1);
+            continue;
+        }
+
+        switch (*in++)
+        {
+        case 'e':   c = 0x1b; break;
+        case 't':   c = 0x09; break;
+        case 'r':   c = 0x0d; break;
+        case 'n':   c = 0x0a; break;
+        case '\\':  c = '\\'; break;
+        case 'x':
+            {
+                int value = 0;
+                int digits = 0;
+                while (digits < 2 && isxdigit((unsigned char)*in))
+                {
+                    char d = *in++;
+                    value <<= 4;
+                    value += (d <= '9') ? (d - '0') : (tolower(d) - 'a' + 10);
+                    ++digits;
+                }
+                if (!digits || !value)
+                {
+                    error = "invalid \\x escape";
+                    return false;
+                }
+                c = char(value);
+            }
+            break;
+        default:
+            error = "unknown escape";
+            return false;
+        }
+
+        out.concat(&c, 1);
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+struct replay_stats
+{
+    std::vector<long long>  latencies;  // QPC ticks, one per keystroke.
+    unsigned long           total_allocs = 0;
+    unsigned long long      total_alloc_bytes = 0;
+    unsigned long           max_key_allocs = 0;
+    unsigned int            lines = 0;
+};
+
+//------------------------------------------------------------------------------
+static long long percentile(std::vector<long long>& sorted, int pct)
+{
+    if (sorted.empty())
+        return 0;
+    size_t index = (sorted.size() - 1) * pct / 100;
+    return sorted[index];
+}
+
+//------------------------------------------------------------------------------
+static void report_replay_stats(replay_stats& stats)
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    std::vector<long long>& lat = stats.latencies;
+    std::sort(lat.begin(), lat.end());
+
+    long long total = 0;
+    for (long long ticks : lat)
+        total += ticks;
+
+    auto usec = [&] (long long ticks) {
+        return double(ticks) * 1000000.0 / double(frequency.QuadPart);
+    };
+
+    printf("lines           %u\n", stats.lines);
+    printf("keystrokes      %u\n", unsigned(lat.size()));
+    if (!lat.empty())
+    {
+        printf("latency usec    mean %.1f  p50 %.1f  p95 %.1f  p99 %.1f  max %.1f\n",
+               usec(total) / double(lat.size()),
+               usec(percentile(lat, 50)),
+               usec(percentile(lat, 95)),
+               usec(percentile(lat, 99)),
+               usec(lat.back()));
+        printf("rl allocs       total %lu (%llu bytes), max per key %lu\n",
+               stats.total_allocs,
+               stats.total_alloc_bytes,
+               stats.max_key_allocs);
+    }
+}
+
 //------------------------------------------------------------------------------
-int testbed(int, char**)
+// Replays a keystroke script through the line editor against a null terminal
+// and reports per-keystroke latency and allocation statistics.  Each non-#
+// line of the script is one editing session; end lines with \r so the editor
+// accepts them the way an interactive session would.
+static int testbed_replay(const char* path, int repeat)
 {
+    FILE* file = fopen(path, "rt");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "Unable to open '%s'.\n", path);
+        return 1;
+    }
+
+    str_compare_scope _(str_compare_scope::relaxed);
+
+    replay_terminal_in input;
+    null_terminal_out output;
+    printer printer(output);
+
+    line_editor::desc desc = { &input, &output, &printer };
+    line_editor* editor = line_editor_create(desc);
+    editor->add_generator(file_match_generator());
+
+    replay_stats stats;
+    LARGE_INTEGER start, stop;
+
+    str<> keystrokes;
+    str<> error;
+    char line[1024];
+    unsigned int line_number = 0;
+    int ret = 0;
+    while (fgets(line, sizeof_array(line), file) != nullptr)
+    {
+        ++line_number;
+
+        // Strip the line ending; skip blank lines and # comments.
+        for (char* end = line + strlen(line); end > line && (end[-1] == '\n' || end[-1] == '\r');)
+            *--end = '\0';
+        if (!line[0] || line[0] == '#')
+            continue;
+
+        if (!unescape_keystrokes(line, keystrokes, error))
+        {
+            fprintf(stderr, "%s(%u): %s.\n", path, line_number, error.c_str());
+            ret = 1;
+            break;
+        }
+
+        for (int pass = 0; pass < repeat; ++pass)
+        {
+            input.set_input(keystrokes.c_str());
+            ++stats.lines;
+
+            // The first update initialises without reading input, same as
+            // the interactive edit() loop.
+            editor->update();
+            rl_get_alloc_counters(nullptr, nullptr, 1/*reset*/);
+            while (input.has_input())
+            {
+                QueryPerformanceCounter(&start);
+                bool editing = editor->update();
+                QueryPerformanceCounter(&stop);
+
+                stats.latencies.push_back(stop.QuadPart - start.QuadPart);
+
+                unsigned long allocs;
+                unsigned long long bytes;
+                rl_get_alloc_counters(&allocs, &bytes, 1/*reset*/);
+                stats.total_allocs += allocs;
+                stats.total_alloc_bytes += bytes;
+                if (stats.max_key_allocs < allocs)
+                    stats.max_key_allocs = allocs;
+
+                if (!editing)
+                    break;
+            }
+
+            // Flush any line still being edited so the next session starts
+            // clean (scripts normally end each line with \r).
+            str<> out;
+            editor->get_line(out);
+        }
+    }
+
+    fclose(file);
+    line_editor_destroy(editor);
+
+    if (!ret)
+        report_replay_stats(stats);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+int testbed(int argc, char** argv)
+{
+    const char* replay_path = nullptr;
+    int repeat = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        if (_stricmp(arg, "--help") == 0 || _stricmp(arg, "-h") == 0)
+        {
+            extern const char* g_clink_header;
+            puts(g_clink_header);
+            printf("Usage: %s [--replay <file> [--repeat <n>]]\n\n", argv[0]);
+            puts("Hosts a standalone line editor for testing.\n\n"
+                 "With --replay, feeds the keystroke script in <file> through the editor\n"
+                 "against a null terminal and reports per-keystroke latency and allocation\n"
+                 "statistics.  Each non-# line of the script is one editing session, using\n"
+                 "\\e \\t \\r \\n \\\\ and \\xHH escapes for special keys; end lines with \\r.\n"
+                 "--repeat replays each session <n> times for steadier numbers.");
+            return 0;
+        }
+        if (_stricmp(arg, "--replay") == 0 && i + 1 < argc)
+            replay_path = argv[++i];
+        else if (_stricmp(arg, "--repeat") == 0 && i + 1 < argc)
+            repeat = max(1, atoi(argv[++i]));
+    }
+
+    if (replay_path != nullptr)
+        return testbed_replay(replay_path, repeat);
+
     str_compare_scope _(str_compare_scope::relaxed);
 
     terminal term = terminal_create();
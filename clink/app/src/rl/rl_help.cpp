@@ -36,6 +36,7 @@ struct Keyentry
     char* key_name;
     char* macro_text;
     const char* func_name;
+    unsigned int key_cells; // measured once, reused for layout and padding.
     bool warning;
 };
 
@@ -351,9 +352,8 @@ static int _cdecl cmp_sort_collector(const void* pv1, const void* pv2)
 }
 
 //------------------------------------------------------------------------------
-static void pad_with_spaces(str_base& str, unsigned int pad_to)
+static void pad_with_spaces(str_base& str, unsigned int pad_to, unsigned int len)
 {
-    unsigned int len = cell_count(str.c_str());
     while (len < pad_to)
     {
         const char spaces[] = "                                ";
@@ -364,6 +364,12 @@ static void pad_with_spaces(str_base& str, unsigned int pad_to)
     }
 }
 
+//------------------------------------------------------------------------------
+static void pad_with_spaces(str_base& str, unsigned int pad_to)
+{
+    pad_with_spaces(str, pad_to, cell_count(str.c_str()));
+}
+
 //------------------------------------------------------------------------------
 static void append_key_macro(str_base& s, const char* macro)
 {
@@ -394,42 +400,118 @@ static void append_key_macro(str_base& s, const char* macro)
     }
 }
 
+//------------------------------------------------------------------------------
+// Content-derived fingerprint of a keymap chain.  Bindings can change through
+// many paths (inputrc, Lua, vi/emacs mode switches) with no notification, so
+// the cached inventory below is validated by rehashing the keymap contents --
+// a pointer walk with no allocations, far cheaper than re-collecting
+// (translating and sorting) the bindings themselves.
+static unsigned int fingerprint_keymap(Keymap map, unsigned int hash)
+{
+    for (int i = 0; i < 256; ++i)
+    {
+        const KEYMAP_ENTRY& entry = map[i];
+        if (entry.function == nullptr)
+            continue;
+
+        hash = ((hash << 5) + hash) ^ i;
+        hash = ((hash << 5) + hash) ^ entry.type;
+        const unsigned char* p = (const unsigned char*)&entry.function;
+        for (size_t j = 0; j < sizeof(entry.function); ++j)
+            hash = ((hash << 5) + hash) ^ p[j];
+
+        if (entry.type == ISKMAP)
+            hash = fingerprint_keymap((Keymap)entry.function, hash);
+    }
+
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+// Cached binding inventory, so reopening help with an unchanged keymap skips
+// collecting, translating, sorting, and measuring the bindings.
+static Keyentry* s_collector = nullptr;
+static int s_collector_count = 0;       // Including the placeholder at [0].
+static unsigned int s_fingerprint = 0;
+static bool s_collector_friendly = false;
+static unsigned int s_longest_key = 0;
+static unsigned int s_longest_func = 0;
+static std::vector<str_moveable> s_warnings;
+
+//------------------------------------------------------------------------------
+static void free_collector()
+{
+    // N.B. the first entry is a placeholder and shouldn't be freed.
+    while (--s_collector_count > 0)
+    {
+        free(s_collector[s_collector_count].key_name);
+        free(s_collector[s_collector_count].macro_text);
+    }
+    free(s_collector);
+    s_collector = nullptr;
+    s_collector_count = 0;
+    s_warnings.clear();
+}
+
 //------------------------------------------------------------------------------
 static void show_key_bindings(bool friendly)
 {
     Keymap map = rl_get_keymap();
-    int offset = 1;
-    int max_collect = 64;
-    Keyentry* collector = (Keyentry*)malloc(sizeof(Keyentry) * max_collect);
-    collector[0].key_name = nullptr;
-    collector[0].macro_text = nullptr;
-    collector[0].func_name = nullptr;
-
-    // Build string up the functions in the active keymap.
-    str<32> keyseq;
-    std::vector<str_moveable> warnings;
-    collector = collect_keymap(map, collector, &offset, &max_collect, keyseq, friendly, (map == emacs_standard_keymap) ? &warnings : nullptr);
-
-    // Sort the collected keymap.
-    qsort(collector + 1, offset - 1, sizeof(*collector), cmp_sort_collector);
-
-    // Find the longest key name and function name.
-    unsigned int longest_key = 0;
-    unsigned int longest_func = 0;
-    for (int i = 1; i < offset; ++i)
+
+    unsigned int fingerprint = 5381;
+    fingerprint = fingerprint_keymap(map, fingerprint);
+
+    if (s_collector == nullptr ||
+        fingerprint != s_fingerprint ||
+        friendly != s_collector_friendly)
     {
-        unsigned int k = (unsigned int)strlen(collector[i].key_name);
-        unsigned int f = 0;
-        if (collector[i].func_name)
-            f = (unsigned int)strlen(collector[i].func_name);
-        else if (collector[i].macro_text)
-            f = min(2 + (int)strlen(collector[i].macro_text), 32);
-        if (longest_key < k)
-            longest_key = k;
-        if (longest_func < f)
-            longest_func = f;
+        free_collector();
+
+        int offset = 1;
+        int max_collect = 64;
+        Keyentry* collector = (Keyentry*)malloc(sizeof(Keyentry) * max_collect);
+        collector[0].key_name = nullptr;
+        collector[0].macro_text = nullptr;
+        collector[0].func_name = nullptr;
+
+        // Build string up the functions in the active keymap.
+        str<32> keyseq;
+        collector = collect_keymap(map, collector, &offset, &max_collect, keyseq, friendly, (map == emacs_standard_keymap) ? &s_warnings : nullptr);
+
+        // Sort the collected keymap.
+        qsort(collector + 1, offset - 1, sizeof(*collector), cmp_sort_collector);
+
+        // Find the longest key name and function name.  Measure each key
+        // name once here; the display loop below reuses the cached widths
+        // instead of re-measuring per row.
+        s_longest_key = 0;
+        s_longest_func = 0;
+        for (int i = 1; i < offset; ++i)
+        {
+            unsigned int k = collector[i].key_cells = cell_count(collector[i].key_name);
+            unsigned int f = 0;
+            if (collector[i].func_name)
+                f = (unsigned int)strlen(collector[i].func_name);
+            else if (collector[i].macro_text)
+                f = min(2 + (int)strlen(collector[i].macro_text), 32);
+            if (s_longest_key < k)
+                s_longest_key = k;
+            if (s_longest_func < f)
+                s_longest_func = f;
+        }
+
+        s_collector = collector;
+        s_collector_count = offset;
+        s_fingerprint = fingerprint;
+        s_collector_friendly = friendly;
     }
 
+    const Keyentry* collector = s_collector;
+    const int offset = s_collector_count;
+    const std::vector<str_moveable>& warnings = s_warnings;
+    const unsigned int longest_key = s_longest_key;
+    const unsigned int longest_func = s_longest_func;
+
     // Calculate columns.
     unsigned int longest = longest_key + 3 + longest_func + 2;
     int max_width = complete_get_screenwidth();
@@ -459,7 +541,7 @@ static void show_key_bindings(bool friendly)
         int num_warnings = stop ? 0 : int(warnings.size());
         for (int i = 0; i < num_warnings; ++i)
         {
-            str_moveable& s = warnings[i];
+            const str_moveable& s = warnings[i];
 
             // Ask the pager what to do.
             int lines = ((s.length() - 14 + max_width - 1) / max_width); // -14 for escape codes.
@@ -489,7 +571,7 @@ static void show_key_bindings(bool friendly)
         if (!columns_that_fit)
         {
             int len = 3; // " : "
-            len += int(strlen(collector[index].key_name));
+            len += int(collector[index].key_cells);
             if (collector[index].func_name)
                 len += int(strlen(collector[index].func_name));
             else
@@ -513,7 +595,7 @@ static void show_key_bindings(bool friendly)
             str << entry.key_name;
             if (entry.warning)
                 str << "\x1b[m";
-            pad_with_spaces(str, longest_key);
+            pad_with_spaces(str, longest_key, entry.key_cells);
             str << " : ";
             if (entry.func_name)
                 str << entry.func_name;
@@ -539,13 +621,8 @@ static void show_key_bindings(bool friendly)
 
     g_printer->print("\n");
 
-    // Tidy up (N.B. the first match is a placeholder and shouldn't be freed).
-    while (--offset)
-    {
-        free(collector[offset].key_name);
-        free(collector[offset].macro_text);
-    }
-    free(collector);
+    // The collector stays cached for the next invocation; it's freed and
+    // rebuilt by the fingerprint check above when the bindings change.
 
     g_result->redraw();
 }
@@ -137,6 +137,12 @@ bool app_context::is_logging_enabled() const
     return m_desc.log;
 }
 
+//------------------------------------------------------------------------------
+bool app_context::is_binary_log_enabled() const
+{
+    return m_desc.binary_log;
+}
+
 //------------------------------------------------------------------------------
 bool app_context::is_quiet() const
 {
@@ -148,6 +154,15 @@ void app_context::get_binaries_dir(str_base& out) const
 {
     out.clear();
 
+    // Resolving the binaries directory walks the module list and probes for a
+    // '.origin' redirection file.  The answer can't change for the lifetime
+    // of the process, so resolve once and serve the cached copy afterwards.
+    if (!m_binaries_dir.empty())
+    {
+        out.copy(m_binaries_dir.c_str());
+        return;
+    }
+
     void* base = vm().get_alloc_base("");
     if (base == nullptr)
         return;
@@ -178,6 +193,7 @@ void app_context::get_binaries_dir(str_base& out) const
     }
 
     path::get_directory(out);
+    m_binaries_dir.copy(out.c_str());
 }
 
 //------------------------------------------------------------------------------
@@ -193,6 +209,28 @@ void app_context::get_log_path(str_base& out) const
     path::append(out, "clink.log");
 }
 
+//------------------------------------------------------------------------------
+void app_context::get_memory_stats_path(str_base& out) const
+{
+    get_state_dir(out);
+
+    str<32> name;
+    name.format("clink_memory_%d", m_id);
+    path::append(out, name.c_str());
+}
+
+//------------------------------------------------------------------------------
+// generator.lua builds this same path from the "=clink.profile" and
+// "=clink.id" environment variables when writing the file.
+void app_context::get_generator_stats_path(str_base& out) const
+{
+    get_state_dir(out);
+
+    str<32> name;
+    name.format("clink_generators_%d", m_id);
+    path::append(out, name.c_str());
+}
+
 //------------------------------------------------------------------------------
 void app_context::get_settings_path(str_base& out) const
 {
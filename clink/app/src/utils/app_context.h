@@ -4,8 +4,7 @@
 #pragma once
 
 #include <core/singleton.h>
-
-class str_base;
+#include <core/str.h>
 
 //------------------------------------------------------------------------------
 class app_context
@@ -18,7 +17,7 @@ public:
         bool    quiet = false;
         bool    log = true;
         bool    inherit_id = false;
-        char    unused = 0;
+        bool    binary_log = false;
         char    state_dir[510]; // = {}; (this crashes cl.exe v18.00.21005.1)
         char    script_path[510]; // = {}; (this crashes cl.exe v18.00.21005.1)
     };
@@ -26,10 +25,13 @@ public:
                 app_context(const desc& desc);
     int         get_id() const;
     bool        is_logging_enabled() const;
+    bool        is_binary_log_enabled() const;
     bool        is_quiet() const;
     void        get_binaries_dir(str_base& out) const;
     void        get_state_dir(str_base& out) const;
     void        get_log_path(str_base& out) const;
+    void        get_memory_stats_path(str_base& out) const;
+    void        get_generator_stats_path(str_base& out) const;
     void        get_settings_path(str_base& out) const;
     void        get_history_path(str_base& out) const;
     void        get_script_path(str_base& out) const;
@@ -40,4 +42,5 @@ private:
     void        get_script_path(str_base& out, bool readable) const;
     desc        m_desc;
     int         m_id;
+    mutable str<288, false> m_binaries_dir;
 };
@@ -6,6 +6,7 @@
 
 #include <core/base.h>
 #include <core/log.h>
+#include <core/timings.h>
 #include <process/hook.h>
 #include <process/vm.h>
 #include <detours.h>
@@ -52,17 +53,15 @@ hook_setter::~hook_setter()
 //------------------------------------------------------------------------------
 bool hook_setter::commit()
 {
+    timing_scope timing("hook commit");
+
     m_pending = false;
 
     // TODO: suspend threads?  Currently this relies on CMD being essentially
     // single threaded.
 
     LONG err = DetourTransactionCommit();
-    if (!err)
-    {
-        apply_repair_iat_list(m_repair_iat);
-    }
-    else
+    if (err)
     {
         LOG("<<< Unable to commit hooks (error %u).", err);
         free_repair_iat_list(m_repair_iat);
@@ -70,13 +69,22 @@ bool hook_setter::commit()
         return false;
     }
 
-    // Apply any IAT hooks.
+    // The repair list and the IAT hooks below probe and restore protection on
+    // the same few IAT pages once per entry; memoize the protection queries
+    // across the whole batch.
+    vm_access_cache_scope access_cache;
+
+    apply_repair_iat_list(m_repair_iat);
+
+    // Apply any IAT hooks, with a single icache flush at the end of the batch.
     int failed = 0;
     for (int i = 0; i < m_desc_count; ++i)
     {
         const hook_iat_desc& desc = m_descs[i];
         failed += !commit_iat(m_self, desc);
     }
+    if (m_desc_count)
+        vm().flush_icache();
     m_desc_count = 0;
 
     if (failed)
@@ -150,7 +158,7 @@ bool hook_setter::add_detour(const char* module, const char* name, hookptr_t det
 //------------------------------------------------------------------------------
 bool hook_setter::commit_iat(void* self, const hook_iat_desc& desc)
 {
-    hookptr_t addr = hook_iat(desc.base, nullptr, desc.name, desc.hook, 1);
+    hookptr_t addr = hook_iat(desc.base, nullptr, desc.name, desc.hook, 1, 0/*flush*/);
     if (addr == nullptr)
     {
         LOG("Unable to hook %s in IAT at base %p", desc.name, desc.base);
@@ -160,7 +168,7 @@ bool hook_setter::commit_iat(void* self, const hook_iat_desc& desc)
     // If the target's IAT was hooked then the hook destination is now
     // stored in 'addr'. We hook ourselves with this address to maintain
     // any IAT hooks that may already exist.
-    if (hook_iat(self, nullptr, desc.name, addr, 1) == 0)
+    if (hook_iat(self, nullptr, desc.name, addr, 1, 0/*flush*/) == 0)
     {
         LOG("Failed to hook own IAT for %s", desc.name);
         return false;
@@ -92,14 +92,20 @@ static LONG WINAPI exception_filter(EXCEPTION_POINTERS* info)
 
 
 
+//------------------------------------------------------------------------------
+threadlocal int seh_scope::ts_depth = 0;
+
 //------------------------------------------------------------------------------
 seh_scope::seh_scope()
+: m_prev_filter(nullptr)
 {
-    m_prev_filter = (void*)SetUnhandledExceptionFilter(exception_filter);
+    if (ts_depth++ == 0)
+        m_prev_filter = (void*)SetUnhandledExceptionFilter(exception_filter);
 }
 
 //------------------------------------------------------------------------------
 seh_scope::~seh_scope()
 {
-    SetUnhandledExceptionFilter(LPTOP_LEVEL_EXCEPTION_FILTER(m_prev_filter));
+    if (--ts_depth == 0)
+        SetUnhandledExceptionFilter(LPTOP_LEVEL_EXCEPTION_FILTER(m_prev_filter));
 }
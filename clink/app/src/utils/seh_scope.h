@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <core/base.h>
+
 //------------------------------------------------------------------------------
 class seh_scope
 {
@@ -12,4 +14,9 @@ public:
 
 private:
     void*       m_prev_filter;
+
+    // Hooked entry points nest (e.g. hooked APIs calling other hooked APIs)
+    // and some are very hot, so only the outermost scope on each thread pays
+    // for swapping the unhandled exception filter; inner scopes just count.
+    threadlocal static int ts_depth;
 };
@@ -19,6 +19,8 @@
 //------------------------------------------------------------------------------
 extern "C" {
 char* tgetstr(char*, char**);
+void rl_clear_history(void);
+extern int history_length;
 }
 
 //------------------------------------------------------------------------------
@@ -61,6 +63,11 @@ struct test_history_db
     {
         m_min_compact_threshold = threshold;
     }
+
+    void set_mirror_lines(size_t lines)
+    {
+        m_mirror_lines = lines;
+    }
 };
 
 //------------------------------------------------------------------------------
@@ -590,6 +597,11 @@ TEST_CASE("history limit")
         history.add(history_lines[5-1]);
         history.load_rl_history();
 
+        // Compaction happens on a worker thread; wait for it to land and
+        // reload to observe the rewritten bank.
+        history.finish_async_compact();
+        history.load_rl_history();
+
         REQUIRE(history.get_master_length() == 3);
         REQUIRE(history.get_master_deleted_count() == 0);
         REQUIRE(strcmp(ctag.get(), history.get_master_tag()) != 0);
@@ -619,3 +631,156 @@ TEST_CASE("history limit")
         }
     }
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("history timestamps")
+{
+    const char* master_path = "clink_history";
+
+    // Start with an empty state dir.
+    const char* empty_fs[] = { nullptr };
+    fs_fixture fs(empty_fs);
+
+    // This sets the state id to something explicit.
+    static const char* env_desc[] = {
+        "=clink.id", "493",
+        nullptr
+    };
+    env_fixture env(env_desc);
+
+    app_context::desc context_desc;
+    context_desc.inherit_id = true;
+    str_base(context_desc.state_dir).copy(fs.get_root());
+    app_context context(context_desc);
+
+    // Time-windowed loading records timestamp markers as lines are added.
+    settings::find("history.shared")->set("true");
+    settings::find("history.load_days")->set("7");
+
+    test_history_db history;
+    history.add("alpha");
+    history.add("bravo");
+    history.load_rl_history();
+
+    SECTION("Marker recorded once per interval")
+    {
+        char content[512];
+        FILE* in = fopen(master_path, "rb");
+        int length = int(fread(content, 1, sizeof(content) - 1, in));
+        fclose(in);
+        content[(length < 0) ? 0 : length] = '\0';
+
+        int markers = 0;
+        for (const char* next = content; (next = strstr(next, "|TS_")) != nullptr; ++next)
+            ++markers;
+        REQUIRE(markers == 1);
+    }
+
+    SECTION("Markers invisible to readers")
+    {
+        REQUIRE(history.get_master_length() == 2);
+        REQUIRE(history.get_master_deleted_count() == 0);
+
+        char buffer[256];
+        str_iter line;
+        history_db::iter iter = history.read_lines(buffer);
+        REQUIRE(iter.next(line));
+        REQUIRE(line.length() == 5);
+        REQUIRE(strncmp(line.get_pointer(), "alpha", line.length()) == 0);
+        REQUIRE(iter.next(line));
+        REQUIRE(line.length() == 5);
+        REQUIRE(strncmp(line.get_pointer(), "bravo", line.length()) == 0);
+        REQUIRE(!iter.next(line));
+    }
+
+    settings::find("history.load_days")->set("0");
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("history mirror")
+{
+    const char* mirror_path = "clink_history.recent";
+
+    // Start with an empty state dir.
+    const char* empty_fs[] = { nullptr };
+    fs_fixture fs(empty_fs);
+
+    // This sets the state id to something explicit.
+    static const char* env_desc[] = {
+        "=clink.id", "493",
+        nullptr
+    };
+    env_fixture env(env_desc);
+
+    app_context::desc context_desc;
+    context_desc.inherit_id = true;
+    str_base(context_desc.state_dir).copy(fs.get_root());
+    app_context context(context_desc);
+
+    settings::find("history.shared")->set("true");
+    settings::find("history.dupe_mode")->set("add");
+    settings::find("history.max_lines")->set("2500");
+
+    static const char* history_lines[] = {
+        "alpha", "bravo", "charlie", "delta", "echo",
+    };
+
+    // A full load rewrites the mirror with the most recent lines.
+    {
+        test_history_db history;
+        history.set_mirror_lines(3);
+        for (const char* line : history_lines)
+            history.add(line);
+        history.load_rl_history();
+    }
+
+    SECTION("Written on load")
+    {
+        char content[256];
+        FILE* in = fopen(mirror_path, "rb");
+        REQUIRE(in != nullptr);
+        int length = int(fread(content, 1, sizeof(content) - 1, in));
+        fclose(in);
+        content[(length < 0) ? 0 : length] = '\0';
+
+        REQUIRE(strcmp(content, "charlie\ndelta\necho\n") == 0);
+    }
+
+    SECTION("Primes an empty session")
+    {
+        rl_clear_history();
+
+        test_history_db history;
+        history.set_mirror_lines(3);
+        REQUIRE(history.load_mirror());
+        REQUIRE(history_length == 3);
+        REQUIRE(!history.is_loaded());
+
+        // Priming is one-shot; the banks then merge in place.
+        REQUIRE(!history.load_mirror());
+        history.load_rl_history();
+        REQUIRE(history.is_loaded());
+        REQUIRE(history_length == sizeof_array(history_lines));
+    }
+
+    SECTION("Appended between loads")
+    {
+        {
+            test_history_db history;
+            history.add("foxtrot");
+        }
+
+        rl_clear_history();
+
+        test_history_db history;
+        REQUIRE(history.load_mirror());
+        REQUIRE(history_length == 4);
+    }
+
+    SECTION("Cleared with the banks")
+    {
+        test_history_db history;
+        history.clear();
+        REQUIRE(os::get_path_type(mirror_path) == os::path_type_invalid);
+    }
+}
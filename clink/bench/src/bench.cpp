@@ -0,0 +1,69 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "bench.h"
+
+#include <stdio.h>
+
+namespace bench {
+
+//------------------------------------------------------------------------------
+static volatile size_t s_sink;
+void consume(size_t value)
+{
+    s_sink += value;
+}
+
+//------------------------------------------------------------------------------
+long long now()
+{
+    LARGE_INTEGER li;
+    QueryPerformanceCounter(&li);
+    return li.QuadPart;
+}
+
+//------------------------------------------------------------------------------
+long long frequency()
+{
+    static long long s_frequency;
+    if (!s_frequency)
+    {
+        LARGE_INTEGER li;
+        QueryPerformanceFrequency(&li);
+        s_frequency = li.QuadPart;
+    }
+    return s_frequency;
+}
+
+//------------------------------------------------------------------------------
+void context::report(const char* label, unsigned int iterations, long long elapsed_ticks)
+{
+    double total_ms = elapsed_ticks * 1000.0 / frequency();
+    double ns_per_iter = elapsed_ticks * 1e9 / frequency() / iterations;
+    printf("%s,%s,%u,%.3f,%.1f\n", m_case_name, label, iterations, total_ms, ns_per_iter);
+}
+
+//------------------------------------------------------------------------------
+int run(const char* prefix)
+{
+    puts("case,label,iterations,total_ms,ns_per_iter");
+
+    int case_count = 0;
+    for (case_info* info = case_info::get_head(); info != nullptr; info = info->m_next)
+    {
+        // Cheap lower-case prefix test.
+        const char* a = prefix, *b = info->m_name;
+        for (; *a && (*a & ~0x20) == (*b & ~0x20); ++a, ++b);
+        if (*a)
+            continue;
+
+        ++case_count;
+        context ctx(info->m_name);
+        (info->m_func)(ctx);
+    }
+
+    return (case_count != 0) ? 0 : 1;
+}
+
+} // namespace bench
@@ -0,0 +1,83 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+namespace bench {
+
+//------------------------------------------------------------------------------
+// Feeds a value the optimiser must assume is observed, so a measured kernel
+// is not eliminated as dead code.
+void consume(size_t value);
+
+//------------------------------------------------------------------------------
+long long now();
+long long frequency();
+
+//------------------------------------------------------------------------------
+// Passed to each benchmark case.  measure() runs 'fn' a fixed number of
+// iterations and emits one CSV row; fixed counts keep runs comparable
+// between builds and machines.
+class context
+{
+public:
+    explicit            context(const char* case_name) : m_case_name(case_name) {}
+
+    template <typename T>
+    void                measure(const char* label, unsigned int iterations, T&& fn);
+
+private:
+    void                report(const char* label, unsigned int iterations, long long elapsed_ticks);
+    const char*         m_case_name;
+};
+
+//------------------------------------------------------------------------------
+template <typename T>
+void context::measure(const char* label, unsigned int iterations, T&& fn)
+{
+    // One untimed pass warms caches and faults in lazily built tables.
+    fn();
+
+    long long start = now();
+    for (unsigned int i = 0; i < iterations; ++i)
+        fn();
+    report(label, iterations, now() - start);
+}
+
+//------------------------------------------------------------------------------
+struct case_info
+{
+    typedef void        (case_func)(context&);
+    static case_info*&  get_head() { static case_info* head; return head; }
+    static case_info*&  get_tail() { static case_info* tail; return tail; }
+    case_info*          m_next = nullptr;
+    case_func*          m_func;
+    const char*         m_name;
+
+    case_info(const char* name, case_func* func)
+    : m_name(name)
+    , m_func(func)
+    {
+        if (get_head() == nullptr)
+            get_head() = this;
+
+        if (case_info* tail = get_tail())
+            tail->m_next = this;
+        get_tail() = this;
+    }
+};
+
+//------------------------------------------------------------------------------
+int run(const char* prefix="");
+
+} // namespace bench
+
+//------------------------------------------------------------------------------
+#define BENCH_IDENT__(d, b) _bench_##d##_##b
+#define BENCH_IDENT_(d, b)  BENCH_IDENT__(d, b)
+#define BENCH_IDENT(d)      BENCH_IDENT_(d, __LINE__)
+
+#define BENCH_CASE(name)\
+    static void BENCH_IDENT(case_func)(bench::context&);\
+    static bench::case_info BENCH_IDENT(case)(name, BENCH_IDENT(case_func));\
+    static void BENCH_IDENT(case_func)(bench::context& ctx)
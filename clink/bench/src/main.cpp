@@ -0,0 +1,45 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include "core/str.h"
+
+#include <list>
+#include <assert.h>
+
+//------------------------------------------------------------------------------
+void host_cmd_enqueue_lines(std::list<str_moveable>& lines)
+{
+    assert(false);
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    argc--, argv++;
+
+    while (argc > 0)
+    {
+        if (!strcmp(argv[0], "-?") || !strcmp(argv[0], "--help"))
+        {
+            puts("Usage: clink_bench [prefix]\n"
+                 "\n"
+                 "Runs the microbenchmarks whose case name starts with [prefix] (all of\n"
+                 "them by default) and writes one CSV row per measurement to stdout.");
+            return 1;
+        }
+        else if (!strcmp(argv[0], "--"))
+        {
+        }
+        else
+        {
+            break;
+        }
+
+        argc--, argv++;
+    }
+
+    const char* prefix = (argc > 0) ? argv[0] : "";
+    return bench::run(prefix);
+}
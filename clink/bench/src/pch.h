@@ -0,0 +1,8 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "bench.h"
+
+#include <Windows.h>
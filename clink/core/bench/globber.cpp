@@ -0,0 +1,72 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/base.h>
+#include <core/globber.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+
+#include <stdio.h>
+
+//------------------------------------------------------------------------------
+static void get_entry_path(const char* root, int index, str_base& out)
+{
+    str<32> name;
+    name.format("file_%04d.txt", index);
+    out.copy(root);
+    path::append(out, name.c_str());
+}
+
+//------------------------------------------------------------------------------
+BENCH_CASE("globber")
+{
+    const int c_file_count = 1000;
+
+    // Populate a scratch directory with a known number of files so the
+    // throughput numbers are comparable between machines.
+    str<280> root;
+    os::get_temp_dir(root);
+    path::append(root, "clink_bench_glob");
+    os::make_dir(root.c_str());
+
+    str<280> file;
+    for (int i = 0; i < c_file_count; ++i)
+    {
+        get_entry_path(root.c_str(), i, file);
+        if (FILE* f = fopen(file.c_str(), "wb"))
+            fclose(f);
+    }
+
+    str<280> pattern(root.c_str());
+    path::append(pattern, "*");
+
+    const unsigned int iterations = 200;
+
+    ctx.measure("next", iterations, [&] () {
+        globber glob(pattern.c_str());
+        str<280> path;
+        unsigned int count = 0;
+        while (glob.next(path))
+            ++count;
+        bench::consume(count);
+    });
+
+    ctx.measure("next_batch", iterations, [&] () {
+        globber glob(pattern.c_str());
+        glob_entry entries[32];
+        unsigned int count = 0;
+        while (unsigned int n = glob.next_batch(entries, sizeof_array(entries)))
+            count += n;
+        bench::consume(count);
+    });
+
+    for (int i = 0; i < c_file_count; ++i)
+    {
+        get_entry_path(root.c_str(), i, file);
+        os::unlink(file.c_str());
+    }
+    os::remove_dir(root.c_str());
+}
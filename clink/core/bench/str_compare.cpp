@@ -0,0 +1,44 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/base.h>
+#include <core/str_compare.h>
+
+//------------------------------------------------------------------------------
+BENCH_CASE("str_compare")
+{
+    static const char* const c_pairs[] = {
+        "c:/program files/common files", "c:/program files/common stuff",
+        "C:\\PROGRAM FILES\\COMMON FILES", "c:/program files/common files",
+        "some_file-name.txt",             "some-file_name.txt",
+        "identical/path/no/difference",   "identical/path/no/difference",
+    };
+
+    const unsigned int iterations = 200000;
+
+    {
+        str_compare_scope _(str_compare_scope::exact);
+        ctx.measure("exact", iterations, [] () {
+            for (int i = 0; i < sizeof_array(c_pairs); i += 2)
+                bench::consume(str_compare(c_pairs[i], c_pairs[i + 1]));
+        });
+    }
+
+    {
+        str_compare_scope _(str_compare_scope::caseless);
+        ctx.measure("caseless", iterations, [] () {
+            for (int i = 0; i < sizeof_array(c_pairs); i += 2)
+                bench::consume(str_compare(c_pairs[i], c_pairs[i + 1]));
+        });
+    }
+
+    {
+        str_compare_scope _(str_compare_scope::relaxed);
+        ctx.measure("relaxed", iterations, [] () {
+            for (int i = 0; i < sizeof_array(c_pairs); i += 2)
+                bench::consume(str_compare(c_pairs[i], c_pairs[i + 1]));
+        });
+    }
+}
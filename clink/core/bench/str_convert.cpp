@@ -0,0 +1,34 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+BENCH_CASE("str_convert")
+{
+    // A long ASCII body with a multi-byte tail, so both the fast path and
+    // the full decoder get exercised.
+    str<> utf8;
+    for (int i = 0; i < 64; ++i)
+        utf8 << "path\\to\\some file-";
+    utf8 << "\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80";
+
+    wstr<> utf16;
+    to_utf16(utf16, utf8.c_str());
+
+    const unsigned int iterations = 100000;
+
+    wstr<> wout;
+    ctx.measure("to_utf16", iterations, [&] () {
+        wout.clear();
+        bench::consume(to_utf16(wout, utf8.c_str()));
+    });
+
+    str<> out;
+    ctx.measure("to_utf8", iterations, [&] () {
+        out.clear();
+        bench::consume(to_utf8(out, utf16.c_str()));
+    });
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "linear_allocator.h"
+#include "str.h"
+
+//------------------------------------------------------------------------------
+// Growable strings whose initial buffer is carved from a linear_allocator,
+// for short-lived temporaries on hot paths; the arena is rewound wholesale
+// once the pass that created them is done, so neither construction nor
+// destruction touches the heap.  A string that outgrows its slab falls back
+// to the heap like any growable str -- the arena is an optimisation, not a
+// cap.  If the arena itself is exhausted the string starts out with a one
+// character buffer and grows from the heap on first use.
+class arena_str : public str_base
+{
+public:
+    explicit        arena_str(linear_allocator& arena, unsigned int size=128)
+    : str_base(m_inline, 1)
+    {
+        set_growable();
+
+        if (char* data = (char*)arena.alloc(size * sizeof(char)))
+            reset_data(data, size);
+
+        clear();
+    }
+
+    using           str_base::operator =;
+
+private:
+    char            m_inline[1];
+};
+
+//------------------------------------------------------------------------------
+class arena_wstr : public wstr_base
+{
+public:
+    explicit        arena_wstr(linear_allocator& arena, unsigned int size=128)
+    : wstr_base(m_inline, 1)
+    {
+        set_growable();
+
+        if (wchar_t* data = (wchar_t*)arena.alloc(size * sizeof(wchar_t)))
+            reset_data(data, size);
+
+        clear();
+    }
+
+    using           wstr_base::operator =;
+
+private:
+    wchar_t         m_inline[1];
+};
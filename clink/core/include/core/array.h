@@ -3,6 +3,10 @@
 
 #pragma once
 
+#include <new>
+#include <stdlib.h>
+#include <utility>
+
 //------------------------------------------------------------------------------
 template <typename T>
 class array
@@ -103,3 +107,167 @@ public:
 private:
     T           m_buffer[SIZE];
 };
+
+
+
+//------------------------------------------------------------------------------
+// Like fixed_array, but spills to the heap with geometric growth when the
+// inline capacity is exceeded, so SIZE is a starting point rather than a cap
+// and push_back() only returns nullptr when allocation fails.  Elements are
+// constructed by push_back()/resize() and must be movable, since they get
+// moved when the storage grows.
+template <typename T, unsigned int SIZE>
+class small_vector
+    : public array<T>
+{
+public:
+                small_vector() : array<T>(get_inline(), 0, SIZE) {}
+                small_vector(small_vector&& rhs) : small_vector() { *this = std::move(rhs); }
+                small_vector(const small_vector&) = delete;
+                ~small_vector();
+
+    small_vector& operator = (small_vector&& rhs);
+    void        operator = (const small_vector&) = delete;
+
+    void        clear();
+    bool        reserve(unsigned int capacity);
+    bool        resize(unsigned int size);
+    T*          push_back();
+    T*          push_back(const T& value);
+    T*          push_back(T&& value);
+
+private:
+    T*          get_inline() { return reinterpret_cast<T*>(m_inline); }
+    bool        is_inline() const { return (this->m_ptr == reinterpret_cast<const T*>(m_inline)); }
+
+    alignas(T)  unsigned char m_inline[SIZE * sizeof(T)];
+};
+
+//------------------------------------------------------------------------------
+template <typename T, unsigned int SIZE>
+small_vector<T, SIZE>::~small_vector()
+{
+    clear();
+    if (!is_inline())
+        free(this->m_ptr);
+}
+
+//------------------------------------------------------------------------------
+template <typename T, unsigned int SIZE>
+small_vector<T, SIZE>& small_vector<T, SIZE>::operator = (small_vector&& rhs)
+{
+    clear();
+    if (!is_inline())
+    {
+        free(this->m_ptr);
+        this->m_ptr = get_inline();
+        this->m_capacity = SIZE;
+    }
+
+    if (rhs.is_inline())
+    {
+        // Inline elements move one by one.
+        if (reserve(rhs.m_size))
+        {
+            for (unsigned int i = 0; i < rhs.m_size; ++i)
+                new (this->m_ptr + i) T(std::move(rhs.m_ptr[i]));
+            this->m_size = rhs.m_size;
+        }
+        rhs.clear();
+    }
+    else
+    {
+        // Heap storage transfers wholesale.
+        this->m_ptr = rhs.m_ptr;
+        this->m_size = rhs.m_size;
+        this->m_capacity = rhs.m_capacity;
+        rhs.m_ptr = rhs.get_inline();
+        rhs.m_size = 0;
+        rhs.m_capacity = SIZE;
+    }
+
+    return *this;
+}
+
+//------------------------------------------------------------------------------
+template <typename T, unsigned int SIZE>
+void small_vector<T, SIZE>::clear()
+{
+    for (unsigned int i = this->m_size; i--;)
+        (this->m_ptr + i)->~T();
+    this->m_size = 0;
+}
+
+//------------------------------------------------------------------------------
+template <typename T, unsigned int SIZE>
+bool small_vector<T, SIZE>::reserve(unsigned int capacity)
+{
+    if (capacity <= this->m_capacity)
+        return true;
+
+    unsigned int new_capacity = this->m_capacity;
+    while (new_capacity < capacity)
+        new_capacity += new_capacity;
+
+    T* new_ptr = static_cast<T*>(malloc(new_capacity * sizeof(T)));
+    if (new_ptr == nullptr)
+        return false;
+
+    for (unsigned int i = 0; i < this->m_size; ++i)
+    {
+        new (new_ptr + i) T(std::move(this->m_ptr[i]));
+        (this->m_ptr + i)->~T();
+    }
+
+    if (!is_inline())
+        free(this->m_ptr);
+
+    this->m_ptr = new_ptr;
+    this->m_capacity = new_capacity;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+template <typename T, unsigned int SIZE>
+bool small_vector<T, SIZE>::resize(unsigned int size)
+{
+    if (!reserve(size))
+        return false;
+
+    while (this->m_size > size)
+        (this->m_ptr + --this->m_size)->~T();
+    while (this->m_size < size)
+        new (this->m_ptr + this->m_size++) T();
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+template <typename T, unsigned int SIZE>
+T* small_vector<T, SIZE>::push_back()
+{
+    if (this->full() && !reserve(this->m_size + 1))
+        return nullptr;
+
+    return new (this->m_ptr + this->m_size++) T();
+}
+
+//------------------------------------------------------------------------------
+template <typename T, unsigned int SIZE>
+T* small_vector<T, SIZE>::push_back(const T& value)
+{
+    if (this->full() && !reserve(this->m_size + 1))
+        return nullptr;
+
+    return new (this->m_ptr + this->m_size++) T(value);
+}
+
+//------------------------------------------------------------------------------
+template <typename T, unsigned int SIZE>
+T* small_vector<T, SIZE>::push_back(T&& value)
+{
+    if (this->full() && !reserve(this->m_size + 1))
+        return nullptr;
+
+    return new (this->m_ptr + this->m_size++) T(std::move(value));
+}
@@ -60,6 +60,13 @@ template <class A> A clamp(A v, A m, A M) { return min(max(v, m), M); }
 #endif
 //#define PRAGMA_ERROR(s) __pragma(message (FILE_LINE "error: " s))
 
+//------------------------------------------------------------------------------
+// Allocation accounting (see core/perf_counters.h).  Each instrumented event
+// costs one counter increment; define to 0 to compile the accounting out.
+#ifndef CLINK_PERF_COUNTERS
+#define CLINK_PERF_COUNTERS 1
+#endif
+
 //------------------------------------------------------------------------------
 extern const char* const bindableEsc;
 
@@ -0,0 +1,37 @@
+// Copyright (c) 2015 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "str.h"
+
+#include <Windows.h>
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Process-wide cache of directory listings so consecutive completions (and
+// Lua globs) in the same directory hit memory instead of the file system.
+// Listings are stored unfiltered -- hidden and system entries included, dot
+// entries excluded, no dir suffix -- and callers apply their own filtering.
+// A cached listing stays valid while the directory's last-write time is
+// unchanged; snapshot() should be called before enumerating so a change that
+// lands mid-enumeration invalidates the stored listing.
+namespace dir_cache
+{
+
+struct entry
+{
+    str_moveable    name;       // File name only; no path, no dir suffix.
+    int             st_mode;
+    int             attr;
+};
+
+typedef std::vector<entry> listing;
+
+std::shared_ptr<const listing> find(const char* dir);
+bool        snapshot(const char* dir, FILETIME& write_time);
+void        store(const char* dir, const std::shared_ptr<const listing>& entries, const FILETIME& write_time);
+void        clear();
+
+}; // namespace dir_cache
@@ -0,0 +1,23 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+//------------------------------------------------------------------------------
+// Hashed index of the executables in the %PATH% directories.  Each directory
+// is enumerated once and re-enumerated only when its timestamp changes, so
+// asking whether a word names a PATH executable costs hash lookups instead of
+// a filesystem probe per directory and extension.
+namespace exec_index
+{
+
+// Returns true when 'name' -- a bare command word, with or without one of the
+// %PATHEXT% extensions -- names an executable in a %PATH% directory.  Words
+// containing a path separator or drive are not the index's business and
+// return false.
+bool lookup(const char* name);
+
+// Drops the index; the next lookup rebuilds it from scratch.
+void clear();
+
+};
@@ -7,6 +7,16 @@
 
 #include <Windows.h>
 
+//------------------------------------------------------------------------------
+// One enumerated entry for the batch APIs; sized so a small stack array of
+// them is cheap for callers to reserve up front.
+struct glob_entry
+{
+    str<280>            path;
+    int                 st_mode;
+    int                 attr;
+};
+
 //------------------------------------------------------------------------------
 class globber
 {
@@ -20,6 +30,7 @@ public:
     void                system(bool state)      { m_system = state; }
     void                dots(bool state)        { m_dots = state; }
     bool                next(str_base& out, bool rooted=true, int* st_mode=nullptr, int* pattr=nullptr);
+    unsigned int        next_batch(glob_entry* out, unsigned int max_count, bool rooted=true);
 
 private:
                         globber(const globber&) = delete;
@@ -35,3 +46,41 @@ private:
     bool                m_system;
     bool                m_dots;
 };
+
+//------------------------------------------------------------------------------
+// Enumerates on a worker thread into a ring buffer so callers can consume the
+// first entries while the rest of a (possibly slow, e.g. network) directory is
+// still being read.  Filter setters must be called before the first next();
+// the worker starts lazily on the first call.
+class async_globber
+{
+public:
+                        async_globber(const char* pattern);
+                        ~async_globber();
+    void                files(bool state)       { m_globber.files(state); }
+    void                directories(bool state) { m_globber.directories(state); }
+    void                suffix_dirs(bool state) { m_globber.suffix_dirs(state); }
+    void                hidden(bool state)      { m_globber.hidden(state); }
+    void                system(bool state)      { m_globber.system(state); }
+    void                dots(bool state)        { m_globber.dots(state); }
+    bool                next(str_base& out, bool rooted=true, int* st_mode=nullptr, int* pattr=nullptr);
+    unsigned int        next_batch(glob_entry* out, unsigned int max_count, bool rooted=true);
+
+private:
+                        async_globber(const async_globber&) = delete;
+    void                operator = (const async_globber&) = delete;
+    enum { ring_size = 64 }; // Power of two; cursors index modulo this.
+    static DWORD WINAPI thread_proc(void* param);
+    void                start(bool rooted);
+    void                enumerate();
+    globber             m_globber;
+    glob_entry          m_ring[ring_size];
+    volatile long       m_write_cursor = 0;
+    volatile long       m_read_cursor = 0;
+    volatile bool       m_complete = false;
+    volatile bool       m_abort = false;
+    HANDLE              m_thread = nullptr;
+    HANDLE              m_data_event;
+    HANDLE              m_space_event;
+    bool                m_rooted = true;
+};
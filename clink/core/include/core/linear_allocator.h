@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "perf_counters.h"
+
 //------------------------------------------------------------------------------
 class linear_allocator
 {
@@ -10,6 +12,9 @@ public:
                           linear_allocator(int size);
                           linear_allocator(void* buffer, int size);
                           ~linear_allocator();
+    void                  reset();
+    void                  reset(void* buffer, int size);
+    int                   remaining() const;
     void*                 alloc(int size);
     template <class T> T* calloc(int count=1);
 
@@ -45,6 +50,34 @@ inline linear_allocator::~linear_allocator()
         free(m_buffer);
 }
 
+//------------------------------------------------------------------------------
+// Rewinds the allocator so the buffer can be recycled for a new round of
+// allocations.  Everything previously allocated from it is invalidated.
+inline void linear_allocator::reset()
+{
+    m_used = 0;
+}
+
+//------------------------------------------------------------------------------
+// Points the allocator at a new (unowned) buffer, discarding any bookkeeping
+// about the previous one.
+inline void linear_allocator::reset(void* buffer, int size)
+{
+    if (m_owned)
+        free(m_buffer);
+
+    m_buffer = (char*)buffer;
+    m_used = 0;
+    m_max = size;
+    m_owned = false;
+}
+
+//------------------------------------------------------------------------------
+inline int linear_allocator::remaining() const
+{
+    return m_max - m_used;
+}
+
 //------------------------------------------------------------------------------
 inline void* linear_allocator::alloc(int size)
 {
@@ -53,7 +86,10 @@ inline void* linear_allocator::alloc(int size)
 
     int used = m_used + size;
     if (used > m_max)
+    {
+        perf_counters::add(perf_counters::arena_exhausted);
         return nullptr;
+    }
 
     char* ptr = m_buffer + m_used;
     m_used = used;
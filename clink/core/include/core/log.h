@@ -6,6 +6,10 @@
 #include "str.h"
 #include "singleton.h"
 
+#include <Windows.h>
+
+#include <vector>
+
 //------------------------------------------------------------------------------
 #define LOG(...)    logger::info(__FUNCTION__, __LINE__, __VA_ARGS__)
 #define ERR(...)    logger::error(__FUNCTION__, __LINE__, __VA_ARGS__)
@@ -31,6 +35,108 @@ public:
                     file_logger(const char* log_path);
     virtual void    emit(const char* function, int line, const char* fmt, va_list args) override;
 
-private:
+protected:
     str<256>        m_log_path;
 };
+
+//------------------------------------------------------------------------------
+// Buffered variant of file_logger.  Log calls format the line and memcpy it
+// into a ring buffer; a low priority thread drains the ring to a file handle
+// that stays open for the logger's lifetime.  With verbose logging enabled
+// the per-call open/append/flush/close of file_logger measurably slows
+// injection, and this moves the file i/o off the hot path.  If the drain
+// thread can't be created it degrades to file_logger's synchronous appends.
+class async_file_logger
+    : public file_logger
+{
+public:
+                        async_file_logger(const char* log_path);
+    virtual             ~async_file_logger();
+    virtual void        emit(const char* function, int line, const char* fmt, va_list args) override;
+
+protected:
+    enum : unsigned int
+    {
+        ring_size       = 64,
+        max_message     = 510,
+    };
+
+    struct message
+    {
+        unsigned short  length;
+        char            text[max_message];
+    };
+
+                        async_file_logger(const char* log_path, bool binary);
+    bool                async() const { return m_thread != nullptr; }
+    void                publish(const message& msg);
+    FILE*               open_file() const;
+
+private:
+    static DWORD WINAPI thread_proc(void* param);
+    void                drain_loop();
+
+    message             m_ring[ring_size];
+    CRITICAL_SECTION    m_lock;
+    FILE*               m_file = nullptr;
+    HANDLE              m_thread = nullptr;
+    HANDLE              m_data_event = nullptr;
+    HANDLE              m_space_event = nullptr;
+    volatile long       m_write_cursor = 0;
+    volatile long       m_read_cursor = 0;
+    volatile bool       m_quit = false;
+    bool                m_binary = false;
+};
+
+//------------------------------------------------------------------------------
+// Structured variant of async_file_logger.  Instead of formatting at log time
+// emit() encodes a compact binary record -- an id interned per call site plus
+// the raw argument values -- and defers all formatting to 'clink log decode'.
+// Each call site's function, line, and format string are written once, in a
+// 'define' record the first time the site logs, so the file is self
+// describing.  Events the encoder can't represent (star widths, unrecognised
+// conversions) fall back to a preformatted text record, so nothing is lost.
+class binary_file_logger
+    : public async_file_logger
+{
+public:
+    enum record : unsigned char
+    {
+        record_define   = 0x01, // u32 id, u16 line, u8 func_len, u16 fmt_len, func, fmt
+        record_event    = 0x02, // u32 id, u32 pid, u8 argc, { u8 arg_*, payload }...
+        record_text     = 0x03, // u32 id, u32 pid, u16 len, preformatted text
+    };
+
+    enum arg : unsigned char
+    {
+        arg_int         = 0x00, // i64
+        arg_uint        = 0x01, // u64
+        arg_double      = 0x02, // f64
+        arg_pointer     = 0x03, // u64
+        arg_string      = 0x04, // u16 len, utf8 bytes
+        arg_wstring     = 0x05, // u16 len, utf16 code units
+    };
+
+    // First eight bytes of a binary log file.
+    static const char   c_magic[8];
+
+                        binary_file_logger(const char* log_path);
+    virtual             ~binary_file_logger();
+    virtual void        emit(const char* function, int line, const char* fmt, va_list args) override;
+
+private:
+    struct site
+    {
+        const char*     function;
+        const char*     fmt;
+        int             line;
+    };
+
+    unsigned int        intern(const char* function, int line, const char* fmt, message& define, bool& first);
+    bool                encode_event(message& out, unsigned int id, const char* fmt, va_list args);
+    void                encode_text(message& out, unsigned int id, const char* fmt, va_list args);
+    void                dispatch(const message& msg);
+
+    std::vector<site>   m_sites;
+    CRITICAL_SECTION    m_intern_lock;
+};
@@ -18,8 +18,8 @@ bool match_char_impl(int pc, int fc)
 {
     if (MODE > 0)
     {
-        pc = (pc > 0xffff) ? pc : int(uintptr_t(CharLowerW(LPWSTR(uintptr_t(pc)))));
-        fc = (fc > 0xffff) ? fc : int(uintptr_t(CharLowerW(LPWSTR(uintptr_t(fc)))));
+        pc = fold_case(pc);
+        fc = fold_case(fc);
     }
 
     if (MODE > 1)
@@ -206,6 +206,70 @@ back_track:
     }
 }
 
+//------------------------------------------------------------------------------
+// Compiles a wildcard pattern once per query:  binds the compare scope's
+// match_wild_impl instantiation up front and precomputes the minimum
+// candidate length (literal pattern characters, with separator runs counted
+// once since the matcher treats "\\\\" and "\" as equal).  Filtering a large
+// match set then pays the scope dispatch once per query instead of per
+// candidate, and rejects too-short candidates without running the matcher.
+template <class T>
+class wild_matcher
+{
+public:
+    explicit wild_matcher(const str_iter_impl<T>& pattern)
+    : m_pattern(pattern)
+    {
+        bool fuzzy_accents = str_compare_scope::current_fuzzy_accents();
+        switch (str_compare_scope::current())
+        {
+        case str_compare_scope::relaxed:
+            m_impl = fuzzy_accents ? match_wild_impl<T, 2, true> : match_wild_impl<T, 2, false>;
+            break;
+        case str_compare_scope::caseless:
+            m_impl = fuzzy_accents ? match_wild_impl<T, 1, true> : match_wild_impl<T, 1, false>;
+            break;
+        default:
+            m_impl = fuzzy_accents ? match_wild_impl<T, 0, true> : match_wild_impl<T, 0, false>;
+            break;
+        }
+
+        // '*' and '?' can both match zero characters, so only literal
+        // characters contribute to the minimum candidate length.
+        str_iter_impl<T> iter(pattern);
+        bool in_separators = false;
+        while (int c = iter.peek())
+        {
+            if (c == '*' || c == '?')
+                in_separators = false;
+            else if (path::is_separator(c))
+            {
+                m_min_length += !in_separators;
+                in_separators = true;
+            }
+            else
+            {
+                ++m_min_length;
+                in_separators = false;
+            }
+            iter.next();
+        }
+    }
+
+    bool match(const str_iter_impl<T>& file, bool star_matches_everything=false) const
+    {
+        if (file.length() < m_min_length)
+            return false;
+        return m_impl(m_pattern, file, star_matches_everything);
+    }
+
+private:
+    typedef bool        (impl_func)(const str_iter_impl<T>&, const str_iter_impl<T>&, bool);
+    str_iter_impl<T>    m_pattern;
+    impl_func*          m_impl;
+    unsigned int        m_min_length = 0;
+};
+
 //------------------------------------------------------------------------------
 template <class T>
 bool match_wild(const str_iter_impl<T>& pattern, const str_iter_impl<T>& file, bool star_matches_everything=false)
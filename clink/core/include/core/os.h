@@ -23,11 +23,14 @@ bool    set_current_dir(const char* dir);
 bool    make_dir(const char* dir);
 bool    remove_dir(const char* dir);
 bool    unlink(const char* path);
-bool    move(const char* src_path, const char* dest_path);
+bool    move(const char* src_path, const char* dest_path, bool replace=false);
 bool    copy(const char* src_path, const char* dest_path);
 bool    get_temp_dir(str_base& out);
 bool    get_env(const char* name, str_base& out);
 bool    set_env(const char* name, const char* value);
+void    refresh_env_snapshot();
+unsigned int get_env_revision();
+bool    get_env_name(unsigned int index, str_base& out);
 bool    get_alias(const char* name, str_base& out);
 
 }; // namespace os
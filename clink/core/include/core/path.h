@@ -33,6 +33,7 @@ bool        is_rooted(const char* path);
 bool        is_root(const char* path);
 bool        join(const char* lhs, const char* rhs, str_base& out);
 bool        append(str_base& out, const char* rhs);
+bool        append(str_base& out, const char* rhs, int rhs_length);
 void        maybe_strip_last_separator(str_base& out);
 void        maybe_strip_last_separator(wstr_base& out);
 bool        to_parent(str_base& out, str_base* child);
@@ -0,0 +1,47 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "base.h"
+
+//------------------------------------------------------------------------------
+// Counts allocation events that are cheap individually but can dominate
+// keystroke cost in aggregate (string buffer regrowth, match store paging,
+// scratch arena overflow).  Counters are process-wide running totals; the
+// increments are unsynchronised, so with worker threads involved the values
+// are statistics rather than exact counts, which is all they're used for.
+//
+// The accounting compiles out entirely when CLINK_PERF_COUNTERS (core/base.h)
+// is 0; when enabled each event costs a single increment.
+class perf_counters
+{
+public:
+    enum counter
+    {
+        str_reallocs,       // str_base::reserve allocated a new buffer.
+        str_realloc_bytes,  // bytes allocated by those regrowths.
+        arena_exhausted,    // linear_allocator::alloc failed for lack of space.
+        match_pages,        // match store pages allocated.
+        match_page_bytes,   // bytes in those pages.
+        count
+    };
+
+    static void                 add(counter c, unsigned long long amount=1);
+    static unsigned long long   get(counter c);
+    static const char*          get_name(counter c);
+    static void                 reset();
+};
+
+//------------------------------------------------------------------------------
+#if CLINK_PERF_COUNTERS
+extern unsigned long long g_perf_counters[];
+inline void perf_counters::add(counter c, unsigned long long amount)
+{
+    g_perf_counters[c] += amount;
+}
+#else
+inline void perf_counters::add(counter, unsigned long long)
+{
+}
+#endif
@@ -38,8 +38,12 @@ namespace settings
 
 setting_iter        first();
 setting*            find(const char* name);
+void                format_list(str_base& out);
 bool                load(const char* file);
 bool                save(const char* file);
+bool                sync();
+void                begin_transaction();
+bool                commit_transaction(const char* file);
 
 };
 
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "perf_counters.h"
+
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -147,6 +149,13 @@ bool str_impl<TYPE>::reserve(unsigned int new_size, bool exact)
     if (!exact)
         new_size = (new_size + 63) & ~63;
 
+#if CLINK_PERF_COUNTERS
+    // Counts spills out of a str<N>'s inline buffer as well as regrowth of a
+    // heap buffer; both are the allocations being measured.
+    perf_counters::add(perf_counters::str_reallocs);
+    perf_counters::add(perf_counters::str_realloc_bytes, new_size * sizeof(TYPE));
+#endif
+
     TYPE* new_data = (TYPE*)malloc(new_size * sizeof(TYPE));
     memcpy(new_data, c_str(), m_size * sizeof(TYPE));
 
@@ -40,6 +40,23 @@ private:
 
 //------------------------------------------------------------------------------
 int normalize_accent(int c);
+const wchar_t* get_case_fold_table();
+
+//------------------------------------------------------------------------------
+// Lower-cases a code point without a Win32 call per character: ASCII folds
+// inline and the rest of the BMP goes through a table built once with
+// CharLowerW.  Code points outside the BMP are returned unchanged, matching
+// what CharLowerW does with them.
+inline int fold_case(int c)
+{
+    if (unsigned(c) < 0x80)
+        return (c >= 'A' && c <= 'Z') ? c + 0x20 : c;
+
+    if (c > 0xffff)
+        return c;
+
+    return get_case_fold_table()[c];
+}
 
 //------------------------------------------------------------------------------
 // Returns how many characters match at the beginning of the strings, or -1 if
@@ -58,8 +75,8 @@ int str_compare_impl(str_iter_impl<T>& lhs, str_iter_impl<T>& rhs)
 
         if (MODE > 0)
         {
-            c = (c > 0xffff) ? c : int(uintptr_t(CharLowerW(LPWSTR(uintptr_t(c)))));
-            d = (d > 0xffff) ? d : int(uintptr_t(CharLowerW(LPWSTR(uintptr_t(d)))));
+            c = fold_case(c);
+            d = fold_case(d);
         }
 
         if (MODE > 1)
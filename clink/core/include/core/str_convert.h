@@ -0,0 +1,59 @@
+// Copyright (c) 2015 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "str.h"
+
+//------------------------------------------------------------------------------
+// Reusable conversion buffers for the UTF-8/UTF-16 crossings in hot paths
+// (hooked console APIs, os queries).  A context claims a buffer from a small
+// process-wide pool for its lifetime; pooled buffers keep their allocation at
+// its high-water size, so steady-state conversions of strings too long for a
+// stack buffer (a PATH value, an 8K doskey macro) stop paying a heap round
+// trip per call.
+//
+// The pool is claimed with interlocked operations instead of living in
+// thread-local storage:  some callers run on short-lived worker threads, and
+// pre-VS2015 threadlocal (see base.h) can't run destructors, so per-thread
+// buffers would leak at their high-water size every time such a thread exits.
+// When the pool is exhausted (deep nesting, many threads) a context falls
+// back to a plain growable buffer, which is simply today's behaviour.
+class utf16_conversion_context
+{
+public:
+                    utf16_conversion_context();
+    explicit        utf16_conversion_context(const char* utf8);
+                    ~utf16_conversion_context();
+                    utf16_conversion_context(const utf16_conversion_context&) = delete;
+    void            operator = (const utf16_conversion_context&) = delete;
+
+    wstr_base&      get()           { return *m_str; }
+    const wchar_t*  c_str() const   { return m_str->c_str(); }
+    unsigned int    length() const  { return m_str->length(); }
+
+private:
+    wstr_base*      m_str;
+    int             m_slot;
+    wstr<16>        m_fallback;
+};
+
+//------------------------------------------------------------------------------
+class utf8_conversion_context
+{
+public:
+                    utf8_conversion_context();
+    explicit        utf8_conversion_context(const wchar_t* utf16);
+                    ~utf8_conversion_context();
+                    utf8_conversion_context(const utf8_conversion_context&) = delete;
+    void            operator = (const utf8_conversion_context&) = delete;
+
+    str_base&       get()           { return *m_str; }
+    const char*     c_str() const   { return m_str->c_str(); }
+    unsigned int    length() const  { return m_str->length(); }
+
+private:
+    str_base*       m_str;
+    int             m_slot;
+    str<16>         m_fallback;
+};
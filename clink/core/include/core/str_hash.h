@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <string.h>
+
 //------------------------------------------------------------------------------
 template <typename T> unsigned int str_hash_impl(const T* in, unsigned int length)
 {
@@ -29,3 +31,76 @@ inline unsigned int wstr_hash(const wchar_t* in, int length=-1)
 {
     return str_hash_impl<wchar_t>(in, length);
 }
+
+
+
+//------------------------------------------------------------------------------
+// 64-bit seeded hash with MurmurHash64A mixing.  It consumes eight bytes per
+// mix instead of one, which matters for the long keys the indexes hash
+// constantly (history lines, match paths), and the wider result makes
+// collisions -- and the compares that resolve them -- rarer.  The 32-bit
+// str_hash above remains for hashes that are persisted or exposed (cache file
+// names, clink.stringhash).
+template <bool CASELESS>
+unsigned long long str_hash64_impl(const unsigned char* in, unsigned int length, unsigned long long seed)
+{
+    const unsigned long long m = 0xc6a4a7935bd1e995ull;
+    const int r = 47;
+
+    unsigned long long h = seed ^ (length * m);
+
+    while (length)
+    {
+        unsigned long long k;
+        const unsigned int n = (length < 8) ? length : 8;
+        if (!CASELESS && n == 8)
+        {
+            // Unaligned word load; compilers turn this into a single mov.
+            memcpy(&k, in, sizeof(k));
+        }
+        else
+        {
+            k = 0;
+            for (unsigned int i = 0; i < n; ++i)
+            {
+                unsigned long long c = in[i];
+                if (CASELESS && c >= 'A' && c <= 'Z')
+                    c += 0x20;
+                k |= c << (i * 8);
+            }
+        }
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+
+        in += n;
+        length -= n;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+//------------------------------------------------------------------------------
+inline unsigned long long str_hash64(const char* in, int length=-1, unsigned long long seed=0)
+{
+    if (length < 0)
+        length = int(strlen(in));
+    return str_hash64_impl<false>((const unsigned char*)in, (unsigned int)length, seed);
+}
+
+//------------------------------------------------------------------------------
+// Folds ASCII upper case while hashing, for caseless keys (environment
+// variable names, executable file names); fold-then-hash matches how the
+// caseless byte-at-a-time hashes folded.
+inline unsigned long long str_hash64_caseless(const char* in, int length=-1, unsigned long long seed=0)
+{
+    if (length < 0)
+        length = int(strlen(in));
+    return str_hash64_impl<true>((const unsigned char*)in, (unsigned int)length, seed);
+}
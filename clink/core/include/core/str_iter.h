@@ -15,6 +15,7 @@ public:
                     str_iter_impl(const str_iter_impl<T>& i);
     const T*        get_pointer() const;
     const T*        get_next_pointer();
+    const T*        get_end_pointer() const;
     void            reset_pointer(const T* ptr);
     int             peek();
     int             next();
@@ -63,6 +64,15 @@ template <typename T> const T* str_iter_impl<T>::get_next_pointer()
     return ret;
 };
 
+//------------------------------------------------------------------------------
+// The end sentinel.  For unbounded iterators it is before the start and the
+// terminator bounds iteration instead; callers scanning [pointer, end) must
+// check for that.
+template <typename T> const T* str_iter_impl<T>::get_end_pointer() const
+{
+    return m_end;
+}
+
 //------------------------------------------------------------------------------
 template <typename T> void str_iter_impl<T>::reset_pointer(const T* ptr)
 {
@@ -89,3 +99,11 @@ template <typename T> bool str_iter_impl<T>::more() const
 //------------------------------------------------------------------------------
 typedef str_iter_impl<char>     str_iter;
 typedef str_iter_impl<wchar_t>  wstr_iter;
+
+//------------------------------------------------------------------------------
+// Returns a pointer to the first byte in [begin, end) below 'limit', or 'end'
+// when there isn't one.  SSE2, 16 bytes at a time; shared by the scanners that
+// walk utf-8 runs looking for a control byte (in utf-8 every unit of a multi
+// byte encoding is 0x80 or above, so byte-wise scans below 0x20 are safe).
+// 'limit' must be at least 1.
+const char* scan_for_byte_below(const char* begin, const char* end, unsigned char limit);
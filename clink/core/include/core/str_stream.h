@@ -0,0 +1,129 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "str.h"
+#include "str_iter.h"
+
+//------------------------------------------------------------------------------
+// Accumulates characters and segments into one growing buffer and serialises
+// once, so a string built from many pieces costs O(total bytes) instead of a
+// copy of everything so far per piece the way repeated concatenation can.
+template <typename T>
+class str_stream_impl
+{
+public:
+    typedef T               TYPE;
+
+    struct range_desc
+    {
+        const TYPE* const   ptr;
+        unsigned int        count;
+    };
+
+                            str_stream_impl();
+                            ~str_stream_impl();
+    void                    operator << (TYPE c);
+    void                    operator << (const range_desc desc);
+    void                    collect(str_impl<TYPE>& out);
+    TYPE*                   detach();
+    static range_desc       range(TYPE const* ptr, unsigned int count);
+    static range_desc       range(const str_iter_impl<TYPE>& iter);
+
+private:
+    void                    grow(unsigned int hint=128);
+    TYPE* __restrict        m_start;
+    TYPE* __restrict        m_end;
+    TYPE* __restrict        m_cursor;
+};
+
+//------------------------------------------------------------------------------
+template <typename T>
+str_stream_impl<T>::str_stream_impl()
+: m_start(nullptr)
+, m_end(nullptr)
+, m_cursor(nullptr)
+{
+}
+
+//------------------------------------------------------------------------------
+template <typename T>
+str_stream_impl<T>::~str_stream_impl()
+{
+    free(m_start);
+}
+
+//------------------------------------------------------------------------------
+template <typename T>
+void str_stream_impl<T>::operator << (TYPE c)
+{
+    if (m_cursor >= m_end)
+        grow();
+
+    *m_cursor++ = c;
+}
+
+//------------------------------------------------------------------------------
+template <typename T>
+void str_stream_impl<T>::operator << (const range_desc desc)
+{
+    if (m_cursor + desc.count >= m_end)
+        grow(desc.count);
+
+    for (unsigned int i = 0; i < desc.count; ++i, ++m_cursor)
+        *m_cursor = desc.ptr[i];
+}
+
+//------------------------------------------------------------------------------
+template <typename T>
+typename str_stream_impl<T>::range_desc str_stream_impl<T>::range(const TYPE* ptr, unsigned int count)
+{
+    return { ptr, count };
+}
+
+//------------------------------------------------------------------------------
+template <typename T>
+typename str_stream_impl<T>::range_desc str_stream_impl<T>::range(const str_iter_impl<TYPE>& iter)
+{
+    return { iter.get_pointer(), (unsigned int)iter.length() };
+}
+
+//------------------------------------------------------------------------------
+// Hands the accumulated buffer to 'out' without copying.  The caller is
+// responsible for having streamed a terminator.
+template <typename T>
+void str_stream_impl<T>::collect(str_impl<TYPE>& out)
+{
+    out.attach(m_start, int(m_cursor - m_start));
+    m_start = m_end = m_cursor = nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Null-terminates and releases the accumulated buffer to the caller, who owns
+// freeing it (it comes from malloc/realloc).
+template <typename T>
+typename str_stream_impl<T>::TYPE* str_stream_impl<T>::detach()
+{
+    *this << TYPE('\0');
+
+    TYPE* ptr = m_start;
+    m_start = m_end = m_cursor = nullptr;
+    return ptr;
+}
+
+//------------------------------------------------------------------------------
+template <typename T>
+void str_stream_impl<T>::grow(unsigned int hint)
+{
+    hint = (hint + 127) & ~127;
+    unsigned int size = int(m_end - m_start) + hint;
+    TYPE* next = (TYPE*)realloc(m_start, size * sizeof(TYPE));
+    m_cursor = next + (m_cursor - m_start);
+    m_end = next + size;
+    m_start = next;
+}
+
+//------------------------------------------------------------------------------
+typedef str_stream_impl<char>       str_stream;
+typedef str_stream_impl<wchar_t>    wstr_stream;
@@ -21,6 +21,18 @@ public:
 
 
 
+//------------------------------------------------------------------------------
+// Zero-copy token; an (offset,length) slice over the tokenised buffer, plus
+// the strongest delimiter found before the token.
+struct str_token_slice
+{
+    unsigned int        offset;
+    unsigned int        length;
+    unsigned char       delim;
+};
+
+
+
 //------------------------------------------------------------------------------
 template <typename T>
 class str_tokeniser_impl
@@ -32,6 +44,8 @@ public:
     str_token           next(str_impl<T>& out);
     str_token           next(const T*& start, int& length);
     str_token           next(str_iter_impl<T>& out);
+    str_token           next(str_token_slice& out);
+    unsigned int        tokenise(str_token_slice* out, unsigned int max_count);
 
 private:
     struct quote
@@ -46,6 +60,7 @@ private:
     str_token           next_impl(const T*& out_start, int& out_length);
     quotes              m_quotes;
     str_iter_impl<T>    m_iter;
+    const T*            m_start;    // For slice offsets.
     const char*         m_delims;
 };
 
@@ -53,6 +68,7 @@ private:
 template <typename T>
 str_tokeniser_impl<T>::str_tokeniser_impl(const T* in, const char* delims)
 : m_iter(in)
+, m_start(in)
 , m_delims(delims)
 {
 }
@@ -61,6 +77,7 @@ str_tokeniser_impl<T>::str_tokeniser_impl(const T* in, const char* delims)
 template <typename T>
 str_tokeniser_impl<T>::str_tokeniser_impl(const str_iter_impl<T>& in, const char* delims)
 : m_iter(in)
+, m_start(in.get_pointer())
 , m_delims(delims)
 {
 }
@@ -0,0 +1,64 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+//------------------------------------------------------------------------------
+// Records how long named phases take (hooking, loading scripts, settings,
+// history, ...) so injection and prompt latency can be broken down from the
+// log file or from Lua instead of guessing with external profilers.
+class timings
+{
+public:
+    struct record
+    {
+        const char*     name;       // points at a string literal.
+        float           elapsed_ms; // most recent measurement for the phase.
+    };
+
+    struct stats
+    {
+        const char*     name;       // points at a string literal.
+        unsigned int    count;
+        float           total_ms;
+        float           worst_ms;
+    };
+
+    static unsigned int     get_count();
+    static const record*    get_record(unsigned int index);
+    static void             accumulate(const char* name, float elapsed_ms);
+    static void             log_stats(const char* heading);
+
+private:
+    friend class            timing_scope;
+    static void             add(const char* name, float elapsed_ms);
+};
+
+//------------------------------------------------------------------------------
+// Measures the lifetime of a scope and records it against 'name', which must
+// be a string literal.
+class timing_scope
+{
+public:
+                            timing_scope(const char* name);
+                            ~timing_scope();
+
+private:
+    const char*             m_name;
+    long long               m_start;
+};
+
+//------------------------------------------------------------------------------
+// Like timing_scope, but accumulates into per-name statistics (count, total,
+// worst) instead of recording a single measurement, for stages that run once
+// per keystroke.  Does nothing when constructed disabled.
+class timing_accumulator
+{
+public:
+                            timing_accumulator(const char* name, bool enabled=true);
+                            ~timing_accumulator();
+
+private:
+    const char*             m_name;
+    long long               m_start;
+};
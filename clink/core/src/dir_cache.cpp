@@ -0,0 +1,162 @@
+// Copyright (c) 2015 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "dir_cache.h"
+#include "os.h"
+#include "path.h"
+
+namespace dir_cache
+{
+
+//------------------------------------------------------------------------------
+static const int cache_slots = 8;
+
+struct slot
+{
+    str_moveable                    path;
+    std::shared_ptr<const listing>  entries;
+    FILETIME                        write_time;
+    unsigned int                    generation = 0;
+};
+
+struct cache
+{
+                        cache() { InitializeCriticalSection(&m_cs); }
+    CRITICAL_SECTION    m_cs;
+    slot                m_slots[cache_slots];
+    unsigned int        m_generation = 0;
+};
+
+//------------------------------------------------------------------------------
+static cache& get_cache()
+{
+    static cache s_cache;
+    return s_cache;
+}
+
+//------------------------------------------------------------------------------
+// Keys are absolute paths with normalised separators; relative paths resolve
+// against the current directory, matching what FindFirstFileW would open.
+// Comparison is case-insensitive like the file system.
+static void make_key(const char* dir, str_base& out)
+{
+    if (path::is_rooted(dir))
+        out.copy(dir);
+    else
+    {
+        os::get_current_dir(out);
+        path::append(out, dir);
+    }
+
+    path::normalise_separators(out.data());
+}
+
+//------------------------------------------------------------------------------
+static bool get_write_time(const char* dir, FILETIME& out)
+{
+    wstr<280> wdir(dir);
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(wdir.c_str(), GetFileExInfoStandard, &fad))
+        return false;
+
+    if (!(fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        return false;
+
+    out = fad.ftLastWriteTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const listing> find(const char* dir)
+{
+    str<280> key;
+    make_key(dir, key);
+
+    FILETIME write_time;
+    if (!get_write_time(key.c_str(), write_time))
+        return nullptr;
+
+    cache& c = get_cache();
+    EnterCriticalSection(&c.m_cs);
+
+    std::shared_ptr<const listing> result;
+    for (slot& s : c.m_slots)
+    {
+        if (s.entries != nullptr && _stricmp(s.path.c_str(), key.c_str()) == 0)
+        {
+            if (CompareFileTime(&s.write_time, &write_time) == 0)
+            {
+                s.generation = ++c.m_generation;
+                result = s.entries;
+            }
+            else
+                s.entries = nullptr;
+
+            break;
+        }
+    }
+
+    LeaveCriticalSection(&c.m_cs);
+    return result;
+}
+
+//------------------------------------------------------------------------------
+bool snapshot(const char* dir, FILETIME& write_time)
+{
+    str<280> key;
+    make_key(dir, key);
+    return get_write_time(key.c_str(), write_time);
+}
+
+//------------------------------------------------------------------------------
+void store(
+    const char* dir,
+    const std::shared_ptr<const listing>& entries,
+    const FILETIME& write_time)
+{
+    str<280> key;
+    make_key(dir, key);
+
+    cache& c = get_cache();
+    EnterCriticalSection(&c.m_cs);
+
+    // Reuse the slot already holding this directory, else the least recently
+    // used one.
+    slot* victim = c.m_slots;
+    for (slot& s : c.m_slots)
+    {
+        if (s.entries != nullptr && _stricmp(s.path.c_str(), key.c_str()) == 0)
+        {
+            victim = &s;
+            break;
+        }
+
+        if (s.entries == nullptr)
+        {
+            if (victim->entries != nullptr)
+                victim = &s;
+        }
+        else if (victim->entries != nullptr && s.generation < victim->generation)
+            victim = &s;
+    }
+
+    victim->path.copy(key.c_str());
+    victim->entries = entries;
+    victim->write_time = write_time;
+    victim->generation = ++c.m_generation;
+
+    LeaveCriticalSection(&c.m_cs);
+}
+
+//------------------------------------------------------------------------------
+void clear()
+{
+    cache& c = get_cache();
+    EnterCriticalSection(&c.m_cs);
+    for (slot& s : c.m_slots)
+        s.entries = nullptr;
+    LeaveCriticalSection(&c.m_cs);
+}
+
+}; // namespace dir_cache
@@ -0,0 +1,236 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "exec_index.h"
+#include "globber.h"
+#include "os.h"
+#include "path.h"
+#include "str.h"
+#include "str_hash.h"
+#include "str_tokeniser.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace exec_index
+{
+
+//------------------------------------------------------------------------------
+// Directory timestamps are re-checked at most this often; within the window
+// lookups are pure hash probes.
+static const ULONGLONG c_verify_interval_ms = 2000;
+
+//------------------------------------------------------------------------------
+struct dir_entry
+{
+    str_moveable        dir;
+    FILETIME            write_time;
+    bool                have_time = false;
+    std::vector<str_moveable> names;
+    std::unordered_multimap<unsigned long long, unsigned int> lookup;
+};
+
+//------------------------------------------------------------------------------
+struct index
+{
+                        index() { InitializeCriticalSection(&m_cs); }
+    CRITICAL_SECTION    m_cs;
+    str_moveable        m_path;     // %PATH% the index was built from.
+    str_moveable        m_pathext;  // %PATHEXT% the index was built from.
+    std::vector<str_moveable> m_exts;
+    std::vector<dir_entry> m_dirs;
+    ULONGLONG           m_next_verify = 0;
+    bool                m_valid = false;
+};
+
+//------------------------------------------------------------------------------
+static index& get_index()
+{
+    static index s_index;
+    return s_index;
+}
+
+//------------------------------------------------------------------------------
+// Case-insensitive name hash (file names compare case-insensitively);
+// lookups confirm candidates with stricmp.
+static unsigned long long hash_name(const char* name)
+{
+    return str_hash64_caseless(name);
+}
+
+//------------------------------------------------------------------------------
+static bool get_write_time(const char* dir, FILETIME& out)
+{
+    wstr<280> wdir(dir);
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(wdir.c_str(), GetFileExInfoStandard, &fad))
+        return false;
+
+    if (!(fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        return false;
+
+    out = fad.ftLastWriteTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// The timestamp is captured before enumerating; a change racing with the
+// enumeration shows up as another change on the next verify pass.
+static void enumerate_dir(dir_entry& entry)
+{
+    entry.names.clear();
+    entry.lookup.clear();
+    entry.have_time = get_write_time(entry.dir.c_str(), entry.write_time);
+
+    str<280> pattern(entry.dir.c_str());
+    path::append(pattern, "*");
+
+    globber globber(pattern.c_str());
+    globber.directories(false);
+
+    str<280> name;
+    while (globber.next(name, false/*rooted*/))
+    {
+        if (!path::is_executable_extension(name.c_str()))
+            continue;
+
+        unsigned int i = (unsigned int)entry.names.size();
+        entry.names.emplace_back();
+        entry.names.back().copy(name.c_str());
+        entry.lookup.insert({hash_name(name.c_str()), i});
+    }
+}
+
+//------------------------------------------------------------------------------
+static void rebuild(index& x, const char* paths, const char* pathext)
+{
+    x.m_path.copy(paths);
+    x.m_pathext.copy(pathext);
+
+    const char* start;
+    int length;
+
+    x.m_exts.clear();
+    {
+        str_tokeniser tokens(pathext, ";");
+        while (tokens.next(start, length))
+        {
+            x.m_exts.emplace_back();
+            x.m_exts.back().concat(start, length);
+        }
+    }
+
+    x.m_dirs.clear();
+    {
+        str_tokeniser tokens(paths, ";");
+        while (tokens.next(start, length))
+        {
+            if (!length)
+                continue;
+
+            x.m_dirs.emplace_back();
+            dir_entry& entry = x.m_dirs.back();
+            entry.dir.concat(start, length);
+            enumerate_dir(entry);
+        }
+    }
+
+    x.m_valid = true;
+}
+
+//------------------------------------------------------------------------------
+static void verify(index& x)
+{
+    for (dir_entry& entry : x.m_dirs)
+    {
+        FILETIME write_time;
+        bool have_time = get_write_time(entry.dir.c_str(), write_time);
+        if (have_time != entry.have_time ||
+            (have_time && CompareFileTime(&entry.write_time, &write_time) != 0))
+        {
+            enumerate_dir(entry);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+static bool find_name(const index& x, const char* name)
+{
+    const unsigned long long hash = hash_name(name);
+    for (const dir_entry& entry : x.m_dirs)
+    {
+        auto range = entry.lookup.equal_range(hash);
+        for (auto iter = range.first; iter != range.second; ++iter)
+            if (stricmp(entry.names[iter->second].c_str(), name) == 0)
+                return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+bool lookup(const char* name)
+{
+    if (!*name || strpbrk(name, "/\\:") != nullptr)
+        return false;
+
+    str<> paths;
+    str<> pathext;
+    if (!os::get_env("path", paths) || !os::get_env("pathext", pathext))
+        return false;
+
+    index& x = get_index();
+    EnterCriticalSection(&x.m_cs);
+
+    if (!x.m_valid ||
+        stricmp(x.m_path.c_str(), paths.c_str()) != 0 ||
+        stricmp(x.m_pathext.c_str(), pathext.c_str()) != 0)
+    {
+        rebuild(x, paths.c_str(), pathext.c_str());
+        x.m_next_verify = GetTickCount64() + c_verify_interval_ms;
+    }
+    else
+    {
+        ULONGLONG now = GetTickCount64();
+        if (now >= x.m_next_verify)
+        {
+            verify(x);
+            x.m_next_verify = now + c_verify_interval_ms;
+        }
+    }
+
+    bool found = false;
+    if (path::is_executable_extension(name))
+        found = find_name(x, name);
+
+    if (!found)
+    {
+        str<280> candidate;
+        for (const str_moveable& ext : x.m_exts)
+        {
+            candidate.clear();
+            candidate << name << ext.c_str();
+            if (find_name(x, candidate.c_str()))
+            {
+                found = true;
+                break;
+            }
+        }
+    }
+
+    LeaveCriticalSection(&x.m_cs);
+    return found;
+}
+
+//------------------------------------------------------------------------------
+void clear()
+{
+    index& x = get_index();
+    EnterCriticalSection(&x.m_cs);
+    x.m_dirs.clear();
+    x.m_valid = false;
+    LeaveCriticalSection(&x.m_cs);
+}
+
+}; // namespace exec_index
@@ -44,8 +44,15 @@ globber::globber(const char* pattern)
         }
     }
 
+    // FindExInfoBasic skips the short name (which nothing here reads) and
+    // FIND_FIRST_EX_LARGE_FETCH makes the OS read the directory in large
+    // batches; both help a lot on network shares.  Fall back to the plain
+    // call for OSes that don't support them.
     wstr<280> wglob(pattern);
-    m_handle = FindFirstFileW(wglob.c_str(), &m_data);
+    m_handle = FindFirstFileExW(wglob.c_str(), FindExInfoBasic, &m_data,
+        FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (m_handle == INVALID_HANDLE_VALUE)
+        m_handle = FindFirstFileW(wglob.c_str(), &m_data);
     if (m_handle == INVALID_HANDLE_VALUE)
         m_handle = nullptr;
 
@@ -63,10 +70,6 @@ globber::~globber()
 //------------------------------------------------------------------------------
 bool globber::next(str_base& out, bool rooted, int* st_mode, int* pattr)
 {
-    if (m_handle == nullptr)
-        return false;
-
-    str<280> file_name;
     int attr;
 
     while (true)
@@ -74,7 +77,6 @@ bool globber::next(str_base& out, bool rooted, int* st_mode, int* pattr)
         if (m_handle == nullptr)
             return false;
 
-        file_name = m_data.cFileName;
         attr = m_data.dwFileAttributes;
 
         bool again = false;
@@ -87,17 +89,27 @@ bool globber::next(str_base& out, bool rooted, int* st_mode, int* pattr)
         again |= (attr & FILE_ATTRIBUTE_DIRECTORY) && !m_directories;
         again |= !(attr & FILE_ATTRIBUTE_DIRECTORY) && !m_files;
 
-        next_file();
-
         if (!again)
             break;
+
+        next_file();
     }
 
     out.clear();
     if (rooted)
         out << m_root;
 
-    path::append(out, file_name.c_str());
+    // The equivalent of path::append(), but converting the UTF16 name
+    // directly into the caller's buffer instead of snapshotting it through
+    // an intermediate string.  The name is never rooted and never starts
+    // with a separator, so only the left-hand separator rules apply.
+    bool add_separator = out.length() && !path::is_separator(out[out.length() - 1]);
+    add_separator &= !(isalpha((unsigned char)out[0]) && out[1] == ':' && out[2] == '\0');
+    if (add_separator)
+        out << PATH_SEP;
+
+    to_utf8(out, m_data.cFileName);
+    next_file();
 
     if (attr & FILE_ATTRIBUTE_DIRECTORY && m_dir_suffix)
         out << PATH_SEP;
@@ -122,6 +134,20 @@ bool globber::next(str_base& out, bool rooted, int* st_mode, int* pattr)
     return true;
 }
 
+//------------------------------------------------------------------------------
+// Fills up to max_count entries per call; returns how many were filled, zero
+// at the end of the enumeration.  Callers reserve the out storage once and
+// avoid the per-entry call overhead of looping over next().
+unsigned int globber::next_batch(glob_entry* out, unsigned int max_count, bool rooted)
+{
+    unsigned int count = 0;
+    while (count < max_count &&
+           next(out[count].path, rooted, &out[count].st_mode, &out[count].attr))
+        ++count;
+
+    return count;
+}
+
 //------------------------------------------------------------------------------
 void globber::next_file()
 {
@@ -131,3 +157,133 @@ void globber::next_file()
     FindClose(m_handle);
     m_handle = nullptr;
 }
+
+
+
+//------------------------------------------------------------------------------
+async_globber::async_globber(const char* pattern)
+: m_globber(pattern)
+{
+    m_data_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    m_space_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+}
+
+//------------------------------------------------------------------------------
+async_globber::~async_globber()
+{
+    if (m_thread != nullptr)
+    {
+        // The worker may be blocked waiting for ring space; tell it to bail.
+        m_abort = true;
+        SetEvent(m_space_event);
+        WaitForSingleObject(m_thread, INFINITE);
+        CloseHandle(m_thread);
+    }
+
+    CloseHandle(m_data_event);
+    CloseHandle(m_space_event);
+}
+
+//------------------------------------------------------------------------------
+DWORD WINAPI async_globber::thread_proc(void* param)
+{
+    ((async_globber*)param)->enumerate();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+void async_globber::start(bool rooted)
+{
+    m_rooted = rooted;
+    m_thread = CreateThread(nullptr, 0, thread_proc, this, 0, nullptr);
+    if (m_thread == nullptr)
+        m_complete = true; // next() falls back to draining nothing.
+}
+
+//------------------------------------------------------------------------------
+// Worker thread; single producer.  Only m_write_cursor is written here, so
+// the cursors don't need a lock -- the events just provide the wake-ups.
+void async_globber::enumerate()
+{
+    while (!m_abort)
+    {
+        long write = m_write_cursor;
+        if (write - m_read_cursor == ring_size)
+        {
+            WaitForSingleObject(m_space_event, INFINITE);
+            continue;
+        }
+
+        glob_entry& slot = m_ring[write & (ring_size - 1)];
+        if (!m_globber.next(slot.path, m_rooted, &slot.st_mode, &slot.attr))
+            break;
+
+        m_write_cursor = write + 1;
+        SetEvent(m_data_event);
+    }
+
+    m_complete = true;
+    SetEvent(m_data_event);
+}
+
+//------------------------------------------------------------------------------
+bool async_globber::next(str_base& out, bool rooted, int* st_mode, int* pattr)
+{
+    if (m_thread == nullptr && !m_complete)
+        start(rooted);
+
+    long read = m_read_cursor;
+    while (read == m_write_cursor)
+    {
+        if (m_complete)
+            return false;
+
+        WaitForSingleObject(m_data_event, INFINITE);
+    }
+
+    const glob_entry& slot = m_ring[read & (ring_size - 1)];
+    out.copy(slot.path.c_str());
+    if (st_mode != nullptr)
+        *st_mode = slot.st_mode;
+    if (pattr != nullptr)
+        *pattr = slot.attr;
+
+    m_read_cursor = read + 1;
+    SetEvent(m_space_event);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Batch variant; waits for the first entry then drains whatever else the
+// worker has already produced, signalling the worker once per batch instead
+// of once per entry.
+unsigned int async_globber::next_batch(glob_entry* out, unsigned int max_count, bool rooted)
+{
+    if (m_thread == nullptr && !m_complete)
+        start(rooted);
+
+    long read = m_read_cursor;
+    while (read == m_write_cursor)
+    {
+        if (m_complete)
+            return 0;
+
+        WaitForSingleObject(m_data_event, INFINITE);
+    }
+
+    unsigned int count = 0;
+    long write = m_write_cursor;
+    while (count < max_count && read != write)
+    {
+        const glob_entry& slot = m_ring[read & (ring_size - 1)];
+        out[count].path.copy(slot.path.c_str());
+        out[count].st_mode = slot.st_mode;
+        out[count].attr = slot.attr;
+        ++count;
+        ++read;
+    }
+
+    m_read_cursor = read;
+    SetEvent(m_space_event);
+    return count;
+}
@@ -73,3 +73,472 @@ void file_logger::emit(const char* function, int line, const char* fmt, va_list
 
     fclose(file);
 }
+
+
+
+//------------------------------------------------------------------------------
+async_file_logger::async_file_logger(const char* log_path)
+: async_file_logger(log_path, false)
+{
+}
+
+//------------------------------------------------------------------------------
+async_file_logger::async_file_logger(const char* log_path, bool binary)
+: file_logger(log_path)
+, m_binary(binary)
+{
+    InitializeCriticalSection(&m_lock);
+
+    m_data_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    m_space_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (m_data_event != nullptr && m_space_event != nullptr)
+    {
+        m_thread = CreateThread(nullptr, 0, thread_proc, this, 0, nullptr);
+        if (m_thread != nullptr)
+            SetThreadPriority(m_thread, THREAD_PRIORITY_LOWEST);
+    }
+}
+
+//------------------------------------------------------------------------------
+async_file_logger::~async_file_logger()
+{
+    if (m_thread != nullptr)
+    {
+        m_quit = true;
+        SetEvent(m_data_event);
+        WaitForSingleObject(m_thread, INFINITE);
+        CloseHandle(m_thread);
+    }
+
+    if (m_data_event != nullptr)
+        CloseHandle(m_data_event);
+
+    if (m_space_event != nullptr)
+        CloseHandle(m_space_event);
+
+    if (m_file != nullptr)
+        fclose(m_file);
+
+    DeleteCriticalSection(&m_lock);
+}
+
+//------------------------------------------------------------------------------
+void async_file_logger::emit(const char* function, int line, const char* fmt, va_list args)
+{
+    if (m_thread == nullptr)
+        return file_logger::emit(function, line, fmt, args);
+
+    // Format on the calling thread; a va_list can't be handed to another one.
+    str<24> func_name;
+    func_name << function;
+
+    message msg;
+    int used = _snprintf(msg.text, sizeof_array(msg.text), "%04x %-24s %4d ",
+        GetCurrentProcessId(), func_name.c_str(), line);
+    if (used < 0)
+        return;
+
+    int length = vsnprintf(msg.text + used, sizeof_array(msg.text) - used - 1, fmt, args);
+    used = (length < 0) ? sizeof_array(msg.text) - 1 : min<int>(used + length, sizeof_array(msg.text) - 1);
+    msg.text[used++] = '\n';
+    msg.length = (unsigned short)used;
+
+    publish(msg);
+}
+
+//------------------------------------------------------------------------------
+void async_file_logger::publish(const message& msg)
+{
+    // Publish into the ring, waiting for space if the drain thread is behind.
+    EnterCriticalSection(&m_lock);
+    while (m_write_cursor - m_read_cursor >= long(ring_size))
+    {
+        LeaveCriticalSection(&m_lock);
+        WaitForSingleObject(m_space_event, INFINITE);
+        EnterCriticalSection(&m_lock);
+    }
+
+    message& slot = m_ring[m_write_cursor % ring_size];
+    slot.length = msg.length;
+    memcpy(slot.text, msg.text, msg.length);
+    ++m_write_cursor;
+    LeaveCriticalSection(&m_lock);
+
+    SetEvent(m_data_event);
+}
+
+//------------------------------------------------------------------------------
+FILE* async_file_logger::open_file() const
+{
+    if (!m_binary)
+        return fopen(m_log_path.c_str(), "at");
+
+    // Binary logs must dodge the CRT's newline translation, and start with a
+    // magic header so the decoder can recognise them.
+    FILE* file = fopen(m_log_path.c_str(), "ab");
+    if (file != nullptr)
+    {
+        fseek(file, 0, SEEK_END);
+        if (ftell(file) == 0)
+            fwrite(binary_file_logger::c_magic, sizeof(binary_file_logger::c_magic), 1, file);
+    }
+    return file;
+}
+
+//------------------------------------------------------------------------------
+DWORD WINAPI async_file_logger::thread_proc(void* param)
+{
+    ((async_file_logger*)param)->drain_loop();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+void async_file_logger::drain_loop()
+{
+    m_file = open_file();
+
+    while (true)
+    {
+        WaitForSingleObject(m_data_event, INFINITE);
+
+        bool drained = false;
+        while (m_read_cursor != m_write_cursor)
+        {
+            const message& msg = m_ring[m_read_cursor % ring_size];
+            if (m_file != nullptr)
+                fwrite(msg.text, msg.length, 1, m_file);
+            ++m_read_cursor;
+            SetEvent(m_space_event);
+            drained = true;
+        }
+
+        if (drained && m_file != nullptr)
+            fflush(m_file);
+
+        if (m_quit && m_read_cursor == m_write_cursor)
+            break;
+    }
+}
+
+
+
+//------------------------------------------------------------------------------
+// Appends fields to a record, refusing to overflow the message's capacity.
+struct record_writer
+{
+                    record_writer(char* out, unsigned int capacity)
+                    : m_out(out), m_capacity(capacity) {}
+
+    bool put_bytes(const void* bytes, unsigned int count)
+    {
+        if (m_fail || count > m_capacity - m_used)
+        {
+            m_fail = true;
+            return false;
+        }
+
+        memcpy(m_out + m_used, bytes, count);
+        m_used += count;
+        return true;
+    }
+
+    template <typename T>
+    bool put(T value)   { return put_bytes(&value, sizeof(value)); }
+
+    char*           m_out;
+    unsigned int    m_capacity;
+    unsigned int    m_used = 0;
+    bool            m_fail = false;
+};
+
+
+
+//------------------------------------------------------------------------------
+const char binary_file_logger::c_magic[8] = { 'c','l','n','k','l','o','g','1' };
+
+//------------------------------------------------------------------------------
+binary_file_logger::binary_file_logger(const char* log_path)
+: async_file_logger(log_path, true)
+{
+    InitializeCriticalSection(&m_intern_lock);
+}
+
+//------------------------------------------------------------------------------
+binary_file_logger::~binary_file_logger()
+{
+    DeleteCriticalSection(&m_intern_lock);
+}
+
+//------------------------------------------------------------------------------
+void binary_file_logger::emit(const char* function, int line, const char* fmt, va_list args)
+{
+    message define;
+    bool first = false;
+    unsigned int id = intern(function, line, fmt, define, first);
+    if (first)
+        dispatch(define);
+
+    // Encoding consumes the va_list, so give the text fallback a fresh one.
+    message event;
+    va_list copy;
+    va_copy(copy, args);
+    bool encoded = encode_event(event, id, fmt, copy);
+    va_end(copy);
+
+    if (!encoded)
+        encode_text(event, id, fmt, args);
+
+    dispatch(event);
+}
+
+//------------------------------------------------------------------------------
+void binary_file_logger::dispatch(const message& msg)
+{
+    if (async())
+        return publish(msg);
+
+    // Degraded mode; append synchronously like file_logger does for text.
+    if (FILE* file = open_file())
+    {
+        fwrite(msg.text, msg.length, 1, file);
+        fclose(file);
+    }
+}
+
+//------------------------------------------------------------------------------
+unsigned int binary_file_logger::intern(
+    const char* function,
+    int line,
+    const char* fmt,
+    message& define,
+    bool& first)
+{
+    first = false;
+
+    // Call sites are identified by pointer; format strings are literals so a
+    // site always presents the same pointers.  Literals the compiler didn't
+    // fold across translation units just intern twice, which is harmless.
+    EnterCriticalSection(&m_intern_lock);
+
+    unsigned int id = 0;
+    for (unsigned int i = 0; i < (unsigned int)m_sites.size(); ++i)
+    {
+        const site& s = m_sites[i];
+        if (s.fmt == fmt && s.line == line && s.function == function)
+        {
+            id = i + 1;
+            break;
+        }
+    }
+
+    if (!id)
+    {
+        m_sites.push_back({ function, fmt, line });
+        id = (unsigned int)m_sites.size();
+        first = true;
+    }
+
+    LeaveCriticalSection(&m_intern_lock);
+
+    if (first)
+    {
+        unsigned int func_len = min<unsigned int>((unsigned int)strlen(function), 0xff);
+        unsigned int fmt_len = min<unsigned int>((unsigned int)strlen(fmt), 0x180);
+
+        record_writer writer(define.text, max_message);
+        writer.put<unsigned char>(record_define);
+        writer.put(id);
+        writer.put<unsigned short>((unsigned short)line);
+        writer.put<unsigned char>((unsigned char)func_len);
+        writer.put<unsigned short>((unsigned short)fmt_len);
+        writer.put_bytes(function, func_len);
+        writer.put_bytes(fmt, fmt_len);
+        define.length = (unsigned short)writer.m_used;
+    }
+
+    return id;
+}
+
+//------------------------------------------------------------------------------
+bool binary_file_logger::encode_event(
+    message& out,
+    unsigned int id,
+    const char* fmt,
+    va_list args)
+{
+    record_writer writer(out.text, max_message);
+    writer.put<unsigned char>(record_event);
+    writer.put(id);
+    writer.put<unsigned int>(GetCurrentProcessId());
+
+    unsigned int argc_cursor = writer.m_used;
+    writer.put<unsigned char>(0);
+
+    unsigned char argc = 0;
+    for (const char* p = fmt; *p; ++p)
+    {
+        if (*p != '%')
+            continue;
+
+        ++p;
+        if (*p == '%')
+            continue;
+
+        // Flags, width, and precision.  A '*' pulls an extra argument whose
+        // position the decoder couldn't recover, so punt to the fallback.
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+            ++p;
+        if (*p == '*')
+            return false;
+        while (*p >= '0' && *p <= '9')
+            ++p;
+        if (*p == '.')
+        {
+            ++p;
+            if (*p == '*')
+                return false;
+            while (*p >= '0' && *p <= '9')
+                ++p;
+        }
+
+        // Length modifier; only the width of the va_arg read matters here.
+        bool wide = false;
+        bool size64 = false;
+        switch (*p)
+        {
+        case 'h':
+            ++p;
+            if (*p == 'h')
+                ++p;
+            break;
+
+        case 'l':
+            ++p;
+            if (*p == 'l')
+            {
+                size64 = true;  // '%ld' is still 32 bits on Windows.
+                ++p;
+            }
+            else
+                wide = true;
+            break;
+
+        case 'w':   wide = true; ++p;                       break;
+        case 'j':   size64 = true; ++p;                     break;
+        case 'z':
+        case 't':   size64 = (sizeof(size_t) == 8); ++p;    break;
+
+        case 'I':
+            ++p;
+            if (p[0] == '6' && p[1] == '4')         { size64 = true; p += 2; }
+            else if (p[0] == '3' && p[1] == '2')    p += 2;
+            else                                    size64 = (sizeof(size_t) == 8);
+            break;
+        }
+
+        if (argc == 0xff)
+            return false;
+
+        switch (*p)
+        {
+        case 'd':
+        case 'i':
+            writer.put<unsigned char>(arg_int);
+            writer.put<__int64>(size64 ? va_arg(args, __int64) : va_arg(args, int));
+            break;
+
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            writer.put<unsigned char>(arg_uint);
+            writer.put<unsigned __int64>(size64 ? va_arg(args, unsigned __int64) : va_arg(args, unsigned int));
+            break;
+
+        case 'c':
+            writer.put<unsigned char>(arg_int);
+            writer.put<__int64>(va_arg(args, int));
+            break;
+
+        case 'p':
+            writer.put<unsigned char>(arg_pointer);
+            writer.put<unsigned __int64>((uintptr_t)va_arg(args, void*));
+            break;
+
+        case 'f': case 'F':
+        case 'e': case 'E':
+        case 'g': case 'G':
+        case 'a': case 'A':
+            writer.put<unsigned char>(arg_double);
+            writer.put(va_arg(args, double));
+            break;
+
+        case 'S':
+            wide = !wide;
+            // fall through
+        case 's':
+            if (wide)
+            {
+                const wchar_t* value = va_arg(args, const wchar_t*);
+                if (value == nullptr)
+                    value = L"(null)";
+                size_t length = wcslen(value);
+                if (length > 0xffff)
+                    return false;
+                writer.put<unsigned char>(arg_wstring);
+                writer.put<unsigned short>((unsigned short)length);
+                writer.put_bytes(value, (unsigned int)(length * sizeof(*value)));
+            }
+            else
+            {
+                const char* value = va_arg(args, const char*);
+                if (value == nullptr)
+                    value = "(null)";
+                size_t length = strlen(value);
+                if (length > 0xffff)
+                    return false;
+                writer.put<unsigned char>(arg_string);
+                writer.put<unsigned short>((unsigned short)length);
+                writer.put_bytes(value, (unsigned int)length);
+            }
+            break;
+
+        default:
+            return false;
+        }
+
+        if (writer.m_fail)
+            return false;
+
+        ++argc;
+    }
+
+    out.text[argc_cursor] = (char)argc;
+    out.length = (unsigned short)writer.m_used;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void binary_file_logger::encode_text(
+    message& out,
+    unsigned int id,
+    const char* fmt,
+    va_list args)
+{
+    record_writer writer(out.text, max_message);
+    writer.put<unsigned char>(record_text);
+    writer.put(id);
+    writer.put<unsigned int>(GetCurrentProcessId());
+
+    unsigned int len_cursor = writer.m_used;
+    writer.put<unsigned short>(0);
+
+    int capacity = int(max_message - writer.m_used);
+    int length = vsnprintf(out.text + writer.m_used, capacity, fmt, args);
+    if (length < 0 || length >= capacity)
+        length = capacity - 1; // Truncated; vsnprintf kept a byte for the nul.
+
+    unsigned short len16 = (unsigned short)length;
+    memcpy(out.text + len_cursor, &len16, sizeof(len16));
+    out.length = (unsigned short)(writer.m_used + length);
+}
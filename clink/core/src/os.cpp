@@ -5,7 +5,14 @@
 #include "os.h"
 #include "path.h"
 #include "str.h"
+#include "str_convert.h"
+#include "str_hash.h"
+#include "str_iter.h"
+
 #include <locale.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 // We use UTF8 everywhere, and we need to tell the CRT so that mbrtowc and etc
 // use UTF8 instead of the default CRT pseudo-locale.
@@ -19,6 +26,143 @@ static auto_set_locale_utf8 s_auto_utf8;
 namespace os
 {
 
+//------------------------------------------------------------------------------
+// Short-lived cache of file attribute queries.  Word classification and Lua
+// scripts probe the same paths repeatedly within a single prompt (PATH
+// lookups, speculative executable checks), and each probe is a filesystem
+// round trip.  Negative results (path does not exist) are cached too, since
+// those are the common case when probing PATH.  Entries expire after a short
+// TTL so changes made by other processes show up promptly; changes made
+// through this API invalidate the cache immediately.
+class attr_cache
+{
+public:
+                        attr_cache() { InitializeCriticalSection(&m_cs); }
+    bool                get(const char* path, DWORD& attr);
+    void                store(const char* path, DWORD attr);
+    void                clear();
+
+private:
+    struct slot
+    {
+        str_moveable    path;
+        DWORD           attr;
+        ULONGLONG       expires = 0;    // 0 means the slot is empty.
+        unsigned int    generation = 0;
+    };
+
+    static void         make_key(const char* path, str_base& out);
+
+    static const int    c_slots = 128;
+    static const int    c_ttl_ms = 1000;
+
+    CRITICAL_SECTION    m_cs;
+    slot                m_slots[c_slots];
+    unsigned int        m_generation = 0;
+};
+
+//------------------------------------------------------------------------------
+static attr_cache& get_attr_cache()
+{
+    static attr_cache s_cache;
+    return s_cache;
+}
+
+//------------------------------------------------------------------------------
+// Keys are absolute paths with normalised separators, compared
+// case-insensitively like the file system; relative paths resolve against
+// the current directory so the cache survives directory changes.
+void attr_cache::make_key(const char* path, str_base& out)
+{
+    if (path::is_rooted(path))
+        out.copy(path);
+    else
+    {
+        get_current_dir(out);
+        path::append(out, path);
+    }
+
+    path::normalise_separators(out.data());
+}
+
+//------------------------------------------------------------------------------
+bool attr_cache::get(const char* path, DWORD& attr)
+{
+    str<280> key;
+    make_key(path, key);
+
+    ULONGLONG now = GetTickCount64();
+    bool hit = false;
+
+    EnterCriticalSection(&m_cs);
+    for (slot& s : m_slots)
+    {
+        if (s.expires && _stricmp(s.path.c_str(), key.c_str()) == 0)
+        {
+            if (now < s.expires)
+            {
+                s.generation = ++m_generation;
+                attr = s.attr;
+                hit = true;
+            }
+            else
+                s.expires = 0;
+
+            break;
+        }
+    }
+    LeaveCriticalSection(&m_cs);
+
+    return hit;
+}
+
+//------------------------------------------------------------------------------
+void attr_cache::store(const char* path, DWORD attr)
+{
+    str<280> key;
+    make_key(path, key);
+
+    ULONGLONG expires = GetTickCount64() + c_ttl_ms;
+
+    EnterCriticalSection(&m_cs);
+
+    // Reuse the slot already holding this path, else an empty slot, else the
+    // least recently used one.
+    slot* victim = m_slots;
+    for (slot& s : m_slots)
+    {
+        if (s.expires && _stricmp(s.path.c_str(), key.c_str()) == 0)
+        {
+            victim = &s;
+            break;
+        }
+
+        if (!s.expires)
+        {
+            if (victim->expires)
+                victim = &s;
+        }
+        else if (victim->expires && s.generation < victim->generation)
+            victim = &s;
+    }
+
+    victim->path.copy(key.c_str());
+    victim->attr = attr;
+    victim->expires = expires;
+    victim->generation = ++m_generation;
+
+    LeaveCriticalSection(&m_cs);
+}
+
+//------------------------------------------------------------------------------
+void attr_cache::clear()
+{
+    EnterCriticalSection(&m_cs);
+    for (slot& s : m_slots)
+        s.expires = 0;
+    LeaveCriticalSection(&m_cs);
+}
+
 //------------------------------------------------------------------------------
 DWORD get_file_attributes(const wchar_t* path)
 {
@@ -41,8 +185,16 @@ DWORD get_file_attributes(const wchar_t* path)
 //------------------------------------------------------------------------------
 DWORD get_file_attributes(const char* path)
 {
+    attr_cache& cache = get_attr_cache();
+
+    DWORD attr;
+    if (cache.get(path, attr))
+        return attr;
+
     wstr<280> wpath(path);
-    return get_file_attributes(wpath.c_str());
+    attr = get_file_attributes(wpath.c_str());
+    cache.store(path, attr);
+    return attr;
 }
 
 //------------------------------------------------------------------------------
@@ -68,6 +220,12 @@ bool is_hidden(const char* path)
 //------------------------------------------------------------------------------
 int get_file_size(const char* path)
 {
+    // A cached negative attribute query proves the path doesn't exist without
+    // another filesystem round trip; CreateFileW would just fail for it.
+    DWORD attr;
+    if (get_attr_cache().get(path, attr) && attr == INVALID_FILE_ATTRIBUTES)
+        return -1;
+
     wstr<280> wpath(path);
     void* handle = CreateFileW(wpath.c_str(), 0, 0, nullptr, OPEN_EXISTING, 0, nullptr);
     if (handle == INVALID_HANDLE_VALUE)
@@ -110,7 +268,10 @@ bool make_dir(const char* dir)
     if (*dir)
     {
         wstr<280> wdir(dir);
-        return (CreateDirectoryW(wdir.c_str(), nullptr) == TRUE);
+        bool ok = (CreateDirectoryW(wdir.c_str(), nullptr) == TRUE);
+        if (ok)
+            get_attr_cache().clear();
+        return ok;
     }
 
     return true;
@@ -120,22 +281,32 @@ bool make_dir(const char* dir)
 bool remove_dir(const char* dir)
 {
     wstr<280> wdir(dir);
-    return (RemoveDirectoryW(wdir.c_str()) == TRUE);
+    bool ok = (RemoveDirectoryW(wdir.c_str()) == TRUE);
+    if (ok)
+        get_attr_cache().clear();
+    return ok;
 }
 
 //------------------------------------------------------------------------------
 bool unlink(const char* path)
 {
     wstr<280> wpath(path);
-    return (DeleteFileW(wpath.c_str()) == TRUE);
+    bool ok = (DeleteFileW(wpath.c_str()) == TRUE);
+    if (ok)
+        get_attr_cache().clear();
+    return ok;
 }
 
 //------------------------------------------------------------------------------
-bool move(const char* src_path, const char* dest_path)
+bool move(const char* src_path, const char* dest_path, bool replace)
 {
     wstr<280> wsrc_path(src_path);
     wstr<280> wdest_path(dest_path);
-    return (MoveFileW(wsrc_path.c_str(), wdest_path.c_str()) == TRUE);
+    DWORD flags = replace ? MOVEFILE_REPLACE_EXISTING : 0;
+    bool ok = (MoveFileExW(wsrc_path.c_str(), wdest_path.c_str(), flags) == TRUE);
+    if (ok)
+        get_attr_cache().clear();
+    return ok;
 }
 
 //------------------------------------------------------------------------------
@@ -143,7 +314,10 @@ bool copy(const char* src_path, const char* dest_path)
 {
     wstr<280> wsrc_path(src_path);
     wstr<280> wdest_path(dest_path);
-    return (CopyFileW(wsrc_path.c_str(), wdest_path.c_str(), FALSE) == TRUE);
+    bool ok = (CopyFileW(wsrc_path.c_str(), wdest_path.c_str(), FALSE) == TRUE);
+    if (ok)
+        get_attr_cache().clear();
+    return ok;
 }
 
 //------------------------------------------------------------------------------
@@ -165,9 +339,148 @@ bool get_temp_dir(str_base& out)
     return true;
 }
 
+//------------------------------------------------------------------------------
+// Snapshot of the process environment block, captured with a single
+// GetEnvironmentStringsW call and served from a hashed table.  get_env()
+// otherwise costs two GetEnvironmentVariableW calls (size probe plus fetch)
+// and a UTF-8 conversion each time, which adds up when prompt filters and Lua
+// scripts read variables every prompt.  set_env() drops the snapshot; other
+// changes to the environment happen between prompts, when the host captures
+// a fresh one anyway.
+class env_snapshot
+{
+public:
+                        env_snapshot();
+    bool                get(const char* name, str_base& out) const;
+    const char*         get_name(unsigned int index) const;
+    unsigned int        get_revision() const { return m_revision; }
+
+private:
+    struct variable
+    {
+        str_moveable    name;
+        str_moveable    value;
+    };
+    static unsigned long long hash_name(const char* name);
+    std::vector<variable> m_variables;
+    std::unordered_multimap<unsigned long long, unsigned int> m_lookup;
+    unsigned int        m_revision;
+};
+
+//------------------------------------------------------------------------------
+unsigned long long env_snapshot::hash_name(const char* name)
+{
+    // Variable names are compared case-insensitively like the environment
+    // itself, so hash them case-folded.
+    return str_hash64_caseless(name);
+}
+
+//------------------------------------------------------------------------------
+env_snapshot::env_snapshot()
+{
+    // Distinguishes snapshots so enumeration results cached against one
+    // snapshot (e.g. the Lua environment name table) aren't served once a
+    // fresh snapshot replaces it.  Zero is reserved for "no snapshot".
+    static unsigned int s_next_revision = 0;
+    m_revision = ++s_next_revision;
+
+    wchar_t* strings = GetEnvironmentStringsW();
+    if (strings == nullptr)
+        return;
+
+    for (const wchar_t* c = strings; *c; c += wcslen(c) + 1)
+    {
+        // Entries like '=C:=...' store drive working directories and begin
+        // with '='; the name/value split is the next '='.
+        const wchar_t* eq = wcschr(c + 1, '=');
+        if (eq == nullptr)
+            continue;
+
+        m_variables.emplace_back();
+        variable& var = m_variables.back();
+
+        str_iter_impl<wchar_t> wname(c, int(eq - c));
+        to_utf8(var.name, wname);
+        to_utf8(var.value, eq + 1);
+
+        unsigned int index = (unsigned int)(m_variables.size() - 1);
+        m_lookup.insert({hash_name(var.name.c_str()), index});
+    }
+
+    FreeEnvironmentStringsW(strings);
+}
+
+//------------------------------------------------------------------------------
+bool env_snapshot::get(const char* name, str_base& out) const
+{
+    // Drive working directory variables ('=C:' etc.) track the current
+    // directory, which can change mid-prompt; always read those live.
+    if (name[0] == '=')
+        return false;
+
+    auto range = m_lookup.equal_range(hash_name(name));
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+        const variable& var = m_variables[iter->second];
+        if (stricmp(var.name.c_str(), name) == 0)
+        {
+            out.copy(var.value.c_str());
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+const char* env_snapshot::get_name(unsigned int index) const
+{
+    if (index >= m_variables.size())
+        return nullptr;
+
+    return m_variables[index].name.c_str();
+}
+
+//------------------------------------------------------------------------------
+static std::shared_ptr<const env_snapshot> s_env_snapshot;
+
+//------------------------------------------------------------------------------
+void refresh_env_snapshot()
+{
+    s_env_snapshot = std::make_shared<const env_snapshot>();
+}
+
+//------------------------------------------------------------------------------
+unsigned int get_env_revision()
+{
+    std::shared_ptr<const env_snapshot> snapshot = s_env_snapshot;
+    return (snapshot != nullptr) ? snapshot->get_revision() : 0;
+}
+
+//------------------------------------------------------------------------------
+bool get_env_name(unsigned int index, str_base& out)
+{
+    std::shared_ptr<const env_snapshot> snapshot = s_env_snapshot;
+    if (snapshot == nullptr)
+        return false;
+
+    const char* name = snapshot->get_name(index);
+    if (name == nullptr)
+        return false;
+
+    out.copy(name);
+    return true;
+}
+
 //------------------------------------------------------------------------------
 bool get_env(const char* name, str_base& out)
 {
+    // Local copy; match generators may read the environment from worker
+    // threads while set_env drops the shared snapshot.
+    std::shared_ptr<const env_snapshot> snapshot = s_env_snapshot;
+    if (snapshot != nullptr && snapshot->get(name, out))
+        return true;
+
     wstr<32> wname(name);
 
     int len = GetEnvironmentVariableW(wname.c_str(), nullptr, 0);
@@ -191,9 +504,11 @@ bool get_env(const char* name, str_base& out)
         return false;
     }
 
-    wstr<> wvalue;
-    wvalue.reserve(len);
-    len = GetEnvironmentVariableW(wname.c_str(), wvalue.data(), wvalue.size());
+    // Values like PATH routinely outgrow a stack buffer; the pooled context
+    // keeps one sized for the biggest value seen so far.
+    utf16_conversion_context wvalue;
+    wvalue.get().reserve(len);
+    len = GetEnvironmentVariableW(wname.c_str(), wvalue.get().data(), wvalue.get().size());
 
     out.reserve(len);
     out = wvalue.c_str();
@@ -210,7 +525,14 @@ bool set_env(const char* name, const char* value)
         wvalue = value;
 
     const wchar_t* value_arg = (value != nullptr) ? wvalue.c_str() : nullptr;
-    return (SetEnvironmentVariableW(wname.c_str(), value_arg) != 0);
+    bool ok = (SetEnvironmentVariableW(wname.c_str(), value_arg) != 0);
+
+    // The snapshot no longer reflects the environment; drop it.  Lookups fall
+    // back to the live environment until the next refresh.
+    if (ok)
+        s_env_snapshot = nullptr;
+
+    return ok;
 }
 
 //------------------------------------------------------------------------------
@@ -226,10 +548,12 @@ bool get_alias(const char* name, str_base& out)
     wstr<32> exe_name;
     exe_name = path::get_name(exe_path);
 
-    // Get the alias (aka. doskey macro).
-    wstr<32> buffer;
-    buffer.reserve(8191);
-    if (GetConsoleAliasW(alias_name.data(), buffer.data(), buffer.size(), exe_name.data()) == 0)
+    // Get the alias (aka. doskey macro).  The API wants a buffer big enough
+    // for any macro, and this runs for every word classified as a command, so
+    // use a pooled context instead of a fresh 16KB heap block per call.
+    utf16_conversion_context buffer;
+    buffer.get().reserve(8191);
+    if (GetConsoleAliasW(alias_name.data(), buffer.get().data(), buffer.get().size(), exe_name.data()) == 0)
         return false;
 
     if (!buffer.length())
@@ -407,6 +407,15 @@ bool join(const char* lhs, const char* rhs, str_base& out)
 
 //------------------------------------------------------------------------------
 bool append(str_base& out, const char* rhs)
+{
+    return append(out, rhs, -1);
+}
+
+//------------------------------------------------------------------------------
+// Length-bounded variant; 'rhs' must still be nul terminated at 'rhs_length'.
+// Saves the strlen inside concat when the caller already knows the length,
+// which adds up in per-entry joins while globbing large directories.
+bool append(str_base& out, const char* rhs, int rhs_length)
 {
     if (is_rooted(rhs))
         return out.copy(rhs);
@@ -428,7 +437,7 @@ bool append(str_base& out, const char* rhs)
     if (add_separator && !is_separator(rhs[0]))
         out << PATH_SEP;
 
-    return out.concat(rhs);
+    return out.concat(rhs, rhs_length);
 }
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,47 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "perf_counters.h"
+
+#include <string.h>
+
+//------------------------------------------------------------------------------
+#if CLINK_PERF_COUNTERS
+unsigned long long g_perf_counters[perf_counters::count] = {};
+#endif
+
+//------------------------------------------------------------------------------
+static const char* const c_counter_names[] = {
+    "str_reallocs",
+    "str_realloc_bytes",
+    "arena_exhausted",
+    "match_pages",
+    "match_page_bytes",
+};
+static_assert(sizeof_array(c_counter_names) == perf_counters::count,
+    "counter names out of sync with the counter enum");
+
+//------------------------------------------------------------------------------
+unsigned long long perf_counters::get(counter c)
+{
+#if CLINK_PERF_COUNTERS
+    if (unsigned(c) < count)
+        return g_perf_counters[c];
+#endif
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+const char* perf_counters::get_name(counter c)
+{
+    return (unsigned(c) < count) ? c_counter_names[c] : "";
+}
+
+//------------------------------------------------------------------------------
+void perf_counters::reset()
+{
+#if CLINK_PERF_COUNTERS
+    memset(g_perf_counters, 0, sizeof(g_perf_counters));
+#endif
+}
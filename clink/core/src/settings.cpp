@@ -3,13 +3,16 @@
 
 #include "pch.h"
 #include "settings.h"
+#include "os.h"
 #include "str.h"
+#include "str_hash.h"
 #include "str_tokeniser.h"
 #include "path.h"
 
 #include <assert.h>
 #include <string>
 #include <map>
+#include <unordered_map>
 
 //------------------------------------------------------------------------------
 struct loaded_setting
@@ -33,6 +36,45 @@ static auto& get_map()
     return *g_setting_map;
 }
 
+//------------------------------------------------------------------------------
+// Case-insensitive hash index over the same settings.  find() is hot (every
+// Lua settings.get and every value applied while loading goes through it),
+// so lookups shouldn't pay the ordered map's O(log n) stricmp walk; the
+// sorted map stays for iteration, which wants alphabetical order.
+struct hash_str_ci
+{
+    size_t operator()(const char* s) const
+    {
+        size_t hash = 5381;
+        while (int c = (unsigned char)*s++)
+        {
+            if (c >= 'A' && c <= 'Z')
+                c += 0x20;
+            hash = ((hash << 5) + hash) ^ c;
+        }
+        return hash;
+    }
+};
+
+struct eq_str_ci
+{
+    bool operator()(const char* a, const char* b) const
+    {
+        return stricmp(a, b) == 0;
+    }
+};
+
+typedef std::unordered_map<const char*, setting*, hash_str_ci, eq_str_ci> setting_index;
+static setting_index* g_setting_index = nullptr;
+
+//------------------------------------------------------------------------------
+static auto& get_index()
+{
+    if (!g_setting_index)
+        g_setting_index = new setting_index;
+    return *g_setting_index;
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -67,13 +109,35 @@ setting_iter first()
 //------------------------------------------------------------------------------
 setting* find(const char* name)
 {
-    auto i = get_map().find(name);
-    if (i != get_map().end())
+    auto i = get_index().find(name);
+    if (i != get_index().end())
         return i->second;
 
     return nullptr;
 }
 
+//------------------------------------------------------------------------------
+// Formats the whole settings listing (name column plus descriptive value) in
+// one pass, so callers can emit it with a single write instead of a terminal
+// round trip per setting.
+void format_list(str_base& out)
+{
+    int longest = 0;
+    for (auto iter = first(); auto* next = iter.next();)
+        if (int length = int(strlen(next->get_name())))
+            longest = (length > longest) ? length : longest;
+
+    str<> value;
+    str<256> line;
+    for (auto iter = first(); auto* next = iter.next();)
+    {
+        value.clear();
+        next->get_descriptive(value);
+        line.format("%-*s  %s\n", longest, next->get_name(), value.c_str());
+        out << line;
+    }
+}
+
 //------------------------------------------------------------------------------
 static bool set_setting(const char* name, const char* value, const char* comment=nullptr)
 {
@@ -172,14 +236,271 @@ static bool migrate_setting(const char* name, const char* value)
     return set_setting(name, value);
 }
 
+//------------------------------------------------------------------------------
+// Binary settings cache.
+//
+// Clink reloads the settings file on every injection, and the text format
+// needs tokenising, trimming, and comment accumulation each time.  The cache
+// is the already-parsed file; nul-terminated name/value/comment records
+// behind a header carrying the text file's last-write time.  In the common
+// case load() maps the blob and walks pointers instead of parsing, and any
+// edit to the text file changes its timestamp which invalidates the cache
+// and causes it to be rebuilt from a fresh parse.
+struct cache_header
+{
+    unsigned int    magic;
+    unsigned int    version;
+    FILETIME        source_time;
+    unsigned int    record_count;
+};
+
+struct cache_record
+{
+    unsigned short  name_size;      // Sizes are in bytes and include the
+    unsigned short  value_size;     // terminating nul; the three strings
+    unsigned int    comment_size;   // directly follow the record.
+};
+
+static const unsigned int c_cache_magic = 0x73746573;
+static const unsigned int c_cache_version = 1;
+
+//------------------------------------------------------------------------------
+static bool get_last_write_time(const char* file, FILETIME& out)
+{
+    wstr<280> wfile(file);
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(wfile.c_str(), GetFileExInfoStandard, &fad))
+        return false;
+
+    out = fad.ftLastWriteTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static void get_cache_path(const char* file, str_base& out)
+{
+    out.copy(file);
+    out << ".cache";
+}
+
+//------------------------------------------------------------------------------
+static bool load_cache(const char* file)
+{
+    FILETIME source_time;
+    if (!get_last_write_time(file, source_time))
+        return false;
+
+    str<280> cache_path;
+    get_cache_path(file, cache_path);
+
+    wstr<280> wcache_path(cache_path.c_str());
+    HANDLE handle = CreateFileW(wcache_path.c_str(), GENERIC_READ,
+        FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool ok = false;
+    unsigned int size = GetFileSize(handle, nullptr);
+    HANDLE mapping = (size >= sizeof(cache_header) && size != INVALID_FILE_SIZE)
+        ? CreateFileMapping(handle, nullptr, PAGE_READONLY, 0, 0, nullptr)
+        : nullptr;
+    const char* view = (mapping != nullptr)
+        ? (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)
+        : nullptr;
+    if (view != nullptr)
+    {
+        const auto* header = (const cache_header*)view;
+        if (header->magic == c_cache_magic &&
+            header->version == c_cache_version &&
+            CompareFileTime(&header->source_time, &source_time) == 0)
+        {
+            // Reset settings to default.
+            for (auto iter = settings::first(); auto* next = iter.next();)
+                next->set();
+
+            const char* ptr = view + sizeof(cache_header);
+            const char* end = view + size;
+            unsigned int index = 0;
+            for (; index < header->record_count; ++index)
+            {
+                cache_record record;
+                if (unsigned(end - ptr) < sizeof(record))
+                    break;
+                memcpy(&record, ptr, sizeof(record));
+                ptr += sizeof(record);
+
+                unsigned int payload = record.name_size + record.value_size + record.comment_size;
+                if (!record.name_size || !record.value_size || !record.comment_size)
+                    break;
+                if (unsigned(end - ptr) < payload)
+                    break;
+
+                const char* name = ptr;
+                const char* value = name + record.name_size;
+                const char* comment = value + record.value_size;
+                if (name[record.name_size - 1] || value[record.value_size - 1] ||
+                    comment[record.comment_size - 1])
+                    break;
+
+                set_setting(name, value, comment);
+                ptr += payload;
+            }
+
+            // A truncated or corrupt cache falls back to parsing the text
+            // file, which resets and reapplies everything from scratch.
+            ok = (index == header->record_count);
+        }
+
+        UnmapViewOfFile(view);
+    }
+
+    if (mapping != nullptr)
+        CloseHandle(mapping);
+    CloseHandle(handle);
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+static void save_cache(const char* file, const FILETIME& source_time)
+{
+    str<280> cache_path;
+    get_cache_path(file, cache_path);
+
+    FILE* out = fopen(cache_path.c_str(), "wb");
+    if (out == nullptr)
+        return;
+
+    cache_header header = {};
+    header.magic = c_cache_magic;
+    header.version = c_cache_version;
+    header.source_time = source_time;
+    header.record_count = (unsigned int)(g_loaded_settings.size());
+    fwrite(&header, sizeof(header), 1, out);
+
+    for (const auto& iter : g_loaded_settings)
+    {
+        if (iter.first.length() >= 0xffff || iter.second.value.length() >= 0xffff)
+        {
+            // Doesn't fit the record format; leave no cache rather than a
+            // truncated one.
+            fclose(out);
+            remove(cache_path.c_str());
+            return;
+        }
+
+        cache_record record;
+        record.name_size = (unsigned short)(iter.first.length() + 1);
+        record.value_size = (unsigned short)(iter.second.value.length() + 1);
+        record.comment_size = (unsigned int)(iter.second.comment.length() + 1);
+        fwrite(&record, sizeof(record), 1, out);
+        fwrite(iter.first.c_str(), record.name_size, 1, out);
+        fwrite(iter.second.value.c_str(), record.value_size, 1, out);
+        fwrite(iter.second.comment.c_str(), record.comment_size, 1, out);
+    }
+
+    fclose(out);
+}
+
+//------------------------------------------------------------------------------
+// Cross-session change broadcast.
+//
+// 'clink set' runs in its own process and live sessions only reload the
+// settings file at the next prompt, so a session sitting at an idle prompt
+// never sees the change.  Every process that loads a given settings file
+// also opens a named section holding a revision counter; save() bumps the
+// counter, and sync() -- polled from the editor's gap before it blocks on
+// input -- reloads the file in place when the counter has moved.  A named
+// event is signalled alongside the bump so external tooling can wait for a
+// change instead of polling; the counter stays authoritative for sessions.
+// Both names derive from the settings file path, so profiles don't observe
+// each other.
+static str<280>       g_loaded_file;
+static volatile long* g_broadcast_revision = nullptr;
+static HANDLE         g_broadcast_mapping = nullptr;
+static HANDLE         g_broadcast_event = nullptr;
+static long           g_broadcast_seen = 0;
+
+//------------------------------------------------------------------------------
+static void open_broadcast(const char* file)
+{
+    if (g_broadcast_revision != nullptr && g_loaded_file.iequals(file))
+        return;
+
+    if (g_broadcast_revision != nullptr)
+    {
+        UnmapViewOfFile((void*)g_broadcast_revision);
+        CloseHandle(g_broadcast_mapping);
+        if (g_broadcast_event != nullptr)
+            CloseHandle(g_broadcast_event);
+        g_broadcast_revision = nullptr;
+        g_broadcast_mapping = nullptr;
+        g_broadcast_event = nullptr;
+    }
+
+    g_loaded_file = file;
+
+    // Hash caselessly so path case differences between processes still land
+    // on the same objects.
+    str<96> name;
+    name.format("Local\\clink_settings_%016llx", str_hash64_caseless(file));
+
+    wstr<96> wname(name.c_str());
+    g_broadcast_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr,
+        PAGE_READWRITE, 0, sizeof(long), wname.c_str());
+    if (g_broadcast_mapping == nullptr)
+        return;
+
+    // The kernel zero-fills a fresh section, so revision 0 needs no
+    // initialisation by the creator.
+    g_broadcast_revision = (volatile long*)MapViewOfFile(g_broadcast_mapping,
+        FILE_MAP_READ|FILE_MAP_WRITE, 0, 0, sizeof(long));
+    if (g_broadcast_revision == nullptr)
+    {
+        CloseHandle(g_broadcast_mapping);
+        g_broadcast_mapping = nullptr;
+        return;
+    }
+
+    name << "_event";
+    wstr<96> wevent(name.c_str());
+    g_broadcast_event = CreateEventW(nullptr, TRUE/*manual*/, FALSE, wevent.c_str());
+}
+
 //------------------------------------------------------------------------------
 static bool save_internal(const char* file, bool migrating);
 
+//------------------------------------------------------------------------------
+// Applies settings changed by another process since the last load.  Costs
+// one read of the shared counter when nothing changed, so callers can poll
+// it from idle paths.  Returns true when a change was applied.
+bool sync()
+{
+    if (g_broadcast_revision == nullptr || g_loaded_file.empty())
+        return false;
+
+    if (*g_broadcast_revision == g_broadcast_seen)
+        return false;
+
+    return load(g_loaded_file.c_str());
+}
+
 //------------------------------------------------------------------------------
 bool load(const char* file)
 {
     g_loaded_settings.clear();
 
+    // Snapshot the shared revision before reading anything, so a save that
+    // lands mid-load shows up as a pending sync() instead of being missed.
+    open_broadcast(file);
+    if (g_broadcast_revision != nullptr)
+        g_broadcast_seen = *g_broadcast_revision;
+
+    // Fast path; apply the binary settings cache when it still matches the
+    // text file, skipping the parse below entirely.
+    if (load_cache(file))
+        return true;
+    g_loaded_settings.clear();
+
     // Maybe migrate settings.
     str<> old_file;
     bool migrating = false;
@@ -198,6 +519,12 @@ bool load(const char* file)
         migrating = true;
     }
 
+    // Snapshot the text file's timestamp before reading it, so a concurrent
+    // write during the parse leaves a mismatched (stale) cache rather than a
+    // wrong one.
+    FILETIME source_time = {};
+    bool cache_source = !migrating && get_last_write_time(file, source_time);
+
     // Buffer the file.
     fseek(in, 0, SEEK_END);
     int size = ftell(in);
@@ -280,6 +607,8 @@ bool load(const char* file)
     // clean up the old settings file, so don't rely on it staying around.
     if (migrating)
         save_internal(file, migrating);
+    else if (cache_source)
+        save_cache(file, source_time);
 
     return true;
 }
@@ -289,8 +618,14 @@ static bool save_internal(const char* file, bool migrating)
 {
     // Open settings file.  When migrating, fail if the file already exists, so
     // that if multiple concurrent migrations occur only one of them writes the
-    // new settings file.
-    FILE* out = fopen(file, migrating ? "wtx" : "wt");
+    // new settings file.  Otherwise write to a scratch file alongside the
+    // target and rename it into place below, so a reader (or a crash mid
+    // write) never sees a half-written settings file.
+    str<280> scratch;
+    if (!migrating)
+        scratch << file << ".new";
+
+    FILE* out = fopen(migrating ? file : scratch.c_str(), migrating ? "wtx" : "wt");
     if (out == nullptr)
         return false;
 
@@ -355,12 +690,59 @@ static bool save_internal(const char* file, bool migrating)
         }
 
     fclose(out);
+
+    if (!migrating)
+    {
+        if (!os::move(scratch.c_str(), file, true/*replace*/))
+            return false;
+
+        // The new values are on disk; let other sessions know (see sync()).
+        if (g_broadcast_revision != nullptr)
+        {
+            g_broadcast_seen = InterlockedIncrement(g_broadcast_revision);
+            if (g_broadcast_event != nullptr)
+                SetEvent(g_broadcast_event);
+        }
+    }
+
     return true;
 }
 
+//------------------------------------------------------------------------------
+// While a transaction is open, save() just marks the settings dirty and
+// commit_transaction() performs the single atomic write, so applying many
+// settings serializes the file once instead of once per change.
+static bool s_transaction = false;
+static bool s_transaction_dirty = false;
+
+//------------------------------------------------------------------------------
+void begin_transaction()
+{
+    s_transaction = true;
+    s_transaction_dirty = false;
+}
+
+//------------------------------------------------------------------------------
+bool commit_transaction(const char* file)
+{
+    s_transaction = false;
+
+    if (!s_transaction_dirty)
+        return true;
+
+    s_transaction_dirty = false;
+    return save_internal(file, false/*migrating*/);
+}
+
 //------------------------------------------------------------------------------
 bool save(const char* file)
 {
+    if (s_transaction)
+    {
+        s_transaction_dirty = true;
+        return true;
+    }
+
     return save_internal(file, false/*migrating*/);
 }
 
@@ -383,6 +765,7 @@ setting::setting(
     assert(!settings::find(m_name.c_str()));
 
     get_map()[m_name.c_str()] = this;
+    get_index()[m_name.c_str()] = this;
 }
 
 //------------------------------------------------------------------------------
@@ -391,7 +774,10 @@ setting::~setting()
     auto i = settings::find(m_name.c_str());
 
     if (i && i == this)
+    {
         get_map().erase(m_name.c_str());
+        get_index().erase(m_name.c_str());
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -4,6 +4,8 @@
 #include "pch.h"
 #include "str_compare.h"
 
+#include <assert.h>
+
 threadlocal int str_compare_scope::ts_mode = str_compare_scope::exact;
 threadlocal bool str_compare_scope::ts_fuzzy_accents = false;
 
@@ -39,6 +41,25 @@ bool str_compare_scope::current_fuzzy_accents()
     return ts_fuzzy_accents;
 }
 
+//------------------------------------------------------------------------------
+// 64K case folding table for the BMP, filled once with CharLowerW so the hot
+// per-character comparisons never leave the process afterwards.  Filling is
+// idempotent, so a race between threads building it is harmless.
+const wchar_t* get_case_fold_table()
+{
+    static wchar_t* s_table = nullptr;
+    if (s_table == nullptr)
+    {
+        static wchar_t table[0x10000];
+        table[0] = 0;
+        for (unsigned int i = 1; i < 0x10000; ++i)
+            table[i] = wchar_t(uintptr_t(CharLowerW(LPWSTR(uintptr_t(i)))));
+        s_table = table;
+    }
+
+    return s_table;
+}
+
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 int normalize_accent(int c)
@@ -368,31 +389,26 @@ int normalize_accent(int c)
         { 0x1EF9 /* ỹ */, L'y', },
     };
 
-#ifdef DEBUG
-    static bool verified_order = false;
-    if (!verified_order)
+    // Fuzzy accent comparisons call this for every character on both sides
+    // of every comparison, so a binary search over the map here multiplied
+    // completion cost.  Flatten the map into a direct lookup table once, the
+    // same way the case folding table above is built.
+    static const unsigned int table_size = 0x2000;
+    static const wchar_t* s_table = nullptr;
+    if (s_table == nullptr)
     {
-        verified_order = true;
-        for (int i = 1; i < sizeof_array(fuzzy_accent_map); i++)
-            assert(fuzzy_accent_map[i-1].accent < fuzzy_accent_map[i].accent);
-    }
-#endif
-
-    int lo = 0;
-    int hi = sizeof_array(fuzzy_accent_map);
-
-    while (lo < hi)
-    {
-        int mid = (lo + hi) / 2;
-        int a = fuzzy_accent_map[mid].accent;
-
-        if (c == a)
-            return fuzzy_accent_map[mid].normal;
-        else if (c < a)
-            hi = mid;
-        else
-            lo = mid + 1;
+        static wchar_t table[table_size];
+        for (unsigned int i = 0; i < table_size; ++i)
+            table[i] = wchar_t(i);
+        for (const fuzzy_accent& entry : fuzzy_accent_map)
+        {
+            assert(entry.accent < table_size);
+            table[entry.accent] = entry.normal;
+        }
+        s_table = table;
     }
 
+    if ((unsigned int)c < table_size)
+        return s_table[c];
     return c;
 }
@@ -3,12 +3,15 @@
 
 #include "pch.h"
 #include "str.h"
+#include "str_convert.h"
 #include "str_iter.h"
 
 #ifdef USE_OS_UTF_CONVERSION
 #include <assert.h>
 #endif
 
+#include <emmintrin.h>
+
 //------------------------------------------------------------------------------
 template <typename TYPE>
 struct builder
@@ -62,6 +65,124 @@ builder<char>& builder<char>::operator << (int value)
 
 
 
+//------------------------------------------------------------------------------
+// ASCII is the overwhelmingly common case (paths, history lines, matches), so
+// both converters below bulk-copy ASCII runs with SSE2 and only fall into the
+// scalar decoder at the first non-ASCII unit.  Loads are aligned so they can't
+// straddle a page boundary past the end of the string; the unaligned head and
+// the tail go through the scalar path.  The helpers also run in the counting
+// pass (null builder), which sizes the output with the same speed-up.
+
+//------------------------------------------------------------------------------
+static void convert_ascii_run(builder<wchar_t>& b, str_iter& iter)
+{
+    const char* read = iter.get_pointer();
+    const char* end = read + iter.length();
+
+    while (read < end && !b.truncated())
+    {
+        if ((uintptr_t(read) & 15) || (end - read) < 16)
+        {
+            unsigned char c = *read;
+            if (!c || (c & 0x80))
+                break;
+
+            b << c;
+            ++read;
+            continue;
+        }
+
+        const __m128i zero = _mm_setzero_si128();
+        __m128i chunk = _mm_load_si128((const __m128i*)read);
+        if (_mm_movemask_epi8(chunk) != 0 ||
+            _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero)) != 0)
+        {
+            // A non-ASCII or nul byte in this chunk; copy the ASCII prefix
+            // and let the scalar decoder take over.
+            while (read < end && !b.truncated() && *read && !(*read & 0x80))
+                b << (unsigned char)(*read++);
+            break;
+        }
+
+        if (b.start == nullptr)
+        {
+            b.write += 16;
+        }
+        else if (b.write + 16 <= b.end)
+        {
+            _mm_storeu_si128((__m128i*)b.write, _mm_unpacklo_epi8(chunk, zero));
+            _mm_storeu_si128((__m128i*)(b.write + 8), _mm_unpackhi_epi8(chunk, zero));
+            b.write += 16;
+        }
+        else
+        {
+            // Not enough output room for a whole chunk; finish this run
+            // through the builder so truncation is accounted for.
+            while (read < end && !b.truncated() && *read && !(*read & 0x80))
+                b << (unsigned char)(*read++);
+            break;
+        }
+
+        read += 16;
+    }
+
+    iter.reset_pointer(read);
+}
+
+//------------------------------------------------------------------------------
+static void convert_ascii_run(builder<char>& b, wstr_iter& iter)
+{
+    const wchar_t* read = iter.get_pointer();
+    const wchar_t* end = read + iter.length();
+
+    while (read < end && !b.truncated())
+    {
+        if ((uintptr_t(read) & 15) || (end - read) < 8)
+        {
+            wchar_t c = *read;
+            if (!c || c >= 0x80)
+                break;
+
+            b << int(c);
+            ++read;
+            continue;
+        }
+
+        const __m128i zero = _mm_setzero_si128();
+        __m128i chunk = _mm_load_si128((const __m128i*)read);
+        __m128i high = _mm_and_si128(chunk, _mm_set1_epi16(short(0xff80)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xffff ||
+            _mm_movemask_epi8(_mm_cmpeq_epi16(chunk, zero)) != 0)
+        {
+            while (read < end && !b.truncated() && *read && *read < 0x80)
+                b << int(*read++);
+            break;
+        }
+
+        if (b.start == nullptr)
+        {
+            b.write += 8;
+        }
+        else if (b.write + 8 <= b.end)
+        {
+            _mm_storel_epi64((__m128i*)b.write, _mm_packus_epi16(chunk, chunk));
+            b.write += 8;
+        }
+        else
+        {
+            while (read < end && !b.truncated() && *read && *read < 0x80)
+                b << int(*read++);
+            break;
+        }
+
+        read += 8;
+    }
+
+    iter.reset_pointer(read);
+}
+
+
+
 //------------------------------------------------------------------------------
 int to_utf8(char* out, int max_count, wstr_iter& iter)
 {
@@ -97,9 +218,17 @@ int to_utf8(char* out, int max_count, wstr_iter& iter)
 
     builder<char> builder(out, max_count);
 
+    // Bound the input once up front (one scan for unterminated iterators) so
+    // the SSE2 run copier doesn't have to re-measure it.
+    wstr_iter bounded(iter.get_pointer(), iter.length());
+
     int c;
-    while (!builder.truncated() && (c = iter.next()))
+    while (!builder.truncated())
     {
+        convert_ascii_run(builder, bounded);
+        if (!(c = bounded.next()))
+            break;
+
         if (c < 0x80)
         {
             builder << c;
@@ -125,6 +254,7 @@ int to_utf8(char* out, int max_count, wstr_iter& iter)
             builder << (out_chars[i] | 0x80);
     }
 
+    iter.reset_pointer(bounded.get_pointer());
     return builder.get_written();
 }
 
@@ -198,10 +328,21 @@ int to_utf16(wchar_t* out, int max_count, str_iter& iter)
 
     builder<wchar_t> builder(out, max_count);
 
+    // Bound the input once up front (one scan for unterminated iterators) so
+    // the SSE2 run copier doesn't have to re-measure it.
+    str_iter bounded(iter.get_pointer(), iter.length());
+
     int c;
-    while (!builder.truncated() && (c = iter.next()))
+    while (!builder.truncated())
+    {
+        convert_ascii_run(builder, bounded);
+        if (!(c = bounded.next()))
+            break;
+
         builder << c;
+    }
 
+    iter.reset_pointer(bounded.get_pointer());
     return builder.get_written();
 }
 
@@ -233,3 +374,87 @@ int to_utf16(wstr_base& out, const char* utf8)
     str_iter iter(utf8);
     return to_utf16(out, iter);
 }
+
+
+
+//------------------------------------------------------------------------------
+// Process-wide pool backing the conversion contexts (see str_convert.h).
+// Slots are claimed and released with interlocked bit operations; the buffers
+// grow on demand and never shrink, giving each slot high-water sizing.
+static const int c_conversion_slots = 8;
+static wstr<16>      s_utf16_slots[c_conversion_slots];
+static str<16>       s_utf8_slots[c_conversion_slots];
+static volatile long s_utf16_claimed = 0;
+static volatile long s_utf8_claimed = 0;
+
+//------------------------------------------------------------------------------
+static int claim_slot(volatile long& claimed_mask)
+{
+    long claimed = claimed_mask;
+    while (true)
+    {
+        int index = 0;
+        while (index < c_conversion_slots && (claimed & (1 << index)))
+            ++index;
+        if (index == c_conversion_slots)
+            return -1;
+
+        const long prev = InterlockedCompareExchange(&claimed_mask,
+            claimed | (1 << index), claimed);
+        if (prev == claimed)
+            return index;
+
+        claimed = prev;
+    }
+}
+
+//------------------------------------------------------------------------------
+static void release_slot(volatile long& claimed_mask, int index)
+{
+    if (index >= 0)
+        InterlockedAnd(&claimed_mask, ~(1 << index));
+}
+
+//------------------------------------------------------------------------------
+utf16_conversion_context::utf16_conversion_context()
+{
+    m_slot = claim_slot(s_utf16_claimed);
+    m_str = (m_slot >= 0) ? static_cast<wstr_base*>(&s_utf16_slots[m_slot]) : &m_fallback;
+    m_str->clear();
+}
+
+//------------------------------------------------------------------------------
+utf16_conversion_context::utf16_conversion_context(const char* utf8)
+: utf16_conversion_context()
+{
+    if (utf8 != nullptr)
+        to_utf16(*m_str, utf8);
+}
+
+//------------------------------------------------------------------------------
+utf16_conversion_context::~utf16_conversion_context()
+{
+    release_slot(s_utf16_claimed, m_slot);
+}
+
+//------------------------------------------------------------------------------
+utf8_conversion_context::utf8_conversion_context()
+{
+    m_slot = claim_slot(s_utf8_claimed);
+    m_str = (m_slot >= 0) ? static_cast<str_base*>(&s_utf8_slots[m_slot]) : &m_fallback;
+    m_str->clear();
+}
+
+//------------------------------------------------------------------------------
+utf8_conversion_context::utf8_conversion_context(const wchar_t* utf16)
+: utf8_conversion_context()
+{
+    if (utf16 != nullptr)
+        to_utf8(*m_str, utf16);
+}
+
+//------------------------------------------------------------------------------
+utf8_conversion_context::~utf8_conversion_context()
+{
+    release_slot(s_utf8_claimed, m_slot);
+}
@@ -4,6 +4,42 @@
 #include "pch.h"
 #include "str_iter.h"
 
+#include <emmintrin.h>
+#include <intrin.h>
+
+//------------------------------------------------------------------------------
+const char* scan_for_byte_below(const char* begin, const char* end, unsigned char limit)
+{
+    const __m128i lim = _mm_set1_epi8(char(limit - 1));
+
+    while (begin < end)
+    {
+        // Loads are aligned so they can't straddle a page boundary past the
+        // end of the buffer; the unaligned head and the tail go byte-wise.
+        if ((uintptr_t(begin) & 15) || (end - begin) < 16)
+        {
+            if ((unsigned char)*begin < limit)
+                return begin;
+            ++begin;
+            continue;
+        }
+
+        // Unsigned chunk <= limit-1, via min(chunk, limit-1) == chunk.
+        __m128i chunk = _mm_load_si128((const __m128i*)begin);
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(chunk, lim), chunk));
+        if (mask)
+        {
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            return begin + bit;
+        }
+
+        begin += 16;
+    }
+
+    return end;
+}
+
 //------------------------------------------------------------------------------
 template <>
 int str_iter_impl<char>::next()
@@ -6,6 +6,143 @@
 
 #include <new>
 
+#include <emmintrin.h>
+#include <intrin.h>
+
+//------------------------------------------------------------------------------
+// Returns the first byte in [begin, end) that is NUL, is 0x80 or above (a unit
+// of a multi-byte utf-8 sequence, which the caller decodes itself), or appears
+// in the 'set' of 'count' bytes; or 'end' when there isn't one.  SSE2 matches
+// an arbitrary set at one comparison per member per 16 byte chunk, so callers
+// keep the set small.  Loads are aligned so they can't straddle a page
+// boundary; the unaligned head and the tail go byte-wise.
+static const char* scan_for_byte_in_set(const char* begin, const char* end,
+                                        const char* set, int count)
+{
+    while (begin < end)
+    {
+        if ((uintptr_t(begin) & 15) || (end - begin) < 16)
+        {
+            const unsigned char c = (unsigned char)*begin;
+            if (c == 0 || c >= 0x80 || memchr(set, c, count) != nullptr)
+                return begin;
+            ++begin;
+            continue;
+        }
+
+        __m128i chunk = _mm_load_si128((const __m128i*)begin);
+        __m128i hits = _mm_cmpeq_epi8(chunk, _mm_setzero_si128());
+        for (int i = 0; i < count; ++i)
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(set[i])));
+
+        // The chunk itself contributes the sign bits of 0x80-and-above bytes.
+        int mask = _mm_movemask_epi8(_mm_or_si128(hits, chunk));
+        if (mask)
+        {
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            return begin + bit;
+        }
+
+        begin += 16;
+    }
+
+    return end;
+}
+
+//------------------------------------------------------------------------------
+// Tokenising scans every character of the input with a utf-8 decode and a
+// strchr over the delimiters; long pasted lines make that the dominant cost
+// of word collection.  This specialisation keeps the per-character loop for
+// the decisions (decoding, quote state, strongest-delimiter tracking) but
+// lets the vector scan skip the plain bytes in between.
+template <>
+str_token str_tokeniser_impl<char>::next_impl(const char*& out_start, int& out_length)
+{
+    // Skip initial delimiters.
+    const char* max_delim = nullptr;
+    while (int c = m_iter.peek())
+    {
+        const char* delim = strchr(m_delims, c);
+        if (delim == nullptr)
+            break;
+
+        max_delim = max(max_delim, delim);
+        m_iter.next();
+    }
+
+    // Gather the scan set once:  the delimiters plus the quote openers.  An
+    // oversized set disables the scan rather than matching incompletely.
+    char set[16];
+    int set_count = 0;
+    bool scan = true;
+    for (const char* d = m_delims; *d; ++d)
+    {
+        if (set_count == sizeof_array(set))
+        {
+            scan = false;
+            break;
+        }
+        set[set_count++] = *d;
+    }
+    for (const quote& q : m_quotes)
+    {
+        if (set_count == sizeof_array(set))
+        {
+            scan = false;
+            break;
+        }
+        set[set_count++] = q.left;
+    }
+
+    // For unbounded iterators the end sentinel is before the start; the NUL
+    // in the stop set terminates the scan instead, and the aligned loads
+    // can't fault past it.
+    const char* scan_end = m_iter.get_end_pointer();
+    if (scan_end < m_iter.get_pointer())
+        scan_end = (const char*)(~uintptr_t(15));
+
+    // Extract the delimited string.
+    const char* start = m_iter.get_pointer();
+
+    int quote_close = 0;
+    while (int c = m_iter.peek())
+    {
+        if (quote_close)
+        {
+            quote_close = (quote_close == c) ? 0 : quote_close;
+            m_iter.next();
+            if (scan && quote_close)
+            {
+                // Inside quotes only the closing quote can matter.
+                const char close = char(quote_close);
+                m_iter.reset_pointer(scan_for_byte_in_set(m_iter.get_pointer(), scan_end, &close, 1));
+            }
+            continue;
+        }
+
+        if (strchr(m_delims, c))
+            break;
+
+        quote_close = get_right_quote(c);
+        m_iter.next();
+
+        if (scan && !quote_close)
+            m_iter.reset_pointer(scan_for_byte_in_set(m_iter.get_pointer(), scan_end, set, set_count));
+    }
+
+    const char* end = m_iter.get_pointer();
+
+    // Empty string? Must be the end of the input. We're done here.
+    if (start == end)
+        return str_token::invalid_delim;
+
+    // Set the output and return.
+    out_start = start;
+    out_length = int(end - start);
+    return max_delim ? *max_delim : 0;
+}
+
 //------------------------------------------------------------------------------
 template <>
 str_token str_tokeniser_impl<char>::next(str_impl<char>& out)
@@ -80,6 +217,42 @@ str_token str_tokeniser_impl<wchar_t>::next(str_iter_impl<wchar_t>& out)
     return str_token::invalid_delim;
 }
 
+//------------------------------------------------------------------------------
+template <typename T>
+str_token str_tokeniser_impl<T>::next(str_token_slice& out)
+{
+    const T* start;
+    int length;
+    auto ret = next_impl(start, length);
+    if (ret)
+    {
+        out.offset = (unsigned int)(start - m_start);
+        out.length = (unsigned int)(length);
+        out.delim = ret.delim;
+    }
+
+    return ret;
+}
+
+template str_token str_tokeniser_impl<char>::next(str_token_slice&);
+template str_token str_tokeniser_impl<wchar_t>::next(str_token_slice&);
+
+//------------------------------------------------------------------------------
+// Fills up to max_count slices per call, amortising the call overhead when
+// tokenising long inputs; returns how many were filled, zero at the end.
+template <typename T>
+unsigned int str_tokeniser_impl<T>::tokenise(str_token_slice* out, unsigned int max_count)
+{
+    unsigned int count = 0;
+    while (count < max_count && next(out[count]))
+        ++count;
+
+    return count;
+}
+
+template unsigned int str_tokeniser_impl<char>::tokenise(str_token_slice*, unsigned int);
+template unsigned int str_tokeniser_impl<wchar_t>::tokenise(str_token_slice*, unsigned int);
+
 //------------------------------------------------------------------------------
 template <typename T>
 int str_tokeniser_impl<T>::get_right_quote(int left) const
@@ -9,6 +9,36 @@
 
 #include <assert.h>
 
+//------------------------------------------------------------------------------
+static void ascii_transform(const wchar_t* in, unsigned int len, wstr_base& out, transform_mode mode)
+{
+    out.clear();
+    out.reserve(len);
+
+    bool title_char = true;
+    for (unsigned int i = 0; i < len; ++i)
+    {
+        WCHAR c = in[i];
+
+        switch (mode)
+        {
+        case transform_mode::lower:
+            out.data()[i] = __ascii_towlower(c);
+            break;
+        case transform_mode::upper:
+            out.data()[i] = __ascii_towupper(c);
+            break;
+        case transform_mode::title:
+            out.data()[i] = title_char ? __ascii_towupper(c) : __ascii_towlower(c);
+            break;
+        }
+
+        title_char = !!iswspace(c);
+    }
+
+    out.data()[len] = '\0';
+}
+
 //------------------------------------------------------------------------------
 void str_transform(const wchar_t* in, unsigned int len, wstr_base& out, transform_mode mode)
 {
@@ -22,38 +52,33 @@ void str_transform(const wchar_t* in, unsigned int len, wstr_base& out, transfor
     default:                        assert(false); return;
     }
 
+    // ASCII needs no linguistic mapping, and strings that reach here (e.g.
+    // case folding candidate lists from Lua scripts) are overwhelmingly
+    // ASCII, so a trivial loop beats a call into the NLS machinery.
+    bool ascii = true;
+    for (unsigned int i = 0; i < len; ++i)
+        if (in[i] >= 0x80)
+        {
+            ascii = false;
+            break;
+        }
+    if (ascii)
+    {
+        ascii_transform(in, len, out, mode);
+        return;
+    }
+
     out.reserve(len + max<unsigned int>(len / 10, 10));
-    int cch = LCMapStringW(LOCALE_USER_DEFAULT, mapflags, in, len, out.data(), out.size());
+    int cch = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, mapflags, in, len, out.data(), out.size(), nullptr, nullptr, 0);
     if (!cch)
     {
-        cch = LCMapStringW(LOCALE_USER_DEFAULT, mapflags, in, len, nullptr, 0);
+        cch = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, mapflags, in, len, nullptr, 0, nullptr, nullptr, 0);
         out.reserve(cch + 1);
-        cch = LCMapStringW(LOCALE_USER_DEFAULT, mapflags, in, len, out.data(), out.size());
+        cch = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, mapflags, in, len, out.data(), out.size(), nullptr, nullptr, 0);
         if (!cch)
         {
-            out.clear();
-            bool title_char = true;
-            for (unsigned int i = 0; i < len; ++i)
-            {
-                WCHAR c = in[i];
-
-                switch (mode)
-                {
-                case transform_mode::lower:
-                    out.data()[i] = __ascii_towlower(c);
-                    break;
-                case transform_mode::upper:
-                    out.data()[i] = __ascii_towupper(c);
-                    break;
-                case transform_mode::title:
-                    out.data()[i] = title_char ? __ascii_towupper(c) : __ascii_towlower(c);
-                    break;
-                }
-
-                title_char = !!iswspace(c);
-            }
-
-            cch = len;
+            ascii_transform(in, len, out, mode);
+            return;
         }
     }
 
@@ -0,0 +1,148 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "timings.h"
+#include "log.h"
+
+#include <string.h>
+
+//------------------------------------------------------------------------------
+static timings::record s_records[24];
+static unsigned int s_count = 0;
+
+//------------------------------------------------------------------------------
+static long long get_ticks()
+{
+    LARGE_INTEGER li;
+    QueryPerformanceCounter(&li);
+    return li.QuadPart;
+}
+
+//------------------------------------------------------------------------------
+static long long get_frequency()
+{
+    static long long s_frequency;
+    if (!s_frequency)
+    {
+        LARGE_INTEGER li;
+        QueryPerformanceFrequency(&li);
+        s_frequency = li.QuadPart;
+    }
+    return s_frequency;
+}
+
+//------------------------------------------------------------------------------
+unsigned int timings::get_count()
+{
+    return s_count;
+}
+
+//------------------------------------------------------------------------------
+const timings::record* timings::get_record(unsigned int index)
+{
+    if (index >= s_count)
+        return nullptr;
+
+    return s_records + index;
+}
+
+//------------------------------------------------------------------------------
+void timings::add(const char* name, float elapsed_ms)
+{
+    LOG("Phase '%s' took %.1f ms", name, elapsed_ms);
+
+    // Phases can repeat (settings reload before each prompt, scripts can be
+    // reloaded); keep the most recent measurement per phase name.
+    for (unsigned int i = 0; i < s_count; ++i)
+        if (strcmp(s_records[i].name, name) == 0)
+        {
+            s_records[i].elapsed_ms = elapsed_ms;
+            return;
+        }
+
+    if (s_count < sizeof_array(s_records))
+    {
+        s_records[s_count].name = name;
+        s_records[s_count].elapsed_ms = elapsed_ms;
+        ++s_count;
+    }
+}
+
+//------------------------------------------------------------------------------
+static timings::stats s_stats[16];
+static unsigned int s_stats_count = 0;
+
+//------------------------------------------------------------------------------
+void timings::accumulate(const char* name, float elapsed_ms)
+{
+    for (unsigned int i = 0; i < s_stats_count; ++i)
+    {
+        stats& s = s_stats[i];
+        if (strcmp(s.name, name) == 0)
+        {
+            ++s.count;
+            s.total_ms += elapsed_ms;
+            if (s.worst_ms < elapsed_ms)
+                s.worst_ms = elapsed_ms;
+            return;
+        }
+    }
+
+    if (s_stats_count < sizeof_array(s_stats))
+    {
+        stats& s = s_stats[s_stats_count++];
+        s.name = name;
+        s.count = 1;
+        s.total_ms = elapsed_ms;
+        s.worst_ms = elapsed_ms;
+    }
+}
+
+//------------------------------------------------------------------------------
+void timings::log_stats(const char* heading)
+{
+    if (!s_stats_count)
+        return;
+
+    LOG("%s:", heading);
+    for (unsigned int i = 0; i < s_stats_count; ++i)
+    {
+        const stats& s = s_stats[i];
+        LOG("  %s: n=%u avg=%.2f ms worst=%.2f ms total=%.1f ms",
+            s.name, s.count, s.total_ms / s.count, s.worst_ms, s.total_ms);
+    }
+
+    s_stats_count = 0;
+}
+
+//------------------------------------------------------------------------------
+timing_scope::timing_scope(const char* name)
+: m_name(name)
+, m_start(get_ticks())
+{
+}
+
+//------------------------------------------------------------------------------
+timing_scope::~timing_scope()
+{
+    long long elapsed = get_ticks() - m_start;
+    timings::add(m_name, float(elapsed * 1000.0 / get_frequency()));
+}
+
+//------------------------------------------------------------------------------
+timing_accumulator::timing_accumulator(const char* name, bool enabled)
+: m_name(enabled ? name : nullptr)
+, m_start(enabled ? get_ticks() : 0)
+{
+}
+
+//------------------------------------------------------------------------------
+timing_accumulator::~timing_accumulator()
+{
+    if (m_name == nullptr)
+        return;
+
+    long long elapsed = get_ticks() - m_start;
+    timings::accumulate(m_name, float(elapsed * 1000.0 / get_frequency()));
+}
@@ -76,4 +76,26 @@ TEST_CASE("path::match_wild()")
         REQUIRE(!path::match_wild("ori*", "origin/master", false));
         REQUIRE(path::match_wild("ori*", "origin/master", true));
     }
+
+    SECTION("Compiled")
+    {
+        const auto matches = [] (const char* pattern, const char* file, bool star_matches_everything=false)
+        {
+            path::wild_matcher<char> matcher((str_iter(pattern)));
+            return matcher.match(str_iter(file), star_matches_everything);
+        };
+
+        REQUIRE(matches("*foo*bar", "foodbar"));
+        REQUIRE(!matches("*foo*bar", "foodbard"));
+        REQUIRE(matches("a*/d?f/*i", "abc/def/ghi"));
+        REQUIRE(!matches("ori*", "origin/master", false));
+        REQUIRE(matches("ori*", "origin/master", true));
+
+        // Candidates shorter than the literal character count are rejected;
+        // '?' can match a missing character and separator runs collapse, so
+        // neither raises the minimum.
+        REQUIRE(!matches("abcdef", "abc"));
+        REQUIRE(matches("abc?", "abc"));
+        REQUIRE(matches("abc//def", "abc/def"));
+    }
 }
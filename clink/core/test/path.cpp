@@ -367,6 +367,19 @@ TEST_CASE("path::join()")
         }
     }
 
+    SECTION("Length bounded")
+    {
+        str<> s;
+
+        s.copy("one\\two");
+        path::append(s, "three", 5);
+        REQUIRE(s.equals("one\\two\\three"));
+
+        s.copy("one\\two");
+        path::append(s, "three", -1);
+        REQUIRE(s.equals("one\\two\\three"));
+    }
+
     SECTION("Drive letter")
     {
         str<> s;
@@ -2,9 +2,12 @@
 // License: http://opensource.org/licenses/MIT
 
 #include "pch.h"
+#include "fs_fixture.h"
 
 #include <core/base.h>
+#include <core/path.h>
 #include <core/settings.h>
+#include <core/str_hash.h>
 
 //------------------------------------------------------------------------------
 TEST_CASE("settings : basic")
@@ -152,6 +155,50 @@ TEST_CASE("settings : enum")
     REQUIRE(test.set("1"));     REQUIRE(test.get() == 1);
 }
 
+//------------------------------------------------------------------------------
+TEST_CASE("settings : sync")
+{
+    fs_fixture fs;
+    setting_int test("!sync_test", "", "", 1);
+
+    str<280> file(fs.get_root());
+    path::append(file, "settings_file");
+
+    FILE* out = fopen(file.c_str(), "wt");
+    fputs("!sync_test = 2\n", out);
+    fclose(out);
+
+    REQUIRE(settings::load(file.c_str()));
+    REQUIRE(test.get() == 2);
+
+    // Nothing has changed, so sync is a no-op.
+    REQUIRE(!settings::sync());
+
+    // Pose as another session:  rewrite the file and bump the shared
+    // revision counter by opening the named section load() created.
+    out = fopen(file.c_str(), "wt");
+    fputs("!sync_test = 3\n", out);
+    fclose(out);
+
+    str<96> name;
+    name.format("Local\\clink_settings_%016llx", str_hash64_caseless(file.c_str()));
+    wstr<96> wname(name.c_str());
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr,
+        PAGE_READWRITE, 0, sizeof(long), wname.c_str());
+    REQUIRE(mapping != nullptr);
+    volatile long* revision = (volatile long*)MapViewOfFile(mapping,
+        FILE_MAP_READ|FILE_MAP_WRITE, 0, 0, sizeof(long));
+    REQUIRE(revision != nullptr);
+    InterlockedIncrement(revision);
+
+    REQUIRE(settings::sync());
+    REQUIRE(test.get() == 3);
+    REQUIRE(!settings::sync());
+
+    UnmapViewOfFile((void*)revision);
+    CloseHandle(mapping);
+}
+
 //------------------------------------------------------------------------------
 TEST_CASE("settings : color")
 {
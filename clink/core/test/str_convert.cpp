@@ -3,7 +3,9 @@
 
 #include "pch.h"
 
+#include <core/base.h>
 #include <core/str.h>
+#include <core/str_convert.h>
 #include <core/str_iter.h>
 
 //------------------------------------------------------------------------------
@@ -168,3 +170,53 @@ TEST_CASE("Wide character/UTF-8 conversion")
         }
     }
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("Conversion contexts")
+{
+    SECTION("Round trip")
+    {
+        utf16_conversion_context wide("0123456789");
+        REQUIRE(wide.length() == 10);
+        REQUIRE(wcscmp(wide.c_str(), L"0123456789") == 0);
+
+        utf8_conversion_context narrow(wide.c_str());
+        REQUIRE(narrow.get().equals("0123456789"));
+    }
+
+    SECTION("Nested contexts are distinct")
+    {
+        utf16_conversion_context a("alpha");
+        utf16_conversion_context b("bravo");
+        REQUIRE(a.c_str() != b.c_str());
+        REQUIRE(wcscmp(a.c_str(), L"alpha") == 0);
+        REQUIRE(wcscmp(b.c_str(), L"bravo") == 0);
+    }
+
+    SECTION("Exhaustion falls back")
+    {
+        // More live contexts than the pool has slots; the overflow must keep
+        // working from fallback buffers.
+        utf16_conversion_context contexts[12];
+        for (auto& context : contexts)
+            context.get().from_utf8("0123456789abcdef0123");
+
+        for (int i = 0; i < sizeof_array(contexts); ++i)
+        {
+            REQUIRE(contexts[i].length() == 20);
+            for (int j = i + 1; j < sizeof_array(contexts); ++j)
+                REQUIRE(contexts[i].c_str() != contexts[j].c_str());
+        }
+    }
+
+    SECTION("Claimed buffers start empty")
+    {
+        {
+            utf16_conversion_context stale("leftover contents");
+            REQUIRE(stale.length() != 0);
+        }
+
+        utf16_conversion_context fresh;
+        REQUIRE(fresh.length() == 0);
+    }
+}
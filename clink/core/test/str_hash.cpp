@@ -0,0 +1,40 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/str_hash.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_hash64: length")
+{
+    // An explicit length must hash the same as the nul-terminated prefix,
+    // whichever side of a word boundary the length falls on.
+    static const char in[] = "0123456789abcdefghij";
+    for (int i = 0; i <= int(sizeof(in) - 1); ++i)
+    {
+        char prefix[sizeof(in)];
+        memcpy(prefix, in, i);
+        prefix[i] = '\0';
+        REQUIRE(str_hash64(in, i) == str_hash64(prefix));
+    }
+
+    REQUIRE(str_hash64(in) == str_hash64(in, int(sizeof(in) - 1)));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_hash64: seed")
+{
+    REQUIRE(str_hash64("abc") != str_hash64("abc", -1, 493));
+    REQUIRE(str_hash64("abc", -1, 493) == str_hash64("abc", 3, 493));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_hash64: caseless")
+{
+    REQUIRE(str_hash64_caseless("Program Files") == str_hash64_caseless("PROGRAM FILES"));
+    REQUIRE(str_hash64_caseless("program files") == str_hash64_caseless("Program Files"));
+
+    // Only ASCII folds; bytes above 0x7f must hash verbatim.
+    REQUIRE(str_hash64_caseless("\xc3\x80") == str_hash64("\xc3\x80"));
+}
@@ -0,0 +1,45 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include "match_pipeline.h"
+#include "matches_impl.h"
+
+#include <core/str.h>
+#include <core/str_compare.h>
+#include <lib/matches.h>
+
+//------------------------------------------------------------------------------
+BENCH_CASE("match_pipeline")
+{
+    const int c_match_count = 10000;
+
+    matches_impl matches;
+    match_builder builder(matches);
+
+    str<48> name;
+    for (int i = 0; i < c_match_count; ++i)
+    {
+        name.format("file_%04d_%s.txt", i, (i & 1) ? "debug" : "release");
+        builder.add_match(name.c_str(), match_type::file);
+    }
+
+    match_pipeline pipeline(matches);
+    str_compare_scope _(str_compare_scope::caseless);
+
+    const unsigned int iterations = 500;
+
+    ctx.measure("select", iterations, [&] () {
+        pipeline.reopen();
+        pipeline.select("file_00");
+        bench::consume(matches.get_match_count());
+    });
+
+    ctx.measure("select_sort", iterations, [&] () {
+        pipeline.reopen();
+        pipeline.select("file_00");
+        pipeline.sort();
+        bench::consume(matches.get_match_count());
+    });
+}
@@ -9,6 +9,7 @@ class printer;
 class pager;
 class line_buffer;
 class line_state;
+class linear_allocator;
 class matches;
 class word_classifications;
 
@@ -41,6 +42,10 @@ public:
         const line_state&   line;
         const matches&      matches;
         const word_classifications& classifications;
+        // Bump allocator for scratch with at most line-edit lifetime; rewound
+        // when a line edit begins and ends, so nothing allocated from it may
+        // outlive the current line.
+        linear_allocator&   arena;
     };
 
     struct binder
@@ -22,10 +22,11 @@ struct word
 class line_state
 {
 public:
-                        line_state(const char* line, unsigned int cursor, unsigned int command_offset, const std::vector<word>& words);
+                        line_state(const char* line, unsigned int cursor, unsigned int command_offset, const std::vector<word>& words, unsigned int first_dirty_word=0);
     const char*         get_line() const;
     unsigned int        get_cursor() const;
     unsigned int        get_command_offset() const;
+    unsigned int        get_first_dirty_word() const;
     unsigned int        get_end_word_offset() const;
     const std::vector<word>& get_words() const;
     unsigned int        get_word_count() const;
@@ -39,4 +40,5 @@ private:
     const char*         m_line;
     unsigned int        m_cursor;
     unsigned int        m_command_offset;
+    unsigned int        m_first_dirty_word;
 };
@@ -25,6 +25,23 @@ public:
     virtual void    get_word_break_info(const line_state& line, word_break_info& info) const = 0;
     virtual bool    match_display_filter(char** matches, match_display_filter_entry*** filtered_matches, bool popup) { return false; }
 
+    // Generators that only read the line state and have no shared mutable
+    // state can declare themselves thread-safe; the match pipeline may then
+    // run them on a worker thread, overlapped with the other generators.
+    virtual bool    is_thread_safe() const { return false; }
+
+    // Incremental generators may still have matches on the way after
+    // generate() returns (e.g. a Lua coroutine that yielded).  While
+    // is_busy() reports true the editor grants them the idle time between
+    // keys by calling on_idle(), which returns true while work remains.
+    virtual bool    is_busy() const { return false; }
+    virtual bool    on_idle() { return false; }
+
+    // Called when the editor is about to block waiting for the next key, so
+    // a generator can run housekeeping (e.g. garbage collection) off the
+    // keystroke path.  Must be cheap; it runs once per key.
+    virtual void    on_wait() {}
+
 private:
 };
 
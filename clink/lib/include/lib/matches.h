@@ -3,12 +3,18 @@
 
 #pragma once
 
+#include <core/match_wild.h>
 #include <core/str_iter.h>
 #include <assert.h>
 
 class str_base;
 
 //------------------------------------------------------------------------------
+// The type travels with each match from the generator all the way into the
+// display and append-char logic: file_match_generator derives it from the
+// attributes the globber already fetched, and the patched Readline
+// reconstitutes stat data from it (stat_from_match_type in complete.c), so
+// classifying and coloring matches never touches the file system again.
 enum class match_type : unsigned char
 {
     do_not_use,     // complete.c relies on the type never being 0, so it can use savestring().
@@ -94,6 +100,7 @@ private:
     const matches&          m_matches;
     char*                   m_expanded_pattern;
     str_iter                m_pattern;
+    path::wild_matcher<char> m_matcher;
     bool                    m_has_pattern = false;
     unsigned int            m_index = 0;
     unsigned int            m_next = 0;
@@ -119,6 +126,9 @@ public:
     virtual char            get_append_character() const = 0;
     virtual int             get_suppress_quoting() const = 0;
     virtual int             get_word_break_position() const = 0;
+    // True when generation was cut off by its time budget, so the matches
+    // may be missing entries (see match.generate_timeout).
+    virtual bool            is_partial() const = 0;
     virtual bool            match_display_filter(char** matches, match_display_filter_entry*** filtered_matches, bool popup) const = 0;
 
 private:
@@ -148,12 +158,21 @@ class match_builder
 {
 public:
                             match_builder(matches& matches);
+    matches&                get_matches() const { return m_matches; }
+    void                    reserve(unsigned int count, unsigned int store_size);
     bool                    add_match(const char* match, match_type type);
     bool                    add_match(const match_desc& desc);
     void                    set_append_character(char append);
     void                    set_suppress_append(bool suppress=true);
     void                    set_suppress_quoting(int suppress=1); //0=no, 1=yes, 2=suppress end quote
 
+    // Claims that the matches added since the previous claim are already in
+    // sorted order (e.g. file globs come back sorted by NTFS).  Claims are
+    // hints:  the sort verifies them with its own comparator and falls back
+    // to a full sort, so an inexact claim costs a linear scan, not a wrong
+    // order.  Claiming false poisons all claims for this generate pass.
+    void                    set_matches_are_sorted(bool sorted=true);
+
     void                    set_matches_are_files(bool files=true);
 
 private:
@@ -0,0 +1,22 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+//------------------------------------------------------------------------------
+// Process-wide index of how often completions have been accepted, backed by a
+// shared file mapping in the profile directory so counts persist and are
+// shared between sessions.  Recording happens where Readline inserts a chosen
+// match; the match sort consults lookup() to put frequently chosen entries
+// first.  Lookups and records are O(1) open-addressed probes directly in the
+// mapping.  Everything no-ops until open() succeeds.
+namespace usage_index
+{
+
+void            open(const char* state_dir);
+void            close();
+bool            is_active();
+void            record(const char* match);
+unsigned int    lookup(const char* match);
+
+}; // namespace usage_index
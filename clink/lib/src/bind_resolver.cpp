@@ -84,6 +84,18 @@ void bind_resolver::set_group(int group)
         return;
 
     m_group = group;
+
+    // Coming back to a group whose replay cursor is still current (same
+    // consumed prefix, same keys) swaps it in directly; otherwise the next
+    // call to next() replays the pending input from the group's root.
+    const group_cursor& cursor = m_cursors[group & (sizeof_array(m_cursors) - 1)];
+    if (cursor.group == group && cursor.tail == m_tail && cursor.key_count == m_key_count)
+    {
+        m_node_index = cursor.node_index;
+        m_pending_input = false;
+        return;
+    }
+
     m_node_index = group;
     m_pending_input = true;
 }
@@ -149,6 +161,8 @@ bind_resolver::binding bind_resolver::next()
         for (int i = m_tail, n = m_key_count; i < n; ++i)
             if (step_impl(m_keys[i]))
                 break;
+
+        save_group_cursor();
     }
 
     // Go along this depth's nodes looking for valid binds.
@@ -172,6 +186,16 @@ bind_resolver::binding bind_resolver::next()
     return binding();
 }
 
+//------------------------------------------------------------------------------
+void bind_resolver::save_group_cursor()
+{
+    group_cursor& cursor = m_cursors[m_group & (sizeof_array(m_cursors) - 1)];
+    cursor.group = m_group;
+    cursor.node_index = m_node_index;
+    cursor.tail = m_tail;
+    cursor.key_count = m_key_count;
+}
+
 //------------------------------------------------------------------------------
 bool bind_resolver::is_bound(const char* seq, int len) const
 {
@@ -41,9 +41,26 @@ public:
     bool                is_bound(const char* seq, int len) const;
 
 private:
+    // Cursor from a group's last pending-input replay.  Replaying is
+    // deterministic on (group, keys[tail..key_count)), so when a group
+    // switch comes back to a group with the same pending input the saved
+    // cursor is restored instead of re-walking the prefix from the group's
+    // root.  Direct mapped; a collision just overwrites.  Invalidated
+    // wholesale by reset() (which re-initializes the object), and naturally
+    // missed whenever tail or key_count have moved on.
+    struct group_cursor
+    {
+        unsigned short  group = 0;      // 0 == empty.
+        unsigned short  node_index = 0;
+        unsigned char   tail = 0;
+        unsigned char   key_count = 0;
+    };
+
     void                claim(binding& binding);
     bool                step_impl(unsigned char key);
+    void                save_group_cursor();
     const binder&       m_binder;
+    group_cursor        m_cursors[4];
     unsigned short      m_node_index = 1;
     unsigned short      m_group = 1;
     bool                m_pending_input = false;
@@ -107,6 +107,17 @@ binder::binder()
     m_next_node = 2;
 
     static_assert(sizeof(node) == sizeof(group_node), "Size assumption");
+
+    reset_dispatch_cache();
+}
+
+//------------------------------------------------------------------------------
+void binder::reset_dispatch_cache()
+{
+    memset(m_dispatch, 0, sizeof(m_dispatch));
+
+    for (root_table& table : m_root_tables)
+        table.group = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -136,6 +147,8 @@ int binder::create_group(const char* name)
     if (name == nullptr || name[0] == '\0')
         return -1;
 
+    reset_dispatch_cache();
+
     int index = alloc_nodes(2);
     if (index < 0)
         return -1;
@@ -167,6 +180,9 @@ bool binder::bind(
     if (group >= sizeof_array(m_nodes))
         return false;
 
+    // Binding mutates the node graph; memoized lookups may be stale.
+    reset_dispatch_cache();
+
     // Translate from ASCII representation to actual keys.
     char translated[64];
     int len = 0;
@@ -249,17 +265,80 @@ int binder::insert_child(int parent, unsigned char key)
 //------------------------------------------------------------------------------
 int binder::find_child(int parent, unsigned char key) const
 {
+    // Group nodes immediately precede their root nodes, so this cheaply spots
+    // a root-level lookup (resolution always begins at a group's root, and
+    // single-byte input never goes deeper).  Roots get a full dispatch table
+    // rather than a shared cache slot.
+    if (parent > 0 && get_node(parent - 1).is_group)
+        return find_root_child(parent, key);
+
+    // Each input byte resolves through here; answer from the dispatch cache
+    // when possible instead of walking the sibling chain.
+    const unsigned int lookup = (unsigned int(parent) << 8) | key;
+    const unsigned int slot = (lookup * 2654435761u) >> (32 - dispatch_bits);
+    const unsigned int entry = m_dispatch[slot];
+    if ((entry & 0x80000000u) && ((entry >> link_bits) & 0x1ffff) == lookup)
+        return int(entry & ((1 << link_bits) - 1));
+
+    int found = 0;
     const node* node = m_nodes + parent;
-
-    int index = node->child;
-    for (; index > parent; index = node->next)
+    for (int index = node->child; index > parent; index = node->next)
     {
         node = m_nodes + index;
         if (node->key == key)
-            return index;
+        {
+            found = index;
+            break;
+        }
+    }
+
+    m_dispatch[slot] = 0x80000000u | (lookup << link_bits) | found;
+    return found;
+}
+
+//------------------------------------------------------------------------------
+int binder::find_root_child(int root, unsigned char key) const
+{
+    root_table* table = nullptr;
+    for (root_table& candidate : m_root_tables)
+        if (candidate.group == root)
+        {
+            table = &candidate;
+            break;
+        }
+
+    if (table == nullptr)
+    {
+        // No table for this group yet; claim an unused one, or failing that
+        // evict round-robin (more groups can be live than there are tables,
+        // but resolution only ever ping-pongs between a few).
+        for (root_table& candidate : m_root_tables)
+            if (candidate.group == 0)
+            {
+                table = &candidate;
+                break;
+            }
+
+        if (table == nullptr)
+        {
+            table = m_root_tables + m_root_victim;
+            m_root_victim = (m_root_victim + 1) % root_table_count;
+        }
+
+        // One walk of the root's children fills the whole table.
+        memset(table->map, 0, sizeof(table->map));
+        table->group = (unsigned short)root;
+
+        const node* node = m_nodes + root;
+        for (int index = node->child; index > root; index = node->next)
+        {
+            node = m_nodes + index;
+            if (table->map[node->key] == 0)
+                table->map[node->key] = (unsigned short)index;
+        }
     }
 
-    return 0;
+    return table->map[key];
 }
 
 //------------------------------------------------------------------------------
@@ -49,6 +49,8 @@ private:
     friend class        bind_resolver;
     int                 insert_child(int parent, unsigned char key);
     int                 find_child(int parent, unsigned char key) const;
+    int                 find_root_child(int root, unsigned char key) const;
+    void                reset_dispatch_cache();
     int                 add_child(int parent, unsigned char key);
     int                 find_tail(int head);
     int                 append(int head, unsigned char key);
@@ -60,4 +62,26 @@ private:
     modules             m_modules;
     node                m_nodes[1 << link_bits];
     unsigned int        m_next_node;
+
+    // Direct-mapped cache of find_child() lookups so resolving a key is O(1)
+    // instead of walking a sibling chain per input byte.  Entries memoize both
+    // hits and misses for a (parent, key) pair and the whole cache is reset
+    // whenever a bind mutates the node graph.
+    static const int    dispatch_bits = 10;
+    mutable unsigned int m_dispatch[1 << dispatch_bits];
+
+    // Root dispatch:  256-entry tables mapping the first byte of a sequence
+    // straight to its node, built lazily per group.  The first byte is the
+    // overwhelmingly common lookup (plain printable self-insert input is one
+    // byte deep), and unlike the shared cache above a full table can neither
+    // collide nor miss; the trie is only walked for multi-byte sequences.
+    // Invalidated together with the cache whenever a bind mutates the graph.
+    struct root_table
+    {
+        unsigned short  group;      // 0 = unused.
+        unsigned short  map[256];
+    };
+    static const int    root_table_count = 4;
+    mutable root_table  m_root_tables[root_table_count];
+    mutable unsigned char m_root_victim = 0;
 };
@@ -7,6 +7,7 @@
 #include "matches.h"
 
 #include <core/base.h>
+#include <core/dir_cache.h>
 #include <core/globber.h>
 #include <core/path.h>
 #include <core/settings.h>
@@ -49,11 +50,18 @@ static class : public match_generator
 
         root << "*";
 
-        int st_mode = 0;
-        int attr = 0;
-        globber globber(root.c_str());
-        globber.hidden(g_glob_hidden.get());
-        globber.system(g_glob_system.get());
+        // The directory cache key; drive relative patterns (e.g. 'c:foobar')
+        // get expanded inside globber via hidden environment variables, so
+        // they bypass the cache rather than risk a mismatched key.
+        str<288> pattern(root.c_str());
+        str<288> dir;
+        path::get_directory(root.c_str(), dir);
+        const char* c = root.c_str();
+        bool cacheable = !(c[0] && c[1] == ':' && c[2] != '\\' && c[2] != '/');
+
+        std::shared_ptr<const dir_cache::listing> cached;
+        if (cacheable)
+            cached = dir_cache::find(dir.c_str());
 
         path::get_directory(root);
         unsigned int root_len = root.length();
@@ -66,14 +74,81 @@ static class : public match_generator
                 root = collapsed.c_str();
         }
 
-        str<288> buffer;
-        while (globber.next(buffer, false, &st_mode, &attr))
+        bool include_hidden = g_glob_hidden.get();
+        bool include_system = g_glob_system.get();
+
+        if (cached != nullptr)
+        {
+            // Served from the directory cache; just filter and add.
+            for (const dir_cache::entry& entry : *cached)
+            {
+                if ((entry.attr & FILE_ATTRIBUTE_HIDDEN) && !include_hidden)
+                    continue;
+                if ((entry.attr & FILE_ATTRIBUTE_SYSTEM) && !include_system)
+                    continue;
+
+                root.truncate(root_len);
+                path::append(root, entry.name.c_str(), int(entry.name.length()));
+                if (entry.attr & FILE_ATTRIBUTE_DIRECTORY)
+                    root << PATH_SEP;
+                builder.add_match(root.c_str(), to_match_type(entry.st_mode, entry.attr));
+            }
+
+            // The cache preserves enumeration order, which is NTFS name order.
+            builder.set_matches_are_sorted();
+            return true;
+        }
+
+        // Enumerate asynchronously; entries get added to the builder while the
+        // worker is still walking the directory, which overlaps the add/store
+        // work with the (possibly slow) file system reads.  Enumeration is
+        // unfiltered so the result can populate the directory cache; hidden
+        // and system filtering happens below.
+        FILETIME write_time;
+        cacheable = cacheable && dir_cache::snapshot(dir.c_str(), write_time);
+        auto fresh = std::make_shared<dir_cache::listing>();
+
+        async_globber globber(pattern.c_str());
+        globber.hidden(true);
+        globber.system(true);
+        globber.suffix_dirs(false);
+
+        glob_entry entries[32];
+        while (unsigned int count = globber.next_batch(entries, sizeof_array(entries), false))
         {
-            root.truncate(root_len);
-            path::append(root, buffer.c_str());
-            builder.add_match(root.c_str(), to_match_type(st_mode, attr));
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                const glob_entry& entry = entries[i];
+
+                if (cacheable)
+                {
+                    fresh->emplace_back();
+                    dir_cache::entry& stored = fresh->back();
+                    stored.name.copy(entry.path.c_str());
+                    stored.st_mode = entry.st_mode;
+                    stored.attr = entry.attr;
+                }
+
+                if ((entry.attr & FILE_ATTRIBUTE_HIDDEN) && !include_hidden)
+                    continue;
+                if ((entry.attr & FILE_ATTRIBUTE_SYSTEM) && !include_system)
+                    continue;
+
+                root.truncate(root_len);
+                path::append(root, entry.path.c_str(), int(entry.path.length()));
+                if (entry.attr & FILE_ATTRIBUTE_DIRECTORY)
+                    root << PATH_SEP;
+                builder.add_match(root.c_str(), to_match_type(entry.st_mode, entry.attr));
+            }
         }
 
+        if (cacheable)
+            dir_cache::store(dir.c_str(), fresh, write_time);
+
+        // NTFS enumerates names in sorted order, so claim it; the sort
+        // verifies before believing it (FAT volumes don't sort, and NTFS
+        // order can disagree with the locale comparator).
+        builder.set_matches_are_sorted();
         return true;
     }
 
@@ -93,6 +168,12 @@ static class : public match_generator
         info.truncate = 0;
         info.keep = int(c - start);
     }
+
+    virtual bool is_thread_safe() const override
+    {
+        // Only reads the line state and the file system.
+        return true;
+    }
 } g_file_generator;
 
 
@@ -8,4 +8,5 @@ class input_dispatcher
 {
 public:
     virtual void    dispatch(int bind_group) = 0;
+    virtual int     get_dispatch_depth() const = 0;
 };
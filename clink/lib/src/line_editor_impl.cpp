@@ -9,12 +9,16 @@
 #include "match_pipeline.h"
 #include "pager.h"
 
+#include <core/arena_str.h>
 #include <core/base.h>
 #include <core/os.h>
 #include <core/path.h>
 #include <core/str_iter.h>
 #include <core/str_tokeniser.h>
+#include <core/log.h>
 #include <core/settings.h>
+#include <core/timings.h>
+#include <terminal/scroll.h>
 #include <terminal/terminal_in.h>
 #include <terminal/terminal_out.h>
 extern "C" {
@@ -22,6 +26,7 @@ extern "C" {
 #include <readline/rldefs.h>
 extern Keymap _rl_dispatching_keymap;
 extern void _rl_keyseq_chain_dispose(void);
+extern void rl_get_alloc_counters(unsigned long* count, unsigned long long* bytes, int reset);
 }
 
 //------------------------------------------------------------------------------
@@ -31,6 +36,16 @@ const int simple_input_states = (RL_STATE_MOREINPUT |
 
 extern setting_bool g_classify_words;
 
+//------------------------------------------------------------------------------
+static setting_bool g_debug_input_stats(
+    "debug.input_stats",
+    "Log input stage timings",
+    "When enabled, per-stage input latency statistics (on_input, match\n"
+    "update, classify, draw) are accumulated per keystroke and logged each\n"
+    "time a line edit ends, for finding which stage or script makes typing\n"
+    "slow.",
+    false);
+
 
 
 //------------------------------------------------------------------------------
@@ -205,9 +220,19 @@ void line_editor_impl::begin_line()
     m_buffer.begin_line();
     m_prev_generate.clear();
     m_prev_classify.clear();
+    for (collect_cache& cache : m_collect_cache)
+    {
+        cache.buffer.clear();
+        cache.valid = false;
+    }
+    m_first_dirty_word = 0;
+    m_line_arena.reset();
 
     rl_before_display_function = before_display;
 
+    if (g_debug_input_stats.get())
+        rl_get_alloc_counters(nullptr, nullptr, 1/*reset*/);
+
     line_state line = get_linestate();
     editor_module::context context = get_context(line);
     for (auto module : m_modules)
@@ -220,6 +245,9 @@ void line_editor_impl::end_line()
     for (auto i = m_modules.rbegin(), n = m_modules.rend(); i != n; ++i)
         i->on_end_line();
 
+    // Line-lifetime scratch dies with the line.
+    m_line_arena.reset();
+
     rl_before_display_function = nullptr;
 
     m_buffer.end_line();
@@ -228,10 +256,25 @@ void line_editor_impl::end_line()
 
     s_editor = nullptr;
 
+    // Summarise per-keystroke stage costs for the edited line (a no-op
+    // unless 'debug.input_stats' accumulated any).
+    timings::log_stats("Input stage timings");
+    if (g_debug_input_stats.get())
+    {
+        unsigned long allocs;
+        unsigned long long bytes;
+        rl_get_alloc_counters(&allocs, &bytes, 1/*reset*/);
+        LOG("Readline allocations for the line: %lu allocs, %llu bytes", allocs, bytes);
+    }
+
     clear_flag(flag_editing);
 }
 
 //------------------------------------------------------------------------------
+// Modules don't need event subscription masks:  per-keystroke input is
+// routed by the binder to the single module that bound the chord, so the
+// only walks over m_modules are per line (begin/end, bind_input) or on a
+// terminal resize, never per key.
 bool line_editor_impl::add_module(editor_module& module)
 {
     editor_module** slot = m_modules.push_back();
@@ -272,11 +315,59 @@ bool line_editor_impl::edit(str_base& out)
 
     // Update first so the init state goes through.
     while (update())
-        m_desc.input->select();
+    {
+        // While an incremental generator still has matches on the way, poll
+        // for input with a timeout and give it the gaps as idle time.
+        if (update_idle())
+            m_desc.input->select(10/*timeout_ms*/);
+        else
+        {
+            // The keystroke path is clear; use the gap before blocking on
+            // input to run any deferred match generation (so results are
+            // usually ready before the completion command that needs them)
+            // and let generators do housekeeping (e.g. Lua GC steps).  Skip
+            // both while input is already buffered (e.g. a paste burst) so
+            // they never delay a pending key.
+            if (!m_desc.input->more_input_available())
+            {
+                // Pick up settings another session changed ('clink set' in a
+                // different window) while this one sat at its prompt.
+                settings::sync();
+                prefetch_matches();
+                for (auto* generator : m_generators)
+                    generator->on_wait();
+            }
+            m_desc.input->select();
+        }
+    }
 
     return get_line(out);
 }
 
+//------------------------------------------------------------------------------
+// Grants busy incremental generators (e.g. a yielded Lua generator
+// coroutine) the idle time between keys.  Returns true while any generator
+// still has work pending, so edit() polls input instead of blocking on it.
+bool line_editor_impl::update_idle()
+{
+    bool pending = false;
+
+    for (auto* generator : m_generators)
+    {
+        if (!generator->is_busy())
+            continue;
+
+        // Reopen the matches so results streamed in after an earlier
+        // coalesce can be added, then re-select with the current needle.
+        match_pipeline pipeline(m_matches);
+        pipeline.reopen();
+        pending |= generator->on_idle();
+        pipeline.select(m_needle.c_str());
+    }
+
+    return pending;
+}
+
 //------------------------------------------------------------------------------
 bool line_editor_impl::update()
 {
@@ -299,15 +390,62 @@ bool line_editor_impl::update()
     update_input();
 
     if (!check_flag(flag_editing))
+    {
+        end_scroll_transaction();
         return false;
+    }
 
-    update_internal();
+    // During a paste burst the per-character word collection and match
+    // update are wasted work; defer them until the burst drains.  Anything
+    // that consumes matches in the meantime catches up in update_matches().
+    // Console scrolls coalesce across the burst too, so holding a scroll
+    // key costs one console window move per drain instead of one per key.
+    if (m_desc.input->more_input_available())
+    {
+        begin_scroll_transaction();
+        set_flag(flag_deferred);
+        return true;
+    }
+
+    end_scroll_transaction();
+    clear_flag(flag_deferred);
+    {
+        timing_accumulator timing("matches", g_debug_input_stats.get());
+        update_internal();
+    }
     return true;
 }
 
+//------------------------------------------------------------------------------
+// Speculatively runs a deferred generate while the editor is idle, so the
+// matches for the current end word are usually already in place when a
+// completion command calls update_matches().  Selecting and sorting for the
+// needle still happen at completion time; generating is the expensive phase.
+void line_editor_impl::prefetch_matches()
+{
+    if (!check_flag(flag_generate) || check_flag(flag_deferred))
+        return;
+
+    timing_accumulator timing("prefetch", g_debug_input_stats.get());
+
+    line_state line = get_linestate();
+    match_pipeline pipeline(m_matches);
+    pipeline.reset();
+    pipeline.generate(line, m_generators);
+    clear_flag(flag_generate);
+}
+
 //------------------------------------------------------------------------------
 void line_editor_impl::update_matches()
 {
+    // Catch up if update_internal() was deferred during an input burst, so
+    // the generate/select decisions reflect the current line.
+    if (check_flag(flag_deferred))
+    {
+        clear_flag(flag_deferred);
+        update_internal();
+    }
+
     if (check_flag(flag_generate))
     {
         line_state line = get_linestate();
@@ -358,6 +496,12 @@ void line_editor_impl::dispatch(int bind_group)
     m_bind_resolver.set_group(prev_bind_group);
 }
 
+//------------------------------------------------------------------------------
+int line_editor_impl::get_dispatch_depth() const
+{
+    return m_dispatching;
+}
+
 //------------------------------------------------------------------------------
 // Readline is designed for raw terminal input, and Windows is capable of richer
 // input analysis where we can avoid generating terminal input if there's no
@@ -530,7 +674,11 @@ bool line_editor_impl::update_input()
         result.flags = 0;
         result.group = m_bind_resolver.get_group();
 
-        str<16> chord;
+        // A chord can be up to 16 bytes (the resolver's full key buffer), so
+        // size for 16 plus the terminator; the copy must never heap allocate.
+        // (It has to be a copy:  on_input() can recursively dispatch(), which
+        // resets the resolver and reuses the buffer the binding points into.)
+        str<32, false> chord;
         editor_module* module = binding.get_module();
         unsigned char id = binding.get_id();
         binding.get_chord(chord);
@@ -541,6 +689,7 @@ bool line_editor_impl::update_input()
             line_state line = get_linestate();
             editor_module::context context = get_context(line);
             editor_module::input input = { chord.c_str(), chord.length(), id };
+            timing_accumulator timing("on_input", g_debug_input_stats.get());
             module->on_input(input, result, context);
         }
 
@@ -562,9 +711,14 @@ bool line_editor_impl::update_input()
         }
         else
         {
-            // Classify words in the input line (if configured).
-            if (g_classify_words.get())
+            // Classify words in the input line (if configured).  Skipped
+            // while a burst of input is draining; the classification after
+            // the burst's last key covers the whole line anyway.
+            if (g_classify_words.get() && !m_desc.input->more_input_available())
+            {
+                timing_accumulator timing("classify", g_debug_input_stats.get());
                 classify();
+            }
 
             if (result.flags & result_impl::flag_done)
             {
@@ -582,7 +736,13 @@ bool line_editor_impl::update_input()
             m_buffer.redraw();
     }
 
-    m_buffer.draw();
+    // Defer the redraw while a burst of input is draining; Readline's
+    // redisplay is by far the most expensive part of a paste.
+    if (!m_desc.input->more_input_available())
+    {
+        timing_accumulator timing("draw", g_debug_input_stats.get());
+        m_buffer.draw();
+    }
     return true;
 }
 
@@ -590,7 +750,57 @@ bool line_editor_impl::update_input()
 void line_editor_impl::collect_words(bool stop_at_cursor)
 {
     collect_words_mode mode = stop_at_cursor ? collect_words_mode::stop_at_cursor : collect_words_mode::whole_command;
+
+    const char* buffer = m_buffer.get_buffer();
+    unsigned int length = m_buffer.get_length();
+    unsigned int cursor = m_buffer.get_cursor();
+
+    // The editor collects words several times per keystroke; when nothing the
+    // collection depends on has changed the words are already current.
+    collect_cache& cache = m_collect_cache[int(mode)];
+    if (cache.valid && cursor == cache.cursor && cache.buffer.equals(buffer, length))
+    {
+        m_words = cache.words_copy;
+        m_command_offset = cache.command_offset;
+        m_first_dirty_word = (unsigned int)m_words.size();
+        return;
+    }
+
     m_command_offset = collect_words(m_words, m_matches, mode);
+
+    // Find the first word that differs from the previous same-mode
+    // collection, so that line_state can report unchanged leading words and
+    // downstream consumers can skip rework for them.  A word counts as
+    // unchanged when its bounds and flags match and its text lies wholly
+    // within the buffers' common prefix.
+    unsigned int common = 0;
+    if (cache.valid)
+    {
+        const char* prev = cache.buffer.get();
+        unsigned int same = 0;
+        unsigned int max_same = min(length, cache.buffer.length());
+        while (same < max_same && buffer[same] == prev[same])
+            same++;
+
+        while (common < m_words.size() && common < cache.words_copy.size())
+        {
+            const word& a = m_words[common];
+            const word& b = cache.words_copy[common];
+            if (a.offset + a.length > same ||
+                a.offset != b.offset || a.length != b.length ||
+                a.command_word != b.command_word || a.is_alias != b.is_alias ||
+                a.quoted != b.quoted || a.delim != b.delim)
+                break;
+            common++;
+        }
+    }
+    m_first_dirty_word = common;
+
+    cache.buffer.set(buffer, length);
+    cache.words_copy = m_words;
+    cache.cursor = cursor;
+    cache.command_offset = m_command_offset;
+    cache.valid = true;
 }
 
 //------------------------------------------------------------------------------
@@ -689,7 +899,8 @@ void line_editor_impl::classify()
     // Parse word types for coloring the input line.
     int i = 0;
     int command_word_offset = 0;
-    std::vector<word> words;
+    std::vector<word>& words = m_classify_words;
+    words.clear();
     while (true)
     {
         if (!words.empty() && (i >= m_words.size() || m_words[i].command_word))
@@ -705,14 +916,22 @@ void line_editor_impl::classify()
                      m_buffer.get_buffer()[command_char_offset - 2] == ' ')
                 command_char_offset--;
 
+            // Report how many of this command's leading words are unchanged
+            // since the previous classification pass, so the classifier can
+            // serve them from its cache.
+            unsigned int chunk_dirty = 0;
+            if (m_first_dirty_word > (unsigned int)command_word_offset)
+                chunk_dirty = min<unsigned int>(m_first_dirty_word - command_word_offset, (unsigned int)words.size());
+
             line_state linestate(
                 m_buffer.get_buffer(),
                 m_buffer.get_cursor(),
                 command_char_offset,
-                words
+                words,
+                chunk_dirty
             );
 
-            str<16> already_classified;
+            arena_str already_classified(m_scratch_arena, 64);
             {
                 for (int j = 0; j < words.size(); j++)
                 {
@@ -797,6 +1016,7 @@ line_state line_editor_impl::get_linestate() const
         m_buffer.get_cursor(),
         m_command_offset,
         m_words,
+        m_first_dirty_word,
     };
 }
 
@@ -806,7 +1026,8 @@ editor_module::context line_editor_impl::get_context(const line_state& line) con
     auto& pter = const_cast<printer&>(m_printer);
     auto& pger = const_cast<pager&>(static_cast<const pager&>(m_pager));
     auto& buffer = const_cast<rl_buffer&>(m_buffer);
-    return { m_desc.prompt, pter, pger, buffer, line, m_matches, m_classifications };
+    auto& arena = const_cast<linear_allocator&>(m_line_arena);
+    return { m_desc.prompt, pter, pger, buffer, line, m_matches, m_classifications, arena };
 }
 
 //------------------------------------------------------------------------------
@@ -907,6 +1128,17 @@ matches* get_mutable_matches(bool nosort=false)
     return s_editor->get_mutable_matches(nosort);
 }
 
+//------------------------------------------------------------------------------
+// The line arena for Readline command functions, which don't receive a module
+// context.  Null when no line edit is in progress.
+linear_allocator* get_line_arena()
+{
+    if (!s_editor)
+        return nullptr;
+
+    return &s_editor->m_line_arena;
+}
+
 //------------------------------------------------------------------------------
 void line_editor_impl::update_internal()
 {
@@ -940,12 +1172,19 @@ void line_editor_impl::update_internal()
         int len = int(end_word.get_pointer() + end_word.length() - line.get_line());
         if (!m_prev_generate.equals(line.get_line(), len))
         {
+            // The prefix text changed, but the matches may still be reusable
+            // if the word texts, cwd, and generators are unchanged (e.g. only
+            // whitespace between words was edited).
             match_pipeline pipeline(m_matches);
-            pipeline.reset();
-            // Defer generating until update_matches().  Must set word break
-            // position in the meantime because adjust_completion_word() gets
-            // called before the deferred generate().
-            set_flag(flag_generate);
+            if (!pipeline.can_reuse(line, m_generators))
+            {
+                pipeline.reset();
+                // Defer generating until update_matches().  Must set word
+                // break position in the meantime because
+                // adjust_completion_word() gets called before the deferred
+                // generate().
+                set_flag(flag_generate);
+            }
             m_matches.set_word_break_position(line.get_end_word_offset());
             update_prev_generate = len;
         }
@@ -981,6 +1220,10 @@ void line_editor_impl::update_internal()
     // for deciding whether to sort/select, after deciding whether to generate.
     if (update_prev_generate >= 0)
         m_prev_generate.set(m_buffer.get_buffer(), update_prev_generate);
+
+    // Scratch strings carved from the arena during this pass are dead now;
+    // recycle the space.
+    m_scratch_arena.reset();
 }
 
 void line_editor_impl::before_display()
@@ -17,6 +17,7 @@
 #include "rl/rl_buffer.h"
 
 #include <core/array.h>
+#include <core/linear_allocator.h>
 #include <core/str.h>
 #include <terminal/printer.h>
 
@@ -56,6 +57,7 @@ public:
 
     // input_dispatcher
     virtual void        dispatch(int bind_group) override;
+    virtual int         get_dispatch_depth() const override;
 
     // key_tester
     virtual bool        is_bound(const char* seq, int len) override;
@@ -64,12 +66,13 @@ public:
 
 private:
     typedef editor_module                       module;
-    typedef fixed_array<editor_module*, 16>     modules;
-    typedef fixed_array<match_generator*, 32>   generators;
+    typedef small_vector<editor_module*, 16>    modules;
+    typedef small_vector<match_generator*, 32>  generators;
     typedef std::vector<word>                   words;
     friend void update_matches();
     friend matches* get_mutable_matches(bool nosort);
     friend matches* maybe_regenerate_matches(const char* needle, bool popup);
+    friend linear_allocator* get_line_arena();
 
     enum flags : unsigned char
     {
@@ -79,6 +82,7 @@ private:
         flag_select     = 1 << 3,
         flag_done       = 1 << 4,
         flag_eof        = 1 << 5,
+        flag_deferred   = 1 << 6,   // update_internal() skipped during an input burst.
     };
 
     struct key_t
@@ -98,6 +102,8 @@ private:
     void                classify();
     matches*            get_mutable_matches(bool nosort=false);
     void                update_internal();
+    void                prefetch_matches();
+    bool                update_idle();
     bool                update_input();
     module::context     get_context(const line_state& line) const;
     line_state          get_linestate() const;
@@ -120,7 +126,22 @@ private:
     word_classifier*    m_classifier = nullptr;
     binder              m_binder;
     bind_resolver       m_bind_resolver = { m_binder };
+    // Per-mode cache of the previous collection; classification
+    // (whole_command) interleaves with match updates (stop_at_cursor), so a
+    // shared slot would never see two collections of the same mode in a row.
+    struct collect_cache
+    {
+        prev_buffer     buffer;
+        words           words_copy;
+        unsigned int    cursor = 0;
+        unsigned int    command_offset = 0;
+        bool            valid = false;
+    };
+
     words               m_words;
+    words               m_classify_words;
+    collect_cache       m_collect_cache[3];
+    unsigned int        m_first_dirty_word = 0;
     word_classifications m_classifications;
     matches_impl        m_regen_matches;
     matches_impl        m_matches;
@@ -132,6 +153,15 @@ private:
     unsigned char       m_flags = 0;
     str<64>             m_needle;
 
+    // Scratch space for short-lived strings created while updating; rewound
+    // at the end of each update_internal() pass.
+    linear_allocator    m_scratch_arena = { 4096 };
+
+    // Bump allocator handed to editor modules through the context; rewound
+    // when a line edit begins and ends, so per-keystroke scratch costs a
+    // pointer bump instead of a heap round trip.
+    linear_allocator    m_line_arena = { 16384 };
+
     const char*         m_insert_on_begin = nullptr;
 
     // State for dispatch().
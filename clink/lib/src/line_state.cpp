@@ -13,11 +13,13 @@ line_state::line_state(
     const char* line,
     unsigned int cursor,
     unsigned int command_offset,
-    const std::vector<word>& words)
+    const std::vector<word>& words,
+    unsigned int first_dirty_word)
 : m_words(words)
 , m_line(line)
 , m_cursor(cursor)
 , m_command_offset(command_offset)
+, m_first_dirty_word(first_dirty_word)
 {
 }
 
@@ -39,6 +41,15 @@ unsigned int line_state::get_command_offset() const
     return m_command_offset;
 }
 
+//------------------------------------------------------------------------------
+// Words before this index are identical (same bounds, flags, and text) to the
+// previous collection of the line, so consumers that keep per-word results
+// keyed by index can skip rework for them.  0 means all words may be dirty.
+unsigned int line_state::get_first_dirty_word() const
+{
+    return m_first_dirty_word;
+}
+
 //------------------------------------------------------------------------------
 unsigned int line_state::get_end_word_offset() const
 {
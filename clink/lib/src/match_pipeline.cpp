@@ -7,8 +7,11 @@
 #include "match_generator.h"
 #include "match_pipeline.h"
 #include "matches_impl.h"
+#include "usage_index.h"
 
 #include <core/array.h>
+#include <core/base.h>
+#include <core/os.h>
 #include <core/path.h>
 #include <core/str_compare.h>
 #include <core/settings.h>
@@ -17,6 +20,7 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <emmintrin.h>
 
 //------------------------------------------------------------------------------
 static setting_enum g_sort_dirs(
@@ -26,6 +30,17 @@ static setting_enum g_sort_dirs(
     "before,with,after",
     1);
 
+//------------------------------------------------------------------------------
+static setting_int g_generate_timeout(
+    "match.generate_timeout",
+    "Time budget for match generation (ms)",
+    "How many milliseconds match generation may spend before completion goes\n"
+    "ahead with whatever matches have arrived, so a hung network drive bounds\n"
+    "the wait instead of blocking indefinitely.  Overrunning generators are\n"
+    "abandoned (their late results are discarded) and the match list is\n"
+    "flagged as possibly incomplete.  0 disables the budget.",
+    5000);
+
 
 
 //------------------------------------------------------------------------------
@@ -33,29 +48,164 @@ extern "C" {
 extern int rl_complete_with_tilde_expansion;
 extern int _rl_completion_case_fold;
 extern int _rl_locale_sort;
+extern int rl_matches_are_partial;
 int compare_string(const char* s1, const char* s2, int casefold);
 };
 
 static bool s_nosort = false;
 
+// True when the last generate()'s matches all arrived under sorted claims
+// (see match_builder::set_matches_are_sorted).  Like s_nosort, this bridges
+// the pipeline and the Readline sort hook below, which only sees a char**.
+static bool s_sorted_hint = false;
+
 
 
 //------------------------------------------------------------------------------
-static unsigned int normal_selector(
-    const char* needle,
-    match_info* infos,
-    int count)
+// SSE2 prefix selection.  Compares the needle against candidates 16 bytes at
+// a time.  It only engages when the needle is plain ASCII and the compare
+// mode's per-character transforms can be applied bytewise (lower-casing,
+// backslash to slash, and dash to underscore for relaxed mode).  Candidates
+// with non-ASCII bytes in the compared window fall back to str_compare, as do
+// loads that would straddle a page boundary.
+class simd_prefix_matcher
 {
-    int select_count = 0;
-    for (int i = 0; i < count; ++i)
+public:
+    bool            init(const char* needle);
+    int             select(const char* name) const; // 1 = select, 0 = reject, -1 = use str_compare.
+
+private:
+    __m128i         normalise(__m128i value) const;
+    __m128i         m_chunks[4];
+    int             m_length;
+    int             m_mode;
+};
+
+//------------------------------------------------------------------------------
+bool simd_prefix_matcher::init(const char* needle)
+{
+    if (str_compare_scope::current_fuzzy_accents())
+        return false;
+
+    m_mode = str_compare_scope::current();
+    m_length = int(strlen(needle));
+    if (m_length > int(sizeof(m_chunks)))
+        return false;
+
+    char buffer[sizeof(m_chunks)] = {};
+    for (int i = 0; i < m_length; ++i)
+    {
+        char c = needle[i];
+        if (c & 0x80)
+            return false;
+
+        if (m_mode > 0 && c >= 'A' && c <= 'Z')
+            c += 0x20;
+        if (m_mode > 1 && c == '-')
+            c = '_';
+        if (c == '\\')
+            c = '/';
+        buffer[i] = c;
+    }
+
+    memcpy(m_chunks, buffer, sizeof(m_chunks));
+    return true;
+}
+
+//------------------------------------------------------------------------------
+__m128i simd_prefix_matcher::normalise(__m128i value) const
+{
+    if (m_mode > 0)
     {
-        const char* name = infos[i].match;
-        int j = str_compare(needle, name);
-        infos[i].select = (j < 0 || !needle[j]);
-        ++select_count;
+        __m128i ge_a = _mm_cmpgt_epi8(value, _mm_set1_epi8('A' - 1));
+        __m128i le_z = _mm_cmplt_epi8(value, _mm_set1_epi8('Z' + 1));
+        __m128i upper = _mm_and_si128(ge_a, le_z);
+        value = _mm_add_epi8(value, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
     }
 
-    return select_count;
+    if (m_mode > 1)
+    {
+        __m128i dash = _mm_cmpeq_epi8(value, _mm_set1_epi8('-'));
+        value = _mm_or_si128(_mm_andnot_si128(dash, value),
+                             _mm_and_si128(dash, _mm_set1_epi8('_')));
+    }
+
+    __m128i bslash = _mm_cmpeq_epi8(value, _mm_set1_epi8('\\'));
+    value = _mm_or_si128(_mm_andnot_si128(bslash, value),
+                         _mm_and_si128(bslash, _mm_set1_epi8('/')));
+
+    return value;
+}
+
+//------------------------------------------------------------------------------
+int simd_prefix_matcher::select(const char* name) const
+{
+    int remaining = m_length;
+    const char* p = name;
+    const __m128i* chunk = m_chunks;
+
+    while (remaining > 0)
+    {
+        // Don't let an unaligned 16 byte load touch the next page.
+        if ((uintptr_t(p) & 0xfff) > 0xff0)
+            return -1;
+
+        __m128i cand = _mm_loadu_si128((const __m128i*)p);
+        if (_mm_movemask_epi8(cand) != 0)
+            return -1;
+
+        int take = min(remaining, 16);
+        unsigned int region = (take == 16) ? 0xffff : ((1u << take) - 1);
+
+        // A terminator inside the compared window means the candidate is
+        // shorter than the needle.
+        unsigned int nuls = _mm_movemask_epi8(_mm_cmpeq_epi8(cand, _mm_setzero_si128()));
+        if (nuls & region)
+            return 0;
+
+        unsigned int eq = _mm_movemask_epi8(_mm_cmpeq_epi8(normalise(cand), *chunk));
+        if ((eq & region) != region)
+            return 0;
+
+        remaining -= take;
+        p += 16;
+        ++chunk;
+    }
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static void normal_selector(
+    const char* needle,
+    const match_info* infos,
+    int count,
+    unsigned int* select_bits)
+{
+    simd_prefix_matcher matcher;
+    bool use_simd = matcher.init(needle);
+
+    // Accumulate the selection a word at a time; 'select_bits' was cleared
+    // by the caller so only set bits need writing out.
+    for (int i = 0; i < count; )
+    {
+        unsigned int word = 0;
+        const int n = min(count - i, 32);
+        for (int bit = 0; bit < n; ++bit, ++i)
+        {
+            const char* name = infos[i].match;
+
+            int selected = use_simd ? matcher.select(name) : -1;
+            if (selected < 0)
+            {
+                int j = str_compare(needle, name);
+                selected = (j < 0 || !needle[j]);
+            }
+
+            word |= (unsigned int)!!selected << bit;
+        }
+        *select_bits++ = word;
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -71,21 +221,16 @@ static bool is_dir_match(const wstr_base& match, match_type type)
 }
 
 //------------------------------------------------------------------------------
-inline bool sort_worker(wstr_base& l, match_type l_type,
-                        wstr_base& r, match_type r_type,
-                        int order)
+// Compares matches whose text has already been converted to UTF-16 and
+// separator-stripped, so the conversion cost is paid once per match instead
+// of once per comparison.
+inline bool sort_worker_keyed(const wstr_base& l, match_type l_type, bool l_dir,
+                              const wstr_base& r, match_type r_type, bool r_dir,
+                              int order)
 {
-    bool l_dir = is_dir_match(l, l_type);
-    bool r_dir = is_dir_match(r, r_type);
-
     if (order != 1 && l_dir != r_dir)
         return (order == 0) ? l_dir : r_dir;
 
-    if (l_dir)
-        path::maybe_strip_last_separator(l);
-    if (r_dir)
-        path::maybe_strip_last_separator(r);
-
     DWORD flags = SORT_DIGITSASNUMBERS|NORM_LINGUISTIC_CASING;
     if (true/*casefold*/)
         flags |= LINGUISTIC_IGNORECASE;
@@ -116,6 +261,22 @@ inline bool sort_worker(wstr_base& l, match_type l_type,
     return (cmp < 0);
 }
 
+//------------------------------------------------------------------------------
+inline bool sort_worker(wstr_base& l, match_type l_type,
+                        wstr_base& r, match_type r_type,
+                        int order)
+{
+    bool l_dir = is_dir_match(l, l_type);
+    bool r_dir = is_dir_match(r, r_type);
+
+    if (l_dir)
+        path::maybe_strip_last_separator(l);
+    if (r_dir)
+        path::maybe_strip_last_separator(r);
+
+    return sort_worker_keyed(l, l_type, l_dir, r, r_type, r_dir, order);
+}
+
 //------------------------------------------------------------------------------
 //#define SORT_MATCH_PIPELINE
 #ifdef SORT_MATCH_PIPELINE // Unused.
@@ -137,12 +298,25 @@ static void alpha_sorter(match_info* infos, int count)
 }
 #endif
 
+// True while sort_match_list() runs with usage ranking engaged; lets the
+// context-free qsort comparator consult the usage index.
+static bool s_rank_usage = false;
+
 //------------------------------------------------------------------------------
 static int _cdecl qsort_match_compare(const void* pv1, const void* pv2)
 {
-    const char** s1 = (const char**)pv1;
-    const char** s2 = (const char**)pv2;
-    return compare_string(*s1, *s2, 1 /*casefold*/);
+    const char* s1 = *(const char**)pv1;
+    const char* s2 = *(const char**)pv2;
+
+    if (s_rank_usage)
+    {
+        unsigned int u1 = usage_index::lookup(s1);
+        unsigned int u2 = usage_index::lookup(s2);
+        if (u1 != u2)
+            return (u1 > u2) ? -1 : 1;
+    }
+
+    return compare_string(s1, s2, 1 /*casefold*/);
 }
 
 //------------------------------------------------------------------------------
@@ -151,29 +325,106 @@ void sort_match_list(char** matches, int len)
     if (s_nosort || len <= 0)
         return;
 
+    s_rank_usage = usage_index::is_active();
+
     if (!rl_completion_matches_include_type)
     {
+        if (s_sorted_hint)
+        {
+            int i = 1;
+            while (i < len && qsort_match_compare(&matches[i - 1], &matches[i]) <= 0)
+                ++i;
+            if (i == len)
+                return;
+        }
+
         qsort(matches, len, sizeof(matches[0]), qsort_match_compare);
         return;
     }
 
     int order = g_sort_dirs.get();
-    wstr<> ltmp;
-    wstr<> rtmp;
 
-    auto predicate = [&] (const char* l, const char* r) {
-        match_type l_type = match_type(*(l++));
-        match_type r_type = match_type(*(r++));
+    // Convert each match to UTF-16 and strip trailing separators once up
+    // front, rather than redoing both inside the comparison where they'd run
+    // O(n log n) times.
+    struct sort_key
+    {
+        char*       match;  // Original pointer, including the type byte.
+        wstr<>      text;
+        unsigned int usage;
+        match_type  type;
+        bool        dir;
+    };
 
-        ltmp.clear();
-        rtmp.clear();
-        to_utf16(ltmp, l);
-        to_utf16(rtmp, r);
+    std::vector<sort_key> keys(len);
+    std::vector<sort_key*> index(len);
+    for (int i = 0; i < len; ++i)
+    {
+        sort_key& key = keys[i];
+        key.match = matches[i];
+
+        const char* text = matches[i];
+        key.type = match_type(*(text++));
+        to_utf16(key.text, text);
+        key.usage = s_rank_usage ? usage_index::lookup(text) : 0;
+        key.dir = is_dir_match(key.text, key.type);
+        if (key.dir)
+            path::maybe_strip_last_separator(key.text);
+
+        index[i] = &key;
+    }
 
-        return sort_worker(ltmp, l_type, rtmp, r_type, order);
+    // Frequently chosen completions sort first; the usage counts were looked
+    // up once per match above, so ranking adds no work per comparison.
+    auto predicate = [order] (const sort_key* l, const sort_key* r) {
+        if (l->usage != r->usage)
+            return (l->usage > r->usage);
+        return sort_worker_keyed(l->text, l->type, l->dir, r->text, r->type, r->dir, order);
     };
 
-    std::sort(matches, matches + len, predicate);
+    // When the generators claimed their output was sorted, verify with a
+    // linear scan instead of trusting it:  the claims are in the generators'
+    // order (e.g. NTFS name order), which usually -- but not always -- agrees
+    // with this comparator.  One ascending run means the list is already
+    // sorted and the O(n log n) compares are skipped entirely; a few runs
+    // (several generators) are merged; and if the scan finds more runs than
+    // claims plausibly produce, the claim was wrong and the full sort runs.
+    bool sorted = false;
+    if (s_sorted_hint)
+    {
+        static const int c_max_runs = 8;
+        int run_starts[c_max_runs];
+        int runs = 1;
+        run_starts[0] = 0;
+
+        sorted = true;
+        for (int i = 1; i < len; ++i)
+        {
+            if (predicate(index[i], index[i - 1]))
+            {
+                if (runs == c_max_runs)
+                {
+                    sorted = false;
+                    break;
+                }
+                run_starts[runs++] = i;
+            }
+        }
+
+        if (sorted)
+            for (int run = 1; run < runs; ++run)
+                std::inplace_merge(index.begin(),
+                                   index.begin() + run_starts[run],
+                                   (run + 1 < runs) ? index.begin() + run_starts[run + 1]
+                                                    : index.end(),
+                                   predicate);
+    }
+
+    if (!sorted)
+        std::sort(index.begin(), index.end(), predicate);
+
+    for (int i = 0; i < len; ++i)
+        matches[i] = index[i]->match;
 }
 
 
@@ -189,6 +440,30 @@ void match_pipeline::reset() const
 {
     m_matches.reset();
     s_nosort = false;
+    s_sorted_hint = false;
+    rl_matches_are_partial = 0;
+}
+
+//------------------------------------------------------------------------------
+// Discards the memoised generate key so the next completion regenerates even
+// if the line state looks unchanged.  Hosts should call this when something
+// the generators depend on changes behind the line editor's back (e.g. a
+// generator is registered, or scripts are reloaded).
+void match_pipeline::invalidate() const
+{
+    m_matches.m_has_generate_key = false;
+}
+
+//------------------------------------------------------------------------------
+// Reopens the matches for additions after they have been coalesced, so an
+// incremental generator can stream in late results; the caller re-select()s
+// afterwards to fold the new matches in.
+void match_pipeline::reopen() const
+{
+    m_matches.m_coalesced = false;
+
+    // Late results stream in unclaimed; don't let a stale hint cover them.
+    s_sorted_hint = false;
 }
 
 //------------------------------------------------------------------------------
@@ -197,6 +472,96 @@ void match_pipeline::set_nosort(bool nosort)
     s_nosort = nosort;
 }
 
+//------------------------------------------------------------------------------
+static unsigned int hash_append(unsigned int hash, const char* data, int length)
+{
+    while (length-- > 0)
+        hash = ((hash << 5) + hash) ^ *data++;
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+// Key describing what generate() would produce; the word texts (generators
+// see all of them, so argmatcher-style generators are covered), the current
+// directory (file matches depend on it), and the generator set.  Offsets are
+// deliberately excluded so whitespace-only edits don't change the key.
+unsigned int match_pipeline::get_generate_key(
+    const line_state& state,
+    const array<match_generator*>& generators)
+{
+    unsigned int key = 5381;
+
+    for (unsigned int i = 0, n = state.get_word_count(); i < n; ++i)
+    {
+        str_iter word = state.get_word(i);
+        key = hash_append(key, word.get_pointer(), word.length());
+        key = hash_append(key, "\x01", 1); // Word separator.
+    }
+
+    str<288> cwd;
+    os::get_current_dir(cwd);
+    key = hash_append(key, cwd.c_str(), cwd.length());
+
+    for (auto* generator : generators)
+        key = hash_append(key, (const char*)&generator, sizeof(generator));
+
+    return key;
+}
+
+//------------------------------------------------------------------------------
+// True when the matches already hold the result generate() would produce for
+// this line state, so the previous generate can be reused as-is.
+bool match_pipeline::can_reuse(
+    const line_state& state,
+    const array<match_generator*>& generators) const
+{
+    return (m_matches.m_has_generate_key &&
+            m_matches.m_generate_key == get_generate_key(state, generators));
+}
+
+//------------------------------------------------------------------------------
+// Runs one thread-safe generator against a private matches_impl on a worker
+// thread, so independent generators (directory scans, external queries) can
+// overlap instead of running back to back.
+//
+// A run can outlive generate():  when the time budget expires the waiter
+// abandons it rather than blocking on a hung file system call (there is no
+// safe way to kill a thread that may hold the heap lock).  Ownership is
+// settled by m_release -- whichever side arrives second deletes the run, so
+// an abandoned run cleans itself up when its generator eventually returns.
+struct speculative_run
+{
+    // The line text and words are copied rather than referenced:  an
+    // abandoned run's generator keeps reading them after the caller's line
+    // state is gone.
+    speculative_run(const line_state& state, match_generator& generator)
+    : m_line(state.get_line())
+    , m_words(state.get_words())
+    , m_state(m_line.c_str(), state.get_cursor(), state.get_command_offset(), m_words, state.get_first_dirty_word())
+    , m_generator(generator)
+    {
+    }
+
+    static DWORD WINAPI thread_proc(void* param)
+    {
+        speculative_run* run = (speculative_run*)param;
+        match_builder builder(run->m_matches);
+        run->m_generated = run->m_generator.generate(run->m_state, builder);
+        if (InterlockedExchange(&run->m_release, 1))
+            delete run;
+        return 0;
+    }
+
+    str<>               m_line;
+    std::vector<word>   m_words;
+    line_state          m_state;
+    match_generator&    m_generator;
+    matches_impl        m_matches;
+    void*               m_thread = nullptr;
+    volatile long       m_release = 0;
+    bool                m_generated = false;
+};
+
 //------------------------------------------------------------------------------
 void match_pipeline::generate(
     const line_state& state,
@@ -204,10 +569,102 @@ void match_pipeline::generate(
 {
     m_matches.set_word_break_position(state.get_end_word_offset());
 
+    // Generators run in priority order until one of them claims the word by
+    // returning true.  Thread-safe generators are started up front on worker
+    // threads against private builders, overlapping their work with whatever
+    // runs on this thread; their results are merged in priority order and
+    // anything past the first claimant is discarded, preserving the serial
+    // semantics.
+    //
+    // Threaded runs also give the time budget something to cut:  a run that
+    // overruns is abandoned mid-flight, so even a single thread-safe
+    // generator goes to a worker thread when a budget is set.  Generators
+    // that must run inline (Lua) cannot be preempted and are not covered.
+    const DWORD timeout = DWORD(max(g_generate_timeout.get(), 0));
+
+    speculative_run* runs[32] = {}; // matches_impl::generators capacity.
+    if ((generators.size() > 1 || timeout != 0) && generators.size() <= sizeof_array(runs))
+    {
+        int index = 0;
+        for (auto* generator : generators)
+        {
+            if (generator->is_thread_safe())
+            {
+                speculative_run* run = new speculative_run(state, *generator);
+                run->m_thread = CreateThread(nullptr, 0, speculative_run::thread_proc, run, 0, nullptr);
+                if (run->m_thread != nullptr)
+                    runs[index] = run;
+                else
+                    delete run;
+            }
+            ++index;
+        }
+    }
+
+    const DWORD started = GetTickCount();
+    bool deadline_hit = false;
+
     match_builder builder(m_matches);
+    bool claimed = false;
+    unsigned int index = 0;
     for (auto* generator : generators)
-        if (generator->generate(state, builder))
-            break;
+    {
+        speculative_run* run = (index < sizeof_array(runs)) ? runs[index] : nullptr;
+        ++index;
+        if (run != nullptr)
+        {
+            // The budget spans the whole generate, not each run; once spent,
+            // remaining runs get a zero wait so finished ones still merge.
+            DWORD wait = INFINITE;
+            if (timeout != 0)
+            {
+                DWORD elapsed = GetTickCount() - started;
+                wait = (elapsed < timeout) ? timeout - elapsed : 0;
+            }
+
+            if (WaitForSingleObject(run->m_thread, wait) == WAIT_OBJECT_0)
+            {
+                CloseHandle(run->m_thread);
+                if (!claimed)
+                {
+                    merge(run->m_matches);
+                    claimed = run->m_generated;
+                }
+                delete run;
+            }
+            else
+            {
+                // Out of budget; abandon the run rather than waiting on what
+                // is likely a hung file system call.  Whichever of this and
+                // the worker thread arrives second frees the run (m_release),
+                // so it cleans itself up when the generator finally returns.
+                deadline_hit = true;
+                CloseHandle(run->m_thread);
+                if (InterlockedExchange(&run->m_release, 1))
+                    delete run;
+            }
+        }
+        else if (!claimed)
+        {
+            claimed = generator->generate(state, builder);
+        }
+    }
+
+    if (deadline_hit)
+        m_matches.set_partial();
+
+    // Different generators can emit overlapping sets (the file generator
+    // plus Lua generators); drop the duplicates once here rather than
+    // letting every downstream consumer cope with them.
+    m_matches.dedup();
+
+    s_sorted_hint = m_matches.get_sorted_hint();
+    rl_matches_are_partial = m_matches.is_partial();
+
+    // A partial result is not memoised, so the next completion retries the
+    // generators instead of reusing the cut-off list.
+    m_matches.m_generate_key = get_generate_key(state, generators);
+    m_matches.m_has_generate_key = !deadline_hit;
 
 #ifdef DEBUG
     if (dbg_get_env_int("DEBUG_PIPELINE"))
@@ -231,6 +688,37 @@ void match_pipeline::generate(
 #endif
 }
 
+//------------------------------------------------------------------------------
+// Folds the result of a speculative run into the real matches.  Matches are
+// re-added through the builder so the usual bookkeeping (store, pathish
+// implications) applies, and explicitly set builder state is carried over.
+void match_pipeline::merge(const matches_impl& src) const
+{
+    match_builder builder(m_matches);
+
+    for (unsigned int i = 0, n = src.get_info_count(); i < n; ++i)
+    {
+        const match_info& info = src.get_infos()[i];
+        match_desc desc = { info.match, info.type };
+        builder.add_match(desc);
+    }
+
+    if (src.m_filename_completion_desired.is_explicit())
+        builder.set_matches_are_files(src.m_filename_completion_desired.get());
+    if (src.m_append_character)
+        builder.set_append_character(src.m_append_character);
+    if (src.m_suppress_append)
+        builder.set_suppress_append(true);
+    if (src.m_suppress_quoting)
+        builder.set_suppress_quoting(src.m_suppress_quoting);
+
+    // Carry the sortedness hint over.  The merged block may be several runs
+    // rather than one, but claims are only a hint; the sort's verification
+    // pass discovers the actual runs.
+    if (src.get_sorted_hint())
+        builder.set_matches_are_sorted();
+}
+
 //------------------------------------------------------------------------------
 void match_pipeline::select(const char* needle) const
 {
@@ -249,8 +737,12 @@ void match_pipeline::select(const char* needle) const
     str<32> debug_needle(needle); // needle goes out of scope before DEBUG_PIPELINE.
 #endif
 
+    m_matches.clear_select_bits();
     if (count)
-        selected_count = normal_selector(needle, m_matches.get_infos(), count);
+    {
+        normal_selector(needle, m_matches.get_infos(), count, m_matches.get_select_bits());
+        selected_count = m_matches.count_select_bits();
+    }
 
     m_matches.coalesce(selected_count);
 
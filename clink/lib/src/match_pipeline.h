@@ -14,11 +14,16 @@ class match_pipeline
 public:
                         match_pipeline(matches_impl& matches);
     void                reset() const;
+    void                invalidate() const;
+    void                reopen() const;
     void                set_nosort(bool nosort=true);
+    bool                can_reuse(const line_state& state, const array<match_generator*>& generators) const;
     void                generate(const line_state& state, const array<match_generator*>& generators) const;
     void                select(const char* needle) const;
     void                sort() const;
 
 private:
+    static unsigned int get_generate_key(const line_state& state, const array<match_generator*>& generators);
+    void                merge(const matches_impl& src) const;
     matches_impl&       m_matches;
 };
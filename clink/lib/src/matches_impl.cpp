@@ -8,12 +8,15 @@
 #include <core/base.h>
 #include <core/str.h>
 #include <core/str_compare.h>
+#include <core/str_hash.h>
 #include <core/str_tokeniser.h>
 #include <core/match_wild.h>
 #include <core/path.h>
+#include <core/perf_counters.h>
 #include <sys/stat.h>
 #include <readline/readline.h> // for rl_last_path_separator
 
+#include <algorithm>
 #include <assert.h>
 
 extern "C" {
@@ -147,6 +150,12 @@ bool match_builder::add_match(const char* match, match_type type)
     return add_match(desc);
 }
 
+//------------------------------------------------------------------------------
+void match_builder::reserve(unsigned int count, unsigned int store_size)
+{
+    return ((matches_impl&)m_matches).reserve(count, store_size);
+}
+
 //------------------------------------------------------------------------------
 bool match_builder::add_match(const match_desc& desc)
 {
@@ -171,6 +180,12 @@ void match_builder::set_suppress_quoting(int suppress)
     return ((matches_impl&)m_matches).set_suppress_quoting(suppress);
 }
 
+//------------------------------------------------------------------------------
+void match_builder::set_matches_are_sorted(bool sorted)
+{
+    return ((matches_impl&)m_matches).set_matches_are_sorted(sorted);
+}
+
 //------------------------------------------------------------------------------
 void match_builder::set_matches_are_files(bool files)
 {
@@ -185,6 +200,7 @@ matches_iter::matches_iter(const matches& matches, const char* pattern)
 , m_expanded_pattern(pattern && rl_complete_with_tilde_expansion ? tilde_expand(pattern) : nullptr)
 , m_pattern((m_expanded_pattern ? m_expanded_pattern : pattern),
             (m_expanded_pattern ? m_expanded_pattern : pattern) ? -1 : 0)
+, m_matcher(m_pattern)
 , m_has_pattern(pattern != nullptr)
 , m_filename_completion_desired(matches.is_filename_completion_desired())
 , m_filename_display_desired(matches.is_filename_display_desired())
@@ -217,7 +233,7 @@ bool matches_iter::next()
             int match_len = int(strlen(match));
             while (match_len && path::is_separator((unsigned char)match[match_len - 1]))
                 match_len--;
-            if (path::match_wild(m_pattern, str_iter(match, match_len), !is_pathish(get_match_type())))
+            if (m_matcher.match(str_iter(match, match_len), !is_pathish(get_match_type())))
                 goto found;
         }
     }
@@ -270,11 +286,26 @@ shadow_bool matches_iter::is_filename_display_desired() const
 
 
 //------------------------------------------------------------------------------
-matches_impl::store_impl::store_impl(unsigned int size)
+// Process-wide match store accounting.  Unlike the perf counters these track
+// live bytes, so the high-water mark reflects peak footprint rather than
+// cumulative turnover.  Unsynchronised, same as the counters; the values are
+// statistics, not exact counts.
+static size_t s_match_store_used = 0;
+static size_t s_match_store_peak = 0;
+
+//------------------------------------------------------------------------------
+void get_match_store_usage(size_t& used, size_t& peak)
 {
-    m_size = max((unsigned int)4096, size);
-    m_ptr = nullptr;
-    new_page();
+    used = s_match_store_used;
+    peak = s_match_store_peak;
+}
+
+//------------------------------------------------------------------------------
+matches_impl::store_impl::store_impl(unsigned int page_size)
+: m_allocator(nullptr, 0)
+{
+    m_page_size = clamp(page_size, (unsigned int)4096, (unsigned int)0x10000);
+    m_chain = nullptr;
 }
 
 //------------------------------------------------------------------------------
@@ -287,37 +318,38 @@ matches_impl::store_impl::~store_impl()
 void matches_impl::store_impl::reset()
 {
     free_chain(true/*keep_one*/);
-    m_back = m_size;
-    m_front = sizeof(m_ptr);
+    if (m_chain != nullptr)
+        m_allocator.reset(m_chain + 1, m_chain->size);
 }
 
 //------------------------------------------------------------------------------
-const char* matches_impl::store_impl::store_front(const char* str)
+// Ensures at least size bytes can be stored without starting a new page, so
+// a bulk add with a known total pays for one slab allocation up front instead
+// of growing page by page.
+void matches_impl::store_impl::reserve(unsigned int size)
 {
-    unsigned int size = get_size(str);
-    unsigned int next = m_front + size;
-    if (next > m_back && !new_page())
-        return nullptr;
-
-    str_base(m_ptr + m_front, size).copy(str);
-
-    const char* ret = m_ptr + m_front;
-    m_front = next;
-    return ret;
+    if (size && unsigned(m_allocator.remaining()) < size)
+        new_page(size);
 }
 
 //------------------------------------------------------------------------------
-const char* matches_impl::store_impl::store_back(const char* str)
+const char* matches_impl::store_impl::store_front(const char* str)
 {
     unsigned int size = get_size(str);
-    unsigned int next = m_back - size;
-    if (next < m_front && !new_page())
-        return nullptr;
 
-    m_back = next;
-    str_base(m_ptr + m_back, size).copy(str);
+    char* ptr = (char*)m_allocator.alloc(size);
+    if (ptr == nullptr)
+    {
+        if (!new_page(size))
+            return nullptr;
+
+        ptr = (char*)m_allocator.alloc(size);
+        if (ptr == nullptr)
+            return nullptr;
+    }
 
-    return m_ptr + m_back;
+    str_base(ptr, size).copy(str);
+    return ptr;
 }
 
 //------------------------------------------------------------------------------
@@ -330,50 +362,63 @@ unsigned int matches_impl::store_impl::get_size(const char* str) const
 }
 
 //------------------------------------------------------------------------------
-bool matches_impl::store_impl::new_page()
+bool matches_impl::store_impl::new_page(unsigned int min_size)
 {
-    char* temp = (char*)malloc(m_size);
+    // Strings longer than a page get a dedicated right-sized slab.
+    unsigned int payload = max(m_page_size - (unsigned int)sizeof(page), min_size);
+
+    page* temp = (page*)malloc(sizeof(page) + payload);
     if (temp == nullptr)
         return false;
 
-    *reinterpret_cast<char**>(temp) = m_ptr;
-    m_front = sizeof(m_ptr);
-    m_back = m_size;
-    m_ptr = temp;
+    perf_counters::add(perf_counters::match_pages);
+    perf_counters::add(perf_counters::match_page_bytes, sizeof(page) + payload);
+
+    s_match_store_used += sizeof(page) + payload;
+    if (s_match_store_used > s_match_store_peak)
+        s_match_store_peak = s_match_store_used;
+
+    temp->next = m_chain;
+    temp->size = payload;
+    m_chain = temp;
+
+    m_allocator.reset(temp + 1, payload);
     return true;
 }
 
 //------------------------------------------------------------------------------
 void matches_impl::store_impl::free_chain(bool keep_one)
 {
-    char* ptr = m_ptr;
+    page* ptr = m_chain;
 
     if (!keep_one)
     {
-        m_ptr = nullptr;
-        m_front = sizeof(m_ptr);
-        m_back = m_size;
+        m_chain = nullptr;
+        m_allocator.reset(nullptr, 0);
     }
 
     while (ptr)
     {
-        char* tmp = ptr;
-        ptr = *reinterpret_cast<char**>(ptr);
+        page* tmp = ptr;
+        ptr = ptr->next;
         if (keep_one)
         {
             keep_one = false;
-            *reinterpret_cast<char**>(tmp) = nullptr;
+            tmp->next = nullptr;
         }
         else
+        {
+            s_match_store_used -= sizeof(page) + tmp->size;
             free(tmp);
+        }
     }
 }
 
 
 
 //------------------------------------------------------------------------------
-matches_impl::matches_impl(generators* generators, unsigned int store_size)
-: m_store(min(store_size, 0x10000u))
+matches_impl::matches_impl(generators* generators, unsigned int store_page_size)
+: m_store(store_page_size)
 , m_generators(generators)
 , m_filename_completion_desired(false)
 , m_filename_display_desired(false)
@@ -495,6 +540,12 @@ int matches_impl::get_word_break_position() const
     return m_word_break_position;
 }
 
+//------------------------------------------------------------------------------
+bool matches_impl::is_partial() const
+{
+    return m_partial;
+}
+
 //------------------------------------------------------------------------------
 bool matches_impl::match_display_filter(char** matches, match_display_filter_entry*** filtered_matches, bool popup) const
 {
@@ -520,8 +571,15 @@ void matches_impl::reset()
 {
     m_store.reset();
     m_infos.clear();
+    m_select_bits.clear();
     m_coalesced = false;
     m_count = 0;
+    m_generate_key = 0;
+    m_has_generate_key = false;
+    m_sorted_mark = 0;
+    m_sorted_runs = 0;
+    m_sorted_poisoned = false;
+    m_partial = false;
     m_append_character = '\0';
     m_regen_blocked = false;
     m_suppress_append = false;
@@ -561,6 +619,41 @@ void matches_impl::set_regen_blocked()
     m_regen_blocked = true;
 }
 
+//------------------------------------------------------------------------------
+void matches_impl::set_matches_are_sorted(bool sorted)
+{
+    if (!sorted)
+    {
+        m_sorted_poisoned = true;
+        return;
+    }
+
+    if (m_infos.size() > m_sorted_mark)
+    {
+        if (m_sorted_runs < 0xff)
+            ++m_sorted_runs;
+        m_sorted_mark = (unsigned int)m_infos.size();
+    }
+}
+
+//------------------------------------------------------------------------------
+// True when every match arrived under a sorted claim and there are few enough
+// runs that merging them beats a full sort.  dedup() removes matches in place
+// without reordering, so claims survive it.
+bool matches_impl::get_sorted_hint() const
+{
+    static const unsigned char c_max_sorted_runs = 8;
+    return !m_sorted_poisoned &&
+           m_sorted_runs > 0 && m_sorted_runs <= c_max_sorted_runs &&
+           m_sorted_mark == m_infos.size();
+}
+
+//------------------------------------------------------------------------------
+void matches_impl::set_partial()
+{
+    m_partial = true;
+}
+
 //------------------------------------------------------------------------------
 void matches_impl::set_matches_are_files(bool files)
 {
@@ -568,6 +661,13 @@ void matches_impl::set_matches_are_files(bool files)
     m_filename_display_desired.set_explicit(files);
 }
 
+//------------------------------------------------------------------------------
+void matches_impl::reserve(unsigned int count, unsigned int store_size)
+{
+    m_infos.reserve(m_infos.size() + count);
+    m_store.reserve(store_size);
+}
+
 //------------------------------------------------------------------------------
 bool matches_impl::add_match(const match_desc& desc)
 {
@@ -593,6 +693,96 @@ bool matches_impl::add_match(const match_desc& desc)
     return true;
 }
 
+//------------------------------------------------------------------------------
+void matches_impl::clear_select_bits()
+{
+    m_select_bits.assign((m_infos.size() + 31) / 32, 0);
+}
+
+//------------------------------------------------------------------------------
+unsigned int matches_impl::count_select_bits() const
+{
+    unsigned int count = 0;
+    for (unsigned int word : m_select_bits)
+    {
+        word = word - ((word >> 1) & 0x55555555);
+        word = (word & 0x33333333) + ((word >> 2) & 0x33333333);
+        count += (((word + (word >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Removes duplicate matches after all generators have run.  Sorts hashed
+// keys instead of comparing strings pairwise, so duplicate-heavy setups
+// (the file generator overlapping Lua generators) stay O(n log n); strings
+// are only compared within equal-hash runs.  The first occurrence wins,
+// preserving generator priority order.  Duplicate strings stay behind in
+// the store; it's reset wholesale on the next generate.
+void matches_impl::dedup()
+{
+    const unsigned int n = (unsigned int)m_infos.size();
+    if (n < 2)
+        return;
+
+    struct hash_key
+    {
+        unsigned long long  hash;
+        unsigned int        index;
+    };
+
+    // Scratch space lives inline for typical completion sizes; only very
+    // large match sets spill it to the heap.
+    small_vector<hash_key, 128> key_storage;
+    small_vector<bool, 128> duplicate_storage;
+    if (!key_storage.resize(n) || !duplicate_storage.resize(n))
+        return;
+
+    hash_key* keys = key_storage.front();
+    for (unsigned int i = 0; i < n; ++i)
+        keys[i] = { str_hash64(m_infos[i].match), i };
+
+    std::sort(keys, keys + n, [] (const hash_key& l, const hash_key& r) {
+        return (l.hash != r.hash) ? (l.hash < r.hash) : (l.index < r.index);
+    });
+
+    bool* duplicate = duplicate_storage.front();
+    bool any = false;
+    for (unsigned int run = 0; run < n;)
+    {
+        unsigned int run_end = run + 1;
+        while (run_end < n && keys[run_end].hash == keys[run].hash)
+            ++run_end;
+
+        // Within an equal-hash run, compare each entry against the earlier
+        // survivors.  Runs are almost always length 1 or all one string.
+        for (unsigned int i = run + 1; i < run_end; ++i)
+            for (unsigned int j = run; j < i; ++j)
+            {
+                if (duplicate[keys[j].index])
+                    continue;
+                if (strcmp(m_infos[keys[i].index].match, m_infos[keys[j].index].match) == 0)
+                {
+                    duplicate[keys[i].index] = true;
+                    any = true;
+                    break;
+                }
+            }
+
+        run = run_end;
+    }
+
+    if (!any)
+        return;
+
+    unsigned int j = 0;
+    for (unsigned int i = 0; i < n; ++i)
+        if (!duplicate[i])
+            m_infos[j++] = m_infos[i];
+    m_infos.resize(j);
+    m_count = (unsigned short)j;
+}
+
 //------------------------------------------------------------------------------
 void matches_impl::coalesce(unsigned int count_hint)
 {
@@ -601,10 +791,12 @@ void matches_impl::coalesce(unsigned int count_hint)
     bool any_pathish = false;
     bool all_pathish = true;
 
+    // The bits are indexed by pre-coalesce positions; the loop only tests
+    // position i after any swap that could land there has already passed it.
     unsigned int j = 0;
     for (int i = 0, n = int(m_infos.size()); i < n && j < count_hint; ++i)
     {
-        if (!infos[i].select)
+        if (!test_select_bit(i))
             continue;
 
         if (is_pathish(infos[i].type))
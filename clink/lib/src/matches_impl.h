@@ -6,6 +6,7 @@
 #include "matches.h"
 
 #include "core/array.h"
+#include "core/linear_allocator.h"
 #include <vector>
 
 //------------------------------------------------------------------------------
@@ -13,17 +14,6 @@ struct match_info
 {
     const char*     match;
     match_type      type;
-    bool            select;
-};
-
-
-
-//------------------------------------------------------------------------------
-class match_store
-{
-protected:
-    char*                   m_ptr;
-    unsigned int            m_size;
 };
 
 
@@ -36,9 +26,9 @@ class matches_impl
     : public matches
 {
 public:
-    typedef fixed_array<match_generator*, 32> generators;
+    typedef small_vector<match_generator*, 32> generators;
 
-                            matches_impl(generators* generators=nullptr, unsigned int store_size=0x10000);
+                            matches_impl(generators* generators=nullptr, unsigned int store_page_size=0x1000);
     matches_iter            get_iter() const;
     matches_iter            get_iter(const char* pattern) const;
 
@@ -49,6 +39,7 @@ public:
     virtual char            get_append_character() const override;
     virtual int             get_suppress_quoting() const override;
     virtual int             get_word_break_position() const override;
+    virtual bool            is_partial() const override;
     virtual bool            match_display_filter(char** matches, match_display_filter_entry*** filtered_matches, bool popup) const override;
 
     void                    set_word_break_position(int position);
@@ -67,31 +58,59 @@ private:
     void                    set_append_character(char append);
     void                    set_suppress_append(bool suppress);
     void                    set_suppress_quoting(int suppress);
+    void                    set_matches_are_sorted(bool sorted);
+    bool                    get_sorted_hint() const;
+    void                    set_partial();
     void                    set_matches_are_files(bool files);
+    void                    reserve(unsigned int count, unsigned int store_size);
     bool                    add_match(const match_desc& desc);
     unsigned int            get_info_count() const;
     const match_info*       get_infos() const;
     match_info*             get_infos();
+    void                    clear_select_bits();
+    unsigned int*           get_select_bits() { return m_select_bits.data(); }
+    bool                    test_select_bit(unsigned int index) const { return !!(m_select_bits[index >> 5] & (1u << (index & 31))); }
+    unsigned int            count_select_bits() const;
     void                    reset();
+    void                    dedup();
     void                    coalesce(unsigned int count_hint);
 
 private:
+    // Chunk-list store; grows on demand in page-sized slabs, so there is
+    // neither an up-front allocation for tiny completions nor a hard cap on
+    // how much match text can be stored.
+    //
+    // Matches in deep trees share long directory prefixes, and storing each
+    // unique prefix once with (prefix, leaf) pairs in match_info would shrink
+    // the store by the sharing factor.  Deliberately not done: get_match()
+    // hands the text out as a raw nul-terminated pointer which flows into
+    // Readline's char** match arrays and display code, so every match must
+    // exist as a full contiguous string for the completion's lifetime anyway;
+    // a split representation would just rebuild those strings into a second
+    // buffer.  Per-match cost is one strcpy into a warm slab, and the sort
+    // already runs on separately-built keys rather than the stored text.
     class store_impl
-        : public match_store
     {
     public:
-                            store_impl(unsigned int size);
+                            store_impl(unsigned int page_size);
                             ~store_impl();
         void                reset();
+        void                reserve(unsigned int size);
         const char*         store_front(const char* str);
-        const char*         store_back(const char* str);
 
     private:
+        struct page
+        {
+            page*           next;
+            unsigned int    size;   // Payload size, excluding this header.
+        };
+
         unsigned int        get_size(const char* str) const;
-        bool                new_page();
+        bool                new_page(unsigned int min_size);
         void                free_chain(bool keep_one);
-        unsigned int        m_front;
-        unsigned int        m_back;
+        linear_allocator    m_allocator;
+        page*               m_chain;
+        unsigned int        m_page_size;
     };
 
     typedef std::vector<match_info> infos;
@@ -99,8 +118,27 @@ private:
     store_impl              m_store;
     generators*             m_generators;
     infos                   m_infos;
+    // Selection lives outside match_info as a packed bitset, so selecting
+    // dirties one bit per candidate instead of a bool in every 16-byte info
+    // and the selected count popcounts word-at-a-time.  Sized to cover
+    // m_infos by clear_select_bits(); indexed in info order.
+    std::vector<unsigned int> m_select_bits;
     unsigned short          m_count = 0;
     bool                    m_coalesced = false;
+    // Memoisation key for the last generate() (word texts, cwd, generator
+    // set); managed by match_pipeline, cleared by reset().
+    unsigned int            m_generate_key = 0;
+    bool                    m_has_generate_key = false;
+    // Sortedness claims (see match_builder::set_matches_are_sorted):  each
+    // claim marks the matches added since the previous claim as one sorted
+    // run.  m_sorted_mark is the info count as of the last claim, so matches
+    // past it are unclaimed and disqualify the hint.
+    unsigned int            m_sorted_mark = 0;
+    unsigned char           m_sorted_runs = 0;
+    bool                    m_sorted_poisoned = false;
+    // Generation overran its time budget and was cut off (see
+    // match.generate_timeout); the matches may be missing entries.
+    bool                    m_partial = false;
     char                    m_append_character = '\0';
     bool                    m_suppress_append = false;
     bool                    m_regen_blocked = false;
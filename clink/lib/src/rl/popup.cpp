@@ -55,6 +55,7 @@ static bool s_display_filter;
 static bool s_descriptions;
 static bool s_autosize;
 static wstr<32> s_find;
+static std::vector<int> s_find_anchors; // first matching row per find prefix.
 static bool s_reset_find_on_next_char = false;
 
 //------------------------------------------------------------------------------
@@ -64,10 +65,20 @@ enum class find_mode { next, previous, incremental };
 static bool find_in_list(HWND hwnd, find_mode mode)
 {
     int dir = (find_mode::previous == mode) ? -1 : 1;
-    int row = (find_mode::incremental == mode) ? 0 : max(0, ListView_GetCurSel(hwnd)) + dir;
+    int row;
 
-    if (find_mode::incremental != mode)
+    if (find_mode::incremental == mode)
+    {
+        // A row that matches the find string also matches every prefix of it,
+        // so the first hit can't be above the first hit for the previous
+        // prefix; resume the scan there instead of rescanning from the top.
+        row = s_find_anchors.empty() ? 0 : s_find_anchors.back();
+    }
+    else
+    {
+        row = max(0, ListView_GetCurSel(hwnd)) + dir;
         s_reset_find_on_next_char = true;
+    }
 
     str<> find;
     find = s_find.c_str();
@@ -76,6 +87,8 @@ static bool find_in_list(HWND hwnd, find_mode mode)
     {
         if (StrStrI(s_items[row] + s_past_flag, find.c_str()))
         {
+            if (find_mode::incremental == mode && s_find_anchors.size() < s_find.length())
+                s_find_anchors.push_back(row);
             ListView_EnsureVisible(hwnd, row, false);
             ListView_SetCurSel(hwnd, row);
             return true;
@@ -90,6 +103,7 @@ static bool find_in_list(HWND hwnd, find_mode mode)
 static void reset_find()
 {
     s_find.clear();
+    s_find_anchors.clear();
     s_reset_find_on_next_char = false;
 }
 
@@ -179,7 +193,11 @@ static LRESULT CALLBACK SubclassListViewWndProc(HWND hwnd, UINT uMsg, WPARAM wPa
         case VK_BACK:
             // lParam is repeat count.
             for (lParam = (WORD)lParam; s_find.length() > 0 && lParam--; )
+            {
                 s_find.truncate(s_find.length() - 1);
+                if (!s_find_anchors.empty())
+                    s_find_anchors.pop_back();
+            }
             if (s_find.length())
                 find_in_list(hwnd, find_mode::incremental);
             else
@@ -520,13 +538,16 @@ static HWND create_popup_window(HWND hwndConsole, LPCSTR title, const CONSOLE_SC
     }
     rcPopup.bottom = rcPopup.top + 200;
 
-    // Create the window.
+    // Create the window.  WS_EX_COMPOSITED paints the popup and the list view
+    // into one off-screen surface and blits the result, so showing the window
+    // and moving the selection don't flicker (especially noticeable over RDP,
+    // where each separate paint is a round trip).
     wstr<> wtitle;
     wtitle = title;
-    HWND hwndPopup = CreateWindowW(popup_class_name, wtitle.c_str(),
-                                   WS_POPUP | WS_THICKFRAME | WS_CAPTION | WS_SYSMENU,
-                                   rcPopup.left, rcPopup.top, rcPopup.right - rcPopup.left, rcPopup.bottom - rcPopup.top,
-                                   hwndConsole, NULL, s_hinst, NULL);
+    HWND hwndPopup = CreateWindowExW(WS_EX_COMPOSITED, popup_class_name, wtitle.c_str(),
+                                     WS_POPUP | WS_THICKFRAME | WS_CAPTION | WS_SYSMENU,
+                                     rcPopup.left, rcPopup.top, rcPopup.right - rcPopup.left, rcPopup.bottom - rcPopup.top,
+                                     hwndConsole, NULL, s_hinst, NULL);
     if (!hwndPopup)
         return NULL;
 
@@ -677,22 +698,11 @@ popup_list_result do_popup_list(
         num_items--;
     }
 
-    if (s_display_filter)
-    {
-        for (int i = num_items; i--;)
-        {
-            const char* ptr = items[i];
-            size_t len_match = strlen(ptr);
-            ptr += len_match + 1;
-            size_t len_display = strlen(ptr);
-            ptr += len_display + 1;
-            if (*ptr)
-            {
-                s_descriptions = true;
-                break;
-            }
-        }
-    }
+    // The list view is owner-data virtualized (LVS_OWNERDATA), so only the
+    // visible rows are ever materialized and opening the popup must not walk
+    // all of the items.  The caller already scanned for descriptions while
+    // building the list, so trust the flag instead of rescanning here.
+    s_descriptions = s_display_filter;
 
     // Can't show an empty popup list.
     if (num_items <= 0)
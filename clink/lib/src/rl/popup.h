@@ -25,5 +25,5 @@ popup_list_result do_popup_list(
     bool auto_complete,
     int& current,
     str_base& out,
-    bool display_filter=false);
+    bool display_filter=false); // true implies at least one item has a description.
 
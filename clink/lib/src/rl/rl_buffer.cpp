@@ -36,6 +36,9 @@ void rl_buffer::reset()
 void rl_buffer::begin_line()
 {
     m_need_draw = true;
+
+    for (word_cache& cache : m_word_cache)
+        cache.valid = false;
 }
 
 //------------------------------------------------------------------------------
@@ -87,6 +90,9 @@ void rl_buffer::draw()
 {
     if (m_need_draw)
     {
+        // set_need_draw() can be a face-only change (word classification),
+        // which rl_redisplay's no-change snapshot can't observe.
+        rl_invalidate_display();
         rl_redisplay();
         m_need_draw = false;
     }
@@ -164,13 +170,47 @@ void rl_buffer::find_command_bounds(std::vector<command>& commands, bool stop_at
 
 //------------------------------------------------------------------------------
 unsigned int rl_buffer::collect_words(std::vector<word>& words, collect_words_mode mode) const
+{
+    // Word collection is pure over (line, cursor, mode) and several consumers
+    // ask for the same snapshot during one keystroke (input dispatch, word
+    // classification, match generation).  Keep the last result per mode and
+    // revalidate it against a copy of the line; re-tokenising also re-queries
+    // doskey aliases, which is a console call per command.  Readline edits
+    // rl_line_buffer directly rather than through insert()/remove(), so the
+    // snapshot comparison is the only reliable change detection.
+    word_cache& cache = m_word_cache[unsigned(mode)];
+    const char* line_buffer = get_buffer();
+    const unsigned int line_length = get_length();
+    const unsigned int line_cursor = get_cursor();
+    if (cache.valid &&
+        (cache.cursor == line_cursor || mode == collect_words_mode::whole_command) &&
+        cache.line.length() == line_length &&
+        memcmp(cache.line.c_str(), line_buffer, line_length) == 0)
+    {
+        words = cache.words;
+        return cache.command_offset;
+    }
+
+    const unsigned int command_offset = collect_words_impl(words, mode);
+
+    cache.valid = true;
+    cache.cursor = line_cursor;
+    cache.command_offset = command_offset;
+    cache.line.clear();
+    cache.line.concat(line_buffer, line_length);
+    cache.words = words;
+    return command_offset;
+}
+
+//------------------------------------------------------------------------------
+unsigned int rl_buffer::collect_words_impl(std::vector<word>& words, collect_words_mode mode) const
 {
     words.clear();
 
     const char* line_buffer = get_buffer();
     unsigned int line_cursor = get_cursor();
 
-    std::vector<command> commands;
+    std::vector<command>& commands = m_commands;
     bool stop_at_cursor = (mode == collect_words_mode::stop_at_cursor ||
                            mode == collect_words_mode::display_filter);
     find_command_bounds(commands, stop_at_cursor);
@@ -208,15 +248,24 @@ unsigned int rl_buffer::collect_words(std::vector<word>& words, collect_words_mo
         str_iter token_iter(line_buffer + command.offset + doskey_len, command.length - doskey_len);
         str_tokeniser tokens(token_iter, m_word_delims);
         tokens.add_quote_pair(m_quote_pair);
+        str_token_slice slices[32];
+        unsigned int slice_count = 0;
+        unsigned int slice_index = 0;
         while (1)
         {
-            int length = 0;
-            const char *start = nullptr;
-            str_token token = tokens.next(start, length);
-            if (!token)
-                break;
+            // Tokenise in batches of zero-copy slices rather than one call
+            // per word; long lines produce many words.
+            if (slice_index == slice_count)
+            {
+                slice_count = tokens.tokenise(slices, sizeof_array(slices));
+                slice_index = 0;
+                if (!slice_count)
+                    break;
+            }
 
-            unsigned int offset = unsigned(start - line_buffer);
+            const str_token_slice& slice = slices[slice_index++];
+            unsigned int length = slice.length;
+            unsigned int offset = slice.offset + command.offset + doskey_len;
 
             // Mercy.  We need to know later on if a flag word ends with = but
             // that's never part of a word because it's a word delimiter.  We
@@ -242,7 +291,7 @@ unsigned int rl_buffer::collect_words(std::vector<word>& words, collect_words_mo
             }
 
             // Add the word.
-            words.push_back({offset, unsigned(length), first, false/*is_alias*/, 0, token.delim});
+            words.push_back({offset, length, first, false/*is_alias*/, 0, slice.delim});
 
             first = false;
         }
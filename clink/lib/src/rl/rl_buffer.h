@@ -4,6 +4,9 @@
 #pragma once
 
 #include "line_buffer.h"
+#include "line_state.h"
+
+#include <core/str.h>
 
 //------------------------------------------------------------------------------
 class rl_buffer
@@ -38,6 +41,7 @@ public:
     void                    set_need_draw() { m_need_draw = true; }
 
 private:
+    unsigned int            collect_words_impl(std::vector<word>& words, collect_words_mode mode) const;
     void                    find_command_bounds(std::vector<command>& commands, bool stop_at_cursor) const;
     char                    get_closing_quote() const;
 
@@ -47,6 +51,23 @@ private:
     const char* const       m_command_delims;
     const char* const       m_word_delims;
     const char* const       m_quote_pair;
+
+    // Scratch space for collect_words(); kept across calls so its capacity
+    // gets reused instead of reallocated on every keystroke.
+    mutable std::vector<command> m_commands;
+
+    // Last collect_words() result per mode, revalidated against a snapshot
+    // of the line.  Readline edits rl_line_buffer directly (not through this
+    // class), so the snapshot comparison is what detects changes.
+    struct word_cache
+    {
+        std::vector<word>   words;
+        str_moveable        line;
+        unsigned int        cursor = 0;
+        unsigned int        command_offset = 0;
+        bool                valid = false;
+    };
+    mutable word_cache      m_word_cache[3];
 };
 
 //------------------------------------------------------------------------------
@@ -364,28 +364,28 @@ int clink_insert_dot_dot(int count, int invoking_key)
 //------------------------------------------------------------------------------
 int clink_scroll_line_up(int count, int invoking_key)
 {
-    ScrollConsoleRelative(GetStdHandle(STD_OUTPUT_HANDLE), -1, SCR_BYLINE);
+    ScrollConsoleRelative(GetStdHandle(STD_OUTPUT_HANDLE), -1, SCR_BYLINE, true/*coalesce*/);
     return 0;
 }
 
 //------------------------------------------------------------------------------
 int clink_scroll_line_down(int count, int invoking_key)
 {
-    ScrollConsoleRelative(GetStdHandle(STD_OUTPUT_HANDLE), 1, SCR_BYLINE);
+    ScrollConsoleRelative(GetStdHandle(STD_OUTPUT_HANDLE), 1, SCR_BYLINE, true/*coalesce*/);
     return 0;
 }
 
 //------------------------------------------------------------------------------
 int clink_scroll_page_up(int count, int invoking_key)
 {
-    ScrollConsoleRelative(GetStdHandle(STD_OUTPUT_HANDLE), -1, SCR_BYPAGE);
+    ScrollConsoleRelative(GetStdHandle(STD_OUTPUT_HANDLE), -1, SCR_BYPAGE, true/*coalesce*/);
     return 0;
 }
 
 //------------------------------------------------------------------------------
 int clink_scroll_page_down(int count, int invoking_key)
 {
-    ScrollConsoleRelative(GetStdHandle(STD_OUTPUT_HANDLE), 1, SCR_BYPAGE);
+    ScrollConsoleRelative(GetStdHandle(STD_OUTPUT_HANDLE), 1, SCR_BYPAGE, true/*coalesce*/);
     return 0;
 }
 
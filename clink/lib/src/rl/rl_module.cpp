@@ -8,10 +8,12 @@
 #include "line_state.h"
 #include "matches.h"
 #include "match_pipeline.h"
+#include "usage_index.h"
 #include "word_classifier.h"
 #include "popup.h"
 
 #include <core/base.h>
+#include <core/linear_allocator.h>
 #include <core/os.h>
 #include <core/path.h>
 #include <core/str_hash.h>
@@ -70,6 +72,7 @@ extern void         (*rl_fflush_function)(FILE*);
 extern char*        _rl_comment_begin;
 extern int          _rl_convert_meta_chars_to_ascii;
 extern int          _rl_output_meta_chars;
+extern int          _rl_final_display_rows;
 #if defined(PLATFORM_WINDOWS)
 extern int          _rl_vis_botlin;
 extern int          _rl_last_c_pos;
@@ -80,6 +83,7 @@ extern int          _rl_last_v_pos;
 extern bool is_conemu();
 extern void host_add_history(int rl_history_index, const char* line);
 extern void host_remove_history(int rl_history_index, const char* line);
+extern int host_page_older_history();
 extern void sort_match_list(char** matches, int len);
 extern int macro_hook_func(const char* macro);
 extern void update_matches();
@@ -198,6 +202,15 @@ static setting_color g_color_unexpected(
     "values.",
     "default");
 
+static setting_str g_transient_prompt(
+    "prompt.transient",
+    "Replacement prompt for accepted lines",
+    "When set, the prompt of a line that has just been accepted is collapsed to\n"
+    "this string (ANSI escape codes are allowed) with a single small write, and\n"
+    "the next prompt renders fresh.  This cuts scrollback clutter and the bytes\n"
+    "repainted per command.  Leave empty to keep full prompts in scrollback.",
+    "");
+
 static setting_bool g_match_wild(
     "match.wild",
     "menu-complete matches ? and * wildcards",
@@ -672,6 +685,12 @@ static char** alternative_matches(const char* text, int start, int end)
 
     rl_completion_matches_include_type = 1;
 
+    // The pipeline already deduplicated the matches (match_pipeline::generate),
+    // so Readline can skip the sort-and-dedupe postprocess pass and only sort
+    // once a consumer actually needs the list in order -- e.g. after the user
+    // confirms a large display instead of narrowing further.
+    rl_completion_matches_deduped = 1;
+
 #ifdef DEBUG
     const int debug_matches = dbg_get_env_int("DEBUG_MATCHES");
 #endif
@@ -858,7 +877,7 @@ struct match_hasher
 {
     size_t operator()(const char* match) const
     {
-        return str_hash(match);
+        return size_t(str_hash64(match));
     }
 };
 
@@ -1063,9 +1082,20 @@ int clink_popup_history(int count, int invoking_key)
     int orig_pos = where_history();
     int search_len = rl_point;
 
-    // Copy the history list (just a shallow copy of the line pointers).
-    char** history = (char**)malloc(sizeof(*history) * history_length);
-    int* indices = (int*)malloc(sizeof(*indices) * history_length);
+    // Copy the history list (just a shallow copy of the line pointers).  The
+    // copies live on the line arena when it has room; it gets rewound when
+    // the line edit ends, so this costs two pointer bumps instead of a heap
+    // round trip per popup.
+    extern linear_allocator* get_line_arena();
+    linear_allocator* arena = get_line_arena();
+    char** history = arena ? arena->calloc<char*>(history_length) : nullptr;
+    int* indices = arena ? arena->calloc<int>(history_length) : nullptr;
+    const bool arena_allocated = (history && indices);
+    if (!arena_allocated)
+    {
+        history = (char**)malloc(sizeof(*history) * history_length);
+        indices = (int*)malloc(sizeof(*indices) * history_length);
+    }
     int total = 0;
     for (int i = 0; i < history_length; i++)
     {
@@ -1080,8 +1110,11 @@ int clink_popup_history(int count, int invoking_key)
     if (!total)
     {
         rl_ding();
-        free(history);
-        free(indices);
+        if (!arena_allocated)
+        {
+            free(history);
+            free(indices);
+        }
         return 0;
     }
     if (current < 0)
@@ -1130,8 +1163,11 @@ int clink_popup_history(int count, int invoking_key)
         break;
     }
 
-    free(history);
-    free(indices);
+    if (!arena_allocated)
+    {
+        free(history);
+        free(indices);
+    }
 
     return 0;
 }
@@ -1252,6 +1288,15 @@ static void terminal_fflush_thunk(FILE* stream)
         fflush(stream);
 }
 
+//------------------------------------------------------------------------------
+// Called by Readline whenever a chosen match is inserted into the line, so
+// frequently used completions can be ranked first (see usage_index).
+static void record_match_usage(const char* match)
+{
+    if (usage_index::is_active())
+        usage_index::record(match);
+}
+
 //------------------------------------------------------------------------------
 typedef const char* two_strings[2];
 static void bind_keyseq_list(const two_strings* list, Keymap map)
@@ -1322,6 +1367,7 @@ rl_module::rl_module(const char* shell_name, terminal_in* input)
     rl_puts_face_func = puts_face_func;
     rl_macro_hook_func = macro_hook_func;
     rl_last_func_hook_func = last_func_hook_func;
+    rl_insert_match_func = record_match_usage;
 
     // Add commands.
     static bool s_rl_initialized = false;
@@ -1331,6 +1377,7 @@ rl_module::rl_module(const char* shell_name, terminal_in* input)
 
         rl_add_history_hook = host_add_history;
         rl_remove_history_hook = host_remove_history;
+        rl_page_older_history_hook = host_page_older_history;
         rl_add_funmap_entry("clink-reload", clink_reload);
         rl_add_funmap_entry("clink-reset-line", clink_reset_line);
         rl_add_funmap_entry("clink-show-help", show_rl_help);
@@ -1628,6 +1675,21 @@ void rl_module::on_end_line()
         m_rl_buffer = nullptr;
     }
 
+    // Collapse the just-accepted line's prompt to the transient form.  The
+    // cursor sits on the fresh line below the accepted display, and Readline
+    // recorded how many rows that display spanned, so one small write moves
+    // up, clears, and reprints the line behind a minimal prompt; the next
+    // prompt renders fresh.
+    const char* transient = g_transient_prompt.get();
+    if (transient[0] && !m_eof && _rl_final_display_rows > 0 && g_printer != nullptr)
+    {
+        str<> collapse;
+        collapse.format("\x1b[%dA\r\x1b[J%s%s\n",
+            _rl_final_display_rows, transient, rl_line_buffer);
+        g_printer->print(collapse.c_str(), collapse.length());
+    }
+    _rl_final_display_rows = 0;
+
     s_classifications = nullptr;
     s_input_color = nullptr;
     s_arg_color = nullptr;
@@ -1647,6 +1709,10 @@ void rl_module::on_end_line()
     // This prevents any partial Readline state leaking from one line to the next
     rl_readline_state &= ~RL_MORE_INPUT_STATES;
 
+    // The line is over; release the undo arena in one go instead of having
+    // paid per-node frees (and heap churn) during editing.
+    rl_reset_undo_arena();
+
     g_rl_buffer = nullptr;
     g_pager = nullptr;
     g_printer = nullptr;
@@ -0,0 +1,192 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "usage_index.h"
+
+#include <core/base.h>
+#include <core/path.h>
+#include <core/settings.h>
+#include <core/str.h>
+#include <core/str_hash.h>
+
+//------------------------------------------------------------------------------
+static setting_bool g_rank_usage(
+    "match.rank_usage",
+    "Sort frequently chosen completions first",
+    "Records completions as they are accepted and sorts matches that have often\n"
+    "been chosen before ahead of the rest.  The counts persist in the profile\n"
+    "directory (the 'clink_usage' file) and are shared between sessions.",
+    true);
+
+//------------------------------------------------------------------------------
+// The index is a fixed-size open-addressed hash table living in a file
+// mapping shared by every session using the profile.  Fixed size keeps
+// lookups O(1) and the whole table one page-aligned blob; increments land
+// directly in the mapping and the OS writes dirty pages back, so there is no
+// explicit save step.  Concurrent increments can lose an update, which is
+// acceptable for a popularity signal.  When a probe window fills up the
+// least-used entry in it is evicted, so stale completions age out instead of
+// pinning the table.
+struct index_header
+{
+    unsigned int    magic;
+    unsigned int    capacity;
+};
+
+struct index_entry
+{
+    unsigned long long hash;    // 0 = unused.
+    unsigned int    count;
+    unsigned int    reserved;
+};
+
+static const unsigned int c_magic = 0x31495543;     // "CUI1"
+static const unsigned int c_capacity = 4096;        // Power of two; 64KB of entries.
+static const unsigned int c_probes = 8;
+
+static HANDLE       s_file = INVALID_HANDLE_VALUE;
+static HANDLE       s_mapping = nullptr;
+static index_entry* s_entries = nullptr;
+
+//------------------------------------------------------------------------------
+// Matches carry a trailing path separator when they are directories; hash it
+// away so 'dir\' records and ranks the same however it is presented.
+static unsigned long long hash_match(const char* match)
+{
+    int length = int(strlen(match));
+    if (length > 1 && path::is_separator(match[length - 1]))
+        --length;
+    return str_hash64(match, length);
+}
+
+//------------------------------------------------------------------------------
+void usage_index::open(const char* state_dir)
+{
+    if (s_entries != nullptr)
+        return;
+
+    str<280> file_path(state_dir);
+    path::append(file_path, "clink_usage");
+    wstr<280> wfile_path(file_path.c_str());
+
+    const unsigned int size = sizeof(index_header) + (c_capacity * sizeof(index_entry));
+
+    s_file = CreateFileW(wfile_path.c_str(), GENERIC_READ|GENERIC_WRITE,
+        FILE_SHARE_READ|FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (s_file == INVALID_HANDLE_VALUE)
+        return;
+
+    bool fresh = (GetLastError() != ERROR_ALREADY_EXISTS);
+
+    // The mapping's size extends the file when it was just created.
+    s_mapping = CreateFileMappingW(s_file, nullptr, PAGE_READWRITE, 0, size, nullptr);
+    if (s_mapping == nullptr)
+    {
+        close();
+        return;
+    }
+
+    void* view = MapViewOfFile(s_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (view == nullptr)
+    {
+        close();
+        return;
+    }
+
+    // Initialise a fresh file, and treat an unrecognised header as fresh so a
+    // corrupt or older-format file resets instead of poisoning the ranking.
+    index_header* header = (index_header*)view;
+    if (fresh || header->magic != c_magic || header->capacity != c_capacity)
+    {
+        memset(view, 0, size);
+        header->magic = c_magic;
+        header->capacity = c_capacity;
+    }
+
+    s_entries = (index_entry*)(header + 1);
+}
+
+//------------------------------------------------------------------------------
+void usage_index::close()
+{
+    if (s_entries != nullptr)
+    {
+        UnmapViewOfFile((index_header*)s_entries - 1);
+        s_entries = nullptr;
+    }
+
+    if (s_mapping != nullptr)
+    {
+        CloseHandle(s_mapping);
+        s_mapping = nullptr;
+    }
+
+    if (s_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(s_file);
+        s_file = INVALID_HANDLE_VALUE;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool usage_index::is_active()
+{
+    return (s_entries != nullptr && g_rank_usage.get());
+}
+
+//------------------------------------------------------------------------------
+void usage_index::record(const char* match)
+{
+    if (s_entries == nullptr || match == nullptr || !*match)
+        return;
+
+    unsigned long long hash = hash_match(match);
+
+    index_entry* victim = nullptr;
+    for (unsigned int i = 0; i < c_probes; ++i)
+    {
+        index_entry& entry = s_entries[(hash + i) & (c_capacity - 1)];
+        if (entry.hash == hash)
+        {
+            if (entry.count < ~0u)
+                ++entry.count;
+            return;
+        }
+
+        if (entry.hash == 0)
+        {
+            entry.hash = hash;
+            entry.count = 1;
+            return;
+        }
+
+        if (victim == nullptr || entry.count < victim->count)
+            victim = &entry;
+    }
+
+    // Probe window is full; evict its least-used entry.
+    victim->hash = hash;
+    victim->count = 1;
+}
+
+//------------------------------------------------------------------------------
+unsigned int usage_index::lookup(const char* match)
+{
+    if (s_entries == nullptr || match == nullptr || !*match)
+        return 0;
+
+    unsigned long long hash = hash_match(match);
+
+    for (unsigned int i = 0; i < c_probes; ++i)
+    {
+        const index_entry& entry = s_entries[(hash + i) & (c_capacity - 1)];
+        if (entry.hash == hash)
+            return entry.count;
+        if (entry.hash == 0)
+            break;
+    }
+
+    return 0;
+}
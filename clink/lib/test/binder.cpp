@@ -6,6 +6,8 @@
 #include "binder.h"
 #include "editor_module.h"
 
+#include <core/base.h>
+
 //------------------------------------------------------------------------------
 TEST_CASE("Binder")
 {
@@ -102,6 +104,46 @@ TEST_CASE("Binder")
         }
     }
 
+    SECTION("Root dispatch")
+    {
+        auto& null_module = *(editor_module*)0;
+
+        // More live groups than the binder has root dispatch tables, so
+        // resolving from each in turn exercises table eviction and rebuild.
+        int groups[6];
+        for (int i = 0; i < sizeof_array(groups); ++i)
+        {
+            char name[] = { 'g', char('0' + i), 0 };
+            char chord[] = { char('a' + i), 0 };
+            groups[i] = binder.create_group(name);
+            REQUIRE(groups[i] != -1);
+            REQUIRE(binder.bind(groups[i], chord, null_module, i));
+        }
+
+        for (int pass = 0; pass < 2; ++pass)
+            for (int i = 0; i < sizeof_array(groups); ++i)
+            {
+                bind_resolver resolver(binder);
+                resolver.set_group(groups[i]);
+                resolver.step(char('a' + i));
+
+                auto binding = resolver.next();
+                REQUIRE(binding);
+                REQUIRE(binding.get_id() == i);
+            }
+
+        // Binding invalidates the tables; the fresh key must resolve.
+        REQUIRE(binder.bind(groups[0], "z", null_module, 99));
+
+        bind_resolver resolver(binder);
+        resolver.set_group(groups[0]);
+        resolver.step('z');
+
+        auto binding = resolver.next();
+        REQUIRE(binding);
+        REQUIRE(binding.get_id() == 99);
+    }
+
     SECTION("Invalid chords")
     {
         const char* chords[] = {
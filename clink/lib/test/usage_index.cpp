@@ -0,0 +1,49 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <lib/usage_index.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Usage index")
+{
+    fs_fixture fs;
+
+    usage_index::close();
+    usage_index::open(fs.get_root());
+
+    SECTION("Record and lookup")
+    {
+        REQUIRE(usage_index::lookup("alpha") == 0);
+
+        usage_index::record("alpha");
+        usage_index::record("alpha");
+        usage_index::record("beta");
+
+        REQUIRE(usage_index::lookup("alpha") == 2);
+        REQUIRE(usage_index::lookup("beta") == 1);
+        REQUIRE(usage_index::lookup("gamma") == 0);
+    }
+
+    SECTION("Directory marks are ignored")
+    {
+        usage_index::record("dir\\");
+
+        REQUIRE(usage_index::lookup("dir") == 1);
+        REQUIRE(usage_index::lookup("dir\\") == 1);
+        REQUIRE(usage_index::lookup("dir/") == 1);
+    }
+
+    SECTION("Counts persist across open")
+    {
+        usage_index::record("sticky");
+        usage_index::close();
+        usage_index::open(fs.get_root());
+
+        REQUIRE(usage_index::lookup("sticky") == 1);
+    }
+
+    usage_index::close();
+}
@@ -5,7 +5,18 @@
 
 #include <lib/match_generator.h>
 
+class line_state_lua;
 class lua_state;
+class match_builder_lua;
+
+//------------------------------------------------------------------------------
+// Gives the host a chance to load scripts it deferred at injection before
+// matches get generated from Lua, based on the command word in the line.
+class lua_script_demand_loader
+{
+public:
+    virtual void    on_generate(const line_state& line) = 0;
+};
 
 //------------------------------------------------------------------------------
 class lua_match_generator
@@ -14,10 +25,25 @@ class lua_match_generator
 public:
                     lua_match_generator(lua_state& state);
     virtual         ~lua_match_generator();
+    void            set_demand_loader(lua_script_demand_loader* loader);
 
 private:
     virtual bool    generate(const line_state& line, match_builder& builder) override;
     virtual void    get_word_break_info(const line_state& line, word_break_info& info) const override;
     virtual bool    match_display_filter(char** matches, match_display_filter_entry*** filtered_matches, bool popup) override;
+    virtual bool    is_busy() const override;
+    virtual bool    on_idle() override;
+    virtual void    on_wait() override;
+    void            cancel_coroutine();
     lua_state&      m_state;
+    lua_script_demand_loader* m_demand_loader = nullptr;
+
+    // State for a generate() coroutine that yielded; the line state and
+    // builder the coroutine captured must outlive the generate() call, so
+    // copies are owned here until it completes or gets superseded.
+    int             m_coroutine_ref;
+    line_state*     m_coroutine_line = nullptr;
+    match_builder*  m_coroutine_builder = nullptr;
+    line_state_lua* m_coroutine_line_lua = nullptr;
+    match_builder_lua* m_coroutine_builder_lua = nullptr;
 };
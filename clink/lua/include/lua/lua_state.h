@@ -23,12 +23,14 @@ public:
     void            shutdown();
     bool            do_string(const char* string, int length=-1);
     bool            do_file(const char* path);
+    void            gc_step();
     lua_State*      get_state() const;
 
     static bool     push_named_function(lua_State* L, const char* func_name, str_base* error=nullptr);
 
     static int      pcall(lua_State* L, int nargs, int nresults);
     int             pcall(int nargs, int nresults) { return pcall(m_state, nargs, nresults); }
+    int             resume(lua_State* thread, int nargs);
     const char*     get_string(int index) const;
 
     bool            send_event(const char* event_name, int nargs=0);
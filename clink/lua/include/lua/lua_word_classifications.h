@@ -22,5 +22,7 @@ public:
     void                    classify_word(int word_index_zero_based, char wc);
 
 private:
-    str<16>                 m_classifications;
+    // One class char per word.  Sized to match word_classifications' fixed
+    // capacity (72), so classifying a long pipeline never touches the heap.
+    str<72>                 m_classifications;
 };
@@ -6,6 +6,8 @@
 #include "core/str.h"
 #include "lib/word_classifier.h"
 
+#include <vector>
+
 class lua_state;
 
 //------------------------------------------------------------------------------
@@ -17,5 +19,16 @@ public:
     virtual void    classify(const line_state& line, word_classifications& classifications, const char* already_classified=nullptr) override;
 
 private:
+    // One call classifies one command of the line; its result is cached so a
+    // command whose words are unchanged skips the Lua round-trip entirely.
+    struct cached_command
+    {
+        unsigned int    base;       // Pass-wide index of the command's first word.
+        unsigned int    word_count;
+        std::vector<word_class_info> entries;
+    };
+
     lua_state&      m_state;
+    std::vector<cached_command> m_prev_pass;
+    std::vector<cached_command> m_pass;
 };
@@ -770,7 +770,7 @@ function clink._parse_word_types(line_state, word_classifier)
         end
         if word_info.alias then
             table.insert(parsed_word_types, "d"); --doskey
-        elseif clink.is_cmd_command(first_word) then
+        elseif clink.is_cmd_command(first_word) or clink.ispathcommand(first_word) then
             table.insert(parsed_word_types, "c"); --command
         else
             table.insert(parsed_word_types, "o"); --other
@@ -957,3 +957,457 @@ function clink.arg.register_parser(cmd, parser)
     _argmatchers[cmd] = parser
     return matcher
 end
+
+
+
+--------------------------------------------------------------------------------
+-- Compiled argmatcher cache.
+--
+-- Building a big argmatcher runs thousands of constructor and merge calls
+-- every time its script loads.  When a script's finished parser graph is pure
+-- data (no generator functions, no classifier), the graph can be written out
+-- once and reinstalled directly on later loads, skipping the script entirely.
+-- The host decides which scripts qualify -- the same static scan that powers
+-- lazy script loading identifies scripts whose only observable behaviour is
+-- registering argmatchers for known command words (see host_lua.cpp) -- and
+-- calls clink._load_argmatcher_cache / clink._save_argmatcher_cache around
+-- running them.
+--
+-- All entries live in one file in the profile directory, keyed by the
+-- defining script's path and stamped with its last write time, so editing a
+-- script rebuilds its matchers.  The file is Lua source but is loaded in text
+-- mode with an empty environment, so a corrupt or tampered file can only fail
+-- to load, not act.
+local _matcher_cache
+local _matcher_cache_dirty = false
+
+--------------------------------------------------------------------------------
+local function matcher_cache_path()
+    local profile = os.getenv("=clink.profile")
+    if profile then
+        return profile.."\\clink_argmatchers.cache"
+    end
+end
+
+--------------------------------------------------------------------------------
+local function load_matcher_cache()
+    if _matcher_cache then
+        return _matcher_cache
+    end
+    _matcher_cache = {}
+
+    local file = matcher_cache_path()
+    local f = file and io.open(file, "r")
+    if f then
+        local text = f:read("*a")
+        f:close()
+        local chunk = load(text, "@"..file, "t", {})
+        if chunk then
+            local success, data = pcall(chunk)
+            if success and type(data) == "table" then
+                _matcher_cache = data
+            end
+        end
+    end
+    return _matcher_cache
+end
+
+--------------------------------------------------------------------------------
+-- Copies a matcher into a plain data table containing only the fields the
+-- cache knows how to persist, or returns nil if the matcher isn't expressible
+-- as plain data (functions anywhere, or a field this code doesn't know).
+-- Shared sub-matchers and link cycles are preserved via 'seen'.
+local copy_graph
+local function copy_links(links, seen)
+    local copy = {}
+    for word, linked in pairs(links) do
+        if type(word) ~= "string" or type(linked) ~= "table" then
+            return
+        end
+        copy[word] = copy_graph(linked, seen)
+        if not copy[word] then
+            return
+        end
+    end
+    return copy
+end
+
+local function copy_choice(choice)
+    local t = type(choice)
+    if t == "string" or t == "number" or t == "boolean" then
+        return choice
+    end
+    if t == "table" and getmetatable(choice) == nil and choice.match then
+        local copy = {}
+        for key, value in pairs(choice) do
+            local vt = type(value)
+            if type(key) ~= "string" or
+                    (vt ~= "string" and vt ~= "number" and vt ~= "boolean") then
+                return
+            end
+            copy[key] = value
+        end
+        return copy
+    end
+end
+
+copy_graph = function (matcher, seen)
+    local copy = seen[matcher]
+    if copy then
+        return copy
+    end
+    copy = { _args = {} }
+    seen[matcher] = copy
+
+    for key, value in pairs(matcher) do
+        if key == "_priority" or key == "_loop" then
+            if type(value) ~= "number" then return end
+            copy[key] = value
+        elseif key == "_no_file_generation" or key == "_deprecated" then
+            if type(value) ~= "boolean" then return end
+            copy[key] = value
+        elseif key == "_nextargindex" then -- Transient; not persisted.
+        elseif key == "_flagprefix" then
+            local prefixes = {}
+            for prefix, count in pairs(value) do
+                if type(prefix) ~= "string" or type(count) ~= "number" then
+                    return
+                end
+                prefixes[prefix] = count
+            end
+            copy._flagprefix = prefixes
+        elseif key == "_flags" then
+            copy._flags = copy_graph(value, seen)
+            if not copy._flags then return end
+        elseif key == "_args" then
+            for index, arg in pairs(value) do
+                if type(index) == "number" then
+                    local list = { _links = {} }
+                    for k, v in pairs(arg) do
+                        if k == "_links" then
+                            list._links = copy_links(v, seen)
+                            if not list._links then return end
+                        elseif type(k) == "number" then
+                            list[k] = copy_choice(v)
+                            if list[k] == nil then return end
+                        else
+                            return
+                        end
+                    end
+                    copy._args[index] = list
+                elseif index == "_links" then
+                    -- Vestigial container-level links left by the deprecated
+                    -- set_arguments(); kept so round tripping is lossless.
+                    copy._args._links = copy_links(arg, seen)
+                    if not copy._args._links then return end
+                else
+                    return
+                end
+            end
+        else
+            return -- Unknown field (e.g. _classify_func); not cacheable.
+        end
+    end
+
+    if not copy._flagprefix then
+        copy._flagprefix = {}
+    end
+    return copy
+end
+
+--------------------------------------------------------------------------------
+-- Rebuilds a live matcher from cached plain data; the inverse of copy_graph.
+-- The data is deep copied so later merges into the installed matcher can't
+-- mutate the cache's own tables.
+local function install_graph(data, seen)
+    local matcher = seen[data]
+    if matcher then
+        return matcher
+    end
+    matcher = setmetatable({ _args = {} }, _argmatcher)
+    seen[data] = matcher
+
+    matcher._priority = data._priority
+    matcher._loop = data._loop
+    matcher._no_file_generation = data._no_file_generation
+    matcher._deprecated = data._deprecated
+    matcher._nextargindex = 1
+    matcher._flagprefix = {}
+    for prefix, count in pairs(data._flagprefix or {}) do
+        matcher._flagprefix[prefix] = count
+    end
+    if data._flags then
+        matcher._flags = install_graph(data._flags, seen)
+    end
+    for index, arg in pairs(data._args or {}) do
+        local list = { _links = {} }
+        for k, v in pairs(arg) do
+            if k == "_links" then
+                for word, linked in pairs(v) do
+                    list._links[word] = install_graph(linked, seen)
+                end
+            elseif type(v) == "table" then
+                local choice = {}
+                for ck, cv in pairs(v) do
+                    choice[ck] = cv
+                end
+                list[k] = choice
+            else
+                list[k] = v
+            end
+        end
+        matcher._args[index] = list
+    end
+    return matcher
+end
+
+--------------------------------------------------------------------------------
+-- Writes one script's entry as assignments into the numbered node table 'n'.
+-- Emitting node bodies first and links as patch-up assignments afterwards
+-- handles shared sub-matchers and link cycles without recursion.
+local function write_entry(out, script, entry)
+    local index = {}
+    local nodes = {}
+    local function collect(node)
+        if index[node] then
+            return
+        end
+        table.insert(nodes, node)
+        index[node] = #nodes
+        for key, arg in pairs(node._args or {}) do
+            if key == "_links" then
+                for _, linked in pairs(arg) do
+                    collect(linked)
+                end
+            else
+                for _, linked in pairs(arg._links or {}) do
+                    collect(linked)
+                end
+            end
+        end
+        if node._flags then
+            collect(node._flags)
+        end
+    end
+
+    local commands = {}
+    for command in pairs(entry.matchers) do
+        table.insert(commands, command)
+    end
+    table.sort(commands)
+    for _, command in ipairs(commands) do
+        collect(entry.matchers[command])
+    end
+
+    local function sorted_keys(t)
+        local keys = {}
+        for key in pairs(t) do
+            table.insert(keys, key)
+        end
+        table.sort(keys)
+        return keys
+    end
+
+    local function append_choice(choice)
+        if type(choice) == "table" then
+            table.insert(out, "{")
+            for _, key in ipairs(sorted_keys(choice)) do
+                local value = choice[key]
+                if type(value) == "string" then
+                    value = string.format("%q", value)
+                else
+                    value = tostring(value)
+                end
+                table.insert(out, string.format("[%q]=%s,", key, value))
+            end
+            table.insert(out, "}")
+        elseif type(choice) == "string" then
+            table.insert(out, string.format("%q", choice))
+        else
+            table.insert(out, tostring(choice))
+        end
+    end
+
+    table.insert(out, "n={}\n")
+    for i, node in ipairs(nodes) do
+        table.insert(out, "n["..i.."]={")
+        if node._priority then
+            table.insert(out, "_priority="..tostring(node._priority)..",")
+        end
+        if node._loop then
+            table.insert(out, "_loop="..tostring(node._loop)..",")
+        end
+        if node._no_file_generation then
+            table.insert(out, "_no_file_generation=true,")
+        end
+        if node._deprecated then
+            table.insert(out, "_deprecated=true,")
+        end
+        table.insert(out, "_flagprefix={")
+        for _, prefix in ipairs(sorted_keys(node._flagprefix or {})) do
+            table.insert(out, string.format("[%q]=%d,", prefix, node._flagprefix[prefix]))
+        end
+        table.insert(out, "},_args={")
+        for _, arg in ipairs(node._args or {}) do
+            table.insert(out, "{")
+            for _, choice in ipairs(arg) do
+                append_choice(choice)
+                table.insert(out, ",")
+            end
+            table.insert(out, "_links={}},")
+        end
+        table.insert(out, "}}\n")
+    end
+
+    -- Patch in the links (and flag matchers), which reference other nodes.
+    for i, node in ipairs(nodes) do
+        for ai, arg in ipairs(node._args or {}) do
+            for _, word in ipairs(sorted_keys(arg._links or {})) do
+                table.insert(out, string.format("n[%d]._args[%d]._links[%q]=n[%d]\n",
+                        i, ai, word, index[arg._links[word]]))
+            end
+        end
+        for _, word in ipairs(sorted_keys((node._args or {})._links or {})) do
+            table.insert(out, string.format("n[%d]._args._links[%q]=n[%d]\n",
+                    i, word, index[node._args._links[word]]))
+        end
+        if node._flags then
+            table.insert(out, string.format("n[%d]._flags=n[%d]\n", i, index[node._flags]))
+        end
+    end
+
+    table.insert(out, string.format("c[%q]={filetime=%q,matchers={", script, entry.filetime))
+    for _, command in ipairs(commands) do
+        table.insert(out, string.format("[%q]=n[%d],", command, index[entry.matchers[command]]))
+    end
+    table.insert(out, "}}\n")
+end
+
+--------------------------------------------------------------------------------
+local function flush_matcher_cache()
+    if not _matcher_cache_dirty then
+        return
+    end
+    _matcher_cache_dirty = false
+
+    local file = matcher_cache_path()
+    if not file then
+        return
+    end
+
+    local scripts = {}
+    for script in pairs(_matcher_cache) do
+        table.insert(scripts, script)
+    end
+    table.sort(scripts)
+
+    local out = { "local c={}\nlocal n\n" }
+    for _, script in ipairs(scripts) do
+        write_entry(out, script, _matcher_cache[script])
+    end
+    table.insert(out, "return c\n")
+
+    local f = io.open(file, "w")
+    if f then
+        f:write(table.concat(out))
+        f:close()
+    end
+end
+clink.onbeginedit(flush_matcher_cache)
+
+--------------------------------------------------------------------------------
+-- Installs a script's cached matchers instead of running it.  Returns true on
+-- success; any miss (no entry, script edited since it was saved, a command
+-- the entry doesn't cover, or malformed cache data) returns false and the
+-- host runs the script normally.
+function clink._load_argmatcher_cache(script, commands)
+    if type(script) ~= "string" or type(commands) ~= "table" or #commands == 0 then
+        return false
+    end
+
+    local entry = load_matcher_cache()[clink.lower(script)]
+    if not entry or type(entry.matchers) ~= "table" then
+        return false
+    end
+
+    -- A changed script must rebuild its matchers.
+    if entry.filetime ~= os.getfiletime(script) then
+        return false
+    end
+
+    -- Refuse when the entry doesn't cover every command the script registers,
+    -- or when another script already registered one of them:  running the
+    -- script would merge into the existing matcher, and installing over it
+    -- would not.
+    for _, command in ipairs(commands) do
+        local cmd = clink.lower(command)
+        if not entry.matchers[cmd] or _argmatchers[cmd] then
+            return false
+        end
+    end
+
+    local success, installed = pcall(function ()
+        local seen = {}
+        local result = {}
+        for _, command in ipairs(commands) do
+            local cmd = clink.lower(command)
+            result[cmd] = install_graph(entry.matchers[cmd], seen)
+        end
+        return result
+    end)
+    if not success then
+        return false
+    end
+
+    for cmd, matcher in pairs(installed) do
+        _argmatchers[cmd] = matcher
+    end
+    return true
+end
+
+--------------------------------------------------------------------------------
+-- Captures a script's registered matchers right after the script runs, before
+-- any later script has a chance to merge into them (a merge belongs to the
+-- merging script's own run, not to this entry).  Does nothing quietly when
+-- the graph can't be expressed as plain data, dropping any stale entry so the
+-- cache never outlives the script's current behaviour.
+function clink._save_argmatcher_cache(script, commands)
+    if type(script) ~= "string" or type(commands) ~= "table" or #commands == 0 then
+        return
+    end
+    if not matcher_cache_path() then
+        return
+    end
+
+    local filetime = os.getfiletime(script)
+    if not filetime then
+        return
+    end
+
+    local cache = load_matcher_cache()
+    local key = clink.lower(script)
+
+    local matchers = {}
+    local seen = {}
+    for _, command in ipairs(commands) do
+        local cmd = clink.lower(command)
+        local matcher = _argmatchers[cmd]
+        local graph = matcher and copy_graph(matcher, seen)
+        if not graph then
+            if cache[key] then
+                cache[key] = nil
+                _matcher_cache_dirty = true
+            end
+            return
+        end
+        matchers[cmd] = graph
+    end
+
+    cache[key] = { filetime = filetime, matchers = matchers }
+    _matcher_cache_dirty = true
+end
+
+--------------------------------------------------------------------------------
+-- So tests (and "clink set"-style short-lived hosts) can force a write
+-- without waiting for the next edit prompt.
+clink._flush_argmatcher_cache = flush_matcher_cache
@@ -40,6 +40,31 @@ end
 clink.onbeginedit(generator_onbeginedit)
 
 
+--------------------------------------------------------------------------------
+-- Per-generator statistics, accumulated across the session by the
+-- clink._generate loop below and reported by clink.generatorstats().  Keyed
+-- by where each generator's generate() function is defined, which is the only
+-- stable identity a generator table has.
+local _generator_stats = {}
+
+local function stats_for(generator)
+    local info = debug.getinfo(generator.generate, 'S')
+    local key = info.short_src..":"..info.linedefined
+    local stats = _generator_stats[key]
+    if not stats then
+        stats = {
+            source = key,
+            calls = 0,
+            seconds = 0,
+            worstseconds = 0,
+            matches = 0,
+            storebytes = 0,
+        }
+        _generator_stats[key] = stats
+    end
+    return stats
+end
+
 --------------------------------------------------------------------------------
 local function prepare()
     -- Sort generators by priority if required.
@@ -63,7 +88,21 @@ function clink._generate(line_state, match_builder)
         clink.generator_stopped = nil
 
         for _, generator in ipairs(_generators) do
+            local t1, b1 = clink._generatorsnapshot()
+            local m1 = match_builder:_matchcount()
             local ret = generator:generate(line_state, match_builder)
+            local t2, b2 = clink._generatorsnapshot()
+
+            local stats = stats_for(generator)
+            local elapsed = t2 - t1
+            stats.calls = stats.calls + 1
+            stats.seconds = stats.seconds + elapsed
+            if elapsed > stats.worstseconds then
+                stats.worstseconds = elapsed
+            end
+            stats.matches = stats.matches + (match_builder:_matchcount() - m1)
+            stats.storebytes = stats.storebytes + (b2 - b1)
+
             if ret == true then
                 -- Remember the generator function that stopped.
                 clink.generator_stopped = generator.generate
@@ -143,6 +182,67 @@ function clink.generator(priority)
     return ret
 end
 
+--------------------------------------------------------------------------------
+--- -name:  clink.generatorstats
+--- -ret:   table
+--- -show:  for _, s in ipairs(clink.generatorstats()) do
+--- -show:  &nbsp; print(s.source, s.calls, s.seconds, s.matches)
+--- -show:  end
+--- Returns an array of statistics about the registered match generators,
+--- accumulated since the session started and sorted by total time, slowest
+--- first.  Each entry records where the generator's <code>generate()</code>
+--- function is defined (<code>source</code>), how many times it has run
+--- (<code>calls</code>), the total and worst wall clock time spent in it
+--- (<code>seconds</code>, <code>worstseconds</code>), and how many matches
+--- (<code>matches</code>) and match store bytes (<code>storebytes</code>) it
+--- produced.  Use it to identify which generator makes completion slow.
+function clink.generatorstats()
+    local ret = {}
+    for _, stats in pairs(_generator_stats) do
+        table.insert(ret, {
+            source = stats.source,
+            calls = stats.calls,
+            seconds = stats.seconds,
+            worstseconds = stats.worstseconds,
+            matches = stats.matches,
+            storebytes = stats.storebytes,
+        })
+    end
+
+    table.sort(ret, function(a, b) return a.seconds > b.seconds end)
+    return ret
+end
+
+--------------------------------------------------------------------------------
+-- When the clink.generator_stats setting is enabled, write the accumulated
+-- statistics after each edited line to where 'clink info' run from any
+-- process can read them, like the clink.memory_stats report.
+local function generator_stats_onendedit()
+    if not settings.get("clink.generator_stats") then
+        return
+    end
+
+    local profile = os.getenv("=clink.profile")
+    local id = os.getenv("=clink.id")
+    if not profile or not id then
+        return
+    end
+
+    local file = io.open(profile.."\\clink_generators_"..id, "w")
+    if not file then
+        return
+    end
+
+    file:write("session "..id.."\n")
+    for _, stats in ipairs(clink.generatorstats()) do
+        file:write(string.format("%s calls=%d ms=%.3f worst_ms=%.3f matches=%d store_bytes=%d\n",
+            stats.source, stats.calls, stats.seconds * 1000,
+            stats.worstseconds * 1000, stats.matches, stats.storebytes))
+    end
+    file:close()
+end
+clink.onendedit(generator_stats_onendedit)
+
 --------------------------------------------------------------------------------
 --- -name:  clink.add_match
 --- -arg:   match:string
@@ -6,12 +6,15 @@
 #include "../../app/src/version.h" // Ugh.
 
 #include <core/base.h>
+#include <core/exec_index.h>
 #include <core/log.h>
 #include <core/os.h>
 #include <core/path.h>
+#include <core/perf_counters.h>
 #include <core/str.h>
 #include <core/str_iter.h>
 #include <core/str_transform.h>
+#include <core/timings.h>
 #include <readline/readline.h>
 
 #include <unordered_set>
@@ -77,6 +80,7 @@ extern const char*      rl_readline_name;
 extern int              get_clink_setting(lua_State* state);
 extern int              glob_impl(lua_State* state, bool dirs_only, bool back_compat);
 extern int              lua_execute(lua_State* state);
+extern int              lua_execute_async(lua_State* state);
 
 //------------------------------------------------------------------------------
 int old_glob_dirs(lua_State* state)
@@ -227,6 +231,123 @@ static int to_uppercase(lua_State* state)
     return map_string(state, transform_mode::upper);
 }
 
+//------------------------------------------------------------------------------
+/// -name:  clink.gettimings
+/// -ret:   table
+/// -show:  for _, t in ipairs(clink.gettimings()) do
+/// -show:  &nbsp; print(t.name, t.ms)
+/// -show:  end
+/// Returns a table of <code>{ name:string, ms:number }</code> records with
+/// the most recent duration of each instrumented phase (hooking, loading
+/// scripts, settings, history, ...), for breaking down injection and prompt
+/// latency.  The same measurements are also written to the log file.
+static int get_timings(lua_State* state)
+{
+    lua_createtable(state, timings::get_count(), 0);
+
+    for (unsigned int i = 0; i < timings::get_count(); ++i)
+    {
+        const timings::record* record = timings::get_record(i);
+
+        lua_createtable(state, 0, 2);
+
+        lua_pushliteral(state, "name");
+        lua_pushstring(state, record->name);
+        lua_rawset(state, -3);
+
+        lua_pushliteral(state, "ms");
+        lua_pushnumber(state, record->elapsed_ms);
+        lua_rawset(state, -3);
+
+        lua_rawseti(state, -2, i + 1);
+    }
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+extern void get_match_store_usage(size_t& used, size_t& peak);
+
+//------------------------------------------------------------------------------
+// Undocumented; generator.lua brackets each generator invocation with this to
+// meter it.  Returns a monotonic seconds timestamp and the live match store
+// byte count, so the Lua side can compute per-generator deltas.
+static int generator_snapshot(lua_State* state)
+{
+    static LARGE_INTEGER s_frequency;
+    if (!s_frequency.QuadPart)
+        QueryPerformanceFrequency(&s_frequency);
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    lua_pushnumber(state, lua_Number(now.QuadPart) / lua_Number(s_frequency.QuadPart));
+
+    size_t used, peak;
+    get_match_store_usage(used, peak);
+    lua_pushinteger(state, lua_Integer(used));
+
+    return 2;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  clink.ispathcommand
+/// -arg:   word:string
+/// -ret:   boolean
+/// Returns whether <span class="arg">word</span> names an executable in one
+/// of the <code>%PATH%</code> directories, with or without one of the
+/// <code>%PATHEXT%</code> extensions.  The answer comes from a cached index
+/// that enumerates each PATH directory once and refreshes when a directory's
+/// timestamp changes, so the call is cheap enough for per-keystroke use
+/// (word classification uses it to recognise commands).
+static int is_path_command(lua_State* state)
+{
+    const char* word = luaL_checkstring(state, 1);
+    lua_pushboolean(state, exec_index::lookup(word));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  clink.perfcounters
+/// -ret:   table
+/// -show:  local c = clink.perfcounters()
+/// -show:  print(c.str_reallocs, c.match_pages)
+/// Returns a table mapping allocation counter names to process-wide running
+/// totals (string buffer regrowth, match store pages, scratch arena
+/// overflow), for measuring where keystroke cost goes in production.  The
+/// table is empty when the accounting is compiled out (CLINK_PERF_COUNTERS
+/// in core/base.h).
+static int get_perf_counters(lua_State* state)
+{
+    lua_createtable(state, 0, perf_counters::count);
+
+#if CLINK_PERF_COUNTERS
+    for (int i = 0; i < perf_counters::count; ++i)
+    {
+        const auto c = perf_counters::counter(i);
+        lua_pushstring(state, perf_counters::get_name(c));
+        lua_pushinteger(state, lua_Integer(perf_counters::get(c)));
+        lua_rawset(state, -3);
+    }
+#endif
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  clink.memoryusage
+/// -ret:   table
+/// -show:  local m = clink.memoryusage()
+/// -show:  print(m.lua_heap_bytes, m.history_bytes)
+/// Returns a table describing the session's memory footprint:  the Lua GC
+/// heap (<code>lua_heap_bytes</code>), the Readline history list
+/// (<code>history_entries</code>, <code>history_bytes</code>), and the match
+/// store (<code>match_store_bytes</code> live, and
+/// <code>match_store_peak_bytes</code> high-water mark).  When the
+/// <code>clink.memory_stats</code> setting is enabled the same report is
+/// written to the profile directory after each edited line, where
+/// <code>clink info</code> run from any process can read it.
+// (Implemented in host.cpp.)
+
 
 
 //------------------------------------------------------------------------------
@@ -235,9 +356,11 @@ extern int get_aliases(lua_State* state);
 extern int get_current_dir(lua_State* state);
 extern int get_env(lua_State* state);
 extern int get_env_names(lua_State* state);
+extern int get_memory_usage(lua_State* state); // Implemented in host.cpp.
 extern int get_screen_info(lua_State* state);
 extern int is_dir(lua_State* state);
 extern int clink_print(lua_State* state);
+extern int clink_reload(lua_State* state); // Implemented in host_lua.cpp.
 
 //------------------------------------------------------------------------------
 void clink_lua_initialise(lua_state& lua)
@@ -247,8 +370,15 @@ void clink_lua_initialise(lua_state& lua)
         int         (*method)(lua_State*);
     } methods[] = {
         // APIs in the "clink." namespace.
+        { "_generatorsnapshot",     &generator_snapshot },
+        { "execasync",              &lua_execute_async },
+        { "gettimings",             &get_timings },
+        { "ispathcommand",          &is_path_command },
         { "lower",                  &to_lowercase },
+        { "memoryusage",            &get_memory_usage },
+        { "perfcounters",           &get_perf_counters },
         { "print",                  &clink_print },
+        { "reload",                 &clink_reload },
         { "upper",                  &to_uppercase },
         // Backward compatibility with the Clink 0.4.8 API.  Clink 1.0.0a1 had
         // moved these APIs away from "clink.", but backward compatibility
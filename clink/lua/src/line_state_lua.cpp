@@ -28,6 +28,48 @@ line_state_lua::line_state_lua(const line_state& line)
 {
 }
 
+//------------------------------------------------------------------------------
+line_state_lua::~line_state_lua()
+{
+    if (m_cache_state != nullptr)
+        for (int ref : m_word_refs)
+            if (ref != LUA_NOREF)
+                luaL_unref(m_cache_state, LUA_REGISTRYINDEX, ref);
+}
+
+//------------------------------------------------------------------------------
+int line_state_lua::push_word(lua_State* state, unsigned int index)
+{
+    if (index >= m_line.get_word_count())
+    {
+        lua_pushliteral(state, "");
+        return 1;
+    }
+
+    if (m_cache_state != state)
+    {
+        // Should only happen on first use; refs aren't valid across states.
+        m_word_refs.clear();
+        m_word_refs.resize(m_line.get_word_count(), LUA_NOREF);
+        m_cache_state = state;
+    }
+
+    int& ref = m_word_refs[index];
+    if (ref != LUA_NOREF)
+    {
+        lua_rawgeti(state, LUA_REGISTRYINDEX, ref);
+        return 1;
+    }
+
+    str<32> word;
+    m_line.get_word(index, word);
+    lua_pushlstring(state, word.c_str(), word.length());
+
+    lua_pushvalue(state, -1);
+    ref = luaL_ref(state, LUA_REGISTRYINDEX);
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 /// -name:  line:getline
 /// -ret:   string
@@ -151,11 +193,8 @@ int line_state_lua::get_word(lua_State* state)
     if (!lua_isnumber(state, 1))
         return 0;
 
-    str<32> word;
     unsigned int index = int(lua_tointeger(state, 1)) - 1;
-    m_line.get_word(index, word);
-    lua_pushlstring(state, word.c_str(), word.length());
-    return 1;
+    return push_word(state, index);
 }
 
 //------------------------------------------------------------------------------
@@ -173,8 +212,6 @@ int line_state_lua::get_word(lua_State* state)
 /// from the line returned by <a href="#line:getline">line:getline()</a>.
 int line_state_lua::get_end_word(lua_State* state)
 {
-    str<32> word;
-    m_line.get_end_word(word);
-    lua_pushlstring(state, word.c_str(), word.length());
-    return 1;
+    unsigned int count = m_line.get_word_count();
+    return push_word(state, count - 1);
 }
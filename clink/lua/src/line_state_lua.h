@@ -5,6 +5,8 @@
 
 #include "lua_bindable.h"
 
+#include <vector>
+
 class line_state;
 struct lua_State;
 
@@ -14,6 +16,7 @@ class line_state_lua
 {
 public:
                         line_state_lua(const line_state& line);
+                        ~line_state_lua();
     int                 get_line(lua_State* state);
     int                 get_cursor(lua_State* state);
     int                 get_command_offset(lua_State* state);
@@ -23,5 +26,13 @@ public:
     int                 get_end_word(lua_State* state);
 
 private:
+    int                 push_word(lua_State* state, unsigned int index);
     const line_state&   m_line;
+
+    // Memoized words:  registry refs to the Lua strings already extracted
+    // for each word, so repeated getword() calls don't re-slice the line.
+    // The bound line_state is an immutable snapshot, so entries never go
+    // stale within this object's lifetime.
+    lua_State*          m_cache_state = nullptr;
+    std::vector<int>    m_word_refs;
 };
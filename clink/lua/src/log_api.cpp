@@ -17,23 +17,120 @@ static const char* get_string(lua_State* state, int index)
     return lua_tostring(state, index);
 }
 
+//------------------------------------------------------------------------------
+// Token bucket per Lua call site, so a hot loop can't flood the log:  each
+// site can burst up to bucket_capacity lines and then refills one line per
+// refill_interval_ms.  Buckets are direct mapped by a hash of the source and
+// line; a collision just shares a bucket, which only makes the throttling
+// slightly more aggressive.
+struct log_bucket
+{
+    ULONGLONG       last_refill;
+    unsigned int    hash;
+    unsigned int    tokens;
+    unsigned int    dropped;
+};
+
+static log_bucket s_buckets[32];
+
+static const unsigned int bucket_capacity = 20;
+static const unsigned int refill_interval_ms = 100;
+
+//------------------------------------------------------------------------------
+static bool log_rate_limit(const char* source, int line, unsigned int& dropped)
+{
+    unsigned int hash = 5381;
+    for (const char* s = source; *s; ++s)
+        hash = hash * 33 + (unsigned char)*s;
+    hash = hash * 33 + (unsigned int)line;
+
+    log_bucket* bucket = &s_buckets[hash & (sizeof_array(s_buckets) - 1)];
+    const ULONGLONG now = GetTickCount64();
+
+    if (bucket->hash != hash)
+    {
+        // A new call site claims the slot with a full bucket.
+        bucket->hash = hash;
+        bucket->tokens = bucket_capacity;
+        bucket->last_refill = now;
+        bucket->dropped = 0;
+    }
+    else if (now - bucket->last_refill >= refill_interval_ms)
+    {
+        ULONGLONG refill = (now - bucket->last_refill) / refill_interval_ms;
+        if (refill > bucket_capacity)
+            refill = bucket_capacity;
+        bucket->tokens = min<unsigned int>(bucket->tokens + (unsigned int)refill, bucket_capacity);
+        bucket->last_refill += refill * refill_interval_ms;
+    }
+
+    if (!bucket->tokens)
+    {
+        ++bucket->dropped;
+        return false;
+    }
+
+    --bucket->tokens;
+    dropped = bucket->dropped;
+    bucket->dropped = 0;
+    return true;
+}
+
 //------------------------------------------------------------------------------
 /// -name:  log.info
 /// -arg:   message:string
-/// Writes info <span class="arg">message</span> to the Clink log file.  Use
-/// this sparingly, or it could cause performance problems or disk space
-/// problems.
+/// -arg:   [...:any]
+/// Writes info <span class="arg">message</span> to the Clink log file.  Extra
+/// arguments are formatted through <code>string.format</code>, and only once
+/// it's certain the line will be written:  nothing is formatted when logging
+/// is disabled, and each call site is rate limited so a hot loop can't flood
+/// the log (a note with the number of suppressed lines is added when a
+/// throttled site resumes).
 int log_info(lua_State* state)
 {
+    // Bail before doing any work when no log file is being written, so
+    // diagnostic logging left in production scripts costs only this check.
+    if (logger::get() == nullptr)
+        return 0;
+
     lua_Debug ar = {};
     lua_getstack(state, 1, &ar);
     lua_getinfo(state, "Sl", &ar);
     const char* source = ar.source ? ar.source : "?";
     int line = ar.currentline;
 
-    bool ok = false;
-    if (const char* message = get_string(state, 1))
-        logger::info(source, line, "%s", message);
+    unsigned int dropped = 0;
+    if (!log_rate_limit(source, line, dropped))
+        return 0;
+
+    // Format extra arguments through string.format, deferred to this point
+    // so the work only happens for lines that actually get written.
+    const char* message = nullptr;
+    const int arg_count = lua_gettop(state);
+    if (arg_count > 1 && lua_isstring(state, 1))
+    {
+        lua_getglobal(state, "string");
+        lua_pushliteral(state, "format");
+        lua_rawget(state, -2);
+        lua_remove(state, -2);
+        for (int i = 1; i <= arg_count; ++i)
+            lua_pushvalue(state, i);
+        if (lua_pcall(state, arg_count, 1, 0) == LUA_OK)
+            message = lua_tostring(state, -1);
+        else
+            lua_pop(state, 1);
+    }
+
+    if (message == nullptr)
+        message = get_string(state, 1);
+
+    if (message != nullptr)
+    {
+        if (dropped)
+            logger::info(source, line, "%s (%u earlier lines suppressed)", message, dropped);
+        else
+            logger::info(source, line, "%s", message);
+    }
 
     return 0;
 }
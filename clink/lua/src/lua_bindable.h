@@ -70,17 +70,14 @@ void lua_bindable<T>::bind()
         auto* methods = m_methods;
         while (methods != nullptr && methods->name != nullptr)
         {
+            // Capture the method pointer as the upvalue of a C closure, so a
+            // call goes straight from the __index lookup to the method with
+            // no __call metamethod resolution in between.  The object arrives
+            // as the first argument (method call syntax), which keeps the
+            // metatable shared by every instance of the class.
             auto* ptr = (method_t*)lua_newuserdata(m_state, sizeof(method_t));
             *ptr = methods->ptr;
-
-            if (luaL_newmetatable(m_state, "lua_bindable"))
-            {
-                lua_pushliteral(m_state, "__call");
-                lua_pushcfunction(m_state, &lua_bindable<T>::call);
-                lua_rawset(m_state, -3);
-            }
-
-            lua_setmetatable(m_state, -2);
+            lua_pushcclosure(m_state, &lua_bindable<T>::call, 1);
             lua_setfield(m_state, -2, methods->name);
 
             ++methods;
@@ -126,16 +123,15 @@ void lua_bindable<T>::push(lua_State* state)
 template <class T>
 int lua_bindable<T>::call(lua_State* state)
 {
-    auto* const* self = (T* const*)lua_touserdata(state, 2);
+    auto* const* self = (T* const*)lua_touserdata(state, 1);
     if (self == nullptr || *self == nullptr)
         return 0;
 
-    auto* const ptr = (method_t const*)lua_touserdata(state, 1);
+    auto* const ptr = (method_t const*)lua_touserdata(state, lua_upvalueindex(1));
     if (ptr == nullptr)
         return 0;
 
     lua_remove(state, 1);
-    lua_remove(state, 1);
 
     return ((*self)->*(*ptr))(state);
 }
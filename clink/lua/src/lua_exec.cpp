@@ -148,6 +148,99 @@ static DWORD WINAPI thread_proc(exec_state_t* state)
     return 0;
 }
 
+//------------------------------------------------------------------------------
+// Remembers whether a tool had to be run through the command processor, so
+// repeated invocations of the same tool skip the CreateProcess attempt that
+// is known to fail.  Keyed on the command's first token; direct mapped and
+// content compared, so a collision just costs the extra attempt again.
+typedef struct
+{
+    char    tool[64];
+    char    via_cmd;
+    char    valid;
+} tool_cache_t;
+
+static tool_cache_t s_tool_cache[16];
+
+//------------------------------------------------------------------------------
+static tool_cache_t* tool_cache_lookup(const char* cmd)
+{
+    char tool[sizeof_array(s_tool_cache->tool)];
+    unsigned int hash = 5381;
+    unsigned int len = 0;
+    char quote;
+
+    while (*cmd == ' ' || *cmd == '\t')
+        ++cmd;
+
+    quote = (*cmd == '\"');
+    cmd += quote;
+
+    while (*cmd)
+    {
+        char c = *cmd++;
+        if (quote ? (c == '\"') : (c == ' ' || c == '\t'))
+            break;
+
+        if (len >= sizeof(tool) - 1)
+            return nullptr;
+
+        tool[len++] = c;
+        hash = hash * 33 + (unsigned char)c;
+    }
+    tool[len] = '\0';
+
+    if (!len)
+        return nullptr;
+
+    tool_cache_t* entry = &s_tool_cache[hash & (sizeof_array(s_tool_cache) - 1)];
+    if (entry->valid && strcmp(entry->tool, tool) != 0)
+        entry->valid = 0;
+    if (!entry->valid)
+        strcpy(entry->tool, tool);
+    return entry;
+}
+
+//------------------------------------------------------------------------------
+static BOOL start_process(const char* cmd, STARTUPINFO* si, PROCESS_INFORMATION* pi)
+{
+    static const DWORD process_flags = NORMAL_PRIORITY_CLASS|CREATE_NO_WINDOW;
+
+    BOOL ok = FALSE;
+    tool_cache_t* cached = tool_cache_lookup(cmd);
+
+    if (!cached || !cached->valid || !cached->via_cmd)
+    {
+        ok = CreateProcess(nullptr, (char*)cmd, nullptr, nullptr, TRUE, process_flags,
+            nullptr, nullptr, si, pi);
+        if (ok)
+        {
+            if (cached)
+            {
+                cached->via_cmd = 0;
+                cached->valid = 1;
+            }
+            return ok;
+        }
+
+        // Did it fail because the executable wasn't found? Maybe it's a batch
+        // file? Best try running through the command processor.
+        if (GetLastError() != ERROR_FILE_NOT_FOUND)
+            return FALSE;
+    }
+
+    str<MAX_PATH> buffer;
+    buffer << "cmd.exe /c " << cmd;
+    ok = CreateProcess(nullptr, buffer.data(), nullptr, nullptr, TRUE, process_flags,
+        nullptr, nullptr, si, pi);
+    if (ok && cached)
+    {
+        cached->via_cmd = 1;
+        cached->valid = 1;
+    }
+    return ok;
+}
+
 //------------------------------------------------------------------------------
 static char* next_line(char* str)
 {
@@ -172,10 +265,30 @@ static char* next_line(char* str)
 }
 
 //------------------------------------------------------------------------------
-int lua_execute(lua_State* state)
+// Splits the null terminated output into lines, appending them to the Lua
+// table at the top of the stack.
+static void push_output_lines(lua_State* state, char* buffer)
 {
-    static const DWORD process_flags = NORMAL_PRIORITY_CLASS|CREATE_NO_WINDOW;
+    int line_count = 0;
+    char* line = buffer;
+    char* next = nullptr;
 
+    do
+    {
+        next = next_line(line);
+
+        lua_pushinteger(state, ++line_count);
+        lua_pushstring(state, line);
+        lua_rawset(state, -3);
+
+        line = next;
+    }
+    while (next);
+}
+
+//------------------------------------------------------------------------------
+int lua_execute(lua_State* state)
+{
     const char* cmd;
     int arg_count;
     BOOL ok;
@@ -224,29 +337,14 @@ int lua_execute(lua_State* state)
     si.hStdInput = pipe_stdin.read;
     si.dwFlags = STARTF_USESTDHANDLES;
 
-    ok = CreateProcess(nullptr, (char*)cmd, nullptr, nullptr, TRUE, process_flags, NULL,
-        nullptr, &si, &exec_state.pi
-    );
+    ok = start_process(cmd, &si, &exec_state.pi);
     if (ok == FALSE)
     {
-        // Did it fail because the executable wasn't found? Maybe it's a batch
-        // file? Best try running through the command processor.
-        if (GetLastError() == ERROR_FILE_NOT_FOUND)
-        {
-            str<MAX_PATH> buffer;
-            buffer << "cmd.exe /c " << cmd;
-            ok = CreateProcess(nullptr, buffer.data(), nullptr, nullptr, TRUE,
-                process_flags, nullptr, nullptr, &si, &exec_state.pi);
-        }
-
-        if (ok == FALSE)
-        {
-            destroy_pipe(&pipe_stdout);
-            destroy_pipe(&pipe_stderr);
-            destroy_pipe(&pipe_stdin);
-            CloseHandle(exec_state.job);
-            return 0;
-        }
+        destroy_pipe(&pipe_stdout);
+        destroy_pipe(&pipe_stderr);
+        destroy_pipe(&pipe_stdin);
+        CloseHandle(exec_state.job);
+        return 0;
     }
 
     AssignProcessToJobObject(exec_state.job, exec_state.pi.hProcess);
@@ -313,23 +411,7 @@ int lua_execute(lua_State* state)
         }
 
         // Extract lines from the process's output.
-        {
-            int line_count = 0;
-            char* line = (char*)buffer;
-            char* next = nullptr;
-
-            do
-            {
-                next = next_line(line);
-
-                lua_pushinteger(state, ++line_count);
-                lua_pushstring(state, line);
-                lua_rawset(state, -3);
-
-                line = next;
-            }
-            while (next);
-        }
+        push_output_lines(state, (char*)buffer);
 
         VirtualFree(buffer, 0, MEM_RELEASE);
     }
@@ -349,3 +431,294 @@ int lua_execute(lua_State* state)
 
     return 2;
 }
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+//  ASYNC EXECUTION:  THE CHILD RUNS WHILE THE EDITOR KEEPS ACCEPTING INPUT.  //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+// A worker thread drains the child's stdout while the editor keeps running;
+// a generator coroutine polls ready() between yields and collects the output
+// lines once the child finishes.  Anonymous pipes don't support overlapped
+// reads, so the asynchrony comes from servicing the blocking reads on the
+// worker instead of on the editor thread.
+
+//------------------------------------------------------------------------------
+typedef struct
+{
+    PROCESS_INFORMATION pi;
+    HANDLE              job;
+    HANDLE              thread;
+    pipe_t              pipe_stdout;
+    pipe_t              pipe_stderr;
+    pipe_t              pipe_stdin;
+    char*               buffer;
+    DWORD               exit_code;
+    int                 timeout;
+    int                 collected;
+    volatile LONG       finished;
+} async_exec_t;
+
+static const char* const ASYNC_EXEC_META = "clink_async_exec";
+
+//------------------------------------------------------------------------------
+static DWORD WINAPI async_exec_thread_proc(LPVOID param)
+{
+    async_exec_t* async = (async_exec_t*)param;
+    char* write = async->buffer;
+    int remaining = 0;
+    int page_size;
+    SYSTEM_INFO sys_info;
+
+    GetSystemInfo(&sys_info);
+    page_size = sys_info.dwAllocationGranularity;
+
+    // Collect all the process's output.  Committed pages are zero filled and
+    // a spare byte is always kept, so the output stays null terminated.
+    while (write != nullptr)
+    {
+        DWORD bytes_read;
+
+        // Commit the next page if we're out of buffer space.
+        if (remaining <= 1)
+        {
+            remaining = page_size;
+            if (!VirtualAlloc(write, page_size, MEM_COMMIT, PAGE_READWRITE))
+            {
+                break;
+            }
+        }
+
+        if (ReadFile(async->pipe_stdout.read, write, remaining - 1, &bytes_read, nullptr) != TRUE)
+        {
+            break;
+        }
+
+        remaining -= bytes_read;
+        write += bytes_read;
+    }
+
+    WaitForSingleObject(async->pi.hProcess, async->timeout);
+
+    async->exit_code = (DWORD)-1;
+    GetExitCodeProcess(async->pi.hProcess, &async->exit_code);
+    InterlockedExchange(&async->finished, 1);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static void async_exec_cleanup(async_exec_t* async)
+{
+    // Closing the job kills the child if it's still running, which also
+    // closes its end of the pipes and unblocks the worker's ReadFile().
+    if (async->job)
+    {
+        CloseHandle(async->job);
+        async->job = nullptr;
+    }
+
+    if (async->thread)
+    {
+        WaitForSingleObject(async->thread, INFINITE);
+        CloseHandle(async->thread);
+        async->thread = nullptr;
+    }
+
+    if (async->pi.hProcess)
+    {
+        CloseHandle(async->pi.hProcess);
+        async->pi.hProcess = nullptr;
+    }
+
+    destroy_pipe(&async->pipe_stdout);
+    destroy_pipe(&async->pipe_stderr);
+    destroy_pipe(&async->pipe_stdin);
+
+    if (async->buffer)
+    {
+        VirtualFree(async->buffer, 0, MEM_RELEASE);
+        async->buffer = nullptr;
+    }
+}
+
+//------------------------------------------------------------------------------
+static async_exec_t* async_exec_check(lua_State* state)
+{
+    return (async_exec_t*)luaL_checkudata(state, 1, ASYNC_EXEC_META);
+}
+
+//------------------------------------------------------------------------------
+static int async_exec_ready(lua_State* state)
+{
+    async_exec_t* async = async_exec_check(state);
+
+    if (!async->finished && async->thread)
+    {
+        WaitForSingleObject(async->thread, (DWORD)luaL_optinteger(state, 2, 0));
+    }
+
+    lua_pushboolean(state, async->finished != 0);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int async_exec_results(lua_State* state)
+{
+    async_exec_t* async = async_exec_check(state);
+
+    if (async->collected)
+    {
+        return 0;
+    }
+
+    // Wait out the execution timeout if the child is still running, then
+    // kill it via the job so the worker can finish.
+    if (!async->finished && async->thread)
+    {
+        if (WaitForSingleObject(async->thread, async->timeout) != WAIT_OBJECT_0
+            && async->job)
+        {
+            CloseHandle(async->job);
+            async->job = nullptr;
+            WaitForSingleObject(async->thread, INFINITE);
+        }
+    }
+
+    lua_newtable(state);
+    if (async->buffer)
+    {
+        push_output_lines(state, async->buffer);
+    }
+
+    lua_pushinteger(state, async->exit_code);
+
+    async->collected = 1;
+    async_exec_cleanup(async);
+    return 2;
+}
+
+//------------------------------------------------------------------------------
+static int async_exec_gc(lua_State* state)
+{
+    async_exec_cleanup(async_exec_check(state));
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  clink.execasync
+/// -arg:   command:string
+/// -arg:   [timeout:integer]
+/// -ret:   object
+/// -show:  local proc = clink.execasync("git status --porcelain")
+/// -show:  while not proc:ready() do
+/// -show:  &nbsp; coroutine.yield()
+/// -show:  end
+/// -show:  local lines, exit_code = proc:results()
+/// Starts <em>command</em> without blocking the editor and returns an object
+/// tracking it.  <code>ready()</code> reports whether the command has
+/// finished yet.  <code>results()</code> returns a table with the lines the
+/// command printed and its exit code, waiting for it to finish if necessary
+/// (up to <em>timeout</em> milliseconds, 1000 by default, after which the
+/// command is killed).  Match generator coroutines can poll
+/// <code>ready()</code> between yields so slow tools keep typing responsive.
+int lua_execute_async(lua_State* state)
+{
+    const char* cmd;
+    int arg_count;
+    STARTUPINFO si = { sizeof(si) };
+    async_exec_t* async;
+
+    // Get the command line to execute.
+    arg_count = lua_gettop(state);
+    if (arg_count == 0 || !lua_isstring(state, 1))
+    {
+        return 0;
+    }
+
+    cmd = lua_tostring(state, 1);
+
+    async = (async_exec_t*)lua_newuserdata(state, sizeof(*async));
+    memset(async, 0, sizeof(*async));
+
+    // Get the execution timeout.
+    if (arg_count > 1 && lua_isnumber(state, 2))
+    {
+        async->timeout = (int)lua_tointeger(state, 2);
+    }
+    else
+    {
+        async->timeout = 1000;
+    }
+
+    if (luaL_newmetatable(state, ASYNC_EXEC_META))
+    {
+        static const luaL_Reg methods[] = {
+            { "ready",      async_exec_ready },
+            { "results",    async_exec_results },
+            { "__gc",       async_exec_gc },
+            { nullptr,      nullptr },
+        };
+
+        luaL_setfuncs(state, methods, 0);
+        lua_pushvalue(state, -1);
+        lua_setfield(state, -2, "__index");
+    }
+    lua_setmetatable(state, -2);
+
+    // Create a job object to manage the processes we'll spawn.
+    async->job = create_job();
+    if (async->job == nullptr)
+    {
+        return 0;
+    }
+
+    // Create pipes to redirect std* streams.
+    create_pipe(WriteHandleInheritable, &async->pipe_stdout);
+    create_pipe(WriteHandleInheritable, &async->pipe_stderr);
+    create_pipe(ReadHandleInheritable, &async->pipe_stdin);
+
+    // Launch the process.
+    si.hStdError = async->pipe_stderr.write;
+    si.hStdOutput = async->pipe_stdout.write;
+    si.hStdInput = async->pipe_stdin.read;
+    si.dwFlags = STARTF_USESTDHANDLES;
+
+    if (start_process(cmd, &si, &async->pi) == FALSE)
+    {
+        async_exec_cleanup(async);
+        return 0;
+    }
+
+    AssignProcessToJobObject(async->job, async->pi.hProcess);
+    CloseHandle(async->pi.hThread);
+    async->pi.hThread = nullptr;
+
+    // Release our references to the child-side pipes. We don't use them, and
+    // it means the worker's ReadFile() returns once the child closes the
+    // stdout pipe.
+    CloseHandle(async->pipe_stdout.write);
+    CloseHandle(async->pipe_stderr.write);
+    CloseHandle(async->pipe_stdin.read);
+
+    async->pipe_stdout.write = nullptr;
+    async->pipe_stderr.write = nullptr;
+    async->pipe_stdin.read = nullptr;
+
+    // Reserve the output buffer; the worker commits pages as output arrives.
+    {
+        static const unsigned int RESERVE = 4 * 1024 * 1024;
+        async->buffer = (char*)VirtualAlloc(nullptr, RESERVE, MEM_RESERVE, PAGE_READWRITE);
+    }
+
+    async->thread = CreateThread(nullptr, 0, async_exec_thread_proc, async, 0, nullptr);
+    if (async->thread == nullptr)
+    {
+        async_exec_cleanup(async);
+        return 0;
+    }
+
+    return 1;
+}
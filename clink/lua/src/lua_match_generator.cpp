@@ -23,9 +23,83 @@ extern "C" {
 
 extern void sort_match_list(char** matches, int len);
 
+//------------------------------------------------------------------------------
+// Pool for match_display_filter_entry allocations.  Filtered entries live in
+// page-sized slabs that are rewound at the start of each filter invocation
+// and kept for reuse, so display-filtering thousands of matches costs a
+// handful of page allocations the first time and none after that.  Entries
+// stay valid until the next invocation; free_filtered_matches() is a release
+// no-op (this pool is the only producer of filtered match arrays).
+class filter_entry_pool
+{
+public:
+                    ~filter_entry_pool();
+    void            reset();
+    void*           alloc(unsigned int size);
+
+private:
+    struct page
+    {
+        page*       next;
+        unsigned int capacity;  // Payload size, excluding this header.
+        unsigned int used;
+    };
+
+    page*           m_chain = nullptr;
+    page*           m_cursor = nullptr;
+};
+
+static const unsigned int c_filter_page_size = 0x10000;
+
+//------------------------------------------------------------------------------
+filter_entry_pool::~filter_entry_pool()
+{
+    for (page* p = m_chain; p != nullptr;)
+    {
+        page* next = p->next;
+        free(p);
+        p = next;
+    }
+}
+
+//------------------------------------------------------------------------------
+void filter_entry_pool::reset()
+{
+    for (page* p = m_chain; p != nullptr; p = p->next)
+        p->used = 0;
+    m_cursor = m_chain;
+}
+
+//------------------------------------------------------------------------------
+void* filter_entry_pool::alloc(unsigned int size)
+{
+    while (m_cursor != nullptr && m_cursor->capacity - m_cursor->used < size)
+        m_cursor = m_cursor->next;
+
+    if (m_cursor == nullptr)
+    {
+        unsigned int capacity = (size > c_filter_page_size) ? size : c_filter_page_size;
+        page* p = (page*)malloc(sizeof(page) + capacity);
+        if (p == nullptr)
+            return nullptr;
+        p->capacity = capacity;
+        p->used = 0;
+        p->next = m_chain;
+        m_chain = p;
+        m_cursor = p;
+    }
+
+    char* ptr = (char*)(m_cursor + 1) + m_cursor->used;
+    m_cursor->used += size;
+    return ptr;
+}
+
+static filter_entry_pool s_filter_entry_pool;
+
 //------------------------------------------------------------------------------
 lua_match_generator::lua_match_generator(lua_state& state)
 : m_state(state)
+, m_coroutine_ref(LUA_NOREF)
 {
     lua_load_script(m_state, lib, generator);
     lua_load_script(m_state, lib, arguments);
@@ -34,11 +108,24 @@ lua_match_generator::lua_match_generator(lua_state& state)
 //------------------------------------------------------------------------------
 lua_match_generator::~lua_match_generator()
 {
+    cancel_coroutine();
+}
+
+//------------------------------------------------------------------------------
+void lua_match_generator::set_demand_loader(lua_script_demand_loader* loader)
+{
+    m_demand_loader = loader;
 }
 
 //------------------------------------------------------------------------------
 bool lua_match_generator::generate(const line_state& line, match_builder& builder)
 {
+    if (m_demand_loader != nullptr)
+        m_demand_loader->on_generate(line);
+
+    // A fresh generate supersedes any coroutine still streaming matches in.
+    cancel_coroutine();
+
     lua_State* state = m_state.get_state();
     save_stack_top ss(state);
 
@@ -59,32 +146,106 @@ bool lua_match_generator::generate(const line_state& line, match_builder& builde
         lua_setglobal(state, "rl_state");
     }
 
-    // Call to Lua to generate matches.
-    lua_getglobal(state, "clink");
-    lua_pushliteral(state, "_generate");
-    lua_rawget(state, -2);
+    // Call to Lua to generate matches.  The call runs on a coroutine so a
+    // generator can yield out of expensive work; the editor then resumes it
+    // on idle ticks (see on_idle) and the matches it adds stream in
+    // incrementally while typing stays responsive.
+    lua_State* thread = lua_newthread(state);
+    m_coroutine_ref = luaL_ref(state, LUA_REGISTRYINDEX);
+
+    lua_getglobal(thread, "clink");
+    lua_pushliteral(thread, "_generate");
+    lua_rawget(thread, -2);
+    lua_remove(thread, -2);
+
+    // The line state and builder must outlive this call if the coroutine
+    // yields, so the Lua facing wrappers bind to copies owned by this
+    // generator instead of to the caller's locals.
+    m_coroutine_line = new line_state(line);
+    m_coroutine_builder = new match_builder(builder.get_matches());
+    m_coroutine_line_lua = new line_state_lua(*m_coroutine_line);
+    m_coroutine_builder_lua = new match_builder_lua(*m_coroutine_builder);
+    m_coroutine_line_lua->push(thread);
+    m_coroutine_builder_lua->push(thread);
+
+    int status = m_state.resume(thread, 2);
+
+    // A generator that yields claims the word; the matches streamed in so
+    // far (and later, from on_idle) get used.
+    if (status == LUA_YIELD)
+        return true;
+
+    bool use_matches = false;
+    if (status == LUA_OK)
+        use_matches = (lua_toboolean(thread, -1) != 0);
+    else if (const char* error = lua_tostring(thread, -1))
+        m_state.print_error(error);
+
+    cancel_coroutine();
+    return use_matches;
+}
 
-    line_state_lua line_lua(line);
-    line_lua.push(state);
+//------------------------------------------------------------------------------
+bool lua_match_generator::is_busy() const
+{
+    return (m_coroutine_ref != LUA_NOREF);
+}
 
-    match_builder_lua builder_lua(builder);
-    builder_lua.push(state);
+//------------------------------------------------------------------------------
+bool lua_match_generator::on_idle()
+{
+    if (m_coroutine_ref == LUA_NOREF)
+        return false;
 
-    if (m_state.pcall(state, 2, 1) != 0)
-    {
-        if (const char* error = lua_tostring(state, -1))
+    lua_State* state = m_state.get_state();
+    save_stack_top ss(state);
+
+    lua_rawgeti(state, LUA_REGISTRYINDEX, m_coroutine_ref);
+    lua_State* thread = lua_tothread(state, -1);
+
+    int status = m_state.resume(thread, 0);
+    if (status == LUA_YIELD)
+        return true;
+
+    if (status != LUA_OK)
+        if (const char* error = lua_tostring(thread, -1))
             m_state.print_error(error);
 
-        return false;
+    cancel_coroutine();
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void lua_match_generator::on_wait()
+{
+    m_state.gc_step();
+}
+
+//------------------------------------------------------------------------------
+void lua_match_generator::cancel_coroutine()
+{
+    if (m_coroutine_ref != LUA_NOREF)
+    {
+        luaL_unref(m_state.get_state(), LUA_REGISTRYINDEX, m_coroutine_ref);
+        m_coroutine_ref = LUA_NOREF;
     }
 
-    int use_matches = lua_toboolean(state, -1);
-    return !!use_matches;
+    delete m_coroutine_builder_lua;
+    m_coroutine_builder_lua = nullptr;
+    delete m_coroutine_line_lua;
+    m_coroutine_line_lua = nullptr;
+    delete m_coroutine_builder;
+    m_coroutine_builder = nullptr;
+    delete m_coroutine_line;
+    m_coroutine_line = nullptr;
 }
 
 //------------------------------------------------------------------------------
 void lua_match_generator::get_word_break_info(const line_state& line, word_break_info& info) const
 {
+    if (m_demand_loader != nullptr)
+        m_demand_loader->on_generate(line);
+
     lua_State* state = m_state.get_state();
     save_stack_top ss(state);
 
@@ -286,9 +447,11 @@ bool lua_match_generator::match_display_filter(char** matches, match_display_fil
     int max_visible_display = 0;
     int max_visible_description = 0;
     int new_len = int(lua_rawlen(state, -1));
-    new_matches = (match_display_filter_entry**)calloc(1 + new_len + 1, sizeof(*new_matches));
-    new_matches[0] = (match_display_filter_entry*)malloc(sizeof(match_display_filter_entry));
-    memset(new_matches[0], 0, sizeof(new_matches[0]));
+    s_filter_entry_pool.reset();
+    new_matches = (match_display_filter_entry**)s_filter_entry_pool.alloc((1 + new_len + 1) * sizeof(*new_matches));
+    memset(new_matches, 0, (1 + new_len + 1) * sizeof(*new_matches));
+    new_matches[0] = (match_display_filter_entry*)s_filter_entry_pool.alloc(sizeof(match_display_filter_entry));
+    memset(new_matches[0], 0, sizeof(*new_matches[0]));
     new_matches[0]->display = new_matches[0]->buffer;
     for (i = 1; i <= new_len; ++i)
     {
@@ -344,7 +507,7 @@ bool lua_match_generator::match_display_filter(char** matches, match_display_fil
                 if (description) alloc_size += strlen(description);
 
                 match_display_filter_entry *new_match;
-                new_match = (match_display_filter_entry *)malloc(alloc_size);
+                new_match = (match_display_filter_entry *)s_filter_entry_pool.alloc((unsigned int)alloc_size);
                 memset(new_match, 0, sizeof(*new_match));
                 new_match->type = (unsigned char)type;
                 new_matches[j] = new_match;
@@ -356,7 +519,7 @@ bool lua_match_generator::match_display_filter(char** matches, match_display_fil
                 if (match && !new_match->match[0])
                 {
 discard:
-                    free(new_match);
+                    // Pool memory; reclaimed wholesale at the next reset().
                     j--;
                 }
 
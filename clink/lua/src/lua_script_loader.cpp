@@ -10,6 +10,9 @@
 //------------------------------------------------------------------------------
 void lua_load_script_impl(lua_state& state, const char* script, int length)
 {
+    // The embed step (embed.lua) compiles each script with luac -s, so
+    // 'script' is stripped bytecode and lua_load only has to undump it; no
+    // parsing or compiling happens at injection time.
     state.do_string(script, length);
 }
 
@@ -8,8 +8,11 @@
 
 #include <core/settings.h>
 #include <core/str.h>
+#include <core/str_hash.h>
 #include <core/str_tokeniser.h>
 #include <core/os.h>
+#include <core/path.h>
+#include <core/timings.h>
 
 #include <assert.h>
 
@@ -60,6 +63,15 @@ static setting_bool g_lua_breakonerror(
     "Breaks into the Lua debugger on Lua errors, if lua.debug is enabled.",
     false);
 
+static setting_int g_lua_gcstepmsec(
+    "lua.gc_step_msec",
+    "Garbage collection time between keys",
+    "How many milliseconds to spend stepping the Lua garbage collector while\n"
+    "waiting for the next key, so collections are prepaid in idle time instead\n"
+    "of pausing match generators mid keystroke. Set to 0 to disable idle\n"
+    "stepping and leave collection entirely to the default allocation pacing.",
+    2);
+
 
 
 //------------------------------------------------------------------------------
@@ -91,13 +103,70 @@ lua_state::~lua_state()
 }
 
 //------------------------------------------------------------------------------
-void lua_state::initialise()
+// Evicts modules that scripts pulled in with require(), so edited modules get
+// reloaded on the next require().  The standard libraries stay resident.
+static void unload_user_modules(lua_State* state)
 {
-    shutdown();
+    static const char* const c_core_modules[] = {
+        "_G", "bit32", "coroutine", "debug", "io", "math",
+        "os", "package", "string", "table",
+    };
+
+    lua_getglobal(state, "package");
+    lua_pushliteral(state, "loaded");
+    lua_rawget(state, -2);
+
+    lua_pushnil(state);
+    while (lua_next(state, -2) != 0)
+    {
+        lua_pop(state, 1);
 
-    // Create a new Lua state.
-    m_state = luaL_newstate();
-    luaL_openlibs(m_state);
+        if (lua_type(state, -1) != LUA_TSTRING)
+            continue;
+
+        bool keep = false;
+        const char* name = lua_tostring(state, -1);
+        for (const char* core : c_core_modules)
+            if (strcmp(name, core) == 0)
+            {
+                keep = true;
+                break;
+            }
+
+        // Clearing an existing field mid-traversal is allowed.
+        if (!keep)
+        {
+            lua_pushvalue(state, -1);
+            lua_pushnil(state);
+            lua_rawset(state, -4);
+        }
+    }
+
+    lua_pop(state, 2);
+}
+
+//------------------------------------------------------------------------------
+void lua_state::initialise()
+{
+    timing_scope timing("lua initialise");
+
+    // Reinitialising an existing interpreter takes a fast reset path instead
+    // of tearing the state down: the standard libraries and the registered C
+    // API tables survive, and only script-visible state gets rebuilt.  Each
+    // lib script keeps its registrations (events, generators, argmatchers,
+    // etc) in locals, so re-running it below starts it from scratch; modules
+    // from require() are evicted so edited ones reload.
+    bool reuse = (m_state != nullptr);
+    if (reuse)
+    {
+        unload_user_modules(m_state);
+    }
+    else
+    {
+        // Create a new Lua state.
+        m_state = luaL_newstate();
+        luaL_openlibs(m_state);
+    }
 
     // Set up the package.path value for require() statements.
     str<280> path;
@@ -123,15 +192,19 @@ void lua_state::initialise()
 
     lua_state& self = *this;
 
-    // Initialize API namespaces.
-    clink_lua_initialise(self);
-    os_lua_initialise(self);
-    console_lua_initialise(self);
-    path_lua_initialise(self);
-    rl_lua_initialise(self);
-    settings_lua_initialise(self);
-    string_lua_initialise(self);
-    log_lua_initialise(self);
+    // Initialize API namespaces.  The registrations are all reachable from
+    // the globals table and survive a reuse reset.
+    if (!reuse)
+    {
+        clink_lua_initialise(self);
+        os_lua_initialise(self);
+        console_lua_initialise(self);
+        path_lua_initialise(self);
+        rl_lua_initialise(self);
+        settings_lua_initialise(self);
+        string_lua_initialise(self);
+        log_lua_initialise(self);
+    }
 
     // Load the debugger.
     if (g_force_load_debugger || g_lua_debug.get())
@@ -170,12 +243,181 @@ bool lua_state::do_string(const char* string, int length)
     return ok;
 }
 
+//------------------------------------------------------------------------------
+// Advances the incremental garbage collector while the editor is waiting for
+// the next key.  Prepaying the collection debt in idle time makes it unlikely
+// that the allocation-paced collector fires inside a generator or classifier
+// callback mid keystroke.  Each lua_gc() step is small so the time budget is
+// honoured closely; a completed collection cycle ends the loop early.
+void lua_state::gc_step()
+{
+    int budget_msec = g_lua_gcstepmsec.get();
+    if (budget_msec <= 0 || m_state == nullptr)
+        return;
+
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER start;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    long long budget_ticks = (frequency.QuadPart * budget_msec) / 1000;
+
+    while (true)
+    {
+        if (lua_gc(m_state, LUA_GCSTEP, 1))
+            break;
+
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        if (now.QuadPart - start.QuadPart >= budget_ticks)
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Bytecode cache for do_file().
+//
+// Scripts are recompiled from source on every injection, and with a large
+// script collection lua_load dominates startup.  Compiled chunks are dumped
+// to the temp directory keyed by the source path and its last-write time,
+// and reloaded with luaL_loadbuffer while the source is unchanged.  Any
+// mismatch -- edited source, different Lua version, corrupt file -- falls
+// back to compiling the source, after which the cache file is rewritten.
+struct bytecode_header
+{
+    unsigned int    magic;
+    unsigned int    version;
+    FILETIME        source_time;
+    unsigned int    path_size;      // Bytes, including the terminating nul;
+};                                  // the source path follows the header.
+
+static const unsigned int c_bytecode_magic = 0x61756c63;
+static const unsigned int c_bytecode_version = 1;
+
+//------------------------------------------------------------------------------
+static bool get_last_write_time(const char* path, FILETIME& out)
+{
+    wstr<280> wpath(path);
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &fad))
+        return false;
+
+    out = fad.ftLastWriteTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static bool get_bytecode_path(const char* path, str_base& out)
+{
+    if (!os::get_temp_dir(out))
+        return false;
+
+    str<48> name;
+    name.format("clink_%08x.luac", str_hash(path));
+    return path::append(out, name.c_str());
+}
+
+//------------------------------------------------------------------------------
+static bool load_bytecode(lua_State* state, const char* path, const char* cache_path, const FILETIME& source_time)
+{
+    FILE* in = fopen(cache_path, "rb");
+    if (in == nullptr)
+        return false;
+
+    fseek(in, 0, SEEK_END);
+    int size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+
+    bytecode_header header;
+    bool ok = (size > int(sizeof(header)) &&
+               fread(&header, sizeof(header), 1, in) == 1 &&
+               header.magic == c_bytecode_magic &&
+               header.version == c_bytecode_version &&
+               CompareFileTime(&header.source_time, &source_time) == 0 &&
+               header.path_size > 0 &&
+               int(sizeof(header) + header.path_size) < size);
+
+    if (ok)
+    {
+        int payload = size - int(sizeof(header));
+
+        str<4096> buffer;
+        buffer.reserve(payload);
+        char* data = buffer.data();
+
+        // The stored source path guards against hash collisions in the cache
+        // file's name.
+        ok = (fread(data, payload, 1, in) == 1 &&
+              data[header.path_size - 1] == '\0' &&
+              stricmp(data, path) == 0);
+
+        if (ok)
+        {
+            str<288> chunk_name;
+            chunk_name.format("@%s", path);
+            ok = !luaL_loadbuffer(state, data + header.path_size,
+                payload - header.path_size, chunk_name.c_str());
+            if (!ok)
+                lua_pop(state, 1);
+        }
+    }
+
+    fclose(in);
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+static int bytecode_writer(lua_State*, const void* data, size_t size, void* file)
+{
+    return fwrite(data, 1, size, (FILE*)file) != size;
+}
+
+//------------------------------------------------------------------------------
+static void save_bytecode(lua_State* state, const char* path, const char* cache_path, const FILETIME& source_time)
+{
+    // The freshly compiled chunk is at the top of the stack.
+    FILE* out = fopen(cache_path, "wb");
+    if (out == nullptr)
+        return;
+
+    bytecode_header header = {};
+    header.magic = c_bytecode_magic;
+    header.version = c_bytecode_version;
+    header.source_time = source_time;
+    header.path_size = (unsigned int)(strlen(path)) + 1;
+
+    bool ok = (fwrite(&header, sizeof(header), 1, out) == 1 &&
+               fwrite(path, header.path_size, 1, out) == 1 &&
+               !lua_dump(state, bytecode_writer, out));
+    fclose(out);
+
+    // Leave no cache rather than a truncated one.
+    if (!ok)
+        os::unlink(cache_path);
+}
+
 //------------------------------------------------------------------------------
 bool lua_state::do_file(const char* path)
 {
     save_stack_top ss(m_state);
 
-    bool ok = !luaL_loadfile(m_state, path);
+    // Snapshot the source's timestamp before compiling, so a concurrent edit
+    // leaves a mismatched (stale) cache rather than a wrong one.
+    FILETIME source_time;
+    str<280> cache_path;
+    bool can_cache = (get_last_write_time(path, source_time) &&
+                      get_bytecode_path(path, cache_path));
+
+    bool compiled = false;
+    bool ok = can_cache && load_bytecode(m_state, path, cache_path.c_str(), source_time);
+    if (!ok)
+    {
+        ok = !luaL_loadfile(m_state, path);
+        compiled = ok;
+    }
+
+    if (compiled && can_cache)
+        save_bytecode(m_state, path, cache_path.c_str(), source_time);
+
     if (ok)
         ok = !pcall(0, LUA_MULTRET);
     else if (const char* error = lua_tostring(m_state, -1))
@@ -278,6 +520,24 @@ int lua_state::pcall(lua_State* L, int nargs, int nresults)
     return ret;
 }
 
+//------------------------------------------------------------------------------
+// Mirrors pcall()'s console mode guard; resumed coroutines can run the same
+// kinds of side-effectful code.
+int lua_state::resume(lua_State* thread, int nargs)
+{
+    DWORD modeIn, modeOut;
+    HANDLE hIn = GetStdHandle(STD_INPUT_HANDLE);
+    HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+    GetConsoleMode(hIn, &modeIn);
+    GetConsoleMode(hOut, &modeOut);
+
+    int ret = lua_resume(thread, m_state, nargs);
+
+    SetConsoleMode(hIn, modeIn);
+    SetConsoleMode(hOut, modeOut);
+    return ret;
+}
+
 //------------------------------------------------------------------------------
 const char* lua_state::get_string(int index) const
 {
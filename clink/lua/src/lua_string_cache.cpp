@@ -0,0 +1,103 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_string_cache.h"
+
+#include <core/str.h>
+#include <core/str_hash.h>
+
+#include <new>
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+//------------------------------------------------------------------------------
+// Strings up to LUAI_MAXSHORTLEN (40) characters are interned by Lua, so
+// pushing those again is already allocation free.  Longer strings get a fresh
+// heap object per push, so recently pushed ones are kept alive by registry
+// references in a small direct-mapped cache keyed by content.  The cache is
+// stored in the registry of the state it serves, as a userdata with a __gc
+// metamethod, so its lifetime matches the state's and its references never
+// outlive them.
+static const unsigned int c_cache_slots = 256;
+static const unsigned int c_min_cached_length = 41;
+static const unsigned int c_max_cached_length = 512;
+
+//------------------------------------------------------------------------------
+struct string_cache
+{
+    struct slot
+    {
+        str_moveable    value;
+        int             ref = LUA_NOREF;
+    };
+
+    slot                slots[c_cache_slots];
+};
+
+static const char* const c_cache_registry_key = "clink_string_cache";
+
+//------------------------------------------------------------------------------
+static int cache_gc(lua_State* state)
+{
+    string_cache* cache = (string_cache*)lua_touserdata(state, 1);
+    if (cache != nullptr)
+        cache->~string_cache();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static string_cache* get_cache(lua_State* state)
+{
+    lua_getfield(state, LUA_REGISTRYINDEX, c_cache_registry_key);
+    string_cache* cache = (string_cache*)lua_touserdata(state, -1);
+    lua_pop(state, 1);
+    if (cache != nullptr)
+        return cache;
+
+    cache = (string_cache*)lua_newuserdata(state, sizeof(string_cache));
+    new (cache) string_cache();
+
+    lua_createtable(state, 0, 1);
+    lua_pushcfunction(state, cache_gc);
+    lua_setfield(state, -2, "__gc");
+    lua_setmetatable(state, -2);
+
+    lua_setfield(state, LUA_REGISTRYINDEX, c_cache_registry_key);
+    return cache;
+}
+
+//------------------------------------------------------------------------------
+void lua_push_cached_string(lua_State* state, const char* value, unsigned int length)
+{
+    if (length < c_min_cached_length || length > c_max_cached_length)
+    {
+        lua_pushlstring(state, value, length);
+        return;
+    }
+
+    string_cache* cache = get_cache(state);
+    string_cache::slot& slot = cache->slots[str_hash(value, length) & (c_cache_slots - 1)];
+
+    if (slot.ref != LUA_NOREF &&
+        slot.value.length() == length &&
+        memcmp(slot.value.c_str(), value, length) == 0)
+    {
+        lua_rawgeti(state, LUA_REGISTRYINDEX, slot.ref);
+        return;
+    }
+
+    lua_pushlstring(state, value, length);
+
+    // Displace whatever occupied the slot; direct mapping is enough to absorb
+    // the repeated pushes successive completion passes make.
+    if (slot.ref != LUA_NOREF)
+        luaL_unref(state, LUA_REGISTRYINDEX, slot.ref);
+    lua_pushvalue(state, -1);
+    slot.ref = luaL_ref(state, LUA_REGISTRYINDEX);
+    slot.value.clear();
+    slot.value.concat(value, length);
+}
@@ -0,0 +1,14 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+struct lua_State;
+
+//------------------------------------------------------------------------------
+// Pushes 'value' as a Lua string, re-using a previously pushed string with
+// the same content when one is still cached.  Lua interns short strings in
+// its global string table itself; this exists for the longer strings (deep
+// paths) that Lua 5.2 allocates anew on every push, which makes repeated
+// completion passes over the same tree churn the Lua heap.
+void lua_push_cached_string(lua_State* state, const char* value, unsigned int length);
@@ -41,6 +41,34 @@ lua_word_classifier::lua_word_classifier(lua_state& state)
 //------------------------------------------------------------------------------
 void lua_word_classifier::classify(const line_state& line, word_classifications& classifications, const char* already_classified)
 {
+    // A pass classifies each command of the line in turn; a new pass starts
+    // when no classifications have accumulated yet.
+    unsigned int base = classifications.size();
+    if (base == 0)
+    {
+        m_prev_pass.swap(m_pass);
+        m_pass.clear();
+    }
+
+    // Serve the whole command from the previous pass when every one of its
+    // words is unchanged; only commands inside the edited range cost a Lua
+    // round-trip.
+    unsigned int word_count = line.get_word_count();
+    if (word_count && line.get_first_dirty_word() >= word_count)
+    {
+        for (const cached_command& cached : m_prev_pass)
+        {
+            if (cached.base != base || cached.word_count != word_count)
+                continue;
+
+            for (const word_class_info& entry : cached.entries)
+                *classifications.push_back() = entry;
+
+            m_pass.push_back(cached);
+            return;
+        }
+    }
+
     lua_State* state = m_state.get_state();
     save_stack_top ss(state);
 
@@ -93,4 +121,12 @@ void lua_word_classifier::classify(const line_state& line, word_classifications&
         if (classifications_lua.get_word_class(i, wc))
             classifications[i]->word_class = wc;
     }
+
+    // Record the command's final classifications for the next pass.
+    cached_command fresh;
+    fresh.base = base;
+    fresh.word_count = word_count;
+    for (unsigned int i = base; i < classifications.size(); i++)
+        fresh.entries.push_back(*classifications[i]);
+    m_pass.push_back(std::move(fresh));
 }
@@ -15,6 +15,8 @@ static match_builder_lua::method g_methods[] = {
     { "setappendcharacter", &match_builder_lua::set_append_character },
     { "setsuppressappend",  &match_builder_lua::set_suppress_append },
     { "setsuppressquoting", &match_builder_lua::set_suppress_quoting },
+    // Internal; used by the generator statistics in generator.lua.
+    { "_matchcount",        &match_builder_lua::get_match_count },
     // Only for backward compatibility:
     { "setmatchesarefiles", &match_builder_lua::set_matches_are_files },
     {}
@@ -159,6 +161,15 @@ int match_builder_lua::set_suppress_quoting(lua_State* state)
     return 0;
 }
 
+//------------------------------------------------------------------------------
+// Undocumented; generator.lua reads the live match count before and after each
+// generator runs to attribute matches to it.
+int match_builder_lua::get_match_count(lua_State* state)
+{
+    lua_pushinteger(state, m_builder.get_matches().get_match_count());
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 // Undocumented because it exists only to enable the clink.matches_are_files
 // backward compatibility.
@@ -204,8 +215,30 @@ int match_builder_lua::add_matches(lua_State* state)
 
     match_type type = to_match_type(get_string(state, 2));
 
-    int count = 0;
     int total = int(lua_rawlen(state, 1));
+
+    // Measure the table first -- lua_rawlen on a string value doesn't copy
+    // it -- and reserve the match store and index in one go, so the add loop
+    // below never reallocates partway through a big table.
+    unsigned int store_size = 0;
+    for (int i = 1; i <= total; ++i)
+    {
+        lua_rawgeti(state, 1, i);
+        if (lua_istable(state, -1))
+        {
+            lua_pushliteral(state, "match");
+            lua_rawget(state, -2);
+            if (lua_isstring(state, -1))
+                store_size += unsigned(lua_rawlen(state, -1)) + 1;
+            lua_pop(state, 1);
+        }
+        else if (lua_isstring(state, -1))
+            store_size += unsigned(lua_rawlen(state, -1)) + 1;
+        lua_pop(state, 1);
+    }
+    m_builder.reserve(total, store_size);
+
+    int count = 0;
     for (int i = 1; i <= total; ++i)
     {
         lua_rawgeti(state, 1, i);
@@ -21,6 +21,7 @@ public:
     int             set_append_character(lua_State* state);
     int             set_suppress_append(lua_State* state);
     int             set_suppress_quoting(lua_State* state);
+    int             get_match_count(lua_State* state);
 
     int             set_matches_are_files(lua_State* state);
 
@@ -3,16 +3,21 @@
 
 #include "pch.h"
 #include "lua_state.h"
+#include "lua_string_cache.h"
 
 #include <core/base.h>
+#include <core/dir_cache.h>
 #include <core/globber.h>
 #include <core/os.h>
 #include <core/path.h>
 #include <core/settings.h>
 #include <core/str.h>
 #include <process/process.h>
+#include <terminal/screen_buffer.h>
 #include <ntverp.h> // for VER_PRODUCTMAJORVERSION to deduce SDK version
 
+#include <new>
+
 //------------------------------------------------------------------------------
 extern setting_bool g_glob_hidden;
 extern setting_bool g_glob_system;
@@ -134,6 +139,34 @@ static int is_hidden(lua_State* state)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+/// -name:  os.getfiletime
+/// -arg:   path:string
+/// -ret:   string | nil
+/// Returns the last write time of <span class="arg">path</span> as an opaque
+/// token string, or nil if <span class="arg">path</span> is inaccessible.  Two
+/// tokens compare equal if and only if the file was unchanged between the two
+/// calls, which makes the token useful for change detection (for example as a
+/// declared file input of a prompt filter).
+static int get_file_time(lua_State* state)
+{
+    const char* path = get_string(state, 1);
+    if (path == nullptr)
+        return 0;
+
+    wstr<280> wpath(path);
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &fad))
+        return 0;
+
+    str<32> token;
+    token.format("%08x%08x", fad.ftLastWriteTime.dwHighDateTime,
+        fad.ftLastWriteTime.dwLowDateTime);
+
+    lua_pushlstring(state, token.c_str(), token.length());
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 /// -name:  os.unlink
 /// -arg:   path:string
@@ -207,6 +240,37 @@ static void add_type_tag(str_base& out, const char* tag)
     out << tag;
 }
 
+//------------------------------------------------------------------------------
+static void push_glob_entry(
+    lua_State* state,
+    const str_base& file,
+    int attr,
+    bool back_compat,
+    str_base& type)
+{
+    if (back_compat)
+    {
+        lua_push_cached_string(state, file.c_str(), file.length());
+        return;
+    }
+
+    lua_createtable(state, 0, 2);
+
+    lua_pushliteral(state, "name");
+    lua_push_cached_string(state, file.c_str(), file.length());
+    lua_rawset(state, -3);
+
+    type.clear();
+    add_type_tag(type, (attr & FILE_ATTRIBUTE_DIRECTORY) ? "dir" : "file");
+    if (attr & FILE_ATTRIBUTE_HIDDEN)
+        add_type_tag(type, "hidden");
+    if (attr & FILE_ATTRIBUTE_READONLY)
+        add_type_tag(type, "readonly");
+    lua_pushliteral(state, "type");
+    lua_pushlstring(state, type.c_str(), type.length());
+    lua_rawset(state, -3);
+}
+
 //------------------------------------------------------------------------------
 int glob_impl(lua_State* state, bool dirs_only, bool back_compat=false)
 {
@@ -218,45 +282,105 @@ int glob_impl(lua_State* state, bool dirs_only, bool back_compat=false)
 
     lua_createtable(state, 0, 0);
 
-    globber globber(mask);
-    globber.files(!dirs_only);
-    globber.hidden(g_glob_hidden.get());
-    globber.system(g_glob_system.get());
-    if (back_compat)
-        globber.suffix_dirs(false);
+    bool include_hidden = g_glob_hidden.get();
+    bool include_system = g_glob_system.get();
+    bool suffix_dirs = !back_compat;
 
     int i = 1;
     str<288> file;
     str<16> type;
-    int attr;
-    while (globber.next(file, false, nullptr, &attr))
+
+    // Completion-driven globs use 'everything in <dir>' masks, which the
+    // directory cache can serve verbatim; other masks would need
+    // FindFirstFile's pattern matching quirks reproduced, so they go straight
+    // to the globber.  Drive relative masks bypass the cache for the same
+    // reason as in globber's constructor.
+    str<288> strip;
+    concat_strip_quotes(strip, mask);
+    const char* name_part = path::get_name(strip.c_str());
+    const char* c = strip.c_str();
+    bool cacheable = (name_part != nullptr &&
+        (strcmp(name_part, "*") == 0 || strcmp(name_part, "*.*") == 0));
+    cacheable &= !(c[0] && c[1] == ':' && c[2] != '\\' && c[2] != '/');
+
+    str<288> dir;
+    if (cacheable)
     {
-        if (back_compat)
+        path::get_directory(strip.c_str(), dir);
+
+        std::shared_ptr<const dir_cache::listing> cached = dir_cache::find(dir.c_str());
+        if (cached != nullptr)
         {
-            lua_pushlstring(state, file.c_str(), file.length());
+            for (const dir_cache::entry& entry : *cached)
+            {
+                if ((entry.attr & FILE_ATTRIBUTE_HIDDEN) && !include_hidden)
+                    continue;
+                if ((entry.attr & FILE_ATTRIBUTE_SYSTEM) && !include_system)
+                    continue;
+
+                bool is_dir = (entry.attr & FILE_ATTRIBUTE_DIRECTORY) != 0;
+                if (dirs_only && !is_dir)
+                    continue;
+
+                file.copy(entry.name.c_str());
+                if (is_dir && suffix_dirs)
+                    file << PATH_SEP;
+
+                push_glob_entry(state, file, entry.attr, back_compat, type);
+                lua_rawseti(state, -2, i++);
+            }
+
+            return 1;
         }
-        else
-        {
-            lua_createtable(state, 0, 2);
+    }
 
-            lua_pushliteral(state, "name");
-            lua_pushlstring(state, file.c_str(), file.length());
-            lua_rawset(state, -3);
+    // Cache miss (or uncacheable mask); enumerate.  For cacheable masks the
+    // enumeration is unfiltered so the result can populate the cache, and the
+    // filtering happens inline below.
+    FILETIME write_time;
+    cacheable = cacheable && dir_cache::snapshot(dir.c_str(), write_time);
+    auto fresh = std::make_shared<dir_cache::listing>();
 
-            type.clear();
-            add_type_tag(type, (attr & FILE_ATTRIBUTE_DIRECTORY) ? "dir" : "file");
-            if (attr & FILE_ATTRIBUTE_HIDDEN)
-                add_type_tag(type, "hidden");
-            if (attr & FILE_ATTRIBUTE_READONLY)
-                add_type_tag(type, "readonly");
-            lua_pushliteral(state, "type");
-            lua_pushlstring(state, type.c_str(), type.length());
-            lua_rawset(state, -3);
+    globber globber(mask);
+    globber.files(!dirs_only || cacheable);
+    globber.hidden(include_hidden || cacheable);
+    globber.system(include_system || cacheable);
+    globber.suffix_dirs(false);
+
+    // st_mode is only needed to populate the directory cache; the Lua-facing
+    // result is built from the attributes alone.
+    int st_mode;
+    int attr;
+    while (globber.next(file, false, cacheable ? &st_mode : nullptr, &attr))
+    {
+        if (cacheable)
+        {
+            fresh->emplace_back();
+            dir_cache::entry& stored = fresh->back();
+            stored.name.copy(file.c_str());
+            stored.st_mode = st_mode;
+            stored.attr = attr;
+
+            if ((attr & FILE_ATTRIBUTE_HIDDEN) && !include_hidden)
+                continue;
+            if ((attr & FILE_ATTRIBUTE_SYSTEM) && !include_system)
+                continue;
         }
 
+        bool is_dir = (attr & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        if (dirs_only && !is_dir)
+            continue;
+
+        if (is_dir && suffix_dirs)
+            file << PATH_SEP;
+
+        push_glob_entry(state, file, attr, back_compat, type);
         lua_rawseti(state, -2, i++);
     }
 
+    if (cacheable)
+        dir_cache::store(dir.c_str(), fresh, write_time);
+
     return 1;
 }
 
@@ -308,6 +432,97 @@ int glob_files(lua_State* state)
     return glob_impl(state, false);
 }
 
+//------------------------------------------------------------------------------
+// Userdata wrapping a live globber for the iterator forms.  Destruction is
+// driven by Lua's collector via __gc, so the find handle gets closed even
+// when a loop exits early.
+struct globber_userdata
+{
+    globber_userdata(const char* pattern) : inner(pattern) {}
+    globber         inner;
+    bool            extrainfo;
+};
+
+//------------------------------------------------------------------------------
+static int glob_iter_gc(lua_State* state)
+{
+    globber_userdata* ud = (globber_userdata*)lua_touserdata(state, 1);
+    if (ud != nullptr)
+        ud->~globber_userdata();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static int glob_iter_next(lua_State* state)
+{
+    globber_userdata* ud = (globber_userdata*)lua_touserdata(state, lua_upvalueindex(1));
+
+    str<288> file;
+    int attr;
+    if (!ud->inner.next(file, false, nullptr, &attr))
+        return 0;
+
+    str<16> type;
+    push_glob_entry(state, file, attr, !ud->extrainfo, type);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int glob_iter_impl(lua_State* state, bool dirs_only)
+{
+    const char* mask = get_string(state, 1);
+    if (mask == nullptr)
+        return 0;
+
+    bool extrainfo = lua_toboolean(state, 2);
+
+    globber_userdata* ud = (globber_userdata*)lua_newuserdata(state, sizeof(globber_userdata));
+    new (ud) globber_userdata(mask);
+    ud->inner.files(!dirs_only);
+    ud->inner.hidden(g_glob_hidden.get());
+    ud->inner.system(g_glob_system.get());
+    ud->inner.suffix_dirs(true);
+    ud->extrainfo = extrainfo;
+
+    if (luaL_newmetatable(state, "clink_globber"))
+    {
+        lua_pushcfunction(state, glob_iter_gc);
+        lua_setfield(state, -2, "__gc");
+    }
+    lua_setmetatable(state, -2);
+
+    lua_pushcclosure(state, glob_iter_next, 1);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  os.globdirsiter
+/// -arg:   globpattern:string
+/// -arg:   [extrainfo:boolean]
+/// -ret:   iterator
+/// Like <a href="#os.globdirs">os.globdirs()</a>, but returns an iterator
+/// function that yields one directory per call instead of collecting them all
+/// into a table first, so a loop can stop early without enumerating the rest:
+/// <pre><code class="lua">for dir in os.globdirsiter("*") do ... end</code></pre>
+int glob_dirs_iter(lua_State* state)
+{
+    return glob_iter_impl(state, true);
+}
+
+//------------------------------------------------------------------------------
+/// -name:  os.globfilesiter
+/// -arg:   globpattern:string
+/// -arg:   [extrainfo:boolean]
+/// -ret:   iterator
+/// Like <a href="#os.globfiles">os.globfiles()</a>, but returns an iterator
+/// function that yields one entry per call instead of collecting them all
+/// into a table first, so a loop can stop early without enumerating the rest:
+/// <pre><code class="lua">for file in os.globfilesiter("*") do ... end</code></pre>
+int glob_files_iter(lua_State* state)
+{
+    return glob_iter_impl(state, false);
+}
+
 //------------------------------------------------------------------------------
 /// -name:  os.getenv
 /// -arg:   name:string
@@ -358,15 +573,57 @@ int set_env(lua_State* state)
 /// <span class="tablescheme">{ {name:string, value:string}, ... }</span>.
 int get_env_names(lua_State* state)
 {
+    static const char* const cache_key = "clink_env_names";
+    static const char* const cache_revision_key = "clink_env_names_revision";
+
+    // Serve repeated enumerations from a cached table; %-completion calls
+    // this per keystroke while a variable name is typed.  The revision ties
+    // the cache to the environment snapshot, which the host refreshes each
+    // prompt and drops on os.setenv.
+    const unsigned int revision = os::get_env_revision();
+    if (revision)
+    {
+        lua_getfield(state, LUA_REGISTRYINDEX, cache_revision_key);
+        const bool fresh = (unsigned int(lua_tointeger(state, -1)) == revision);
+        lua_pop(state, 1);
+
+        if (fresh)
+        {
+            lua_getfield(state, LUA_REGISTRYINDEX, cache_key);
+            if (lua_istable(state, -1))
+                return 1;
+            lua_pop(state, 1);
+        }
+    }
+
     lua_createtable(state, 0, 0);
 
+    str<128> var;
+    int i = 1;
+    if (revision)
+    {
+        for (unsigned int index = 0; os::get_env_name(index, var); ++index)
+        {
+            // Skip env vars that start with a '='. They're hidden ones.
+            if (var.c_str()[0] == '=')
+                continue;
+
+            lua_pushlstring(state, var.c_str(), var.length());
+            lua_rawseti(state, -2, i++);
+        }
+
+        lua_pushvalue(state, -1);
+        lua_setfield(state, LUA_REGISTRYINDEX, cache_key);
+        lua_pushinteger(state, revision);
+        lua_setfield(state, LUA_REGISTRYINDEX, cache_revision_key);
+        return 1;
+    }
+
     WCHAR* root = GetEnvironmentStringsW();
     if (root == nullptr)
         return 1;
 
-    str<128> var;
     WCHAR* strings = root;
-    int i = 1;
     while (*strings)
     {
         // Skip env vars that start with a '='. They're hidden ones.
@@ -502,28 +759,38 @@ int get_aliases(lua_State* state)
 int get_screen_info(lua_State* state)
 {
     int i;
-    int buffer_width, buffer_height;
-    int window_width, window_height;
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
 
     struct table_t {
         const char* name;
         int         value;
     };
 
-    GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
-    buffer_width = csbi.dwSize.X;
-    buffer_height = csbi.dwSize.Y;
-    window_width = csbi.srWindow.Right - csbi.srWindow.Left;
-    window_height = csbi.srWindow.Bottom - csbi.srWindow.Top;
+    // Prompt filters and display scripts query this repeatedly per prompt;
+    // cache the console metrics under the terminal's resize generation so
+    // only the first query per generation leaves the process.
+    static unsigned int s_generation = 0;
+    static int s_buffer_width, s_buffer_height;
+    static int s_window_width, s_window_height;
+
+    const unsigned int generation = get_screen_metrics_generation();
+    if (generation != s_generation)
+    {
+        CONSOLE_SCREEN_BUFFER_INFO csbi;
+        GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
+        s_buffer_width = csbi.dwSize.X;
+        s_buffer_height = csbi.dwSize.Y;
+        s_window_width = csbi.srWindow.Right - csbi.srWindow.Left;
+        s_window_height = csbi.srWindow.Bottom - csbi.srWindow.Top;
+        s_generation = generation;
+    }
 
     lua_createtable(state, 0, 4);
     {
         struct table_t table[] = {
-            { "bufwidth", buffer_width },
-            { "bufheight", buffer_height },
-            { "winwidth", window_width },
-            { "winheight", window_height },
+            { "bufwidth", s_buffer_width },
+            { "bufheight", s_buffer_height },
+            { "winwidth", s_window_width },
+            { "winheight", s_window_height },
         };
 
         for (i = 0; i < sizeof_array(table); ++i)
@@ -600,11 +867,14 @@ void os_lua_initialise(lua_state& lua)
         { "isdir",       &is_dir },
         { "isfile",      &is_file },
         { "ishidden",    &is_hidden },
+        { "getfiletime", &get_file_time },
         { "unlink",      &unlink },
         { "move",        &move },
         { "copy",        &copy },
         { "globdirs",    &glob_dirs },
+        { "globdirsiter", &glob_dirs_iter },
         { "globfiles",   &glob_files },
+        { "globfilesiter", &glob_files_iter },
         { "getenv",      &get_env },
         { "setenv",      &set_env },
         { "getenvnames", &get_env_names },
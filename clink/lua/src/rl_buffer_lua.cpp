@@ -6,6 +6,8 @@
 #include "lua_state.h"
 #include "lib/line_buffer.h"
 
+#include <core/base.h>
+
 extern "C" {
 #include <lua.h>
 #include <lauxlib.h>
@@ -13,6 +15,7 @@ extern "C" {
 #include <readline/readline.h>
 extern void _rl_move_vert(int);
 extern int _rl_vis_botlin;
+extern unsigned long rl_buffer_changes;
 }
 
 #include <assert.h>
@@ -20,6 +23,7 @@ extern int _rl_vis_botlin;
 //------------------------------------------------------------------------------
 static rl_buffer_lua::method g_methods[] = {
     { "getbuffer",      &rl_buffer_lua::get_buffer },
+    { "getchanges",     &rl_buffer_lua::get_changes },
     { "getlength",      &rl_buffer_lua::get_length },
     { "getcursor",      &rl_buffer_lua::get_cursor },
     { "setcursor",      &rl_buffer_lua::set_cursor },
@@ -56,11 +60,54 @@ rl_buffer_lua::~rl_buffer_lua()
 
 //------------------------------------------------------------------------------
 /// -name:  rl_buffer:getbuffer
+/// -arg:   [from:integer]
+/// -arg:   [to:integer]
 /// -ret:   string
-/// Returns the current input line.
+/// Returns the current input line.  When <span class="arg">from</span> and
+/// <span class="arg">to</span> are given, returns only that slice of the
+/// input line (1-based, inclusive); a per-keystroke script can use this
+/// together with rl_buffer:getchanges() to avoid copying the whole line.
+///
+/// Note:  the input line is UTF8, and slicing in the middle of a multi-byte
+/// Unicode character may have undesirable results.
 int rl_buffer_lua::get_buffer(lua_State* state)
 {
-    lua_pushlstring(state, m_rl_buffer.get_buffer(), m_rl_buffer.get_length());
+    const char* buffer = m_rl_buffer.get_buffer();
+    unsigned int length = m_rl_buffer.get_length();
+
+    unsigned int from = 0;
+    unsigned int to = length;
+    if (lua_isnumber(state, 1))
+    {
+        int n = int(lua_tointeger(state, 1)) - 1;
+        from = min<unsigned int>((n < 0) ? 0 : n, length);
+    }
+    if (lua_isnumber(state, 2))
+    {
+        int n = int(lua_tointeger(state, 2));
+        to = min<unsigned int>((n < 0) ? 0 : n, length);
+    }
+    if (to < from)
+        to = from;
+
+    lua_pushlstring(state, buffer + from, to - from);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  rl_buffer:getchanges
+/// -ret:   integer
+/// Returns a counter that is incremented whenever the contents of the input
+/// line change.  A script that polls the input line (e.g. from an input hook
+/// that runs on every keystroke) can compare this against the value it saw
+/// last time and skip its work when nothing has changed, instead of copying
+/// and comparing the whole line.
+///
+/// The counter is not meaningful across sessions; only compare values
+/// obtained from the same session.
+int rl_buffer_lua::get_changes(lua_State* state)
+{
+    lua_pushinteger(state, lua_Integer(rl_buffer_changes));
     return 1;
 }
 
@@ -19,6 +19,7 @@ public:
                             ~rl_buffer_lua();
 
     int                     get_buffer(lua_State* state);
+    int                     get_changes(lua_State* state);
     int                     get_length(lua_State* state);
     int                     get_cursor(lua_State* state);
     int                     set_cursor(lua_State* state);
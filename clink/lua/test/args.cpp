@@ -675,3 +675,79 @@ TEST_CASE("Lua arg parsers.")
         }
     }
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua arg parser cache.")
+{
+    fs_fixture fs;
+
+    line_editor::desc desc(nullptr, nullptr, nullptr);
+
+    // Build a matcher and capture it, the way the host does right after
+    // running an argmatcher-only script ("file1" stands in for the script).
+    {
+        lua_state lua;
+        lua_match_generator lua_generator(lua);
+
+        const char* script = "\
+            os.setenv('=clink.profile', os.getcwd())\
+            sub = clink.argmatcher():addarg('five', 'six'):loop():nofiles()\
+            clink.argmatcher('cachecmd')\
+            :addflags('-x', '-y')\
+            :addarg('one', 'two' .. sub)\
+            :nofiles()\
+            clink._save_argmatcher_cache('file1', { 'cachecmd' })\
+            clink._flush_argmatcher_cache()\
+        ";
+
+        REQUIRE(lua.do_string(script));
+    }
+
+    // A fresh state has no matchers; installing from the cache must satisfy
+    // completions without the defining script ever running.
+    lua_state lua;
+    lua_match_generator lua_generator(lua);
+
+    line_editor_tester tester(desc);
+    tester.get_editor()->add_generator(lua_generator);
+
+    REQUIRE(lua.do_string("\
+        if not clink._load_argmatcher_cache('file1', { 'cachecmd' }) then\
+            error('cache miss')\
+        end\
+    "));
+
+    SECTION("Args")
+    {
+        tester.set_input("cachecmd ");
+        tester.set_expected_matches("one", "two");
+        tester.run();
+    }
+
+    SECTION("Flags")
+    {
+        tester.set_input("cachecmd -");
+        tester.set_expected_matches("-x", "-y");
+        tester.run();
+    }
+
+    SECTION("Linked loop")
+    {
+        tester.set_input("cachecmd two five ");
+        tester.set_expected_matches("five", "six");
+        tester.run();
+    }
+
+    SECTION("Refuses to overwrite")
+    {
+        // The command is registered now; running the script would merge into
+        // the existing matcher, so installing over it must be refused.
+        REQUIRE(lua.do_string("\
+            if clink._load_argmatcher_cache('file1', { 'cachecmd' }) then\
+                error('should have refused')\
+            end\
+        "));
+    }
+
+    REQUIRE(lua.do_string("os.setenv('=clink.profile', nil)"));
+}
@@ -5,7 +5,7 @@
 
 typedef void (__stdcall *hookptr_t)();
 
-hookptr_t hook_iat(void* base, const char* dll, const char* func_name, hookptr_t hook, int find_by_name);
+hookptr_t hook_iat(void* base, const char* dll, const char* func_name, hookptr_t hook, int find_by_name, int flush=1);
 
 struct repair_iat_node;
 
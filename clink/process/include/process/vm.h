@@ -42,3 +42,16 @@ public:
 private:
     void*               m_handle;
 };
+
+//------------------------------------------------------------------------------
+// While an instance is in scope, current-process protection queries
+// (vm::get_access) are memoized and vm::set_access keeps the memoized pages in
+// step, so a batch of hooks probing and restoring the same few IAT pages costs
+// one VirtualQueryEx instead of one per hook.  The scope must not span code
+// that changes page protection behind vm's back.
+class vm_access_cache_scope
+{
+public:
+                        vm_access_cache_scope();
+                        ~vm_access_cache_scope();
+};
@@ -47,7 +47,8 @@ hookptr_t hook_iat(
     const char* dll,
     const char* func_name,
     hookptr_t hook,
-    int find_by_name
+    int find_by_name,
+    int flush
 )
 {
     LOG("Attempting to hook IAT for module %p", base);
@@ -83,7 +84,10 @@ hookptr_t hook_iat(
     hookptr_t prev_addr = *import;
     write_addr(import, hook);
 
-    vm().flush_icache();
+    // Callers applying a batch of hooks pass flush=0 and flush once at the
+    // end instead of once per hook.
+    if (flush)
+        vm().flush_icache();
     return prev_addr;
 }
 
@@ -177,8 +181,31 @@ bool add_repair_iat_node(
 
 void apply_repair_iat_list(repair_iat_node*& list)
 {
+    if (!list)
+        return;
+
     vm vm;
 
+    // The nodes all point into the same module's IAT, which is a contiguous
+    // table with uniform page protection, so open a single write window
+    // spanning the entries instead of flipping protection once per entry.
+    hookptr_t* lo = list->m_iat;
+    hookptr_t* hi = list->m_iat;
+    for (repair_iat_node* r = list; r != nullptr; r = r->m_next)
+    {
+        if (r->m_iat < lo)
+            lo = r->m_iat;
+        if (r->m_iat > hi)
+            hi = r->m_iat;
+    }
+
+    char* lo_page = (char*)vm.get_page(lo);
+    char* hi_page = (char*)vm.get_page(hi);
+    unsigned int page_count = (unsigned int)((hi_page - lo_page) / vm.get_page_size()) + 1;
+    vm::region region = { lo_page, page_count };
+    unsigned int prev_access = vm.get_access(region);
+    vm.set_access(region, vm::access_write);
+
     while (list)
     {
         repair_iat_node* r = list;
@@ -186,11 +213,13 @@ void apply_repair_iat_list(repair_iat_node*& list)
 
         // TODO: need to somehow preserve prev_addr in order for detach to work correctly.
         hookptr_t prev_addr = *r->m_iat;
-        write_addr(r->m_iat, r->m_trampoline);
+        if (!vm.write(r->m_iat, &r->m_trampoline, sizeof(r->m_trampoline)))
+            LOG("VM write to %p failed (err = %d)", r->m_iat, GetLastError());
 
         delete r;
     }
 
+    vm.set_access(region, prev_access);
     vm.flush_icache();
 }
 
@@ -115,6 +115,30 @@ pe_info::funcptr_t pe_info::get_export(const char* func_name) const
     WORD* ordinals = (WORD*)rva_to_addr(ied->AddressOfNameOrdinals);
     DWORD* addresses = (DWORD*)rva_to_addr(ied->AddressOfFunctions);
 
+    // The PE spec keeps AddressOfNames lexically sorted (it's what makes
+    // GetProcAddress fast), so binary search it the same way the loader
+    // does.  System DLLs export thousands of names; kernel32 alone has
+    // ~1600 and the linear walk was paying ~half of them per lookup.
+    int lo = 0;
+    int hi = int(ied->NumberOfNames) - 1;
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) / 2;
+        const char* export_name = (const char*)rva_to_addr(names[mid]);
+        int cmp = strcmp(func_name, export_name);
+        if (cmp == 0)
+        {
+            WORD ordinal = ordinals[mid];
+            return funcptr_t(rva_to_addr(addresses[ordinal]));
+        }
+        else if (cmp < 0)
+            hi = mid - 1;
+        else
+            lo = mid + 1;
+    }
+
+    // Fall back to a linear case-insensitive walk, as before, in case a
+    // module's export names aren't sorted (packers sometimes break this).
     for (int i = 0; i < int(ied->NumberOfNames); ++i)
     {
         const char* export_name = (const char*)rva_to_addr(names[i]);
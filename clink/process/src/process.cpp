@@ -24,12 +24,21 @@ process::process(int pid)
 //------------------------------------------------------------------------------
 int process::get_parent_pid() const
 {
-    LONG (WINAPI *NtQueryInformationProcess)(HANDLE, ULONG, PVOID, ULONG, PULONG);
-
-    *(FARPROC*)&NtQueryInformationProcess = GetProcAddress(
-        LoadLibraryA("ntdll.dll"),
-        "NtQueryInformationProcess"
-    );
+    // Parent discovery walks a chain of these calls (one per ancestor), so
+    // resolve the export once instead of per query.  Deliberately not a
+    // toolhelp snapshot walk:  NtQueryInformationProcess answers for the one
+    // process asked about, where a snapshot enumerates every process on the
+    // machine to find it.
+    typedef LONG (WINAPI *NtQueryInformationProcessFunc)(HANDLE, ULONG, PVOID, ULONG, PULONG);
+    static int s_initialized = 0;
+    static NtQueryInformationProcessFunc NtQueryInformationProcess = nullptr;
+    if (!s_initialized)
+    {
+        HMODULE hdll = GetModuleHandle("ntdll.dll");
+        NtQueryInformationProcess = (NtQueryInformationProcessFunc)GetProcAddress(
+            hdll, "NtQueryInformationProcess");
+        s_initialized = NtQueryInformationProcess ? 1 : -1;
+    }
 
     if (NtQueryInformationProcess != nullptr)
     {
@@ -135,6 +144,14 @@ void process::pause(bool suspend)
 //------------------------------------------------------------------------------
 void* process::inject_module(const char* dll_path)
 {
+    // LoadLibraryW in the target is deliberately the whole injection story.
+    // Hand-mapping the DLL from a pre-created section looks like it would be
+    // cheaper per process, but the OS already backs a loaded DLL with one
+    // image section whose pages are shared machine-wide; repeat loads mostly
+    // cost soft page faults plus per-process import fixups. Bypassing the
+    // loader would give up TLS, exception tables, CRT initialization, and
+    // module accounting for a saving that doesn't materialize.
+
     // Check we can inject into the target.
     if (process().get_arch() != get_arch())
         return nullptr;
@@ -4,7 +4,10 @@
 #include "pch.h"
 #include "vm.h"
 
+#include <core/base.h>
+
 #include <Windows.h>
+#include <string.h>
 
 //------------------------------------------------------------------------------
 static unsigned int g_alloc_granularity = 0;
@@ -43,6 +46,44 @@ static unsigned int to_ms_flags(unsigned int access_flags)
 
 
 
+//------------------------------------------------------------------------------
+// See vm_access_cache_scope in vm.h.  Each entry memoizes the protection of
+// one queried page; hooking only ever touches a couple of distinct IAT pages
+// so a small linear table suffices.
+struct cached_access
+{
+    void*                   page;
+    unsigned int            protect;
+};
+static cached_access        g_cached_access[16];
+static unsigned int         g_cached_access_count = 0;
+static int                  g_access_cache_refs = 0;
+
+//------------------------------------------------------------------------------
+static cached_access* find_cached_access(void* page)
+{
+    for (unsigned int i = 0; i < g_cached_access_count; ++i)
+        if (g_cached_access[i].page == page)
+            return g_cached_access + i;
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+vm_access_cache_scope::vm_access_cache_scope()
+{
+    if (!g_access_cache_refs++)
+        g_cached_access_count = 0;
+}
+
+//------------------------------------------------------------------------------
+vm_access_cache_scope::~vm_access_cache_scope()
+{
+    --g_access_cache_refs;
+}
+
+
+
 //------------------------------------------------------------------------------
 vm::vm(int pid)
 {
@@ -130,6 +171,10 @@ void vm::free(const region& region)
     if (m_handle == nullptr)
         return;
 
+    // Freed pages can be reused with different protection; forget them.
+    if (g_access_cache_refs && m_handle == GetCurrentProcess())
+        g_cached_access_count = 0;
+
     size_t size = region.page_count * get_page_size();
     VirtualFreeEx(m_handle, region.base, size, MEM_RELEASE);
 }
@@ -140,9 +185,22 @@ int vm::get_access(const region& region)
     if (m_handle == nullptr)
         return -1;
 
+    const bool use_cache = (g_access_cache_refs && m_handle == GetCurrentProcess());
+    if (use_cache)
+        if (const cached_access* hit = find_cached_access(region.base))
+            return to_access_flags(hit->protect);
+
     MEMORY_BASIC_INFORMATION mbi;
     if (VirtualQueryEx(m_handle, region.base, &mbi, sizeof(mbi)))
+    {
+        if (use_cache && g_cached_access_count < sizeof_array(g_cached_access))
+        {
+            cached_access& entry = g_cached_access[g_cached_access_count++];
+            entry.page = region.base;
+            entry.protect = mbi.Protect;
+        }
         return to_access_flags(mbi.Protect);
+    }
 
     return -1;
 }
@@ -155,7 +213,22 @@ void vm::set_access(const region& region, unsigned int access)
 
     DWORD ms_flags = to_ms_flags(access);
     size_t size = region.page_count * get_page_size();
-    VirtualProtectEx(m_handle, region.base, size, ms_flags, &ms_flags);
+    DWORD prev_flags;
+    if (!VirtualProtectEx(m_handle, region.base, size, ms_flags, &prev_flags))
+        return;
+
+    // Keep memoized pages in step with the change (see vm_access_cache_scope).
+    if (g_access_cache_refs && m_handle == GetCurrentProcess())
+    {
+        char* begin = (char*)get_page(region.base);
+        char* end = (char*)region.base + size;
+        for (unsigned int i = 0; i < g_cached_access_count; ++i)
+        {
+            char* page = (char*)g_cached_access[i].page;
+            if (page >= begin && page < end)
+                g_cached_access[i].protect = ms_flags;
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -164,6 +237,14 @@ bool vm::read(void* dest, const void* src, size_t size)
     if (m_handle == nullptr)
         return false;
 
+    // Accessing the current process needs no kernel transition; hooking makes
+    // many small reads and writes and each *ProcessMemory call is a syscall.
+    if (m_handle == GetCurrentProcess())
+    {
+        memcpy(dest, src, size);
+        return true;
+    }
+
     return (ReadProcessMemory(m_handle, src, dest, size, nullptr) != FALSE);
 }
 
@@ -173,6 +254,14 @@ bool vm::write(void* dest, const void* src, size_t size)
     if (m_handle == nullptr)
         return false;
 
+    // See read(); callers make the destination writeable via set_access()
+    // before writing, so a plain copy is equivalent in-process.
+    if (m_handle == GetCurrentProcess())
+    {
+        memcpy(dest, src, size);
+        return true;
+    }
+
     return (WriteProcessMemory(m_handle, dest, src, size, nullptr) != FALSE);
 }
 
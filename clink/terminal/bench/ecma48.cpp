@@ -0,0 +1,28 @@
+// Copyright (c) 2021 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/str.h>
+#include <terminal/ecma48_iter.h>
+
+//------------------------------------------------------------------------------
+BENCH_CASE("ecma48_iter")
+{
+    static ecma48_state s_state;
+
+    // A prompt-like mix of plain text runs and CSI sequences.
+    str<> input;
+    for (int i = 0; i < 64; ++i)
+        input << "\x1b[0;1;36mclink\x1b[m \x1b[33mc:\\some\\path\x1b[m plain text run ";
+
+    const unsigned int iterations = 50000;
+
+    ctx.measure("next", iterations, [&] () {
+        ecma48_iter iter(input.c_str(), s_state, input.length());
+        unsigned int codes = 0;
+        while (iter.next())
+            ++codes;
+        bench::consume(codes);
+    });
+}
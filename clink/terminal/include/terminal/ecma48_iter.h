@@ -99,6 +99,18 @@ private:
     unsigned short          m_length;
     type                    m_type;
     unsigned char           m_code;
+
+    // CSI parameters, decoded by ecma48_iter as the bytes stream through it
+    // so decode_csi() doesn't have to make a second pass over the buffer.
+    // When a code carries more parameters than fit here m_params_decoded is
+    // false and decode_csi() falls back to re-parsing the buffered text.
+    enum { max_decoded_params = 16 };
+    int                     m_params[max_decoded_params];
+    unsigned char           m_param_count;
+    char                    m_intermediate;
+    char                    m_final;
+    bool                    m_private_use;
+    bool                    m_params_decoded;
 };
 
 //------------------------------------------------------------------------------
@@ -131,6 +143,12 @@ private:
     ecma48_code         code;
     ecma48_state_enum   state;
     int                 count;
+    // In-flight CSI parameter accumulation; the decoded results land in
+    // code's m_params et al.  Lives here rather than in the iterator so a
+    // code split across input chunks keeps accumulating.
+    int                 csi_param;
+    bool                csi_begun;
+    bool                csi_pending_param;
     char                buffer[64];
 };
 
@@ -145,7 +163,6 @@ public:
 
 private:
     bool                next_c1();
-    bool                next_char(int c);
     bool                next_char_str(int c);
     bool                next_cmd_str(int c);
     bool                next_csi_f(int c);
@@ -153,6 +170,7 @@ private:
     bool                next_esc(int c);
     bool                next_esc_st(int c);
     bool                next_unknown(int c);
+    void                push_csi_param();
     str_iter            m_iter;
     ecma48_code&        m_code;
     ecma48_state&       m_state;
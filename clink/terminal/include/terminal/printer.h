@@ -32,6 +32,8 @@ public:
     int                     find_line(int starting_line, int distance, const char* text, find_line_mode mode, const BYTE* attrs=nullptr, int num_attrs=0, BYTE mask=0xff) const;
     attributes              set_attributes(const attributes attr);
     attributes              get_attributes() const;
+    void                    push_attributes(const attributes attr);
+    void                    pop_attributes();
 
 private: /* TODO: unimplemented API */
     typedef unsigned int    cursor_state;
@@ -45,6 +47,8 @@ private:
     terminal_out&           m_terminal;
     attributes              m_set_attr;
     attributes              m_next_attr;
+    attributes              m_attr_stack[8];
+    unsigned char           m_attr_stack_depth;
     bool                    m_nodiff;
 };
 
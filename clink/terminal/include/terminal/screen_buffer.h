@@ -46,3 +46,10 @@ public:
 //------------------------------------------------------------------------------
 void visible_bell();
 void set_console_title(const char* title);
+
+//------------------------------------------------------------------------------
+// Generation counter for screen metrics (buffer and window dimensions).  The
+// terminal bumps it when it notices the console was resized, so callers can
+// cache metrics and requery only when the generation has moved on.
+unsigned int get_screen_metrics_generation();
+void next_screen_metrics_generation();
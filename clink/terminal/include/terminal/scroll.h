@@ -8,6 +8,15 @@ void set_scrolled_screen_buffer();
 bool is_scroll_mode();
 void reset_scroll_mode();
 
+//------------------------------------------------------------------------------
+// While a scroll transaction is open, relative scroll requests made with
+// coalesce=true accumulate their deltas instead of each issuing console calls;
+// end_scroll_transaction() applies the combined delta with a single console
+// window move.  Used around input bursts so holding a scroll key costs one
+// console round trip per drain instead of one per key.
+void begin_scroll_transaction();
+void end_scroll_transaction();
+
 //------------------------------------------------------------------------------
 enum SCRMODE
 {
@@ -16,4 +25,4 @@ enum SCRMODE
     SCR_TOEND,
     SCR_ABSOLUTE,
 };
-int ScrollConsoleRelative(HANDLE h, int direction, SCRMODE mode);
+int ScrollConsoleRelative(HANDLE h, int direction, SCRMODE mode, bool coalesce=false);
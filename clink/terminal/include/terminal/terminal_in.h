@@ -20,6 +20,12 @@ public:
     virtual void    begin() = 0;
     virtual void    end() = 0;
     virtual void    select() = 0;
+    // Waits at most timeout_ms for input; used when the caller has background
+    // work to get on with.  Implementations without timeout support block.
+    virtual void    select(unsigned int timeout_ms) { select(); }
     virtual int     read() = 0;
+    // Returns true when more input is already waiting to be read; callers can
+    // defer expensive per-key work until a burst of input (a paste) drains.
+    virtual bool    more_input_available() const { return false; }
     virtual key_tester* set_key_tester(key_tester* keys) = 0;
 };
@@ -5,6 +5,8 @@
 #include "cielab.h"
 
 #include <math.h>
+#include <float.h>
+#include <emmintrin.h>
 
 //------------------------------------------------------------------------------
 struct xyz
@@ -116,4 +118,58 @@ float deltaE(COLORREF c1, COLORREF c2)
     return deltaE(lab1, lab2);
 }
 
+//------------------------------------------------------------------------------
+void lab4::set(int lane, const lab& lab)
+{
+    l[lane] = float(lab.l);
+    a[lane] = float(lab.a);
+    b[lane] = float(lab.b);
+}
+
+//------------------------------------------------------------------------------
+int nearest(const lab& target, const lab4* palette, int groups)
+{
+    if (groups <= 0)
+        return -1;
+
+    const __m128 tl = _mm_set1_ps(float(target.l));
+    const __m128 ta = _mm_set1_ps(float(target.a));
+    const __m128 tb = _mm_set1_ps(float(target.b));
+    const __m128 four = _mm_set1_ps(4.0f);
+
+    // Track the best squared distance and its entry index per lane; sqrt is
+    // monotonic so comparing squared distances picks the same entry.
+    __m128 best = _mm_set1_ps(FLT_MAX);
+    __m128 best_index = _mm_setzero_ps();
+    __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+    for (int g = 0; g < groups; ++g)
+    {
+        __m128 dl = _mm_sub_ps(_mm_loadu_ps(palette[g].l), tl);
+        __m128 da = _mm_sub_ps(_mm_loadu_ps(palette[g].a), ta);
+        __m128 db = _mm_sub_ps(_mm_loadu_ps(palette[g].b), tb);
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dl, dl),
+                                          _mm_mul_ps(da, da)),
+                               _mm_mul_ps(db, db));
+
+        __m128 lt = _mm_cmplt_ps(d2, best);
+        best = _mm_min_ps(best, d2);
+        best_index = _mm_or_ps(_mm_and_ps(lt, index),
+                               _mm_andnot_ps(lt, best_index));
+        index = _mm_add_ps(index, four);
+    }
+
+    // Reduce the four per-lane minima.
+    float dist[4];
+    float idx[4];
+    _mm_storeu_ps(dist, best);
+    _mm_storeu_ps(idx, best_index);
+
+    int best_lane = 0;
+    for (int lane = 1; lane < 4; ++lane)
+        if (dist[lane] < dist[best_lane])
+            best_lane = lane;
+    return int(idx[best_lane]);
+}
+
 };
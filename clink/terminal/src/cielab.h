@@ -27,9 +27,25 @@ inline double pow2(double x)
     return x * x;
 }
 
+//------------------------------------------------------------------------------
+// Four Lab entries in structure-of-arrays form, one SSE float lane each, for
+// the batch nearest-entry search below.
+struct lab4
+{
+    void set(int lane, const lab& lab);
+
+    float l[4];
+    float a[4];
+    float b[4];
+};
+
 //------------------------------------------------------------------------------
 float deltaE2(const lab& lab1, const lab& lab2);    // squared
 float deltaE(const lab& lab1, const lab& lab2);     // sqrt()
 float deltaE(COLORREF c1, COLORREF c2);
 
+// Returns the index of the palette entry nearest to 'target', measuring four
+// squared Lab distances per step with SSE2.  Returns -1 if 'groups' is zero.
+int nearest(const lab& target, const lab4* palette, int groups);
+
 };
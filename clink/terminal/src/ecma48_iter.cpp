@@ -8,6 +8,8 @@
 #include <core/str_tokeniser.h>
 
 #include <assert.h>
+#include <emmintrin.h>
+#include <intrin.h>
 
 //------------------------------------------------------------------------------
 unsigned int cell_count(const char* in)
@@ -62,6 +64,56 @@ static void strip_code_quotes(const char*& ptr, int& len)
 
 
 
+//------------------------------------------------------------------------------
+// Returns the first byte in [begin, end) that can't be part of a command
+// string's payload (anything outside 0x08..0x0d and 0x20..0x7e).  That covers
+// the BEL/ESC/0x9c terminators and any byte that resets the state, so OSC and
+// DCS payloads (window titles, hyperlinks) are skipped 16 bytes at a time
+// instead of one trip through the state machine per byte.
+static const char* scan_cmd_str_run(const char* begin, const char* end)
+{
+    const __m128i base1 = _mm_set1_epi8(0x08);
+    const __m128i span1 = _mm_set1_epi8(0x0d - 0x08);
+    const __m128i base2 = _mm_set1_epi8(0x20);
+    const __m128i span2 = _mm_set1_epi8(0x7e - 0x20);
+
+    while (begin < end)
+    {
+        // Loads are aligned so they can't straddle a page boundary past the
+        // end of the buffer; the unaligned head and the tail go byte-wise.
+        if ((uintptr_t(begin) & 15) || (end - begin) < 16)
+        {
+            const unsigned char c = (unsigned char)*begin;
+            if (!in_range(c, 0x08, 0x0d) && !in_range(c, 0x20, 0x7e))
+                return begin;
+            ++begin;
+            continue;
+        }
+
+        // Unsigned (chunk - base) <= span, via min(chunk - base, span) ==
+        // chunk - base; bytes below the base wrap around past the span.
+        __m128i chunk = _mm_load_si128((const __m128i*)begin);
+        __m128i rel1 = _mm_sub_epi8(chunk, base1);
+        __m128i rel2 = _mm_sub_epi8(chunk, base2);
+        __m128i ok = _mm_or_si128(
+            _mm_cmpeq_epi8(_mm_min_epu8(rel1, span1), rel1),
+            _mm_cmpeq_epi8(_mm_min_epu8(rel2, span2), rel2));
+        int mask = _mm_movemask_epi8(ok) ^ 0xffff;
+        if (mask)
+        {
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            return begin + bit;
+        }
+
+        begin += 16;
+    }
+
+    return end;
+}
+
+
+
 //------------------------------------------------------------------------------
 enum ecma48_state_enum
 {
@@ -90,6 +142,24 @@ bool ecma48_code::decode_csi(csi_base& base, int* params, unsigned int max_param
     if (get_type() != type_c1 || get_code() != c1_csi)
         return false;
 
+    // The iterator already decoded the parameters while it was consuming the
+    // code's bytes; hand them out directly.  The text re-parse below is only
+    // needed when the code carried more parameters than fit in m_params.
+    if (m_params_decoded && get_length())
+    {
+        unsigned int count = m_param_count;
+        if (count > max_params)
+            count = max_params;
+        for (unsigned int i = 0; i < count; ++i)
+            params[i] = m_params[i];
+
+        base.final = m_final;
+        base.intermediate = m_intermediate;
+        base.private_use = m_private_use;
+        base.param_count = (unsigned char)count;
+        return true;
+    }
+
     /* CSI P ... P I .... I F */
     str_iter iter(get_pointer(), get_length());
 
@@ -290,9 +360,20 @@ const ecma48_code& ecma48_iter::next()
 
         assert(m_nested_cmd_str == 0 || m_state.state == ecma48_state_cmd_str);
 
+        // Fast path; a run of plain text only ends at a C0 control, and in
+        // utf-8 a C0 codepoint is always a single byte below 0x20. Scan the
+        // run 16 bytes at a time instead of decoding each codepoint.
+        if (m_state.state == ecma48_state_char)
+        {
+            const char* ptr = m_iter.get_pointer();
+            const char* end = ptr + m_iter.length();
+            m_iter.reset_pointer(scan_for_byte_below(ptr, end, 0x20));
+            m_code.m_type = ecma48_code::type_chars;
+            break;
+        }
+
         switch (m_state.state)
         {
-        case ecma48_state_char:     done = next_char(c);     break;
         case ecma48_state_char_str: done = next_char_str(c); break;
         case ecma48_state_cmd_str:  done = next_cmd_str(c);  break;
         case ecma48_state_csi_f:    done = next_csi_f(c);    break;
@@ -347,6 +428,15 @@ bool ecma48_iter::next_c1()
             return false;
 
         case 0x5b: /* csi */
+            // Begin streaming parameter accumulation (see decode_csi()).
+            m_code.m_param_count = 0;
+            m_code.m_intermediate = 0;
+            m_code.m_final = 0;
+            m_code.m_private_use = false;
+            m_code.m_params_decoded = true;
+            m_state.csi_param = 0;
+            m_state.csi_begun = false;
+            m_state.csi_pending_param = false;
             m_state.state = ecma48_state_csi_p;
             return false;
 
@@ -358,19 +448,6 @@ bool ecma48_iter::next_c1()
     return true;
 }
 
-//------------------------------------------------------------------------------
-bool ecma48_iter::next_char(int c)
-{
-    if (in_range(c, 0x00, 0x1f))
-    {
-        m_code.m_type = ecma48_code::type_chars;
-        return true;
-    }
-
-    m_iter.next();
-    return false;
-}
-
 //------------------------------------------------------------------------------
 bool ecma48_iter::next_char_str(int c)
 {
@@ -412,7 +489,16 @@ bool ecma48_iter::next_cmd_str(int c)
     }
     else if (in_range(c, 0x08, 0x0d) || in_range(c, 0x20, 0x7e))
     {
-        m_iter.next();
+        // Bulk-skip the rest of the payload run; everything that matters
+        // (terminators, nested ESC, resetting bytes) is outside these ranges.
+        // 'c' is a decoded codepoint, so check the raw byte before skipping
+        // raw bytes; a multi-byte sequence goes through next() as before.
+        const char* ptr = m_iter.get_pointer();
+        const unsigned char raw = (unsigned char)*ptr;
+        if (in_range(raw, 0x08, 0x0d) || in_range(raw, 0x20, 0x7e))
+            m_iter.reset_pointer(scan_cmd_str_run(ptr + 1, ptr + m_iter.length()));
+        else
+            m_iter.next();
         return false;
     }
 
@@ -429,30 +515,70 @@ bool ecma48_iter::next_csi_f(int c)
     if (in_range(c, 0x20, 0x2f))
     {
         m_iter.next();
+        m_code.m_intermediate = char(c);
         return false;
     }
     else if (in_range(c, 0x40, 0x7e))
     {
         m_iter.next();
+        m_code.m_final = char(c);
         return true;
     }
 
     // Reset
     m_code.m_str = m_iter.get_pointer();
     m_code.m_length = 0;
+    m_code.m_params_decoded = false;
     m_state.reset();
     return false;
 }
 
+//------------------------------------------------------------------------------
+void ecma48_iter::push_csi_param()
+{
+    if (m_code.m_param_count < sizeof_array(m_code.m_params))
+        m_code.m_params[m_code.m_param_count++] = m_state.csi_param;
+    else
+        m_code.m_params_decoded = false;
+
+    m_state.csi_param = 0;
+}
+
 //------------------------------------------------------------------------------
 bool ecma48_iter::next_csi_p(int c)
 {
     if (in_range(c, 0x30, 0x3f))
     {
         m_iter.next();
+
+        // Decode the parameter bytes as they stream through, so
+        // decode_csi() doesn't need a second pass over the buffer.
+        if (in_range(c, 0x30, 0x3b))
+        {
+            m_state.csi_pending_param = true;
+
+            if (c == 0x3b)
+                push_csi_param();
+            else if (c != 0x3a) // Blissfully gloss over ':' part of spec.
+                m_state.csi_param = (m_state.csi_param * 10) + (c - 0x30);
+        }
+        else if (!m_state.csi_begun)
+        {
+            // Only a leading 0x3c..0x3f byte tags the parameter string as
+            // private/experimental; later ones are ignored.
+            m_code.m_private_use = true;
+        }
+
+        m_state.csi_begun = true;
         return false;
     }
 
+    if (m_state.csi_pending_param)
+    {
+        push_csi_param();
+        m_state.csi_pending_param = false;
+    }
+
     m_state.state = ecma48_state_csi_f;
     return next_csi_f(c);
 }
@@ -74,10 +74,24 @@ void set_console_title(const char* title)
     SetConsoleTitleW(out.c_str());
 }
 
+//------------------------------------------------------------------------------
+// Starts at 1 so a zero-initialised cached generation always misses.
+static volatile long s_screen_metrics_generation = 1;
+
+unsigned int get_screen_metrics_generation()
+{
+    return (unsigned int)s_screen_metrics_generation;
+}
+
+void next_screen_metrics_generation()
+{
+    InterlockedIncrement(&s_screen_metrics_generation);
+}
+
 
 
 //------------------------------------------------------------------------------
-ecma48_terminal_out::ecma48_terminal_out(screen_buffer& screen)
+ecma48_terminal_out::ecma48_terminal_out(screen_buffer_impl& screen)
 : m_screen(screen)
 {
 }
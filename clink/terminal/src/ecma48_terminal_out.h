@@ -6,15 +6,30 @@
 #include "ecma48_iter.h"
 #include "terminal_out.h"
 
-class screen_buffer;
+#include <core/base.h>
+
+//------------------------------------------------------------------------------
+// A build only ever ships one screen_buffer implementation per target, so the
+// ecma48 layer binds to it by its concrete (final) type at compile time and
+// the per-fragment write calls resolve directly instead of through the
+// screen_buffer vtable.  A port with more than one implementation can define
+// ECMA48_GENERIC_SCREEN_BUFFER to dispatch through the interface again.
+#if defined(PLATFORM_WINDOWS) && !defined(ECMA48_GENERIC_SCREEN_BUFFER)
+#include "win_screen_buffer.h"
+typedef win_screen_buffer screen_buffer_impl;
+#else
+#include "screen_buffer.h"
+typedef screen_buffer screen_buffer_impl;
+#endif
+
 class str_base;
 
 //------------------------------------------------------------------------------
-class ecma48_terminal_out
+class ecma48_terminal_out final
     : public terminal_out
 {
 public:
-                        ecma48_terminal_out(screen_buffer& screen);
+                        ecma48_terminal_out(screen_buffer_impl& screen);
     virtual void        open() override;
     virtual void        begin() override;
     virtual void        end() override;
@@ -42,7 +57,7 @@ private:
     int                 build_pending(char c);
     void                reset_pending();
     ecma48_state        m_state;
-    screen_buffer&      m_screen;
+    screen_buffer_impl& m_screen;
     int                 m_ax;
     int                 m_encode_length;
     int                 m_pending = 0;
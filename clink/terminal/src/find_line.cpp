@@ -65,6 +65,15 @@ int find_line(HANDLE h, const CONSOLE_SCREEN_BUFFER_INFO& csbi,
     int start_found = 0;
     int len_found = csbi.dwSize.X;
 
+    // Rows are fetched a batch at a time; ReadConsoleOutputCharacterW wraps
+    // across rows, so one console round trip covers many rows.  Reading row
+    // by row makes the round trips dominate when scanning a tall buffer.
+    const int width = csbi.dwSize.X;
+    const int max_batch_rows = 32;
+    wstr_moveable batch;
+    int batch_top = 0;
+    int batch_rows = 0;
+
     while (distance != 0)
     {
         if (starting_line < 0 || starting_line >= csbi.dwSize.Y)
@@ -73,13 +82,32 @@ int find_line(HANDLE h, const CONSOLE_SCREEN_BUFFER_INFO& csbi,
         bool found_text = true;
         if (text)
         {
-            COORD coord = { 0, SHORT(starting_line) };
-            DWORD len = 0;
-            if (!ReadConsoleOutputCharacterW(h, chars_buffer, csbi.dwSize.X, coord, &len))
-                return -1;
-            if (len != csbi.dwSize.X)
-                return -1;
+            if (starting_line < batch_top || starting_line >= batch_top + batch_rows)
+            {
+                int rows = min<int>(max_batch_rows, (distance > 0) ? distance : -distance);
+                batch_top = (distance > 0) ? starting_line : starting_line - (rows - 1);
+                if (batch_top < 0)
+                {
+                    rows += batch_top;
+                    batch_top = 0;
+                }
+                if (batch_top + rows > csbi.dwSize.Y)
+                    rows = csbi.dwSize.Y - batch_top;
+                if (!batch.reserve(rows * width))
+                    return -2;
+
+                COORD coord = { 0, SHORT(batch_top) };
+                DWORD len = 0;
+                if (!ReadConsoleOutputCharacterW(h, batch.data(), rows * width, coord, &len))
+                    return -1;
+                if (len != DWORD(rows * width))
+                    return -1;
+                batch_rows = rows;
+            }
+
+            memcpy(chars_buffer, batch.data() + (starting_line - batch_top) * width, width * sizeof(*chars_buffer));
 
+            DWORD len = width;
             while (len > 0 && iswspace(chars_buffer[len - 1]))
                 len--;
             chars_buffer[len] = '\0';
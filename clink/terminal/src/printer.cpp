@@ -5,6 +5,7 @@
 #include "printer.h"
 #include "terminal_out.h"
 
+#include <core/base.h>
 #include <core/str.h>
 
 //------------------------------------------------------------------------------
@@ -29,6 +30,7 @@ void printer::reset()
 {
     m_set_attr = attributes::defaults;
     m_next_attr = attributes::defaults;
+    m_attr_stack_depth = 0;
     m_nodiff = false;
 }
 
@@ -191,6 +193,31 @@ attributes printer::get_attributes() const
     return m_next_attr;
 }
 
+//------------------------------------------------------------------------------
+void printer::push_attributes(const attributes attr)
+{
+    // Pushes past the stack's capacity still merge the attributes; the
+    // matching pops just can't restore until the depth is back in range.
+    if (m_attr_stack_depth < sizeof_array(m_attr_stack))
+        m_attr_stack[m_attr_stack_depth] = m_next_attr;
+    m_attr_stack_depth++;
+    set_attributes(attr);
+}
+
+//------------------------------------------------------------------------------
+void printer::pop_attributes()
+{
+    if (!m_attr_stack_depth)
+        return;
+
+    // The restore is lazy:  the diff against what the terminal was last told
+    // is emitted the next time something prints, so nested push/pop pairs
+    // cost SGR bytes only for state that actually changed.
+    m_attr_stack_depth--;
+    if (m_attr_stack_depth < sizeof_array(m_attr_stack))
+        m_next_attr = m_attr_stack[m_attr_stack_depth];
+}
+
 //------------------------------------------------------------------------------
 void printer::insert(int count)
 {
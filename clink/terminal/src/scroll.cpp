@@ -11,6 +11,14 @@ extern "C" int _rl_last_v_pos;
 //------------------------------------------------------------------------------
 static bool s_scroll_mode = false;
 
+//------------------------------------------------------------------------------
+// Scroll transaction state.  Lines and pages accumulate separately because
+// the page height isn't known until the flush reads the window size.
+static bool s_scroll_transaction = false;
+static HANDLE s_pending_scroll_handle = nullptr;
+static int  s_pending_scroll_lines = 0;
+static int  s_pending_scroll_pages = 0;
+
 //------------------------------------------------------------------------------
 bool is_scroll_mode()
 {
@@ -24,8 +32,76 @@ void reset_scroll_mode()
 }
 
 //------------------------------------------------------------------------------
-int ScrollConsoleRelative(HANDLE h, int direction, SCRMODE mode)
+static int flush_scroll_transaction()
+{
+    if (!s_pending_scroll_lines && !s_pending_scroll_pages)
+        return 0;
+
+    HANDLE h = s_pending_scroll_handle;
+    int lines = s_pending_scroll_lines;
+    int pages = s_pending_scroll_pages;
+    s_pending_scroll_lines = 0;
+    s_pending_scroll_pages = 0;
+
+    if (!lines)
+        return ScrollConsoleRelative(h, pages, SCR_BYPAGE);
+
+    if (pages)
+    {
+        CONSOLE_SCREEN_BUFFER_INFO csbiInfo;
+        if (!GetConsoleScreenBufferInfo(h, &csbiInfo))
+            return 0;
+        lines += pages * (csbiInfo.srWindow.Bottom - csbiInfo.srWindow.Top);
+    }
+
+    return ScrollConsoleRelative(h, lines, SCR_BYLINE);
+}
+
+//------------------------------------------------------------------------------
+void begin_scroll_transaction()
 {
+    s_scroll_transaction = true;
+}
+
+//------------------------------------------------------------------------------
+void end_scroll_transaction()
+{
+    s_scroll_transaction = false;
+    flush_scroll_transaction();
+}
+
+//------------------------------------------------------------------------------
+int ScrollConsoleRelative(HANDLE h, int direction, SCRMODE mode, bool coalesce)
+{
+    if (s_scroll_transaction)
+    {
+        if (coalesce && (mode == SCR_BYLINE || mode == SCR_BYPAGE))
+        {
+            // Accumulate the delta; end_scroll_transaction() applies the
+            // combined total in one console window move.
+            s_scroll_mode = true;
+            s_pending_scroll_handle = h;
+            if (mode == SCR_BYPAGE)
+                s_pending_scroll_pages += direction;
+            else
+                s_pending_scroll_lines += direction;
+            return direction;
+        }
+
+        // An absolute scroll supersedes any accumulated relative scrolls.
+        if (mode == SCR_TOEND || mode == SCR_ABSOLUTE)
+        {
+            s_pending_scroll_lines = 0;
+            s_pending_scroll_pages = 0;
+        }
+        else
+        {
+            // An immediate relative scroll (e.g. console.scroll() from a Lua
+            // command) applies on top of whatever is already pending.
+            flush_scroll_transaction();
+        }
+    }
+
     // Get the current screen buffer window position.
     CONSOLE_SCREEN_BUFFER_INFO csbiInfo;
     if (!GetConsoleScreenBufferInfo(h, &csbiInfo))
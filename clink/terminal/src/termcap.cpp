@@ -18,6 +18,21 @@ const char* const bindableEsc = "\x1b[27;27~";
 //------------------------------------------------------------------------------
 threadlocal static char gt_termcap_buffer[64];
 
+//------------------------------------------------------------------------------
+// Formatted motion strings, direct-mapped by the motion count.  Readline
+// calls tgoto() for every parameterized cursor operation during a redisplay,
+// and the same few (capability, count) pairs repeat constantly; formatting
+// each pair once and replaying the bytes skips the printf machinery.  The
+// capability is compared by content rather than pointer, since Readline hands
+// back its own copy of the string tgetstr() gave it.
+struct tgoto_cache_entry
+{
+    char            base[16];
+    int             y;
+    char            str[32];
+};
+threadlocal static tgoto_cache_entry gt_tgoto_cache[8];
+
 //------------------------------------------------------------------------------
 static int get_cap(const char* name)
 {
@@ -168,6 +183,20 @@ char* tgetstr(char* name, char** out)
 //------------------------------------------------------------------------------
 char* tgoto(char* base, int x, int y)
 {
+    size_t base_len = strlen(base);
+
+    tgoto_cache_entry& entry = gt_tgoto_cache[unsigned(y) & (sizeof_array(gt_tgoto_cache) - 1)];
+    if (base_len < sizeof_array(entry.base))
+    {
+        if (entry.y != y || strcmp(entry.base, base) != 0)
+        {
+            memcpy(entry.base, base, base_len + 1);
+            entry.y = y;
+            str_base(entry.str).format(base, y);
+        }
+        return entry.str;
+    }
+
     str_base(gt_termcap_buffer).format(base, y);
     return gt_termcap_buffer;
 }
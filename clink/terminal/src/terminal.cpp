@@ -15,9 +15,14 @@ terminal terminal_create(screen_buffer* screen)
 #if defined(PLATFORM_WINDOWS)
     terminal term;
     term.screen_owned = (screen == nullptr);
-    term.screen = screen ? screen : new win_screen_buffer();
+    // win_screen_buffer is the only screen_buffer implementation on Windows,
+    // so a caller-supplied screen is necessarily one; the concrete type lets
+    // ecma48_terminal_out bind to it at compile time (see its header).
+    win_screen_buffer* impl = screen ? static_cast<win_screen_buffer*>(screen)
+                                     : new win_screen_buffer();
+    term.screen = impl;
     term.in = new win_terminal_in();
-    term.out = new ecma48_terminal_out(*term.screen);
+    term.out = new ecma48_terminal_out(*impl);
     return term;
 #else
     return {};
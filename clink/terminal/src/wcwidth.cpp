@@ -61,6 +61,7 @@
 
 #include <pch.h>
 #include <wchar.h>
+#include <string.h>
 
 #include <map>
 
@@ -198,7 +199,7 @@ static const struct interval combining[] = {
  * in ISO 10646.
  */
 
-int mk_wcwidth(char32_t ucs)
+static int classify_wcwidth(char32_t ucs)
 {
   /* sorted list of non-overlapping intervals of non-spacing characters */
   /* generated by "uniset +cat=Me +cat=Mn +cat=Cf -00AD +1160-11FF +200B c" */
@@ -215,7 +216,7 @@ int mk_wcwidth(char32_t ucs)
 
   /* if we arrive here, ucs is not a combining or C0/C1 control character */
 
-  return 1 + 
+  return 1 +
     (ucs >= 0x1100 &&
      (ucs <= 0x115f ||                    /* Hangul Jamo init. consonants */
       ucs == 0x2329 || ucs == 0x232a ||
@@ -232,6 +233,74 @@ int mk_wcwidth(char32_t ucs)
 }
 
 
+/* Direct-index width tables, built once from classify_wcwidth() above so
+ * the per-glyph cost of measuring output is one or two array loads instead
+ * of a binary search. The BMP gets a flat table; the astral planes get a
+ * page table where pages of uniform width share one of four constant pages
+ * and only the few mixed pages get private storage. */
+static signed char s_bmp_widths[0x10000];
+static const signed char *s_astral_pages[0x1100];
+static signed char s_uniform_pages[4][256];    /* widths -1, 0, 1, 2 */
+static signed char s_mixed_pages[16][256];
+static int s_widths_built = 0;
+
+static void build_width_tables(void)
+{
+  char32_t ucs;
+  int page, i, mixed = 0;
+
+  for (ucs = 0; ucs < 0x10000; ucs++)
+    s_bmp_widths[ucs] = (signed char)classify_wcwidth(ucs);
+
+  for (i = 0; i < 4; i++)
+    memset(s_uniform_pages[i], i - 1, sizeof(s_uniform_pages[i]));
+
+  for (page = 0; page < (int)(sizeof(s_astral_pages) / sizeof(s_astral_pages[0])); page++)
+  {
+    char32_t first = 0x10000 + (char32_t)page * 256;
+    signed char w = (signed char)classify_wcwidth(first);
+    int uniform = 1;
+
+    for (i = 1; i < 256; i++)
+      if (classify_wcwidth(first + i) != w)
+      {
+        uniform = 0;
+        break;
+      }
+
+    if (uniform)
+      s_astral_pages[page] = s_uniform_pages[w + 1];
+    else if (mixed < (int)(sizeof(s_mixed_pages) / sizeof(s_mixed_pages[0])))
+    {
+      for (i = 0; i < 256; i++)
+        s_mixed_pages[mixed][i] = (signed char)classify_wcwidth(first + i);
+      s_astral_pages[page] = s_mixed_pages[mixed++];
+    }
+    /* else leave the page NULL; mk_wcwidth falls back to classifying. */
+  }
+
+  s_widths_built = 1;
+}
+
+int mk_wcwidth(char32_t ucs)
+{
+  if (!s_widths_built)
+    build_width_tables();
+
+  if (ucs < 0x10000)
+    return s_bmp_widths[ucs];
+
+  if (ucs <= 0x10ffff)
+  {
+    const signed char *page = s_astral_pages[(ucs - 0x10000) >> 8];
+    if (page)
+      return page[ucs & 0xff];
+  }
+
+  return classify_wcwidth(ucs);
+}
+
+
 int mk_wcswidth(const char32_t *pwcs, size_t n)
 {
   int w, width = 0;
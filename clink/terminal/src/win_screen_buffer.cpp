@@ -15,6 +15,7 @@
 #include <Windows.h>
 #include <assert.h>
 
+#include <map>
 #include <regex>
 
 // For compatibility with Windows 8.1 SDK.
@@ -24,6 +25,21 @@
 # error ENABLE_VIRTUAL_TERMINAL_PROCESSING must be 0x0004
 #endif
 
+//------------------------------------------------------------------------------
+// The screen buffer currently in begin()..end(), so the input side can flush
+// deferred output before blocking for a key (see drain()).
+static const win_screen_buffer* s_active_screen_buffer = nullptr;
+
+//------------------------------------------------------------------------------
+void flush_deferred_screen_output()
+{
+    if (s_active_screen_buffer != nullptr)
+        s_active_screen_buffer->drain();
+}
+
+//------------------------------------------------------------------------------
+static void invalidate_nearest_color_cache();
+
 //------------------------------------------------------------------------------
 static const char* s_conemu_dll = nullptr;
 bool is_conemu()
@@ -96,6 +112,10 @@ void win_screen_buffer::begin()
     if (!m_handle)
         open();
 
+    // The console may have been resized while the host was running a command;
+    // no size event is seen for that, so each edit starts a new generation.
+    next_screen_metrics_generation();
+
     static bool detect_conemu = true;
     if (detect_conemu)
     {
@@ -192,6 +212,12 @@ void win_screen_buffer::begin()
         SetConsoleMode(m_handle, m_prev_mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
 
     m_ready = true;
+    m_move_type = move_none; // Nothing pending from a previous session.
+    m_shadow_count = 0; // Other processes may have written to the console.
+    invalidate_read_cache();
+    m_written_attr = -1; // And may have changed the text attributes.
+    invalidate_nearest_color_cache(); // The palette may have changed too.
+    s_active_screen_buffer = this;
 }
 
 //------------------------------------------------------------------------------
@@ -199,9 +225,13 @@ void win_screen_buffer::end()
 {
     if (m_ready)
     {
+        drain();
         SetConsoleTextAttribute(m_handle, m_default_attr);
+        m_written_attr = -1;
         SetConsoleMode(m_handle, m_prev_mode);
         m_ready = false;
+        if (s_active_screen_buffer == this)
+            s_active_screen_buffer = nullptr;
     }
 }
 
@@ -216,28 +246,47 @@ void win_screen_buffer::write(const char* data, int length)
 {
     assert(m_ready);
 
-    str_iter iter(data, length);
+    // Defer the text instead of writing it right away; a redisplay produces
+    // many small fragments (Readline emits one character at a time), and the
+    // deferred text goes to the console as one WriteConsoleW call when
+    // anything else touches the console, or when input goes idle.
     while (length > 0)
     {
-        wchar_t wbuf[384];
-        int n = min<int>(sizeof_array(wbuf), length + 1);
-        n = to_utf16(wbuf, n, iter);
+        int space = int(sizeof_array(m_deferred)) - int(m_deferred_count);
+        if (space < 4) // Room for a surrogate pair plus terminator.
+        {
+            drain();
+            space = sizeof_array(m_deferred);
+        }
+
+        // Widen ASCII directly; Readline's output is overwhelmingly ASCII,
+        // so the UTF-8 decoder only runs from the first high byte onward.
+        int run = min<int>(space, length);
+        int ascii = 0;
+        while (ascii < run && !(data[ascii] & 0x80))
+        {
+            m_deferred[m_deferred_count + ascii] = (unsigned char)data[ascii];
+            ++ascii;
+        }
+        if (ascii)
+        {
+            m_deferred_count += ascii;
+            data += ascii;
+            length -= ascii;
+            continue;
+        }
+
+        str_iter iter(data, length);
+        int n = min<int>(space, length + 1);
+        n = to_utf16(m_deferred + m_deferred_count, n, iter);
         if (!n && !*iter.get_pointer())
         {
             assert(false); // Very inefficient, and shouldn't be possible.
-            wbuf[0] = '\0';
+            m_deferred[m_deferred_count] = '\0';
             n = 1;
         }
 
-#ifdef CLINK_DEBUG
-        // Why was this forcing a break/crash on '\r'??
-        // for (int i = 0; i < n; ++i)
-        //     if (wbuf[i] == '\r')
-        //         __debugbreak();
-#endif
-
-        DWORD written;
-        WriteConsoleW(m_handle, wbuf, n, &written, nullptr);
+        m_deferred_count += n;
 
         n = int(iter.get_pointer() - data);
         length -= n;
@@ -245,9 +294,93 @@ void win_screen_buffer::write(const char* data, int length)
     }
 }
 
+//------------------------------------------------------------------------------
+void win_screen_buffer::drain() const
+{
+    // Any pending cursor movement comes first; the deferred text was written
+    // after the movement was recorded.
+    apply_pending_move();
+
+    if (!m_deferred_count)
+        return;
+
+    DWORD written;
+
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    if (!GetConsoleScreenBufferInfo(m_handle, &csbi))
+    {
+        WriteConsoleW(m_handle, m_deferred, m_deferred_count, &written, nullptr);
+        m_deferred_count = 0;
+        m_shadow_count = 0;
+        invalidate_read_cache();
+        return;
+    }
+
+    // Diff against the shadow of the last drained chunk. A redisplay often
+    // repaints text that is already on the screen (Readline rewrites to the
+    // end of a wrapped line); when this chunk starts where the last one did
+    // with the same attributes, the unchanged part need not be sent again.
+    const COORD pos = csbi.dwCursorPosition;
+    unsigned int skip = 0;
+    if (m_shadow_count &&
+        pos.X == m_shadow_pos.X && pos.Y == m_shadow_pos.Y &&
+        csbi.wAttributes == m_shadow_attr)
+    {
+        if (m_deferred_count == m_shadow_count &&
+            memcmp(m_deferred, m_shadow, m_deferred_count * sizeof(*m_deferred)) == 0)
+        {
+            // The chunk repaints exactly what it painted last time; skip the
+            // write and just put the cursor where the write left it.
+            SetConsoleCursorPosition(m_handle, m_shadow_end);
+            m_deferred_count = 0;
+            return;
+        }
+
+        // Skip an unchanged prefix when it is long enough to pay for the
+        // extra cursor call. Only plain single-cell characters before the
+        // end of the cursor's row can be skipped, since only then is the
+        // cursor position after the prefix knowable without emulating the
+        // console's wrapping behavior.
+        unsigned int max_common = min<unsigned int>(m_deferred_count, m_shadow_count);
+        max_common = min<unsigned int>(max_common, (csbi.dwSize.X - pos.X) - 1);
+        unsigned int common = 0;
+        while (common < max_common &&
+               m_deferred[common] == m_shadow[common] &&
+               m_deferred[common] >= 0x20 && m_deferred[common] <= 0x7e)
+            common++;
+        if (common >= 16)
+        {
+            skip = common;
+            COORD skip_pos = { SHORT(pos.X + common), pos.Y };
+            SetConsoleCursorPosition(m_handle, skip_pos);
+        }
+    }
+
+    WriteConsoleW(m_handle, m_deferred + skip, m_deferred_count - skip, &written, nullptr);
+    invalidate_read_cache();
+
+    // Remember the chunk; invalidate instead if the write may have scrolled
+    // the buffer, since that moves the cells out from under the shadow.
+    m_shadow_count = 0;
+    CONSOLE_SCREEN_BUFFER_INFO after;
+    if (GetConsoleScreenBufferInfo(m_handle, &after) &&
+        after.dwCursorPosition.Y < csbi.dwSize.Y - 1)
+    {
+        m_shadow_pos = pos;
+        m_shadow_end = after.dwCursorPosition;
+        m_shadow_attr = csbi.wAttributes;
+        m_shadow_count = m_deferred_count;
+        memcpy(m_shadow, m_deferred, m_deferred_count * sizeof(*m_deferred));
+    }
+
+    m_deferred_count = 0;
+}
+
 //------------------------------------------------------------------------------
 void win_screen_buffer::flush()
 {
+    drain();
+
     // When writing to the console conhost.exe will restart the cursor blink
     // timer and hide it which can be disorientating, especially when moving
     // around a line. The below will make sure it stays visible.
@@ -275,18 +408,14 @@ int win_screen_buffer::get_rows() const
 //------------------------------------------------------------------------------
 bool win_screen_buffer::get_line_text(int line, str_base& out) const
 {
+    drain();
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     if (!GetConsoleScreenBufferInfo(m_handle, &csbi))
         return false;
 
-    if (!ensure_chars_buffer(csbi.dwSize.X))
-        return false;
-
-    COORD coord = { 0, SHORT(line) };
-    DWORD len = 0;
-    if (!ReadConsoleOutputCharacterW(m_handle, m_chars, csbi.dwSize.X, coord, &len))
-        return false;
-    if (len != csbi.dwSize.X)
+    DWORD len;
+    if (!read_line_chars(line, csbi.dwSize.X, len))
         return false;
 
     while (len > 0 && iswspace(m_chars[len - 1]))
@@ -306,6 +435,10 @@ bool win_screen_buffer::has_native_vt_processing() const
 //------------------------------------------------------------------------------
 void win_screen_buffer::clear(clear_type type)
 {
+    drain();
+    m_shadow_count = 0;
+    invalidate_read_cache();
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     GetConsoleScreenBufferInfo(m_handle, &csbi);
 
@@ -345,6 +478,10 @@ void win_screen_buffer::clear(clear_type type)
 //------------------------------------------------------------------------------
 void win_screen_buffer::clear_line(clear_type type)
 {
+    drain();
+    m_shadow_count = 0;
+    invalidate_read_cache();
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     GetConsoleScreenBufferInfo(m_handle, &csbi);
 
@@ -376,36 +513,85 @@ void win_screen_buffer::clear_line(clear_type type)
 //------------------------------------------------------------------------------
 void win_screen_buffer::set_cursor(int column, int row)
 {
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
-    GetConsoleScreenBufferInfo(m_handle, &csbi);
-
-    const SMALL_RECT& window = csbi.srWindow;
-    int width = (window.Right - window.Left) + 1;
-    int height = (window.Bottom - window.Top) + 1;
+    // Only text needs flushing (it goes to the screen at the pre-movement
+    // position); a still-pending movement is simply superseded, which is
+    // what collapses runs of adjacent repositions into one console call.
+    if (m_deferred_count)
+        drain();
+
+    m_move_type = move_absolute;
+    m_move_x = column;
+    m_move_y = row;
+}
 
-    column = clamp(column, 0, width);
-    row = clamp(row, 0, height);
+//------------------------------------------------------------------------------
+void win_screen_buffer::move_cursor(int dx, int dy)
+{
+    if (m_deferred_count)
+        drain();
 
-    COORD xy = { window.Left + SHORT(column), window.Top + SHORT(row) };
-    SetConsoleCursorPosition(m_handle, xy);
+    if (m_move_type == move_none)
+    {
+        m_move_type = move_relative;
+        m_move_x = dx;
+        m_move_y = dy;
+    }
+    else
+    {
+        // Relative deltas fold into whatever movement is already pending.
+        m_move_x += dx;
+        m_move_y += dy;
+    }
 }
 
 //------------------------------------------------------------------------------
-void win_screen_buffer::move_cursor(int dx, int dy)
+void win_screen_buffer::apply_pending_move() const
 {
+    if (m_move_type == move_none)
+        return;
+
+    const move_type type = m_move_type;
+    m_move_type = move_none;
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
-    GetConsoleScreenBufferInfo(m_handle, &csbi);
+    if (!GetConsoleScreenBufferInfo(m_handle, &csbi))
+        return;
+
+    COORD xy;
+    if (type == move_absolute)
+    {
+        const SMALL_RECT& window = csbi.srWindow;
+        int width = (window.Right - window.Left) + 1;
+        int height = (window.Bottom - window.Top) + 1;
+
+        int column = clamp(m_move_x, 0, width);
+        int row = clamp(m_move_y, 0, height);
+
+        xy = { window.Left + SHORT(column), window.Top + SHORT(row) };
+    }
+    else
+    {
+        xy = {
+            SHORT(clamp(csbi.dwCursorPosition.X + m_move_x, 0, csbi.dwSize.X - 1)),
+            SHORT(clamp(csbi.dwCursorPosition.Y + m_move_y, 0, csbi.dwSize.Y - 1)),
+        };
+    }
+
+    // Movements that cancel out (cursor right then left, say) resolve to
+    // where the cursor already is and don't need the call at all.
+    if (xy.X == csbi.dwCursorPosition.X && xy.Y == csbi.dwCursorPosition.Y)
+        return;
 
-    COORD xy = {
-        SHORT(clamp(csbi.dwCursorPosition.X + dx, 0, csbi.dwSize.X - 1)),
-        SHORT(clamp(csbi.dwCursorPosition.Y + dy, 0, csbi.dwSize.Y - 1)),
-    };
     SetConsoleCursorPosition(m_handle, xy);
 }
 
 //------------------------------------------------------------------------------
 void win_screen_buffer::insert_chars(int count)
 {
+    drain();
+    m_shadow_count = 0;
+    invalidate_read_cache();
+
     if (count <= 0)
         return;
 
@@ -429,6 +615,10 @@ void win_screen_buffer::insert_chars(int count)
 //------------------------------------------------------------------------------
 void win_screen_buffer::delete_chars(int count)
 {
+    drain();
+    m_shadow_count = 0;
+    invalidate_read_cache();
+
     if (count <= 0)
         return;
 
@@ -463,10 +653,20 @@ void win_screen_buffer::delete_chars(int count)
 //------------------------------------------------------------------------------
 void win_screen_buffer::set_attributes(attributes attr)
 {
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
-    GetConsoleScreenBufferInfo(m_handle, &csbi);
+    drain();
+
+    // Diff against the last written attribute word; while the editor owns
+    // the console nothing else writes to it, so the cache both replaces the
+    // GetConsoleScreenBufferInfo query and lets no-op changes skip the set.
+    int current_attr = m_written_attr;
+    if (current_attr < 0)
+    {
+        CONSOLE_SCREEN_BUFFER_INFO csbi;
+        GetConsoleScreenBufferInfo(m_handle, &csbi);
+        current_attr = csbi.wAttributes;
+    }
 
-    int out_attr = csbi.wAttributes & attr_mask_all;
+    int out_attr = current_attr & attr_mask_all;
 
     // Note to self; lookup table is probably much faster.
     auto swizzle = [] (int rgbi) {
@@ -548,8 +748,26 @@ void win_screen_buffer::set_attributes(attributes attr)
         }
     }
 
-    out_attr |= csbi.wAttributes & ~attr_mask_all;
-    SetConsoleTextAttribute(m_handle, short(out_attr));
+    out_attr |= current_attr & ~attr_mask_all;
+    if (out_attr != current_attr || m_written_attr < 0)
+        SetConsoleTextAttribute(m_handle, short(out_attr));
+    m_written_attr = out_attr;
+}
+
+//------------------------------------------------------------------------------
+// Nearest-color results are memoized per 24-bit color; converting the palette
+// to Lab and measuring sixteen perceptual distances per escape code is far too
+// slow for colorful output. The cache is reset each time the editor takes over
+// the console, since the palette may have changed in between.
+static cie::lab4 s_palette_lab[4]; // 16 entries, 4 per SSE group.
+static bool s_palette_valid = false;
+static std::map<COLORREF, unsigned char> s_nearest_color_cache;
+
+//------------------------------------------------------------------------------
+static void invalidate_nearest_color_cache()
+{
+    s_palette_valid = false;
+    s_nearest_color_cache.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -562,30 +780,34 @@ static bool get_nearest_color(void* handle, const unsigned char (&rgb)[3], unsig
     if (!proc)
         return false;
 
-    CONSOLE_SCREEN_BUFFER_INFOEX infoex = { sizeof(infoex) };
-    if (!GCSBIEx(proc)(handle, &infoex))
-        return false;
-
-    cie::lab target(RGB(rgb[0], rgb[1], rgb[2]));
-    float best_deltaE = 0;
-    int best_idx = -1;
+    const COLORREF target_rgb = RGB(rgb[0], rgb[1], rgb[2]);
+    auto cached = s_nearest_color_cache.find(target_rgb);
+    if (cached != s_nearest_color_cache.end())
+    {
+        attr = cached->second;
+        return true;
+    }
 
-    for (int i = sizeof_array(infoex.ColorTable); i--;)
+    if (!s_palette_valid)
     {
-        cie::lab candidate(infoex.ColorTable[i]);
-        float deltaE = cie::deltaE(target, candidate);
-        if (best_idx < 0 || best_deltaE > deltaE)
-        {
-            best_deltaE = deltaE;
-            best_idx = i;
-        }
+        CONSOLE_SCREEN_BUFFER_INFOEX infoex = { sizeof(infoex) };
+        if (!GCSBIEx(proc)(handle, &infoex))
+            return false;
+
+        static_assert(sizeof_array(infoex.ColorTable) == sizeof_array(s_palette_lab) * 4, "palette size mismatch");
+        for (int i = 0; i < sizeof_array(infoex.ColorTable); ++i)
+            s_palette_lab[i / 4].set(i & 3, cie::lab(infoex.ColorTable[i]));
+        s_palette_valid = true;
     }
 
+    const cie::lab target(target_rgb);
+    const int best_idx = cie::nearest(target, s_palette_lab, sizeof_array(s_palette_lab));
     if (best_idx < 0)
         return false;
 
     static const int dos_to_ansi_order[] = { 0, 4, 2, 6, 1, 5, 3, 7 };
     attr = (best_idx & 0x08) + dos_to_ansi_order[best_idx & 0x07];
+    s_nearest_color_cache[target_rgb] = attr;
     return true;
 }
 
@@ -618,19 +840,14 @@ bool win_screen_buffer::get_nearest_color(attributes& attr) const
 //------------------------------------------------------------------------------
 int win_screen_buffer::is_line_default_color(int line) const
 {
+    drain();
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     if (!GetConsoleScreenBufferInfo(m_handle, &csbi))
         return -1;
 
-    if (!ensure_attrs_buffer(csbi.dwSize.X))
-        return -1;
-
-    int ret = true;
-    COORD coord = { 0, SHORT(line) };
-    DWORD len = 0;
-    if (!ReadConsoleOutputAttribute(m_handle, m_attrs, csbi.dwSize.X, coord, &len))
-        return -1;
-    if (len != csbi.dwSize.X)
+    DWORD len;
+    if (!read_line_attrs(line, csbi.dwSize.X, len))
         return -1;
 
     for (const WORD* attr = m_attrs; len--; attr++)
@@ -643,19 +860,14 @@ int win_screen_buffer::is_line_default_color(int line) const
 //------------------------------------------------------------------------------
 int win_screen_buffer::line_has_color(int line, const BYTE* attrs, int num_attrs, BYTE mask) const
 {
+    drain();
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     if (!GetConsoleScreenBufferInfo(m_handle, &csbi))
         return -1;
 
-    if (!ensure_attrs_buffer(csbi.dwSize.X))
-        return -1;
-
-    int ret = true;
-    COORD coord = { 0, SHORT(line) };
-    DWORD len = 0;
-    if (!ReadConsoleOutputAttribute(m_handle, m_attrs, csbi.dwSize.X, coord, &len))
-        return -1;
-    if (len != csbi.dwSize.X)
+    DWORD len;
+    if (!read_line_attrs(line, csbi.dwSize.X, len))
         return -1;
 
     const BYTE* end_attrs = attrs + num_attrs;
@@ -672,6 +884,8 @@ int win_screen_buffer::line_has_color(int line, const BYTE* attrs, int num_attrs
 //------------------------------------------------------------------------------
 int win_screen_buffer::find_line(int starting_line, int distance, const char* text, find_line_mode mode, const BYTE* attrs, int num_attrs, BYTE mask) const
 {
+    drain();
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     if (!GetConsoleScreenBufferInfo(m_handle, &csbi))
         return -2;
@@ -681,6 +895,9 @@ int win_screen_buffer::find_line(int starting_line, int distance, const char* te
     if (attrs && num_attrs > 0 && !ensure_attrs_buffer(csbi.dwSize.X))
         return -2;
 
+    // The search uses m_chars/m_attrs as scratch space.
+    invalidate_read_cache();
+
     return ::find_line(m_handle, csbi,
                        m_chars, m_chars_capacity,
                        m_attrs, m_attrs_capacity,
@@ -689,6 +906,76 @@ int win_screen_buffer::find_line(int starting_line, int distance, const char* te
                        attrs, num_attrs, mask);
 }
 
+//------------------------------------------------------------------------------
+void win_screen_buffer::invalidate_read_cache() const
+{
+    m_read_line = -1;
+    m_read_chars = false;
+    m_read_attrs = false;
+}
+
+//------------------------------------------------------------------------------
+bool win_screen_buffer::read_line_chars(int line, int width, unsigned long& len) const
+{
+    if (m_read_line == line && m_read_width == width && m_read_chars)
+    {
+        len = width;
+        return true;
+    }
+
+    if (!ensure_chars_buffer(width))
+        return false;
+
+    if (m_read_line != line || m_read_width != width)
+    {
+        m_read_line = line;
+        m_read_width = width;
+        m_read_chars = false;
+        m_read_attrs = false;
+    }
+
+    COORD coord = { 0, SHORT(line) };
+    len = 0;
+    if (!ReadConsoleOutputCharacterW(m_handle, m_chars, width, coord, &len))
+        return false;
+    if (len != DWORD(width))
+        return false;
+
+    m_read_chars = true;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool win_screen_buffer::read_line_attrs(int line, int width, unsigned long& len) const
+{
+    if (m_read_line == line && m_read_width == width && m_read_attrs)
+    {
+        len = width;
+        return true;
+    }
+
+    if (!ensure_attrs_buffer(width))
+        return false;
+
+    if (m_read_line != line || m_read_width != width)
+    {
+        m_read_line = line;
+        m_read_width = width;
+        m_read_chars = false;
+        m_read_attrs = false;
+    }
+
+    COORD coord = { 0, SHORT(line) };
+    len = 0;
+    if (!ReadConsoleOutputAttribute(m_handle, m_attrs, width, coord, &len))
+        return false;
+    if (len != DWORD(width))
+        return false;
+
+    m_read_attrs = true;
+    return true;
+}
+
 //------------------------------------------------------------------------------
 bool win_screen_buffer::ensure_chars_buffer(int width) const
 {
@@ -9,7 +9,7 @@ class str_base;
 enum find_line_mode : int;
 
 //------------------------------------------------------------------------------
-class win_screen_buffer
+class win_screen_buffer final
     : public screen_buffer
 {
 public:
@@ -36,9 +36,15 @@ public:
     virtual int     line_has_color(int line, const BYTE* attrs, int num_attrs, BYTE mask=0xff) const override;
     virtual int     find_line(int starting_line, int distance, const char* text, find_line_mode mode, const BYTE* attrs=nullptr, int num_attrs=0, BYTE mask=0xff) const override;
 
+    void            drain() const;
+
 private:
     bool            ensure_chars_buffer(int width) const;
     bool            ensure_attrs_buffer(int width) const;
+    void            apply_pending_move() const;
+    void            invalidate_read_cache() const;
+    bool            read_line_chars(int line, int width, unsigned long& len) const;
+    bool            read_line_attrs(int line, int width, unsigned long& len) const;
 
     enum : unsigned short
     {
@@ -56,9 +62,52 @@ private:
     bool            m_bold = false;
     bool            m_native_vt = false;
 
+    // Last attribute word written by set_attributes(), or -1 when unknown
+    // (on taking over the console, or after releasing it).  Lets repeated
+    // SGR codes that resolve to the current attributes skip both console
+    // API round trips.
+    int             m_written_attr = -1;
+
     mutable WORD*   m_attrs = nullptr;
     mutable SHORT   m_attrs_capacity = 0;
 
     mutable WCHAR*  m_chars = nullptr;
     mutable SHORT   m_chars_capacity = 0;
+
+    // Which screen line (if any) m_chars/m_attrs currently hold, so repeated
+    // reads of the same line within one prompt cycle (a Lua prompt filter
+    // checking both text and colors, say) share a single console round trip.
+    // Anything that changes screen contents invalidates this.
+    mutable int     m_read_line = -1;
+    mutable int     m_read_width = 0;
+    mutable bool    m_read_chars = false;
+    mutable bool    m_read_attrs = false;
+
+    // Cursor movement deferred by set_cursor()/move_cursor(); adjacent moves
+    // coalesce here and drain() issues at most one SetConsoleCursorPosition
+    // per flushed chunk.  Absolute coordinates are window relative, matching
+    // set_cursor().  A pending move always logically precedes any deferred
+    // text, since recording a new move flushes text first.
+    enum move_type : unsigned char
+    {
+        move_none,
+        move_absolute,
+        move_relative,
+    };
+    mutable move_type m_move_type = move_none;
+    mutable int     m_move_x = 0;
+    mutable int     m_move_y = 0;
+
+    // Text deferred by write(); drain() flushes it as a single WriteConsoleW
+    // call when anything else touches the console, or when input goes idle.
+    mutable WCHAR   m_deferred[4096];
+    mutable unsigned int m_deferred_count = 0;
+
+    // Shadow of the last drained chunk so drain() can avoid rewriting text
+    // that is already on the screen.
+    mutable WCHAR   m_shadow[4096];
+    mutable unsigned int m_shadow_count = 0;
+    mutable COORD   m_shadow_pos = {};
+    mutable COORD   m_shadow_end = {};
+    mutable WORD    m_shadow_attr = 0;
 };
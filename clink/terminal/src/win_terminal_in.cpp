@@ -4,6 +4,7 @@
 #include "pch.h"
 #include "win_terminal_in.h"
 #include "scroll.h"
+#include "screen_buffer.h"
 #include "key_tester.h"
 
 #include <core/base.h>
@@ -311,12 +312,33 @@ static void ensure_keyseqs_to_names()
     }
 }
 
+//------------------------------------------------------------------------------
+// Translated key sequences, direct-mapped by virtual key code.  A held or
+// repeated key delivers the exact same KEY_EVENT_RECORD over and over
+// (cursoring through history, say); translating it once and replaying the
+// bytes turns the per-keypress branching in process_input() into one lookup.
+// Only translations made with an empty buffer are cached, which is the steady
+// state.  The table resets with the key name map below, since the same
+// settings influence the translation.
+struct key_translation
+{
+    unsigned int    key_char;
+    unsigned int    key_flags;
+    unsigned short  key_vk;
+    unsigned short  key_sc;
+    unsigned char   length;
+    bool            valid;
+    char            seq[12];
+};
+static key_translation s_translations[32];
+
 //------------------------------------------------------------------------------
 void reset_keyseq_to_name_map()
 {
     // Settings can affect key sequence processing, so being able to reset the
     // map enables show_rl_help to show accurate key names.
     map_keyseq_to_name.clear();
+    memset(s_translations, 0, sizeof(s_translations));
 }
 
 //------------------------------------------------------------------------------
@@ -479,13 +501,34 @@ void win_terminal_in::end()
     m_stdin = nullptr;
 }
 
+//------------------------------------------------------------------------------
+// Output deferred by the output side must reach the console before blocking
+// for a key; waiting for input is the end of the output frame.
+void flush_deferred_screen_output();
+void flush_deferred_terminal_output();
+
 //------------------------------------------------------------------------------
 void win_terminal_in::select()
 {
+    flush_deferred_screen_output();
+    flush_deferred_terminal_output();
+
     if (!m_buffer_count)
         read_console();
 }
 
+//------------------------------------------------------------------------------
+void win_terminal_in::select(unsigned int timeout_ms)
+{
+    flush_deferred_screen_output();
+    flush_deferred_terminal_output();
+
+    if (!m_buffer_count &&
+        (m_pending_next < m_pending_count ||
+         WaitForSingleObject(m_stdin, timeout_ms) == WAIT_OBJECT_0))
+        read_console();
+}
+
 //------------------------------------------------------------------------------
 int win_terminal_in::read()
 {
@@ -493,6 +536,7 @@ int win_terminal_in::read()
     if (dimensions != m_dimensions)
     {
         m_dimensions = dimensions;
+        next_screen_metrics_generation();
         return terminal_in::input_terminal_resize;
     }
 
@@ -509,6 +553,31 @@ int win_terminal_in::read()
     }
 }
 
+//------------------------------------------------------------------------------
+bool win_terminal_in::more_input_available() const
+{
+    if (m_buffer_count > 0)
+        return true;
+
+    // Only a key-down record can turn into more input. Key-up records ride
+    // along with every keystroke and unaccompanied modifier presses produce
+    // nothing, so they must not hold up deferred per-key work (a redraw).
+    for (unsigned int i = m_pending_next; i < m_pending_count; ++i)
+    {
+        const INPUT_RECORD& record = m_pending_records[i];
+        if (record.EventType != KEY_EVENT || !record.Event.KeyEvent.bKeyDown)
+            continue;
+
+        const WORD key_vk = record.Event.KeyEvent.wVirtualKeyCode;
+        if (key_vk == VK_SHIFT || key_vk == VK_CONTROL || key_vk == VK_MENU)
+            continue;
+
+        return true;
+    }
+
+    return false;
+}
+
 //------------------------------------------------------------------------------
 key_tester* win_terminal_in::set_key_tester(key_tester* keys)
 {
@@ -520,6 +589,13 @@ key_tester* win_terminal_in::set_key_tester(key_tester* keys)
 //------------------------------------------------------------------------------
 void win_terminal_in::read_console()
 {
+    // A previous batch may have fetched more records than were needed to
+    // buffer one key sequence; serve those before touching the console again.
+    // This is what makes a paste cheap: the burst of key events is fetched
+    // with one ReadConsoleInputW call and dribbled out from here.
+    if (process_records())
+        return;
+
     // Hide the cursor unless we're accepting input so we don't have to see it
     // jump around as the screen's drawn.
     struct cursor_scope {
@@ -535,11 +611,11 @@ void win_terminal_in::read_console()
     GetConsoleScreenBufferInfo(stdout_handle, &csbi);
     if (!is_scroll_mode())
         SetConsoleCursorPosition(stdout_handle, csbi.dwCursorPosition);
+    m_pending_cursor = csbi.dwCursorPosition;
 
     // Read input records sent from the terminal (aka conhost) until some
     // input has been buffered.
-    unsigned int buffer_count = m_buffer_count;
-    while (buffer_count == m_buffer_count)
+    while (true)
     {
 #ifdef DEBUG
         DWORD modeIn;
@@ -548,8 +624,7 @@ void win_terminal_in::read_console()
 #endif
 
         DWORD count;
-        INPUT_RECORD record;
-        if (!ReadConsoleInputW(m_stdin, &record, 1, &count))
+        if (!ReadConsoleInputW(m_stdin, m_pending_records, sizeof_array(m_pending_records), &count))
         {
             // Handle's probably invalid if ReadConsoleInput() failed.
             m_buffer_count = 1;
@@ -557,6 +632,21 @@ void win_terminal_in::read_console()
             return;
         }
 
+        m_pending_count = count;
+        m_pending_next = 0;
+        if (process_records())
+            return;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool win_terminal_in::process_records()
+{
+    const unsigned int buffer_count = m_buffer_count;
+    while (m_pending_next < m_pending_count)
+    {
+        INPUT_RECORD& record = m_pending_records[m_pending_next++];
+
         switch (record.EventType)
         {
         case KEY_EVENT:
@@ -627,17 +717,67 @@ void win_terminal_in::read_console()
         case WINDOW_BUFFER_SIZE_EVENT:
             // Windows will move the cursor onto a new line when it gets clipped
             // on buffer resize.
+            next_screen_metrics_generation();
             reset_wcwidths();
-            if (adjust_cursor_on_resize(csbi.dwCursorPosition))
-                return;
+            if (adjust_cursor_on_resize(m_pending_cursor))
+                return true;
             break;
         }
+
+        if (m_buffer_count != buffer_count)
+            return true;
     }
+
+    return false;
 }
 
 //------------------------------------------------------------------------------
-extern "C" int rl_editing_mode;
 void win_terminal_in::process_input(KEY_EVENT_RECORD const& record)
+{
+    static const unsigned int mask = sizeof_array(m_buffer) - 1;
+
+    // The cache only holds translations made from an empty buffer; the tab,
+    // space and back-tab special cases consult m_buffer_count, and a pending
+    // lead surrogate carries state between events.  Verbose input bypasses
+    // the cache so every event gets logged.
+    const bool cacheable = !m_buffer_count && !m_lead_surrogate && !s_verbose_input;
+
+    key_translation& slot =
+        s_translations[record.wVirtualKeyCode & (sizeof_array(s_translations) - 1)];
+    if (cacheable && slot.valid &&
+        slot.key_char == record.uChar.UnicodeChar &&
+        slot.key_flags == record.dwControlKeyState &&
+        slot.key_vk == record.wVirtualKeyCode &&
+        slot.key_sc == record.wVirtualScanCode)
+    {
+        // Replay byte by byte; the sequence can legitimately contain a nul
+        // (Ctrl-2 is a bare c0 nul), so push(const char*) can't be used.
+        unsigned int index = m_buffer_head + m_buffer_count;
+        for (unsigned int i = 0; i < slot.length && m_buffer_count <= mask; ++i, ++index, ++m_buffer_count)
+            m_buffer[index & mask] = slot.seq[i];
+        return;
+    }
+
+    translate_input(record);
+
+    if (cacheable && !m_lead_surrogate && m_buffer_count <= sizeof_array(slot.seq))
+    {
+        slot.key_char = record.uChar.UnicodeChar;
+        slot.key_flags = record.dwControlKeyState;
+        slot.key_vk = record.wVirtualKeyCode;
+        slot.key_sc = record.wVirtualScanCode;
+        slot.length = (unsigned char)m_buffer_count;
+        for (unsigned int i = 0; i < m_buffer_count; ++i)
+            slot.seq[i] = m_buffer[(m_buffer_head + i) & mask];
+        slot.valid = true;
+    }
+    else
+        slot.valid = false;
+}
+
+//------------------------------------------------------------------------------
+extern "C" int rl_editing_mode;
+void win_terminal_in::translate_input(KEY_EVENT_RECORD const& record)
 {
     int key_char = record.uChar.UnicodeChar;
     int key_vk = record.wVirtualKeyCode;
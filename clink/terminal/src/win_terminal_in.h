@@ -8,19 +8,23 @@
 class key_tester;
 
 //------------------------------------------------------------------------------
-class win_terminal_in
+class win_terminal_in final
     : public terminal_in
 {
 public:
     virtual void    begin() override;
     virtual void    end() override;
     virtual void    select() override;
+    virtual void    select(unsigned int timeout_ms) override;
     virtual int     read() override;
+    virtual bool    more_input_available() const override;
     virtual key_tester* set_key_tester(key_tester* keys) override;
 
 private:
     void            read_console();
+    bool            process_records();
     void            process_input(const KEY_EVENT_RECORD& key_event);
+    void            translate_input(const KEY_EVENT_RECORD& key_event);
     void            push(unsigned int value);
     void            push(const char* seq);
     unsigned char   pop();
@@ -32,4 +36,13 @@ private:
     unsigned char   m_buffer_count = 0;
     wchar_t         m_lead_surrogate = 0;
     unsigned char   m_buffer[16]; // must be power of two.
+
+    // Input records are fetched in batches; a paste delivers thousands of
+    // records and reading them one ReadConsoleInputW call at a time costs a
+    // console round trip per character. Records beyond the next key sequence
+    // wait here and are served without touching the console again.
+    INPUT_RECORD    m_pending_records[64];
+    unsigned int    m_pending_count = 0;
+    unsigned int    m_pending_next = 0;
+    COORD           m_pending_cursor = {};
 };
@@ -8,8 +8,21 @@
 #include <core/base.h>
 #include <core/str_iter.h>
 
+#include <assert.h>
 #include <Windows.h>
 
+//------------------------------------------------------------------------------
+// The terminal currently in begin()..end(), so the input side can flush
+// deferred output before blocking for a key (see drain()).
+static const win_terminal_out* s_active_terminal_out = nullptr;
+
+//------------------------------------------------------------------------------
+void flush_deferred_terminal_output()
+{
+    if (s_active_terminal_out != nullptr)
+        s_active_terminal_out->drain();
+}
+
 //------------------------------------------------------------------------------
 win_terminal_out::~win_terminal_out()
 {
@@ -26,28 +39,49 @@ void win_terminal_out::begin()
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     GetConsoleScreenBufferInfo(m_stdout, &csbi);
     m_default_attr = csbi.wAttributes;
+
+    s_active_terminal_out = this;
 }
 
 //------------------------------------------------------------------------------
 void win_terminal_out::end()
 {
+    drain();
     SetConsoleTextAttribute(m_stdout, m_default_attr);
     SetConsoleMode(m_stdout, m_prev_mode);
     m_stdout = nullptr;
+
+    if (s_active_terminal_out == this)
+        s_active_terminal_out = nullptr;
 }
 
 //------------------------------------------------------------------------------
 void win_terminal_out::write(const char* chars, int length)
 {
-    str_iter iter(chars, length);
+    // Defer the converted text instead of writing it right away; scripts
+    // that print many short lines (prompt filters) would otherwise cost one
+    // console transaction per line.  Attributes travel in-band as VT escapes
+    // on this terminal, so deferral never reorders them against the text.
     while (length > 0)
     {
-        wchar_t wbuf[384];
-        int n = min<int>(sizeof_array(wbuf), length + 1);
-        n = to_utf16(wbuf, n, iter);
-
-        DWORD written;
-        WriteConsoleW(m_stdout, wbuf, n, &written, nullptr);
+        int space = int(sizeof_array(m_deferred)) - int(m_deferred_count);
+        if (space < 4) // Room for a surrogate pair plus terminator.
+        {
+            drain();
+            space = sizeof_array(m_deferred);
+        }
+
+        str_iter iter(chars, length);
+        int n = min<int>(space, length + 1);
+        n = to_utf16(m_deferred + m_deferred_count, n, iter);
+        if (!n && !*iter.get_pointer())
+        {
+            assert(false); // Very inefficient, and shouldn't be possible.
+            m_deferred[m_deferred_count] = '\0';
+            n = 1;
+        }
+
+        m_deferred_count += n;
 
         n = int(iter.get_pointer() - chars);
         length -= n;
@@ -55,9 +89,22 @@ void win_terminal_out::write(const char* chars, int length)
     }
 }
 
+//------------------------------------------------------------------------------
+void win_terminal_out::drain() const
+{
+    if (!m_deferred_count)
+        return;
+
+    DWORD written;
+    WriteConsoleW(m_stdout, m_deferred, m_deferred_count, &written, nullptr);
+    m_deferred_count = 0;
+}
+
 //------------------------------------------------------------------------------
 void win_terminal_out::flush()
 {
+    drain();
+
     // When writing to the console conhost.exe will restart the cursor blink
     // timer and hide it which can be disorientating, especially when moving
     // around a line. The below will make sure it stays visible.
@@ -69,6 +116,8 @@ void win_terminal_out::flush()
 //------------------------------------------------------------------------------
 int win_terminal_out::get_columns() const
 {
+    drain();
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     GetConsoleScreenBufferInfo(m_stdout, &csbi);
     return csbi.dwSize.X;
@@ -77,6 +126,8 @@ int win_terminal_out::get_columns() const
 //------------------------------------------------------------------------------
 int win_terminal_out::get_rows() const
 {
+    drain();
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     GetConsoleScreenBufferInfo(m_stdout, &csbi);
     return (csbi.srWindow.Bottom - csbi.srWindow.Top) + 1;
@@ -85,6 +136,8 @@ int win_terminal_out::get_rows() const
 //------------------------------------------------------------------------------
 bool win_terminal_out::get_line_text(int line, str_base& out) const
 {
+    drain();
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     if (!GetConsoleScreenBufferInfo(m_stdout, &csbi))
         return false;
@@ -110,6 +163,8 @@ bool win_terminal_out::get_line_text(int line, str_base& out) const
 //------------------------------------------------------------------------------
 int win_terminal_out::is_line_default_color(int line) const
 {
+    drain();
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     if (!GetConsoleScreenBufferInfo(m_stdout, &csbi))
         return -1;
@@ -134,6 +189,8 @@ int win_terminal_out::is_line_default_color(int line) const
 //------------------------------------------------------------------------------
 int win_terminal_out::line_has_color(int line, const BYTE* attrs, int num_attrs, BYTE mask) const
 {
+    drain();
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     if (!GetConsoleScreenBufferInfo(m_stdout, &csbi))
         return -1;
@@ -162,6 +219,8 @@ int win_terminal_out::line_has_color(int line, const BYTE* attrs, int num_attrs,
 //------------------------------------------------------------------------------
 int win_terminal_out::find_line(int starting_line, int distance, const char* text, find_line_mode mode, const BYTE* attrs, int num_attrs, BYTE mask) const
 {
+    drain();
+
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     if (!GetConsoleScreenBufferInfo(m_stdout, &csbi))
         return -2;
@@ -6,7 +6,7 @@
 #include "terminal_out.h"
 
 //------------------------------------------------------------------------------
-class win_terminal_out
+class win_terminal_out final
     : public terminal_out
 {
 public:
@@ -22,6 +22,8 @@ public:
     virtual int     line_has_color(int line, const BYTE* attrs, int num_attrs, BYTE mask=0xff) const override;
     virtual int     find_line(int starting_line, int distance, const char* text, find_line_mode mode, const BYTE* attrs=nullptr, int num_attrs=0, BYTE mask=0xff) const override;
 
+    void            drain() const;
+
 private:
     bool            ensure_chars_buffer(int width) const;
     bool            ensure_attrs_buffer(int width) const;
@@ -30,6 +32,11 @@ private:
     unsigned long   m_prev_mode = 0;
     unsigned short  m_default_attr = 0x07;
 
+    // Text deferred by write(); drain() flushes it as a single WriteConsoleW
+    // call.  Everything that reads from the console drains first.
+    mutable WCHAR   m_deferred[4096];
+    mutable unsigned int m_deferred_count = 0;
+
     mutable WORD*   m_attrs = nullptr;
     mutable SHORT   m_attrs_capacity = 0;
 
@@ -27,6 +27,30 @@ TEST_CASE("ecma48 chars")
     REQUIRE(!iter.next());
 }
 
+//------------------------------------------------------------------------------
+TEST_CASE("ecma48 chars utf8 run")
+{
+    // Multi-byte codepoints must not end a run of plain text; only the C0
+    // byte does.
+    const char* input = "ab\xc2\xa9\xe2\x98\x83xy\x1b[m";
+
+    const ecma48_code* code;
+
+    ecma48_iter iter(input, g_state);
+    code = &iter.next();
+    REQUIRE(*code);
+    REQUIRE(code->get_type() == ecma48_code::type_chars);
+    REQUIRE(code->get_pointer() == input);
+    REQUIRE(code->get_length() == 9);
+
+    code = &iter.next();
+    REQUIRE(*code);
+    REQUIRE(code->get_type() == ecma48_code::type_c1);
+    REQUIRE(code->get_length() == 3);
+
+    REQUIRE(!iter.next());
+}
+
 //------------------------------------------------------------------------------
 TEST_CASE("ecma48 c0")
 {
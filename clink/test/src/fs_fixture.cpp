@@ -5,6 +5,7 @@
 #include "fs_fixture.h"
 
 #include <core/base.h>
+#include <core/dir_cache.h>
 #include <core/globber.h>
 #include <core/os.h>
 #include <core/path.h>
@@ -35,6 +36,10 @@ fs_fixture::fs_fixture(const char** fs)
     bool existed = !os::make_dir(m_root.c_str());
     os::set_current_dir(m_root.c_str());
 
+    // Directory timestamps are too coarse to tell apart fixtures built in
+    // quick succession, so drop any cached listings outright.
+    dir_cache::clear();
+
     if (existed)
         clean(m_root.c_str());
 
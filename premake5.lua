@@ -81,7 +81,7 @@ end
 clink_git_name, clink_git_commit = get_git_info()
 
 workspace("clink")
-    configurations({"debug", "release", "final"})
+    configurations({"debug", "release", "final", "pginstrument", "pgoptimize"})
     platforms({"x32", "x64"})
     location(to)
 
@@ -98,20 +98,39 @@ workspace("clink")
     setup_cfg("final")
     setup_cfg("release")
     setup_cfg("debug")
+    setup_cfg("pginstrument")
+    setup_cfg("pgoptimize")
 
     configuration("debug")
         optimize("off")
         defines("DEBUG")
         defines("_DEBUG")
 
-    configuration("final")
-        optimize("full")
-        omitframepointer("on")
-        flags("NoBufferSecurityCheck")
-        defines("NDEBUG")
+    -- The shipping configuration, plus the profile-guided pair built the same
+    -- way.  PGO workflow (MSVC):
+    --   1. build "pginstrument", which links with /GENPROFILE;
+    --   2. train it -- run clink_bench (the microbenchmarks replay the hot
+    --      editor and terminal paths) and/or drive a real session, producing
+    --      .pgc counts next to the instrumented binaries;
+    --   3. build "pgoptimize", which links with /USEPROFILE against the
+    --      training data from the pginstrument output directory.
+    -- Both inherit LTO; /GL code generation is a prerequisite for PGO.
+    for _, cfg in ipairs({"final", "pginstrument", "pgoptimize"}) do
+        configuration(cfg)
+            optimize("full")
+            omitframepointer("on")
+            flags("NoBufferSecurityCheck")
+            defines("NDEBUG")
+
+        configuration({cfg, "vs*"})
+            flags("LinkTimeOptimization")
+    end
 
-    configuration({"final", "vs*"})
-        flags("LinkTimeOptimization")
+    configuration({"pginstrument", "vs*"})
+        linkoptions("/GENPROFILE")
+
+    configuration({"pgoptimize", "vs*"})
+        linkoptions("/USEPROFILE:PGD=\""..path.translate(path.getabsolute(to.."/bin/pginstrument")).."\\$(TargetName).pgd\"")
 
     configuration("release")
         optimize("full")
@@ -348,6 +367,39 @@ clink_exe("clink_test")
         pchheader("pch.h")
         pchsource("clink/test/src/pch.cpp")
 
+--------------------------------------------------------------------------------
+clink_exe("clink_bench")
+    exceptionhandling("on")
+    links("clink_app_common")
+    links("clink_core")
+    links("clink_lib")
+    links("clink_lua")
+    links("clink_process")
+    links("clink_terminal")
+    links("lua")
+    links("readline")
+    links("shlwapi")
+    links("rpcrt4")
+    includedirs("clink/bench/src")
+    includedirs("clink/app/src")
+    includedirs("clink/core/include")
+    includedirs("clink/lib/include")
+    includedirs("clink/lib/include/lib")
+    includedirs("clink/lib/src")
+    includedirs("clink/lua/include")
+    includedirs("clink/terminal/include")
+    includedirs("lua/src")
+    includedirs("readline")
+    files("clink/app/bench/*.cpp")
+    files("clink/core/bench/*.cpp")
+    files("clink/lib/bench/*.cpp")
+    files("clink/terminal/bench/*.cpp")
+    files("clink/bench/**")
+
+    configuration("vs*")
+        pchheader("pch.h")
+        pchsource("clink/bench/src/pch.cpp")
+
 --------------------------------------------------------------------------------
 require "vstudio"
 local function add_tag(tag, value, project_name)
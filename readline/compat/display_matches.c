@@ -80,6 +80,10 @@ extern void qsort_match_list (char** matches, int len);
 rl_match_display_filter_func_t *rl_match_display_filter_func = NULL;
 const char *_rl_filtered_color = NULL;
 
+// Non-zero when match generation was cut off by its time budget (see
+// match.generate_timeout), so the displayed list may be missing entries.
+int rl_matches_are_partial = 0;
+
 
 
 //------------------------------------------------------------------------------
@@ -152,6 +156,47 @@ static void flush_tmpbuf(void)
 
 
 
+//------------------------------------------------------------------------------
+// Per-codepoint column widths for the BMP, filled lazily from WCWIDTH(); the
+// ASCII fast paths below never get here, so the cache only pays off for long
+// non-ASCII lists, where it replaces WCWIDTH's interval search per character
+// with an array load.  Stored as width+2 so zero means unfilled (widths can
+// be -1).
+static signed char s_wcwidth_cache[65536];
+
+static int cached_wcwidth(WCHAR_T wc)
+{
+    int w;
+    signed char c;
+
+    if ((unsigned int)wc >= 65536)
+        return WCWIDTH(wc);
+
+    c = s_wcwidth_cache[(unsigned int)wc];
+    if (c)
+        return c - 2;
+
+    w = WCWIDTH(wc);
+    s_wcwidth_cache[(unsigned int)wc] = (signed char)(w + 2);
+    return w;
+}
+
+//------------------------------------------------------------------------------
+// Column width of a match as the display loop will print it.  Printable
+// ASCII -- the overwhelmingly common case -- is one cell per byte, so its
+// width is its length; anything else defers to fnwidth()'s multibyte walk.
+static int match_width(char* s)
+{
+    const char* p = s;
+    while (*p >= 0x20 && *p < 0x7f)
+        p++;
+    if (!*p)
+        return (int)(p - s);
+    return fnwidth(s);
+}
+
+
+
 //------------------------------------------------------------------------------
 #if defined (COLOR_SUPPORT)
 static void append_color_indicator(enum indicator_no colored_filetype)
@@ -527,23 +572,39 @@ static int fnappend(const char *to_print, int prefix_bytes, const char *real_pat
         else
         {
 #if defined(HANDLE_MULTIBYTE)
-            tlen = MBRTOWC(&wc, s, end - s, &ps);
-            if (MB_INVALIDCH(tlen))
+            // Printable ASCII advances one cell per byte; append whole runs
+            // instead of converting character by character.  Runs stop at the
+            // colored-prefix boundary so the epilogue below still fires there.
+            if (*s >= 0x20 && *s < 0x7f)
             {
-                tlen = 1;
-                width = 1;
-                memset(&ps, 0, sizeof(mbstate_t));
+                const char* run = s;
+                const char* stop = (common_prefix_len > 0) ? to_print + common_prefix_len : end;
+                while (run < stop && *run >= 0x20 && *run < 0x7f)
+                    run++;
+                append_tmpbuf_string(s, run - s);
+                printed_len += (int)(run - s);
+                s = run;
             }
-            else if (MB_NULLWCH(tlen))
-                break;
             else
             {
-                w = WCWIDTH(wc);
-                width = (w >= 0) ? w : 1;
+                tlen = MBRTOWC(&wc, s, end - s, &ps);
+                if (MB_INVALIDCH(tlen))
+                {
+                    tlen = 1;
+                    width = 1;
+                    memset(&ps, 0, sizeof(mbstate_t));
+                }
+                else if (MB_NULLWCH(tlen))
+                    break;
+                else
+                {
+                    w = cached_wcwidth(wc);
+                    width = (w >= 0) ? w : 1;
+                }
+                append_tmpbuf_string(s, tlen);
+                s += tlen;
+                printed_len += width;
             }
-            append_tmpbuf_string(s, tlen);
-            s += tlen;
-            printed_len += width;
 #else
             append_tmpbuf_char(*s);
             s++;
@@ -825,8 +886,12 @@ static int display_match_list_internal(char **matches, int len, int max, bool on
     if (only_measure)
         return count;
 
-    // Sort the items if they are not already sorted.
-    if (rl_ignore_completion_duplicates == 0 && rl_sort_completion_matches)
+    // Sort the items if they are not already sorted.  Matches the application
+    // already deduplicated skip readline's postprocess sort, so they get
+    // sorted here instead -- only once the list is actually being displayed,
+    // after any "display all N possibilities?" confirmation.
+    if ((rl_ignore_completion_duplicates == 0 || rl_completion_matches_deduped) &&
+        rl_sort_completion_matches)
         qsort_match_list(matches + 1, len);
 
     // Watch out for special case.  If LEN is less than LIMIT, then
@@ -848,10 +913,13 @@ static int display_match_list_internal(char **matches, int len, int max, bool on
         minor_stride = 1;
     }
 
+    // The whole grid accumulates in the buffer and goes out in one write,
+    // rather than a write (and its console round trip) per row; paging and
+    // signals flush what has accumulated before interleaving with it.
     lines = 0;
+    reset_tmpbuf();
     for (i = 0; i < count; i++)
     {
-        reset_tmpbuf();
         for (j = 0, l = 1 + i * major_stride; j < limit; j++)
         {
             if (l > len || matches[l] == 0)
@@ -871,22 +939,26 @@ static int display_match_list_internal(char **matches, int len, int max, bool on
             append_color_indicator(C_CLR_TO_EOL);
         }
 #endif
-        flush_tmpbuf();
-        rl_crlf();
+        append_tmpbuf_string("\r\n", 2);
 #if defined(SIGWINCH)
         if (RL_SIG_RECEIVED() && RL_SIGWINCH_RECEIVED() == 0)
 #else
         if (RL_SIG_RECEIVED())
 #endif
+        {
+            flush_tmpbuf();
             return 0;
+        }
         lines++;
         if (_rl_page_completions && lines >= (_rl_screenheight - 1) && i < count)
         {
+            flush_tmpbuf();
             lines = _rl_internal_pager(lines);
             if (lines < 0)
                 return 0;
         }
     }
+    flush_tmpbuf();
 
     return 0;
 }
@@ -950,10 +1022,11 @@ static int display_filtered_match_list_internal(match_display_filter_entry **mat
         filtered_color_len = strlen(filtered_color);
     }
 
+    // One buffered frame for the whole grid; see display_match_list_internal.
     lines = 0;
+    reset_tmpbuf();
     for (i = 0; i < count; i++)
     {
-        reset_tmpbuf();
         for (j = 0, l = 1 + i * major_stride; j < limit; j++)
         {
             if (l > len || matches[l] == 0)
@@ -981,22 +1054,26 @@ static int display_filtered_match_list_internal(match_display_filter_entry **mat
         }
         append_default_color();
         append_color_indicator(C_CLR_TO_EOL);
-        flush_tmpbuf();
-        rl_crlf();
+        append_tmpbuf_string("\r\n", 2);
 #if defined(SIGWINCH)
         if (RL_SIG_RECEIVED() && RL_SIGWINCH_RECEIVED() == 0)
 #else
         if (RL_SIG_RECEIVED())
 #endif
+        {
+            flush_tmpbuf();
             return 0;
+        }
         lines++;
         if (_rl_page_completions && lines >= (_rl_screenheight - 1) && i < count)
         {
+            flush_tmpbuf();
             lines = _rl_internal_pager(lines);
             if (lines < 0)
                 return 0;
         }
     }
+    flush_tmpbuf();
 
     return 1;
 }
@@ -1004,12 +1081,10 @@ static int display_filtered_match_list_internal(match_display_filter_entry **mat
 //------------------------------------------------------------------------------
 void free_filtered_matches(match_display_filter_entry** filtered_matches)
 {
-    if (filtered_matches)
-    {
-        for (match_display_filter_entry** walk = filtered_matches; *walk; walk++)
-            free(*walk);
-        free(filtered_matches);
-    }
+    // Filtered match arrays and their entries come from a pool owned by the
+    // producer (lua_match_generator), which rewinds it at the start of each
+    // filter invocation.  Releasing them is a no-op; the memory is recycled
+    // wholesale for the next filtered display.
 }
 
 //------------------------------------------------------------------------------
@@ -1106,7 +1181,7 @@ done_filtered:
     for (max = 0, i = 1; matches[i]; i++)
     {
         temp = printable_part(matches[i]);
-        len = fnwidth(temp);
+        len = match_width(temp);
 
         // If present, use the match type to determine whether there will be a
         // visible stat character, and include it in the max length calculation.
@@ -1152,6 +1227,13 @@ done_filtered:
     display_match_list_internal(matches, len, max, false);
 
 done:
+    if (rl_matches_are_partial)
+    {
+        static const char partial_message[] = "(list may be incomplete; match generation timed out)";
+        rl_crlf();
+        fwrite(partial_message, sizeof(partial_message) - 1, 1, rl_outstream);
+        rl_crlf();
+    }
     rl_forced_update_display();
     rl_display_fixed = 1;
 }
@@ -22,5 +22,12 @@ extern rl_match_display_filter_func_t *rl_match_display_filter_func;
 
 extern const char *_rl_filtered_color;
 
+// Non-zero when match generation was cut off by its time budget (see
+// match.generate_timeout); display_matches() appends a notice that the list
+// may be missing entries.
+extern int rl_matches_are_partial;
+
+// Entries are pool-owned by the producer and stay valid until the next filter
+// invocation; "freeing" marks the list done and reclaims nothing itself.
 extern void free_filtered_matches(match_display_filter_entry** filtered_matches);
 extern void display_matches(char **matches);
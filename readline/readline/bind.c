@@ -1904,12 +1904,26 @@ static const struct {
 static int
 find_boolean_var (const char *name)
 {
-  register int i;
-
-  for (i = 0; boolean_varlist[i].name; i++)
-    if (_rl_stricmp (name, boolean_varlist[i].name) == 0)
-      return i;
+/* begin_clink_change */
+  /* The list is kept sorted by name, so bisect instead of scanning; the
+     host queries rl_variable_value repeatedly from scripts. */
+  register int lo, hi, mid, r;
+
+  lo = 0;
+  hi = sizeof (boolean_varlist) / sizeof (boolean_varlist[0]) - 1;
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      r = _rl_stricmp (name, boolean_varlist[mid].name);
+      if (r == 0)
+	return mid;
+      else if (r < 0)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
   return -1;
+/* end_clink_change */
 }
 
 static const char *
@@ -2004,12 +2018,25 @@ static const struct {
 static int
 find_string_var (const char *name)
 {
-  register int i;
-
-  for (i = 0; string_varlist[i].name; i++)
-    if (_rl_stricmp (name, string_varlist[i].name) == 0)
-      return i;
+/* begin_clink_change */
+  /* Sorted by name; bisect, as in find_boolean_var. */
+  register int lo, hi, mid, r;
+
+  lo = 0;
+  hi = sizeof (string_varlist) / sizeof (string_varlist[0]) - 1;
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      r = _rl_stricmp (name, string_varlist[mid].name);
+      if (r == 0)
+	return mid;
+      else if (r < 0)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
   return -1;
+/* end_clink_change */
 }
 
 static const char *
@@ -167,6 +167,9 @@ static int print_filename PARAMS((char *, char *, int));
 static char **gen_completion_matches PARAMS((char *, int, int, rl_compentry_func_t *, int, int));
 
 static char **remove_duplicate_matches PARAMS((char **));
+/* begin_clink_change */
+static void sort_deduped_matches PARAMS((char **));
+/* end_clink_change */
 static void insert_match PARAMS((char *, int, int, char *));
 /* begin_clink_change */
 //static int append_to_match PARAMS((char *, int, int, int));
@@ -363,6 +366,9 @@ rl_qsort_match_list_func_t *rl_qsort_match_list_func = (rl_qsort_match_list_func
 /* Hook function to allow an application to adjust the found completion
    word before readline tries to complete it. */
 rl_adjcmpwrd_func_t *rl_adjust_completion_word = (rl_adjcmpwrd_func_t *)NULL;
+/* Hook function called when a chosen match has been inserted, so the host
+   can track which completions get used. */
+rl_insert_match_func_t *rl_insert_match_func = (rl_insert_match_func_t *)NULL;
 /* end_clink_change */
 
 /* List of characters which can be used to quote a substring of the line.
@@ -473,6 +479,12 @@ const char *_rl_command_color = 0;
 const char *_rl_alias_color = 0;
 rl_read_key_hook_func_t *rl_read_key_hook = 0;
 int rl_completion_matches_include_type = 0;
+/* When set, the application's completion function guarantees the matches it
+   returned contain no duplicates, so postprocess_matches can skip the sort
+   and scan in remove_duplicate_matches.  Paths that consume the match list
+   in order sort it on demand (sort_deduped_matches).  This is ALWAYS zero on
+   entry, and can only be changed by rl_attempted_completion_function. */
+int rl_completion_matches_deduped = 0;
 static int no_compute_lcd = 0;
 static int quote_lcd = 0;
 static int force_quoting = 0;
@@ -1694,6 +1706,7 @@ gen_completion_matches (char *text, int start, int end, rl_compentry_func_t *our
   rl_completion_quote_character = quote_char;
 /* begin_clink_change */
   rl_completion_matches_include_type = 0; /* rl_attempted_completion_function can set this */
+  rl_completion_matches_deduped = 0; /* ditto */
 /* end_clink_change */
 
   /* If the user wants to TRY to complete, but then wants to give
@@ -1730,6 +1743,7 @@ gen_completion_matches (char *text, int start, int end, rl_compentry_func_t *our
       /* Clear the type flag in case rl_attempted_completion_function
 	 set it without returning matches. */
       rl_completion_matches_include_type = 0;
+      rl_completion_matches_deduped = 0;
 /* end_clink_change */
     }
 
@@ -1854,6 +1868,28 @@ remove_duplicate_matches (char **matches)
   return (temp_array);
 }
 
+/* begin_clink_change */
+/* When rl_completion_matches_deduped is set, postprocess_matches skips the
+   sort in remove_duplicate_matches, so the match list reaches here in the
+   order the application produced it.  Paths that consume the list in order
+   (menu completion, insert-all, the popup) call this to sort it on demand;
+   the display code sorts lazily on its own, after the user has confirmed a
+   large display. */
+static void
+sort_deduped_matches (char **matches)
+{
+  int i;
+
+  if (rl_completion_matches_deduped == 0 || rl_sort_completion_matches == 0)
+    return;
+
+  for (i = 0; matches[i]; i++)
+    ;
+  if (i > 2)
+    qsort_match_list (matches + 1, i - 1);
+}
+/* end_clink_change */
+
 /* Find the common prefix of the list of matches, and put it into
    matches[0]. */
 static int
@@ -2088,6 +2124,25 @@ postprocess_matches (char ***matchesp, int matching_filenames)
   /* It seems to me that in all the cases we handle we would like
      to ignore duplicate possibilities.  Scan for the text to
      insert being identical to the other completions. */
+/* begin_clink_change
+ * When the application guarantees the match list is already free of
+ * duplicates, the sort and scan in remove_duplicate_matches would find
+ * nothing.  Keep only its collapse of a lone match identical to the lcd,
+ * which doesn't need sorted input; paths that consume the list in order
+ * sort it on demand instead (sort_deduped_matches). */
+  if (rl_ignore_completion_duplicates && rl_completion_matches_deduped)
+    {
+      if (matches[1] && matches[2] == 0 &&
+	  match_type_strcmp (matches[0], matches[1],
+			     rl_completion_matches_include_type ? 1 : 0,
+			     0/*casefold*/, 1/*dedupe*/) == 0)
+	{
+	  xfree (matches[1]);
+	  matches[1] = (char *)NULL;
+	}
+    }
+  else
+/* end_clink_change */
   if (rl_ignore_completion_duplicates)
     {
       temp_matches = remove_duplicate_matches (matches);
@@ -2233,7 +2288,11 @@ rl_display_match_list_internal (char **matches, int len, int max, int only_measu
 	   0 < len <= limit  implies  count = 1. */
 
   /* Sort the items if they are not already sorted. */
-  if (rl_ignore_completion_duplicates == 0 && rl_sort_completion_matches)
+/* begin_clink_change */
+  //if (rl_ignore_completion_duplicates == 0 && rl_sort_completion_matches)
+  if ((rl_ignore_completion_duplicates == 0 || rl_completion_matches_deduped) &&
+      rl_sort_completion_matches)
+/* end_clink_change */
 /* begin_clink_change */
     //qsort (matches + 1, len, sizeof (char *), (QSFUNC *)_rl_qsort_string_compare);
     qsort_match_list (matches + 1, len);
@@ -2607,6 +2666,12 @@ insert_match (char *match, int start, int mtype, char *qc)
 	_rl_replace_text (replacement, start, end);
       if (replacement != match)
         xfree (replacement);
+/* begin_clink_change */
+      /* MULT_MATCH only inserts the common prefix of several matches, which
+	 isn't a chosen completion. */
+      if (rl_insert_match_func && mtype == SINGLE_MATCH)
+	rl_insert_match_func (match);
+/* end_clink_change */
 /* begin_clink_change */
       if (remove_dir_mark)
 	{
@@ -2759,6 +2824,11 @@ insert_all_matches (char **matches, int point, char *qc)
   int i;
   char *rp;
 
+/* begin_clink_change
+ * The matches are inserted in list order, so make sure they're sorted. */
+  sort_deduped_matches (matches);
+/* end_clink_change */
+
   rl_begin_undo_group ();
   /* remove any opening quote character; make_quoted_replacement will add
      it back. */
@@ -3731,6 +3801,12 @@ rl_old_menu_complete (int count, int invoking_key)
 
       RL_UNSETSTATE(RL_STATE_COMPLETING);
 
+/* begin_clink_change
+ * Menu completion cycles through the matches in list order, so make sure
+ * they're sorted. */
+      sort_deduped_matches (matches);
+/* end_clink_change */
+
       for (match_list_size = 0; matches[match_list_size]; match_list_size++)
         ;
       /* matches[0] is lcd if match_list_size > 1, but the circular buffer
@@ -3904,10 +3980,16 @@ rl_menu_complete (int count, int ignore)
 
       RL_UNSETSTATE(RL_STATE_COMPLETING);
 
+/* begin_clink_change
+ * Menu completion cycles through the matches in list order, so make sure
+ * they're sorted. */
+      sort_deduped_matches (matches);
+/* end_clink_change */
+
       for (match_list_size = 0; matches[match_list_size]; match_list_size++)
         ;
 
-      if (match_list_size == 0) 
+      if (match_list_size == 0)
 	{
 	  rl_ding ();
 	  FREE (matches);
@@ -4097,6 +4179,10 @@ rl_get_completions (int* match_count, char** ot, int* os, int* oe, int* delim, c
 
   RL_UNSETSTATE (RL_STATE_COMPLETING);
 
+  /* The popup shows the matches in list order, so make sure they're
+     sorted. */
+  sort_deduped_matches (matches);
+
   for (match_list_size = 0; matches[match_list_size]; match_list_size++)
     ;
 
@@ -233,6 +233,13 @@ int _rl_last_v_pos = 0;
   on screen minus 1. */
 int _rl_vis_botlin = 0;
 
+/* begin_clink_change */
+/* Physical rows between the start of the display finalized by
+   _rl_update_final() and the cursor afterwards.  Consumed (and reset) by
+   the transient prompt collapse in clink's rl_module. */
+int _rl_final_display_rows = 0;
+/* end_clink_change */
+
 static int _rl_quick_redisplay = 0;
 
 /* This is a hint update_line gives to rl_redisplay that it has adjusted the
@@ -766,6 +773,68 @@ _rl_optimize_redisplay (void)
     _rl_quick_redisplay = 1;
 }  
 
+/* begin_clink_change */
+/* Snapshot of everything the layout pass in rl_redisplay depends on, taken
+   after a successful redisplay of the plain prompt.  When the next call
+   finds the snapshot still matching, the screen already shows the right
+   thing and the whole O(line length) re-layout can be skipped.  Anything
+   that changes display state outside rl_redisplay (or changes what the
+   application's face function would return) must call
+   rl_invalidate_display (). */
+extern unsigned long rl_buffer_changes;
+static struct {
+  unsigned long buffer_changes;
+  int point;
+  int end;
+  int screenwidth;
+  int screenheight;
+  char *prompt;
+  UNDO_LIST *undo_list;
+  int valid;
+} redisplay_snapshot = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+void
+rl_invalidate_display (void)
+{
+  redisplay_snapshot.valid = 0;
+}
+
+static int
+redisplay_snapshot_matches (void)
+{
+  return (redisplay_snapshot.valid
+	  && forced_display == 0
+	  && _rl_want_redisplay == 0
+	  && rl_display_prompt == rl_prompt
+	  && rl_mark_active_p () == 0
+	  && redisplay_snapshot.buffer_changes == rl_buffer_changes
+	  && redisplay_snapshot.point == rl_point
+	  && redisplay_snapshot.end == rl_end
+	  && redisplay_snapshot.screenwidth == _rl_screenwidth
+	  && redisplay_snapshot.screenheight == _rl_screenheight
+	  && redisplay_snapshot.prompt == rl_prompt
+	  && redisplay_snapshot.undo_list == rl_undo_list);
+}
+
+static void
+redisplay_snapshot_update (void)
+{
+  if (rl_display_prompt == rl_prompt && rl_mark_active_p () == 0)
+    {
+      redisplay_snapshot.buffer_changes = rl_buffer_changes;
+      redisplay_snapshot.point = rl_point;
+      redisplay_snapshot.end = rl_end;
+      redisplay_snapshot.screenwidth = _rl_screenwidth;
+      redisplay_snapshot.screenheight = _rl_screenheight;
+      redisplay_snapshot.prompt = rl_prompt;
+      redisplay_snapshot.undo_list = rl_undo_list;
+      redisplay_snapshot.valid = 1;
+    }
+  else
+    redisplay_snapshot.valid = 0;
+}
+/* end_clink_change */
+
 /* Basic redisplay algorithm.  See comments inline. */
 void
 rl_redisplay (void)
@@ -788,9 +857,16 @@ rl_redisplay (void)
   if (_rl_echoing_p == 0)
     return;
 
+/* begin_clink_change */
+  /* Skip the re-layout entirely when nothing it depends on has changed
+     since the last redisplay. */
+  if (redisplay_snapshot_matches ())
+    return;
+/* end_clink_change */
+
   /* Block keyboard interrupts because this function manipulates global
      data structures. */
-  _rl_block_sigint ();  
+  _rl_block_sigint ();
   RL_SETSTATE (RL_STATE_REDISPLAYING);
 
   cur_face = FACE_NORMAL;
@@ -1630,6 +1706,10 @@ rl_redisplay (void)
     _rl_quick_redisplay = 0;
   }
 
+/* begin_clink_change */
+  redisplay_snapshot_update ();
+/* end_clink_change */
+
   RL_UNSETSTATE (RL_STATE_REDISPLAYING);
   _rl_release_sigint ();
 }
@@ -2626,6 +2706,9 @@ clear_rest_of_line:
 int
 rl_on_new_line (void)
 {
+/* begin_clink_change */
+  rl_invalidate_display ();
+/* end_clink_change */
   if (visible_line)
     visible_line[0] = '\0';
 
@@ -2644,6 +2727,10 @@ rl_clear_visible_line (void)
 {
   int curr_line;
 
+/* begin_clink_change */
+  rl_invalidate_display ();
+/* end_clink_change */
+
   /* Make sure we move to column 0 so we clear the entire line */
   _rl_cr ();
   _rl_last_c_pos = 0;
@@ -2672,6 +2759,10 @@ rl_on_new_line_with_prompt (void)
   int prompt_size, i, l, real_screenwidth, newlines;
   char *prompt_last_line, *lprompt;
 
+/* begin_clink_change */
+  rl_invalidate_display ();
+/* end_clink_change */
+
   /* Initialize visible_line and invisible_line to ensure that they can hold
      the already-displayed prompt. */
   prompt_size = strlen (rl_prompt) + 1;
@@ -3173,6 +3264,9 @@ rl_save_prompt (void)
 void
 rl_restore_prompt (void)
 {
+/* begin_clink_change */
+  rl_invalidate_display ();
+/* end_clink_change */
   FREE (local_prompt);
   FREE (local_prompt_prefix);
   FREE (local_prompt_newlines);
@@ -3375,6 +3469,10 @@ _rl_update_final (void)
   if (line_structures_initialized == 0)
     return;
 
+/* begin_clink_change */
+  rl_invalidate_display ();
+/* end_clink_change */
+
   full_lines = 0;
   /* If the cursor is the only thing on an otherwise-blank last line,
      compensate so we don't print an extra CRLF. */
@@ -3405,6 +3503,9 @@ _rl_update_final (void)
       puts_face (&last_line[_rl_screenwidth - 1 + woff],
 		 &last_face[_rl_screenwidth - 1 + woff], 1);
     }
+/* begin_clink_change */
+  _rl_final_display_rows = _rl_vis_botlin + (botline_length > 0 || _rl_last_c_pos > 0);
+/* end_clink_change */
   _rl_vis_botlin = 0;
   if (botline_length > 0 || _rl_last_c_pos > 0)
     rl_crlf ();
@@ -3452,6 +3553,10 @@ _rl_redisplay_after_sigwinch (void)
 {
   char *t;
 
+/* begin_clink_change */
+  rl_invalidate_display ();
+/* end_clink_change */
+
   /* Clear the last line (assuming that the screen size change will result in
      either more or fewer characters on that line only) and put the cursor at
      column 0.  Make sure the right thing happens if we have wrapped to a new
@@ -3490,6 +3595,9 @@ _rl_redisplay_after_sigwinch (void)
 void
 _rl_clean_up_for_exit (void)
 {
+/* begin_clink_change */
+  rl_invalidate_display ();
+/* end_clink_change */
   if (_rl_echoing_p)
     {
       if (_rl_vis_botlin > 0)	/* minor optimization plus bug fix */
@@ -3503,6 +3611,9 @@ _rl_clean_up_for_exit (void)
 void
 _rl_erase_entire_line (void)
 {
+/* begin_clink_change */
+  rl_invalidate_display ();
+/* end_clink_change */
   cr ();
   _rl_clear_to_eol (0);
   cr ();
@@ -266,6 +266,36 @@ hist_inittime (void)
   return ret;
 }
 
+/* begin_clink_change
+ * Bulk loaders know how many add_history calls are coming; growing the
+ * array once beats thousands of DEFAULT_HISTORY_GROW_SIZE reallocations. */
+void
+history_prealloc (int count)
+{
+  int needed;
+
+  if (count <= 0)
+    return;
+
+  /* +1 for the trailing NULL slot add_history maintains. */
+  needed = history_length + count + 1;
+  if (history_stifled && history_max_entries > 0 && needed > history_max_entries + 2)
+    needed = history_max_entries + 2;
+  if (needed <= history_size)
+    return;
+
+  history_size = needed;
+  if (the_history)
+    the_history = (HIST_ENTRY **)
+      xrealloc (the_history, history_size * sizeof (HIST_ENTRY *));
+  else
+    {
+      the_history = (HIST_ENTRY **)xmalloc (history_size * sizeof (HIST_ENTRY *));
+      the_history[0] = (HIST_ENTRY *)NULL;
+    }
+}
+/* end_clink_change */
+
 /* Place STRING at the end of the history list.  The data field
    is  set to NULL. */
 void
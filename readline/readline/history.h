@@ -82,6 +82,12 @@ extern void history_set_history_state PARAMS((HISTORY_STATE *));
    The associated data field (if any) is set to NULL. */
 extern void add_history PARAMS((const char *));
 
+/* begin_clink_change
+ * Grow the history array once for a known number of upcoming add_history
+ * calls, instead of incremental DEFAULT_HISTORY_GROW_SIZE reallocations. */
+extern void history_prealloc PARAMS((int));
+/* end_clink_change */
+
 /* Change the timestamp associated with the most recent history entry to
    STRING. */
 extern void add_history_time PARAMS((const char *));
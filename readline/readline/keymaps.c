@@ -44,6 +44,10 @@
 
 #include "xmalloc.h"
 
+/* begin_clink_change */
+#include <string.h>
+/* end_clink_change */
+
 /* **************************************************************** */
 /*								    */
 /*		      Functions for manipulating Keymaps.	    */
@@ -56,15 +60,24 @@
 Keymap
 rl_make_bare_keymap (void)
 {
-  register int i;
+/* begin_clink_change */
+  /*register int i;*/
+/* end_clink_change */
   Keymap keymap;
 
   keymap = (Keymap)xmalloc (KEYMAP_SIZE * sizeof (KEYMAP_ENTRY));
+/* begin_clink_change
+ * An all-zero entry is a bare binding (ISFUNC is 0), so zero-fill the block
+ * instead of storing each entry's fields individually. */
+  memset (keymap, 0, KEYMAP_SIZE * sizeof (KEYMAP_ENTRY));
+#if 0
   for (i = 0; i < KEYMAP_SIZE; i++)
     {
       keymap[i].type = ISFUNC;
       keymap[i].function = (rl_command_func_t *)NULL;
     }
+#endif
+/* end_clink_change */
 
 #if 0
   for (i = 'A'; i < ('Z' + 1); i++)
@@ -97,15 +110,14 @@ rl_empty_keymap (Keymap keymap)
 Keymap
 rl_copy_keymap (Keymap map)
 {
-  register int i;
+/* begin_clink_change
+ * A shallow copy is exactly what memcpy does; skip the zero-fill from
+ * rl_make_bare_keymap and the per-entry stores. */
   Keymap temp;
 
-  temp = rl_make_bare_keymap ();
-  for (i = 0; i < KEYMAP_SIZE; i++)
-    {
-      temp[i].type = map[i].type;
-      temp[i].function = map[i].function;
-    }
+  temp = (Keymap)xmalloc (KEYMAP_SIZE * sizeof (KEYMAP_ENTRY));
+  memcpy (temp, map, KEYMAP_SIZE * sizeof (KEYMAP_ENTRY));
+/* end_clink_change */
   return (temp);
 }
 
@@ -76,6 +76,9 @@ int _rl_history_saved_point = -1;
 rl_history_hook_func_t *rl_add_history_hook = (rl_history_hook_func_t *)NULL;
 /* If non-null, called when rl_remove_history removes a history line. */
 rl_history_hook_func_t *rl_remove_history_hook = (rl_history_hook_func_t *)NULL;
+/* If non-null, called when history scrolling hits the oldest loaded entry.
+   Returns non-zero if older history lines were made available. */
+rl_hook_func_t *rl_page_older_history_hook = (rl_hook_func_t *)NULL;
 
 /* end_clink_change */
 
@@ -628,6 +631,23 @@ rl_get_previous_history (int count, int key)
       --count;
     }
 
+/* begin_clink_change
+ * When the walk hits the oldest loaded entry, give the host a chance to page
+ * older history lines in (the hook repositions the history offset), then
+ * keep walking. */
+  while (temp == 0 && count
+	 && rl_page_older_history_hook && (*rl_page_older_history_hook) ())
+    while (count)
+      {
+	temp = previous_history ();
+	if (temp == 0)
+	  break;
+
+	old_temp = temp;
+	--count;
+      }
+/* end_clink_change */
+
   /* If there was a large argument, and we moved back to the start of the
      history, that is not an error.  So use the last value found. */
   if (!temp && old_temp)
@@ -354,6 +354,12 @@ rl_set_prompt (const char *prompt)
   rl_prompt = prompt ? savestring (prompt) : (char *)NULL;
   rl_display_prompt = rl_prompt ? rl_prompt : "";
 
+/* begin_clink_change */
+  /* The new prompt can land at the old prompt's address, so pointer
+     comparison alone can't catch the change. */
+  rl_invalidate_display ();
+/* end_clink_change */
+
   rl_visible_prompt_length = rl_expand_prompt (rl_prompt);
   return 0;
 }
@@ -402,6 +402,9 @@ extern void rl_push_macro_input PARAMS((char *));
 /* Functions for undoing, from undo.c */
 extern void rl_add_undo PARAMS((enum undo_code, int, int, char *));
 extern void rl_free_undo_list PARAMS((void));
+/* begin_clink_change */
+extern void rl_reset_undo_arena PARAMS((void));
+/* end_clink_change */
 extern int rl_do_undo PARAMS((void));
 extern int rl_begin_undo_group PARAMS((void));
 extern int rl_end_undo_group PARAMS((void));
@@ -649,6 +652,9 @@ extern rl_hook_func_t *rl_input_available_hook;
 extern rl_history_hook_func_t *rl_add_history_hook;
 /* Called when rl_remove_history removes a history line. */
 extern rl_history_hook_func_t *rl_remove_history_hook;
+/* Called when history scrolling hits the oldest loaded entry.  Returns
+   non-zero if older history lines were made available. */
+extern rl_hook_func_t *rl_page_older_history_hook;
 /* Conditional support for backslash as a path separator.
    This is used by rl_is_path_separator.*/
 extern int rl_backslash_path_sep;
@@ -684,6 +690,11 @@ extern rl_postprocess_lcd_func_t *rl_postprocess_lcd_func;
 #define IS_MATCH_TYPE_PATHISH(x)	(((x) & MATCH_TYPE_MASK) >= MATCH_TYPE_FILE && \
 					 ((x) & MATCH_TYPE_MASK) <= MATCH_TYPE_LINK)
 extern int rl_completion_matches_include_type;
+/* When set by rl_attempted_completion_function, the matches it returned are
+   guaranteed free of duplicates and readline skips its own sort-and-dedupe
+   postprocess pass; match lists are instead sorted on demand by the paths
+   that consume them in order. */
+extern int rl_completion_matches_deduped;
 /* end_clink_change */
 
 /* The address of the function to call to fetch a character from the current
@@ -705,6 +716,10 @@ extern char _rl_face_modmark;
 extern char _rl_face_horizscroll;
 extern rl_get_face_func_t *rl_get_face_func;
 extern rl_puts_face_func_t *rl_puts_face_func;
+/* Discards rl_redisplay's no-change snapshot so the next call re-lays out
+   the line.  Call after changing anything rl_redisplay can't observe, such
+   as what rl_get_face_func would return. */
+extern void rl_invalidate_display PARAMS((void));
 /* end_clink_change */
 
 extern rl_vintfunc_t *rl_prep_term_function;
@@ -882,6 +897,10 @@ extern rl_vcppfunc_t *rl_completion_display_matches_func;
    list of matches.  It can accommodate any special sorting behavior the host
    may require, such as ignoring trailing path separators. */
 extern rl_qsort_match_list_func_t *rl_qsort_match_list_func;
+/* If non-zero, then this is the address of a function called whenever a
+   chosen match has been inserted into the line, so the host can track
+   which completions get used. */
+extern rl_insert_match_func_t *rl_insert_match_func;
 /* If non-zero, then this is the address of a function to call that determines
    whether a file extension is executable. */
 extern rl_iccpfunc_t *rl_is_exec_func;
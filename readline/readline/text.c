@@ -73,6 +73,14 @@ static int _rl_char_search_callback PARAMS((_rl_callback_generic_arg *));
 
 int _rl_optimize_typeahead = 1;	/* rl_insert tries to read typeahead */
 
+/* begin_clink_change */
+/* Incremented whenever the line buffer's contents change, so the host can
+   poll for modifications without comparing buffer contents.  All content
+   changes funnel through rl_insert_text, rl_delete_text, or
+   rl_replace_line. */
+unsigned long rl_buffer_changes = 0;
+/* end_clink_change */
+
 /* **************************************************************** */
 /*								    */
 /*			Insert and Delete			    */
@@ -114,6 +122,9 @@ rl_insert_text (const char *string)
   rl_point += l;
   rl_end += l;
   rl_line_buffer[rl_end] = '\0';
+/* begin_clink_change */
+  rl_buffer_changes++;
+/* end_clink_change */
   return l;
 }
 
@@ -155,6 +166,9 @@ rl_delete_text (int from, int to)
   rl_end -= diff;
   rl_line_buffer[rl_end] = '\0';
   _rl_fix_mark ();
+/* begin_clink_change */
+  rl_buffer_changes++;
+/* end_clink_change */
   return (diff);
 }
 
@@ -222,6 +236,9 @@ rl_replace_line (const char *text, int clear_undo)
     rl_free_undo_list ();
 
   _rl_fix_point (1);
+/* begin_clink_change */
+  rl_buffer_changes++;
+/* end_clink_change */
 }
 
 /* **************************************************************** */
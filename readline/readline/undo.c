@@ -69,12 +69,101 @@ UNDO_LIST *rl_undo_list = (UNDO_LIST *)NULL;
 /*								    */
 /* **************************************************************** */
 
+/* begin_clink_change */
+/* Arena-backed UNDO_LIST node storage.  Every edit used to xmalloc a node,
+   so long sessions accumulated thousands of tiny blocks interleaved with
+   the host's allocations.  Nodes now come from chunked arenas and are only
+   recycled within a line; rl_reset_undo_arena () releases everything at
+   line acceptance (called from the host's end-of-line handling).  The text
+   carried by UNDO_DELETE entries is allocated by callers and stays on the
+   heap, freed exactly as before. */
+
+#define UNDO_ARENA_CHUNK 128
+
+typedef struct undo_arena_chunk
+{
+  struct undo_arena_chunk *next;
+  int used;
+  UNDO_LIST nodes[UNDO_ARENA_CHUNK];
+} undo_arena_chunk;
+
+static undo_arena_chunk *undo_arena = (undo_arena_chunk *)NULL;
+static UNDO_LIST *undo_free_nodes = (UNDO_LIST *)NULL;
+
+static UNDO_LIST *
+undo_arena_alloc (void)
+{
+  UNDO_LIST *node;
+
+  if (undo_free_nodes)
+    {
+      node = undo_free_nodes;
+      undo_free_nodes = node->next;
+      return node;
+    }
+
+  if (undo_arena == 0 || undo_arena->used == UNDO_ARENA_CHUNK)
+    {
+      undo_arena_chunk *chunk;
+
+      chunk = (undo_arena_chunk *)xmalloc (sizeof (*chunk));
+      chunk->next = undo_arena;
+      chunk->used = 0;
+      undo_arena = chunk;
+    }
+
+  return &undo_arena->nodes[undo_arena->used++];
+}
+
+/* Nodes live until rl_reset_undo_arena (); recycling freed ones within the
+   line keeps undo-heavy editing from growing the arena. */
+static void
+undo_arena_free (UNDO_LIST *node)
+{
+  node->next = undo_free_nodes;
+  undo_free_nodes = node;
+}
+
+/* Release all undo storage.  Only safe between lines:  any undo list still
+   referenced points into the arena, so the references are dropped with it
+   (rl_maybe_replace_line stashes undo lists in history entry data). */
+void
+rl_reset_undo_arena (void)
+{
+  undo_arena_chunk *chunk, *next;
+  HIST_ENTRY **hl;
+
+  hl = history_list ();
+  if (hl)
+    for (; *hl; hl++)
+      (*hl)->data = (histdata_t)NULL;
+
+  rl_undo_list = (UNDO_LIST *)NULL;
+  undo_free_nodes = (UNDO_LIST *)NULL;
+
+  /* Keep one chunk warm; editing a single line rarely needs more. */
+  if (undo_arena)
+    {
+      for (chunk = undo_arena->next; chunk; chunk = next)
+	{
+	  next = chunk->next;
+	  xfree (chunk);
+	}
+      undo_arena->next = (undo_arena_chunk *)NULL;
+      undo_arena->used = 0;
+    }
+}
+/* end_clink_change */
+
 static UNDO_LIST *
 alloc_undo_entry (enum undo_code what, int start, int end, char *text)
 {
   UNDO_LIST *temp;
 
-  temp = (UNDO_LIST *)xmalloc (sizeof (UNDO_LIST));
+/* begin_clink_change */
+  //temp = (UNDO_LIST *)xmalloc (sizeof (UNDO_LIST));
+  temp = undo_arena_alloc ();
+/* end_clink_change */
   temp->what = what;
   temp->start = start;
   temp->end = end;
@@ -110,7 +199,10 @@ _rl_free_undo_list (UNDO_LIST *ul)
       if (release->what == UNDO_DELETE)
 	xfree (release->text);
 
-      xfree (release);
+/* begin_clink_change */
+      //xfree (release);
+      undo_arena_free (release);
+/* end_clink_change */
     }
 }
 
@@ -264,7 +356,10 @@ rl_do_undo (void)
 	    }
 	}
 
-      xfree (release);
+/* begin_clink_change */
+      //xfree (release);
+      undo_arena_free (release);
+/* end_clink_change */
     }
   while (waiting_for_begin);
 
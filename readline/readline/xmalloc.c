@@ -48,6 +48,27 @@ memory_error_and_abort (char *fname)
   exit (2);
 }
 
+/* Cumulative allocation counters, so the host application can attribute
+   heap churn (history entries, undo records, expansions) to the code
+   driving readline. */
+static unsigned long alloc_count = 0;
+static unsigned long long alloc_bytes = 0;
+
+/* Report the counters, and reset them when RESET is non-zero. */
+void
+rl_get_alloc_counters (unsigned long *count, unsigned long long *bytes, int reset)
+{
+  if (count)
+    *count = alloc_count;
+  if (bytes)
+    *bytes = alloc_bytes;
+  if (reset)
+    {
+      alloc_count = 0;
+      alloc_bytes = 0;
+    }
+}
+
 /* Return a pointer to free()able block of memory large enough
    to hold BYTES number of bytes.  If the memory cannot be allocated,
    print an error message and abort. */
@@ -56,6 +77,9 @@ xmalloc (size_t bytes)
 {
   PTR_T temp;
 
+  alloc_count++;
+  alloc_bytes += bytes;
+
   temp = malloc (bytes);
   if (temp == 0)
     memory_error_and_abort ("xmalloc");
@@ -67,6 +91,9 @@ xrealloc (PTR_T pointer, size_t bytes)
 {
   PTR_T temp;
 
+  alloc_count++;
+  alloc_bytes += bytes;
+
   temp = pointer ? realloc (pointer, bytes) : malloc (bytes);
 
   if (temp == 0)
@@ -42,4 +42,6 @@ extern PTR_T xmalloc PARAMS((size_t));
 extern PTR_T xrealloc PARAMS((void *, size_t));
 extern void xfree PARAMS((void *));
 
+extern void rl_get_alloc_counters PARAMS((unsigned long *, unsigned long long *, int));
+
 #endif /* _XMALLOC_H_ */